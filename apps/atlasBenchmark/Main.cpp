@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Benchmarks the exponential map functions used by BallJoint, FreeJoint and
+// EulerJoint against their previous generic implementations, and times the
+// kinematics and integration of the Atlas robot which has a FreeJoint root.
+//
+// Usage:
+//   atlasBenchmark [numIterations] [sdfFile]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/Timer.h"
+#include "dart/math/Geometry.h"
+#include "dart/math/Helpers.h"
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/utils/Paths.h"
+#include "dart/utils/sdf/SdfParser.h"
+
+using namespace dart;
+
+/// Number of precomputed random operands that the benchmarks cycle through
+#define NUM_OPERANDS 64
+
+//==============================================================================
+// Previous generic implementations of dart/math/Geometry
+//==============================================================================
+
+#define GENERIC_EPSILON_EXPMAP_THETA 1.0e-3
+
+//==============================================================================
+Eigen::Matrix3d genericExpMapRot(const Eigen::Vector3d& _q)
+{
+  double theta = _q.norm();
+  Eigen::Matrix3d qss = math::makeSkewSymmetric(_q);
+  Eigen::Matrix3d qss2 = qss * qss;
+
+  if (theta < GENERIC_EPSILON_EXPMAP_THETA)
+    return Eigen::Matrix3d::Identity() + qss + 0.5 * qss2;
+
+  return Eigen::Matrix3d::Identity()
+      + (sin(theta) / theta) * qss
+      + ((1 - cos(theta)) / (theta * theta)) * qss2;
+}
+
+//==============================================================================
+Eigen::Matrix3d genericExpMapJac(const Eigen::Vector3d& _q)
+{
+  double theta = _q.norm();
+  Eigen::Matrix3d qss = math::makeSkewSymmetric(_q);
+  Eigen::Matrix3d qss2 = qss * qss;
+
+  if (theta < GENERIC_EPSILON_EXPMAP_THETA)
+    return Eigen::Matrix3d::Identity() + 0.5 * qss + (1.0 / 6.0) * qss2;
+
+  return Eigen::Matrix3d::Identity()
+      + ((1 - cos(theta)) / (theta * theta)) * qss
+      + ((theta - sin(theta)) / (theta * theta * theta)) * qss2;
+}
+
+//==============================================================================
+Eigen::Matrix3d genericExpMapJacDot(const Eigen::Vector3d& _q,
+                                    const Eigen::Vector3d& _qdot)
+{
+  double theta = _q.norm();
+  Eigen::Matrix3d Jdot;
+  Eigen::Matrix3d qss = math::makeSkewSymmetric(_q);
+  Eigen::Matrix3d qss2 = qss * qss;
+  Eigen::Matrix3d qdss = math::makeSkewSymmetric(_qdot);
+  double ttdot = _q.dot(_qdot);
+  double st = sin(theta);
+  double ct = cos(theta);
+  double t2 = theta * theta;
+  double t3 = t2 * theta;
+  double t4 = t3 * theta;
+  double t5 = t4 * theta;
+
+  if (theta < GENERIC_EPSILON_EXPMAP_THETA)
+  {
+    Jdot = 0.5 * qdss + (1.0 / 6.0) * (qss * qdss + qdss * qss);
+    Jdot += (-1.0 / 12) * ttdot * qss + (-1.0 / 60) * ttdot * qss2;
+  }
+  else
+  {
+    Jdot = ((1 - ct) / t2) * qdss + ((theta - st) / t3) * (qss * qdss + qdss * qss);
+    Jdot += ((theta * st + 2 * ct - 2) / t4) * ttdot * qss
+            + ((3 * st - theta * ct - 2 * theta) / t5) * ttdot * qss2;
+  }
+
+  return Jdot;
+}
+
+//==============================================================================
+Eigen::Isometry3d genericExpMap(const Eigen::Vector6d& _S)
+{
+  Eigen::Isometry3d ret = Eigen::Isometry3d::Identity();
+  double s2[] = { _S[0]*_S[0], _S[1]*_S[1], _S[2]*_S[2] };
+  double s3[] = { _S[0]*_S[1], _S[1]*_S[2], _S[2]*_S[0] };
+  double theta = sqrt(s2[0] + s2[1] + s2[2]);
+  double cos_t = cos(theta), alpha, beta, gamma;
+
+  if (theta > DART_EPSILON)
+  {
+    double sin_t = sin(theta);
+    alpha = sin_t / theta;
+    beta = (1.0 - cos_t) / theta / theta;
+    gamma = (_S[0]*_S[3] + _S[1]*_S[4] + _S[2]*_S[5])
+            * (theta - sin_t) / theta / theta / theta;
+  }
+  else
+  {
+    alpha = 1.0 - theta*theta/6.0;
+    beta = 0.5 - theta*theta/24.0;
+    gamma = (_S[0]*_S[3] + _S[1]*_S[4] + _S[2]*_S[5])/6.0 - theta*theta/120.0;
+  }
+
+  ret(0, 0) = beta*s2[0] + cos_t;
+  ret(1, 0) = beta*s3[0] + alpha*_S[2];
+  ret(2, 0) = beta*s3[2] - alpha*_S[1];
+
+  ret(0, 1) = beta*s3[0] - alpha*_S[2];
+  ret(1, 1) = beta*s2[1] + cos_t;
+  ret(2, 1) = beta*s3[1] + alpha*_S[0];
+
+  ret(0, 2) = beta*s3[2] + alpha*_S[1];
+  ret(1, 2) = beta*s3[1] - alpha*_S[0];
+  ret(2, 2) = beta*s2[2] + cos_t;
+
+  ret(0, 3) = alpha*_S[3] + beta*(_S[1]*_S[5] - _S[2]*_S[4]) + gamma*_S[0];
+  ret(1, 3) = alpha*_S[4] + beta*(_S[2]*_S[3] - _S[0]*_S[5]) + gamma*_S[1];
+  ret(2, 3) = alpha*_S[5] + beta*(_S[0]*_S[4] - _S[1]*_S[3]) + gamma*_S[2];
+
+  return ret;
+}
+
+//==============================================================================
+// Benchmark driver
+//==============================================================================
+
+/// Elapsed time of the last benchmark in nanoseconds per call
+static double gNanoSecondsPerCall = 0.0;
+
+/// Accumulates every result so that the compiler cannot drop the calls
+static double gChecksum = 0.0;
+
+//==============================================================================
+void printRow(const std::string& _name, double _genericTime, double _time)
+{
+  std::cout << "  " << std::left << std::setw(22) << _name << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << _genericTime
+            << std::setw(12) << _time
+            << std::setw(10) << _genericTime / _time << "x" << std::endl;
+}
+
+//==============================================================================
+// Time _numIterations evaluations of _EXPR, where op indexes the operands
+#define DART_BENCHMARK(_EXPR)                                                  \
+  {                                                                            \
+    common::Timer timer;                                                       \
+    timer.start();                                                             \
+    for (int iter = 0; iter < _numIterations; ++iter)                          \
+    {                                                                          \
+      const Eigen::Vector6d& op = _ops[iter % NUM_OPERANDS];                   \
+      _EXPR;                                                                   \
+    }                                                                          \
+    timer.stop();                                                              \
+    gNanoSecondsPerCall = timer.getLastElapsedTime() * 1e9 / _numIterations;   \
+  }
+
+typedef std::vector<Eigen::Vector6d, Eigen::aligned_allocator<Eigen::Vector6d> >
+    OperandList;
+
+//==============================================================================
+void runMathBenchmarks(const OperandList& _ops, int _numIterations)
+{
+  double genericTime;
+  Eigen::Matrix3d res = Eigen::Matrix3d::Zero();
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+
+  std::cout << "  function                generic[ns]    fast[ns]   speedup"
+            << std::endl;
+
+  DART_BENCHMARK(res += genericExpMapRot(op.head<3>()));
+  genericTime = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::expMapRot(op.head<3>()));
+  printRow("expMapRot", genericTime, gNanoSecondsPerCall);
+
+  DART_BENCHMARK(res += genericExpMapJac(op.head<3>()));
+  genericTime = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::expMapJac(op.head<3>()));
+  printRow("expMapJac", genericTime, gNanoSecondsPerCall);
+
+  DART_BENCHMARK(res += genericExpMapJacDot(op.head<3>(), op.tail<3>()));
+  genericTime = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::expMapJacDot(op.head<3>(), op.tail<3>()));
+  printRow("expMapJacDot", genericTime, gNanoSecondsPerCall);
+
+  DART_BENCHMARK(T = T * genericExpMap(op));
+  genericTime = gNanoSecondsPerCall;
+  DART_BENCHMARK(T = T * math::expMap(op));
+  printRow("expMap", genericTime, gNanoSecondsPerCall);
+
+  gChecksum += res.sum() + T.matrix().sum();
+}
+
+//==============================================================================
+void runAtlasBenchmarks(dynamics::Skeleton* _atlas, int _numIterations)
+{
+  const int dof = _atlas->getNumGenCoords();
+  const int numSteps = std::max(1, _numIterations / 100);
+  const Eigen::VectorXd q0 = _atlas->getConfigs();
+
+  std::vector<Eigen::VectorXd> configs(NUM_OPERANDS);
+  for (size_t i = 0; i < configs.size(); ++i)
+    configs[i] = q0 + 0.1 * Eigen::VectorXd::Random(dof);
+
+  common::Timer timer;
+
+  timer.start();
+  for (int i = 0; i < numSteps; ++i)
+  {
+    _atlas->setConfigs(configs[i % NUM_OPERANDS], true, true, true);
+    gChecksum += _atlas->getBodyNode(0)->getWorldTransform()(0, 3);
+  }
+  timer.stop();
+  std::cout << "  forward kinematics   "
+            << std::setw(12) << timer.getLastElapsedTime() * 1e6 / numSteps
+            << " us/step" << std::endl;
+
+  _atlas->setGenVels(Eigen::VectorXd::Random(dof), false, false);
+  timer.start();
+  for (int i = 0; i < numSteps; ++i)
+  {
+    _atlas->integrateConfigs(1e-3);
+    _atlas->computeForwardKinematics(true, false, false);
+  }
+  timer.stop();
+  gChecksum += _atlas->getConfigs().sum();
+  std::cout << "  integrate + transform"
+            << std::setw(12) << timer.getLastElapsedTime() * 1e6 / numSteps
+            << " us/step" << std::endl;
+
+  _atlas->setConfigs(q0);
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  int numIterations = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  if (numIterations < 1)
+    numIterations = 1;
+
+  // Operands at small, moderate and large rotation angles
+  OperandList ops(NUM_OPERANDS);
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    ops[i] = Eigen::Vector6d::Random();
+    ops[i].head<3>() *= std::pow(10.0, -static_cast<double>(i % 4));
+  }
+
+  double maxError = 0.0;
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    const Eigen::Vector3d w = ops[i].head<3>();
+    const Eigen::Vector3d v = ops[i].tail<3>();
+    maxError = std::max(maxError, (math::expMapRot(w)
+                                   - genericExpMapRot(w)).norm());
+    maxError = std::max(maxError, (math::expMapJac(w)
+                                   - genericExpMapJac(w)).norm());
+    maxError = std::max(maxError, (math::expMapJacDot(w, v)
+                                   - genericExpMapJacDot(w, v)).norm());
+  }
+
+  std::cout << numIterations << " iterations, max difference "
+            << std::scientific << std::setprecision(2) << maxError << std::endl;
+
+  runMathBenchmarks(ops, numIterations);
+
+  const std::string fileName
+      = (argc > 2) ? argv[2] : DART_DATA_PATH"sdf/atlas/atlas_v3_no_head.sdf";
+  dynamics::Skeleton* atlas = utils::SdfParser::readSkeleton(fileName);
+  if (atlas == NULL)
+  {
+    std::cout << "Failed to load [" << fileName << "]" << std::endl;
+    return 1;
+  }
+  atlas->init();
+
+  std::cout << "Atlas robot (" << atlas->getNumGenCoords() << " dofs)"
+            << std::endl;
+  runAtlasBenchmarks(atlas, numIterations);
+
+  std::cout << "(checksum " << std::scientific << gChecksum << ")"
+            << std::endl;
+
+  delete atlas;
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Simulates the double pendulum with a free-floating base of
+// apps/doublePendulumWithBase with the explicit Euler, semi-implicit Euler,
+// RK4 and variational integrators and reports the drift of the total energy.
+// The ground and the other pendulums are removed so that no contacts occur
+// and the exact motion conserves the energy. The time step of every
+// integrator is chosen so that all runs take about the same wall-clock time
+// as the variational integrator at the reference time step.
+//
+// Usage:
+//   energyDriftBenchmark [timeStep] [duration]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "dart/common/Timer.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/integration/EulerIntegrator.h"
+#include "dart/integration/RK4Integrator.h"
+#include "dart/simulation/World.h"
+#include "dart/utils/Paths.h"
+#include "dart/utils/SkelParser.h"
+
+using namespace dart;
+using namespace dart::dynamics;
+
+/// Number of steps used to measure the cost of a step of each integrator
+#define ENERGY_DRIFT_CALIBRATION_STEPS 200
+
+//==============================================================================
+enum IntegratorType
+{
+  EXPLICIT_EULER,
+  SEMI_IMPLICIT_EULER,
+  RK4,
+  VARIATIONAL
+};
+
+//==============================================================================
+struct DriftResult
+{
+  DriftResult()
+    : timeStep(0.0), numSteps(0), wallTime(0.0), maxDrift(0.0),
+      finalDrift(0.0), iterations(0.0) {}
+
+  double timeStep;
+  int numSteps;
+  double wallTime;
+  double maxDrift;
+  double finalDrift;
+  double iterations;
+};
+
+//==============================================================================
+static simulation::World* createWorld(double _timeStep, IntegratorType _type)
+{
+  simulation::World* world = utils::SkelParser::readWorld(
+      DART_DATA_PATH"/skel/test/double_pendulum_with_base.skel");
+  assert(world != NULL);
+
+  // Keep the first double pendulum only
+  Skeleton* pendulum = world->getSkeleton(1);
+  while (world->getNumSkeletons() > 1)
+  {
+    Skeleton* skel = world->getSkeleton(0);
+    world->removeSkeleton(skel == pendulum ? world->getSkeleton(1) : skel);
+  }
+
+  // The base floats freely, and gravity does not change the relative motion of
+  // a free-falling system. Turn it off to keep the energy at the scale of the
+  // swinging links.
+  world->setGravity(Eigen::Vector3d::Zero());
+  world->setTimeStep(_timeStep);
+
+  // Swing the links and spin the base
+  Eigen::VectorXd genVels = Eigen::VectorXd::Zero(pendulum->getNumGenCoords());
+  genVels[0] = 0.5;
+  genVels[6] = 3.0;
+  genVels[7] = -4.0;
+  pendulum->setGenVels(genVels, true, false);
+
+  pendulum->setVariationalIntegration(_type == VARIATIONAL);
+
+  return world;
+}
+
+//==============================================================================
+static double getEnergy(simulation::World* _world)
+{
+  Skeleton* pendulum = _world->getSkeleton(0);
+  pendulum->computeForwardKinematics(true, true, false);
+  return pendulum->getKineticEnergy() + pendulum->getPotentialEnergy();
+}
+
+//==============================================================================
+static void step(simulation::World* _world,
+                 integration::Integrator* _integrator)
+{
+  if (_integrator)
+    _integrator->integrate(_world, _world->getTimeStep());
+  else
+    _world->step();
+}
+
+//==============================================================================
+static integration::Integrator* createIntegrator(IntegratorType _type)
+{
+  if (_type == EXPLICIT_EULER)
+    return new integration::EulerIntegrator();
+  else if (_type == RK4)
+    return new integration::RK4Integrator();
+
+  // World::step() integrates with semi-implicit Euler or, for skeletons with
+  // variational integration, with the variational integrator
+  return NULL;
+}
+
+//==============================================================================
+static double measureStepCost(double _timeStep, IntegratorType _type)
+{
+  simulation::World* world = createWorld(_timeStep, _type);
+  integration::Integrator* integrator = createIntegrator(_type);
+
+  common::Timer timer;
+  timer.start();
+  for (int i = 0; i < ENERGY_DRIFT_CALIBRATION_STEPS; ++i)
+    step(world, integrator);
+  timer.stop();
+
+  delete integrator;
+  delete world;
+
+  return timer.getLastElapsedTime() / ENERGY_DRIFT_CALIBRATION_STEPS;
+}
+
+//==============================================================================
+static DriftResult simulate(double _timeStep, double _duration,
+                            IntegratorType _type)
+{
+  simulation::World* world = createWorld(_timeStep, _type);
+  integration::Integrator* integrator = createIntegrator(_type);
+  Skeleton* pendulum = world->getSkeleton(0);
+
+  DriftResult result;
+  result.timeStep = _timeStep;
+  result.numSteps = static_cast<int>(_duration / _timeStep + 0.5);
+
+  const double initialEnergy = getEnergy(world);
+  double drift = 0.0;
+
+  common::Timer timer;
+  for (int i = 0; i < result.numSteps; ++i)
+  {
+    timer.start();
+    step(world, integrator);
+    timer.stop();
+    result.wallTime += timer.getLastElapsedTime();
+
+    if (_type == VARIATIONAL)
+      result.iterations += pendulum->getVariationalSolverIterations();
+
+    drift = std::fabs(getEnergy(world) - initialEnergy);
+    result.maxDrift = std::max(result.maxDrift, drift);
+  }
+  result.finalDrift = drift;
+  result.iterations /= result.numSteps;
+
+  delete integrator;
+  delete world;
+
+  return result;
+}
+
+//==============================================================================
+static void printResult(const std::string& _name, const DriftResult& _result)
+{
+  std::cout << "  " << std::left << std::setw(15) << _name << std::right
+            << std::setprecision(3)
+            << std::setw(11) << _result.timeStep
+            << std::setw(9) << _result.numSteps
+            << std::setw(11) << _result.wallTime
+            << std::setw(14) << _result.maxDrift
+            << std::setw(14) << _result.finalDrift;
+  if (_result.iterations > 0.0)
+    std::cout << std::setw(8) << _result.iterations;
+  std::cout << std::endl;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  double timeStep = (argc > 1) ? std::atof(argv[1]) : 0.001;
+  double duration = (argc > 2) ? std::atof(argv[2]) : 20.0;
+
+  const IntegratorType types[]
+      = {EXPLICIT_EULER, SEMI_IMPLICIT_EULER, RK4, VARIATIONAL};
+  const char* names[]
+      = {"Euler", "semi-implicit", "RK4", "variational"};
+  const size_t numTypes = sizeof(types) / sizeof(types[0]);
+
+  // Equal wall-clock time: scale the time step by the cost of a step
+  double costs[numTypes];
+  for (size_t i = 0; i < numTypes; ++i)
+    costs[i] = measureStepCost(timeStep, types[i]);
+
+  std::cout << "double pendulum with base, " << duration << " s, "
+            << "reference time step " << timeStep << std::endl;
+  std::cout << "  integrator            dt    steps   time [s]"
+            << "  max |dE| [J]  end |dE| [J]   iters" << std::endl;
+
+  for (size_t i = 0; i < numTypes; ++i)
+  {
+    double equalCostTimeStep = timeStep * costs[i] / costs[numTypes - 1];
+    printResult(names[i], simulate(equalCostTimeStep, duration, types[i]));
+  }
+
+  return 0;
+}
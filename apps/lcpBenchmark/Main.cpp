@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Replays LCPs captured with ConstraintSolver::startLCPCapture() against the
+// Dantzig, PGS and Lemke solvers and reports time, iterations (PGS sweeps and
+// Lemke pivots) and complementarity error.
+//
+// Usage:
+//   lcpBenchmark [--repeat N] file.lcp ...
+//     Replay the given files
+//   lcpBenchmark --capture <dir> [numSteps]
+//     Simulate the cubes, atlasRobot and softCubes scenes headlessly and
+//     write <dir>/{cubes,atlasRobot,softCubes}.lcp
+//
+// No corpus is shipped, so capture one first.
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/Timer.h"
+#include "dart/constraint/AdaptiveLCPSolver.h"
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/constraint/LCPProblemFile.h"
+#include "dart/constraint/PGSLCPSolver.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/lcpsolver/Lemke.h"
+#include "dart/lcpsolver/lcp.h"
+#include "dart/math/Helpers.h"
+#include "dart/simulation/World.h"
+#include "dart/utils/Paths.h"
+#include "dart/utils/SkelParser.h"
+#include "dart/utils/sdf/SoftSdfParser.h"
+#include "dart/utils/urdf/DartLoader.h"
+
+using namespace dart;
+using namespace dart::constraint;
+
+/// Residual above which a solution is counted as a failure
+#define LCP_BENCHMARK_FAILURE_RESIDUAL 1e-3
+
+//==============================================================================
+struct SolverResult
+{
+  SolverResult()
+    : numProblems(0), numSkipped(0), numFailures(0), numIterations(0),
+      totalTime(0.0), sumResidual(0.0), maxResidual(0.0) {}
+
+  size_t numProblems;
+  size_t numSkipped;
+  size_t numFailures;
+  size_t numIterations;
+  double totalTime;
+  double sumResidual;
+  double maxResidual;
+  std::map<std::string, size_t> errors;
+};
+
+//==============================================================================
+static double computeResidual(const LCPProblem& _p, const Eigen::VectorXd& _x)
+{
+  // A is symmetric, so its column-major storage is also a valid row-major one
+  return AdaptiveLCPSolver::computeResidual(_p.b.size(), _p.b.size(),
+                                            _p.A.data(), _x.data(),
+                                            _p.b.data(), _p.lo.data(),
+                                            _p.hi.data(), _p.findex.data());
+}
+
+//==============================================================================
+static void record(SolverResult* _result, double _time, int _iterations,
+                   double _residual)
+{
+  _result->numProblems++;
+  _result->numIterations += _iterations;
+  _result->totalTime += _time;
+  _result->sumResidual += _residual;
+  _result->maxResidual = std::max(_result->maxResidual, _residual);
+  if (!(_residual <= LCP_BENCHMARK_FAILURE_RESIDUAL))
+    _result->numFailures++;
+}
+
+//==============================================================================
+/// Boxed LCP in the padded row-major layout that dSolveLCP and solvePGS use
+struct PaddedLCP
+{
+  void set(const LCPProblem& _p)
+  {
+    n = _p.b.size();
+    nSkip = dPAD(n);
+    A.assign(n * nSkip, 0.0);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+        A[nSkip * i + j] = _p.A(i, j);
+    b.assign(_p.b.data(), _p.b.data() + n);
+    lo.assign(_p.lo.data(), _p.lo.data() + n);
+    hi.assign(_p.hi.data(), _p.hi.data() + n);
+    findex.assign(_p.findex.data(), _p.findex.data() + n);
+    x.assign(n, 0.0);
+    w.assign(n, 0.0);
+  }
+
+  int n;
+  int nSkip;
+  std::vector<double> A;
+  std::vector<double> b;
+  std::vector<double> lo;
+  std::vector<double> hi;
+  std::vector<int> findex;
+  std::vector<double> x;
+  std::vector<double> w;
+};
+
+//==============================================================================
+static void runDantzig(const LCPProblem& _p, int _repeat,
+                       SolverResult* _result)
+{
+  PaddedLCP lcp;
+  double time = 0.0;
+
+  for (int r = 0; r < _repeat; ++r)
+  {
+    lcp.set(_p);
+    double start = common::Timer::getWallTime();
+    dSolveLCP(lcp.n, &lcp.A[0], &lcp.x[0], &lcp.b[0], &lcp.w[0], 0,
+              &lcp.lo[0], &lcp.hi[0], &lcp.findex[0]);
+    time += common::Timer::getWallTime() - start;
+  }
+
+  Eigen::VectorXd x = Eigen::Map<Eigen::VectorXd>(&lcp.x[0], lcp.n);
+  record(_result, time / _repeat, 0, computeResidual(_p, x));
+}
+
+//==============================================================================
+static void runPGS(const LCPProblem& _p, int _repeat, SolverResult* _result)
+{
+  PaddedLCP lcp;
+  PGSOption option;
+  option.setDefault();
+  int iterations = 0;
+  double time = 0.0;
+
+  for (int r = 0; r < _repeat; ++r)
+  {
+    lcp.set(_p);
+    double start = common::Timer::getWallTime();
+    solvePGS(lcp.n, lcp.nSkip, 0, &lcp.A[0], &lcp.x[0], &lcp.b[0],
+             &lcp.lo[0], &lcp.hi[0], &lcp.findex[0], &option, &iterations);
+    time += common::Timer::getWallTime() - start;
+  }
+
+  Eigen::VectorXd x = Eigen::Map<Eigen::VectorXd>(&lcp.x[0], lcp.n);
+  record(_result, time / _repeat, iterations, computeResidual(_p, x));
+}
+
+//==============================================================================
+/// Convert the boxed LCP to the standard form w = M * z + q, z >= 0, w >= 0,
+/// z'w = 0 that Lemke solves. Friction rows x_i are split into
+/// x_i = beta+ - beta- with one extra multiplier per row enforcing
+/// beta+ + beta- <= mu * x_normal. The boxed solution is x = P * z. Return
+/// false if a row has bounds that are neither [0, inf] nor [-inf, 0].
+static bool convertToStandardLCP(const LCPProblem& _p, Eigen::MatrixXd* _M,
+                                 Eigen::VectorXd* _q, Eigen::MatrixXd* _P)
+{
+  const int n = _p.b.size();
+  const double inf = 1e+20;
+
+  std::vector<int> normalRows;
+  std::vector<int> frictionRows;
+  std::vector<double> signs;
+  std::vector<int> zIndex(n, -1);
+
+  for (int i = 0; i < n; ++i)
+  {
+    if (_p.findex[i] >= 0)
+    {
+      frictionRows.push_back(i);
+    }
+    else if (_p.lo[i] == 0.0 && _p.hi[i] >= inf)
+    {
+      zIndex[i] = normalRows.size();
+      normalRows.push_back(i);
+      signs.push_back(1.0);
+    }
+    else if (_p.lo[i] <= -inf && _p.hi[i] == 0.0)
+    {
+      zIndex[i] = normalRows.size();
+      normalRows.push_back(i);
+      signs.push_back(-1.0);
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  const int nN = normalRows.size();
+  const int nF = frictionRows.size();
+  const int m = nN + 3 * nF;
+
+  // x = P * z and the rows of G map the boxed slack A * x - b to z's slack
+  Eigen::MatrixXd G = Eigen::MatrixXd::Zero(m, n);
+  *_P = Eigen::MatrixXd::Zero(n, m);
+  for (int k = 0; k < nN; ++k)
+  {
+    (*_P)(normalRows[k], k) = signs[k];
+    G(k, normalRows[k]) = signs[k];
+  }
+  for (int k = 0; k < nF; ++k)
+  {
+    (*_P)(frictionRows[k], nN + k) = 1.0;
+    (*_P)(frictionRows[k], nN + nF + k) = -1.0;
+    G(nN + k, frictionRows[k]) = 1.0;
+    G(nN + nF + k, frictionRows[k]) = -1.0;
+  }
+
+  *_M = G * _p.A * (*_P);
+  *_q = -G * _p.b;
+
+  for (int k = 0; k < nF; ++k)
+  {
+    const int row = frictionRows[k];
+    const int normal = zIndex[_p.findex[row]];
+    if (normal < 0)
+      return false;
+
+    const int lambda = nN + 2 * nF + k;
+    (*_M)(nN + k, lambda) = 1.0;
+    (*_M)(nN + nF + k, lambda) = 1.0;
+    (*_M)(lambda, normal) = std::fabs(_p.hi[row]);
+    (*_M)(lambda, nN + k) = -1.0;
+    (*_M)(lambda, nN + nF + k) = -1.0;
+  }
+
+  return true;
+}
+
+//==============================================================================
+static void runLemke(const LCPProblem& _p, int _repeat,
+                     lcpsolver::LemkeSolver* _solver, SolverResult* _result)
+{
+  Eigen::MatrixXd M;
+  Eigen::VectorXd q;
+  Eigen::MatrixXd P;
+  if (!convertToStandardLCP(_p, &M, &q, &P))
+  {
+    _result->numSkipped++;
+    return;
+  }
+
+  Eigen::VectorXd z;
+  int err = 0;
+  double time = 0.0;
+
+  for (int r = 0; r < _repeat; ++r)
+  {
+    double start = common::Timer::getWallTime();
+    err = _solver->solve(M, q, &z);
+    time += common::Timer::getWallTime() - start;
+  }
+
+  double residual = std::numeric_limits<double>::infinity();
+  if (err == lcpsolver::LEMKE_SUCCESS)
+    residual = computeResidual(_p, P * z);
+  else
+    _result->errors[lcpsolver::LemkeSolver::getErrorString(err)]++;
+
+  record(_result, time / _repeat, _solver->getNumPivots(), residual);
+}
+
+//==============================================================================
+static void printResult(const std::string& _name, const SolverResult& _result,
+                        bool _hasIterations)
+{
+  std::cout << "  " << std::left << std::setw(8) << _name << std::right;
+
+  if (_result.numProblems == 0)
+  {
+    std::cout << "  no problems solved (" << _result.numSkipped
+              << " skipped)" << std::endl;
+    return;
+  }
+
+  const double num = static_cast<double>(_result.numProblems);
+
+  std::cout << std::setw(8) << _result.numProblems
+            << std::setw(8) << _result.numSkipped
+            << std::setw(14) << std::setprecision(4)
+            << 1e+6 * _result.totalTime / num
+            << std::setw(14) << 1e+3 * _result.totalTime;
+  if (_hasIterations)
+    std::cout << std::setw(10) << std::setprecision(3)
+              << _result.numIterations / num;
+  else
+    std::cout << std::setw(10) << "-";
+  std::cout << std::setw(14) << std::setprecision(3)
+            << _result.sumResidual / num
+            << std::setw(14) << _result.maxResidual
+            << std::setw(8) << _result.numFailures << std::endl;
+
+  for (std::map<std::string, size_t>::const_iterator it
+       = _result.errors.begin(); it != _result.errors.end(); ++it)
+  {
+    std::cout << "            " << it->second << " x " << it->first
+              << std::endl;
+  }
+}
+
+//==============================================================================
+static bool replay(const std::string& _fileName, int _repeat)
+{
+  LCPProblemReader reader;
+  if (!reader.open(_fileName))
+    return false;
+
+  std::vector<LCPProblem> problems = reader.readAll();
+
+  size_t maxDim = 0;
+  double sumDim = 0.0;
+  SolverResult dantzig;
+  SolverResult pgs;
+  SolverResult lemke;
+  lcpsolver::LemkeSolver lemkeSolver;
+
+  for (size_t i = 0; i < problems.size(); ++i)
+  {
+    const LCPProblem& p = problems[i];
+    maxDim = std::max(maxDim, static_cast<size_t>(p.b.size()));
+    sumDim += p.b.size();
+
+    runDantzig(p, _repeat, &dantzig);
+    runPGS(p, _repeat, &pgs);
+    runLemke(p, _repeat, &lemkeSolver, &lemke);
+  }
+
+  std::cout << _fileName << ": " << problems.size() << " problems, mean dim "
+            << (problems.empty() ? 0.0 : sumDim / problems.size())
+            << ", max dim " << maxDim << std::endl;
+  std::cout << "  solver      solved skipped  mean [us]    total [ms]"
+            << "     iters mean residual  max residual   fails" << std::endl;
+  printResult("Dantzig", dantzig, false);
+  printResult("PGS", pgs, true);
+  printResult("Lemke", lemke, true);
+  std::cout << std::endl;
+
+  return true;
+}
+
+//==============================================================================
+static void capture(simulation::World* _world, const std::string& _fileName,
+                    int _numSteps)
+{
+  constraint::ConstraintSolver* solver = _world->getConstraintSolver();
+  if (!solver->startLCPCapture(_fileName))
+    return;
+
+  for (int i = 0; i < _numSteps; ++i)
+    _world->step();
+
+  solver->stopLCPCapture();
+  std::cout << "Wrote " << _fileName << std::endl;
+}
+
+//==============================================================================
+static void captureCorpus(const std::string& _dir, int _numSteps)
+{
+  // apps/cubes
+  simulation::World* world
+      = utils::SkelParser::readWorld(DART_DATA_PATH"skel/cubes.skel");
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+  capture(world, _dir + "/cubes.lcp", _numSteps);
+  delete world;
+
+  // apps/atlasRobot (without the controller, the robot falls on the ground)
+  world = new simulation::World;
+  utils::DartLoader urdfLoader;
+  dynamics::Skeleton* ground
+      = urdfLoader.parseSkeleton(DART_DATA_PATH"sdf/atlas/ground.urdf");
+  dynamics::Skeleton* atlas = utils::SoftSdfParser::readSkeleton(
+        DART_DATA_PATH"sdf/atlas/atlas_v3_no_head_soft_feet.sdf");
+  world->addSkeleton(atlas);
+  world->addSkeleton(ground);
+  Eigen::VectorXd q = atlas->getConfigs();
+  q[0] = -0.5 * DART_PI;
+  atlas->setConfigs(q, true, true, false);
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+  capture(world, _dir + "/atlasRobot.lcp", _numSteps);
+  delete world;
+
+  // apps/softCubes
+  world = utils::SkelParser::readWorld(DART_DATA_PATH"skel/soft_cubes.skel");
+  capture(world, _dir + "/softCubes.lcp", _numSteps);
+  delete world;
+}
+
+//==============================================================================
+static void printUsage(const char* _program)
+{
+  std::cerr << "Usage:\n"
+            << "  " << _program << " [--repeat N] file.lcp ...\n"
+            << "      Replay captured LCPs\n"
+            << "  " << _program << " --capture <dir> [numSteps]\n"
+            << "      Capture the cubes, atlasRobot and softCubes scenes to "
+            << "<dir>/*.lcp\n"
+            << "No LCP corpus is shipped with DART. Capture one with --capture "
+            << "and replay the files it writes." << std::endl;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  int repeat = 10;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+    {
+      int numSteps = (i + 2 < argc) ? std::atoi(argv[i + 2]) : 1000;
+      captureCorpus(argv[i + 1], numSteps);
+      return 0;
+    }
+    else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+    {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    }
+    else
+    {
+      files.push_back(argv[i]);
+    }
+  }
+
+  if (files.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  bool succeeded = true;
+  for (size_t i = 0; i < files.size(); ++i)
+    succeeded = replay(files[i], repeat) && succeeded;
+
+  return succeeded ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Microbenchmarks of the spatial algebra functions in dart/math/Geometry.
+// Each function is timed as the generic Eigen expression it replaced, as the
+// function returning by value and as the in-place overload.
+//
+// Usage:
+//   spatialBenchmark [numIterations]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/Timer.h"
+#include "dart/math/Geometry.h"
+#include "dart/math/MathTypes.h"
+
+using namespace dart;
+
+/// Number of precomputed random operands that the benchmarks cycle through
+#define NUM_OPERANDS 64
+
+/// Number of columns of the benchmarked Jacobians
+#define JACOBIAN_COLS 7
+
+//==============================================================================
+// Generic Eigen expressions used by dart/math/Geometry before the hand-expanded
+// kernels
+//==============================================================================
+
+//==============================================================================
+Eigen::Vector6d genericAdT(const Eigen::Isometry3d& _T,
+                           const Eigen::Vector6d& _V)
+{
+  Eigen::Vector6d res;
+  res.head<3>().noalias() = _T.linear() * _V.head<3>();
+  res.tail<3>().noalias() = _T.linear() * _V.tail<3>()
+                            + _T.translation().cross(res.head<3>());
+  return res;
+}
+
+//==============================================================================
+Eigen::Vector6d genericAdInvT(const Eigen::Isometry3d& _T,
+                              const Eigen::Vector6d& _V)
+{
+  Eigen::Vector6d res;
+  res.head<3>().noalias() = _T.linear().transpose() * _V.head<3>();
+  res.tail<3>().noalias()
+      = _T.linear().transpose()
+        * (_V.tail<3>() + _V.head<3>().cross(_T.translation()));
+  return res;
+}
+
+//==============================================================================
+Eigen::Vector6d genericDAdInvT(const Eigen::Isometry3d& _T,
+                               const Eigen::Vector6d& _F)
+{
+  Eigen::Vector6d res;
+  res.tail<3>().noalias() = _T.linear() * _F.tail<3>();
+  res.head<3>().noalias() = _T.linear() * _F.head<3>();
+  res.head<3>() += _T.translation().cross(res.tail<3>());
+  return res;
+}
+
+//==============================================================================
+Eigen::Vector6d genericAd(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y)
+{
+  Eigen::Vector6d res;
+  res.head<3>() = _X.head<3>().cross(_Y.head<3>());
+  res.tail<3>() = _X.head<3>().cross(_Y.tail<3>())
+                  + _X.tail<3>().cross(_Y.head<3>());
+  return res;
+}
+
+//==============================================================================
+Eigen::Vector6d genericDad(const Eigen::Vector6d& _s, const Eigen::Vector6d& _t)
+{
+  Eigen::Vector6d res;
+  res.head<3>() = _t.head<3>().cross(_s.head<3>())
+                  + _t.tail<3>().cross(_s.tail<3>());
+  res.tail<3>() = _t.tail<3>().cross(_s.head<3>());
+  return res;
+}
+
+//==============================================================================
+math::Jacobian genericAdInvTJac(const Eigen::Isometry3d& _T,
+                                const math::Jacobian& _J)
+{
+  math::Jacobian res = math::Jacobian::Zero(6, _J.cols());
+  for (int i = 0; i < _J.cols(); ++i)
+    res.col(i) = genericAdInvT(_T, _J.col(i));
+  return res;
+}
+
+//==============================================================================
+math::Inertia genericTransformInertia(const Eigen::Isometry3d& _T,
+                                      const math::Inertia& _I)
+{
+  Eigen::Matrix6d AdTMatrix = Eigen::Matrix6d::Zero();
+  AdTMatrix.topLeftCorner<3, 3>() = _T.linear();
+  AdTMatrix.bottomRightCorner<3, 3>() = _T.linear();
+  AdTMatrix.bottomLeftCorner<3, 3>()
+      = math::makeSkewSymmetric(_T.translation()) * _T.linear();
+  return AdTMatrix.transpose() * _I * AdTMatrix;
+}
+
+//==============================================================================
+// Benchmark driver
+//==============================================================================
+
+//==============================================================================
+struct Operands
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  Eigen::Isometry3d T;
+  Eigen::Vector6d V;
+  Eigen::Vector6d W;
+  math::Jacobian J;
+  math::Inertia I;
+};
+
+typedef std::vector<Operands, Eigen::aligned_allocator<Operands> > OperandList;
+
+/// Elapsed time of the last benchmark in nanoseconds per call
+static double gNanoSecondsPerCall = 0.0;
+
+/// Accumulates every result so that the compiler cannot drop the calls
+static double gChecksum = 0.0;
+
+//==============================================================================
+void printRow(const std::string& _name, const double* _times)
+{
+  std::cout << "  " << std::left << std::setw(18) << _name << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << _times[0]
+            << std::setw(12) << _times[1]
+            << std::setw(12) << _times[2]
+            << std::setw(10) << _times[0] / _times[2] << "x" << std::endl;
+}
+
+//==============================================================================
+// Time _numIterations evaluations of _EXPR, where i indexes the operands
+#define DART_BENCHMARK(_EXPR)                                                  \
+  {                                                                            \
+    common::Timer timer;                                                       \
+    timer.start();                                                             \
+    for (int iter = 0; iter < _numIterations; ++iter)                          \
+    {                                                                          \
+      const Operands& op = _ops[iter % NUM_OPERANDS];                          \
+      _EXPR;                                                                   \
+    }                                                                          \
+    timer.stop();                                                              \
+    gNanoSecondsPerCall = timer.getLastElapsedTime() * 1e9 / _numIterations;   \
+  }
+
+//==============================================================================
+void runBenchmarks(const OperandList& _ops, int _numIterations)
+{
+  double times[3];
+  Eigen::Vector6d res = Eigen::Vector6d::Zero();
+  math::Jacobian resJ(6, JACOBIAN_COLS);
+  math::Inertia resI = math::Inertia::Zero();
+
+  std::cout << "  function           generic[ns]   value[ns] inplace[ns]"
+            << "   speedup" << std::endl;
+
+  DART_BENCHMARK(res += genericAdT(op.T, op.V)); times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::AdT(op.T, op.V)); times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::AdT(op.T, op.V, &res); gChecksum += res[0]);
+  times[2] = gNanoSecondsPerCall;
+  printRow("AdT", times);
+
+  DART_BENCHMARK(res += genericAdInvT(op.T, op.V));
+  times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::AdInvT(op.T, op.V));
+  times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::AdInvT(op.T, op.V, &res); gChecksum += res[0]);
+  times[2] = gNanoSecondsPerCall;
+  printRow("AdInvT", times);
+
+  DART_BENCHMARK(res += genericDAdInvT(op.T, op.V));
+  times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::dAdInvT(op.T, op.V));
+  times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::dAdInvT(op.T, op.V, &res); gChecksum += res[0]);
+  times[2] = gNanoSecondsPerCall;
+  printRow("dAdInvT", times);
+
+  DART_BENCHMARK(res += genericAd(op.V, op.W)); times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::ad(op.V, op.W)); times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::ad(op.V, op.W, &res); gChecksum += res[0]);
+  times[2] = gNanoSecondsPerCall;
+  printRow("ad", times);
+
+  DART_BENCHMARK(res += genericDad(op.V, op.W)); times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(res += math::dad(op.V, op.W)); times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::dad(op.V, op.W, &res); gChecksum += res[0]);
+  times[2] = gNanoSecondsPerCall;
+  printRow("dad", times);
+
+  DART_BENCHMARK(gChecksum += genericAdInvTJac(op.T, op.J)(0, 0));
+  times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(gChecksum += math::AdInvTJac(op.T, op.J)(0, 0));
+  times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::AdInvTJac(op.T, op.J, &resJ); gChecksum += resJ(0, 0));
+  times[2] = gNanoSecondsPerCall;
+  printRow("AdInvTJac", times);
+
+  DART_BENCHMARK(resI += genericTransformInertia(op.T, op.I));
+  times[0] = gNanoSecondsPerCall;
+  DART_BENCHMARK(resI += math::transformInertia(op.T, op.I));
+  times[1] = gNanoSecondsPerCall;
+  DART_BENCHMARK(math::transformInertia(op.T, op.I, &resI);
+                 gChecksum += resI(0, 0));
+  times[2] = gNanoSecondsPerCall;
+  printRow("transformInertia", times);
+
+  gChecksum += res.sum() + resI.sum();
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  int numIterations = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  if (numIterations < 1)
+    numIterations = 1;
+
+  OperandList ops(NUM_OPERANDS);
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    ops[i].T = math::expMap(Eigen::Vector6d::Random());
+    ops[i].V = Eigen::Vector6d::Random();
+    ops[i].W = Eigen::Vector6d::Random();
+    ops[i].J = math::Jacobian::Random(6, JACOBIAN_COLS);
+    Eigen::Matrix6d A = Eigen::Matrix6d::Random();
+    ops[i].I = A * A.transpose();
+  }
+
+  // Sanity check of the results before timing them
+  double maxError = 0.0;
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    const Operands& op = ops[i];
+    maxError = std::max(maxError, (math::AdT(op.T, op.V)
+                                   - genericAdT(op.T, op.V)).norm());
+    maxError = std::max(maxError, (math::AdInvT(op.T, op.V)
+                                   - genericAdInvT(op.T, op.V)).norm());
+    maxError = std::max(maxError, (math::dAdInvT(op.T, op.V)
+                                   - genericDAdInvT(op.T, op.V)).norm());
+    maxError = std::max(maxError, (math::ad(op.V, op.W)
+                                   - genericAd(op.V, op.W)).norm());
+    maxError = std::max(maxError, (math::dad(op.V, op.W)
+                                   - genericDad(op.V, op.W)).norm());
+    maxError = std::max(maxError, (math::AdInvTJac(op.T, op.J)
+                                   - genericAdInvTJac(op.T, op.J)).norm());
+    maxError = std::max(maxError, (math::transformInertia(op.T, op.I)
+                                   - genericTransformInertia(op.T, op.I))
+                                  .norm());
+  }
+
+  std::cout << numIterations << " iterations, max error " << std::scientific
+            << std::setprecision(2) << maxError << std::endl;
+
+  runBenchmarks(ops, numIterations);
+
+  std::cout << "(checksum " << std::scientific << gChecksum << ")"
+            << std::endl;
+
+  return 0;
+}
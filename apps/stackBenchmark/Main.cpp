@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Simulates a vertical stack of boxes resting on the ground at several time
+// steps, once with Baumgarte stabilization and once with split impulse, and
+// reports whether the stack stays standing, the remaining penetration and the
+// kinetic energy left in the stack.
+//
+// Usage:
+//   stackBenchmark [numBoxes] [duration]
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/common/Timer.h"
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/constraint/ContactConstraint.h"
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/BoxShape.h"
+#include "dart/dynamics/FreeJoint.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/dynamics/WeldJoint.h"
+#include "dart/math/Geometry.h"
+#include "dart/simulation/World.h"
+
+using namespace dart;
+using namespace dart::dynamics;
+
+/// Edge length of the stacked boxes
+#define STACK_BOX_SIZE 0.1
+
+//==============================================================================
+struct StackResult
+{
+  StackResult()
+    : stable(true), maxPenetration(0.0), maxKineticEnergy(0.0),
+      topDrift(0.0), timePerStep(0.0) {}
+
+  bool stable;
+  double maxPenetration;
+  double maxKineticEnergy;
+  double topDrift;
+  double timePerStep;
+};
+
+//==============================================================================
+static Skeleton* createBox(const Eigen::Vector3d& _size,
+                           const Eigen::Vector3d& _position, bool _mobile)
+{
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  T.translation() = _position;
+
+  Joint* joint;
+  if (_mobile)
+  {
+    joint = new FreeJoint("joint");
+    joint->setConfigs(math::logMap(T));
+  }
+  else
+  {
+    joint = new WeldJoint("joint");
+    joint->setTransformFromParentBodyNode(T);
+  }
+
+  BoxShape* shape = new BoxShape(_size);
+
+  BodyNode* bodyNode = new BodyNode("box");
+  bodyNode->addVisualizationShape(shape);
+  bodyNode->addCollisionShape(shape);
+  bodyNode->setMass(1.0);
+  bodyNode->setParentJoint(joint);
+
+  Skeleton* skeleton = new Skeleton();
+  skeleton->addBodyNode(bodyNode);
+  skeleton->setMobile(_mobile);
+
+  return skeleton;
+}
+
+//==============================================================================
+static StackResult simulateStack(int _numBoxes, double _timeStep,
+                                 double _duration, bool _splitImpulse)
+{
+  constraint::ContactConstraint::setSplitImpulseEnabled(_splitImpulse);
+
+  simulation::World* world = new simulation::World();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+  world->setTimeStep(_timeStep);
+  world->getConstraintSolver()->setCollisionDetector(
+        new collision::DARTCollisionDetector());
+
+  world->addSkeleton(createBox(Eigen::Vector3d(10.0, 0.1, 10.0),
+                               Eigen::Vector3d(0.0, -0.05, 0.0), false));
+
+  std::vector<Skeleton*> boxes;
+  for (int i = 0; i < _numBoxes; ++i)
+  {
+    // Start slightly apart so the stack has to settle
+    Eigen::Vector3d position(0.0, (i + 0.5) * STACK_BOX_SIZE * 1.001, 0.0);
+    boxes.push_back(createBox(Eigen::Vector3d::Constant(STACK_BOX_SIZE),
+                              position, true));
+    world->addSkeleton(boxes.back());
+  }
+
+  const Eigen::Vector3d initialTop = boxes.back()->getWorldCOM();
+  const int numSteps = static_cast<int>(_duration / _timeStep);
+  collision::CollisionDetector* detector
+      = world->getConstraintSolver()->getCollisionDetector();
+
+  StackResult result;
+  common::Timer timer;
+  timer.start();
+  for (int i = 0; i < numSteps; ++i)
+  {
+    world->step();
+
+    // Measure only after the stack had a second to settle
+    if (world->getTime() < 1.0)
+      continue;
+
+    for (size_t j = 0; j < detector->getNumContacts(); ++j)
+    {
+      result.maxPenetration = std::max(
+            result.maxPenetration, detector->getContact(j).penetrationDepth);
+    }
+
+    double kineticEnergy = 0.0;
+    for (size_t j = 0; j < boxes.size(); ++j)
+      kineticEnergy += boxes[j]->getKineticEnergy();
+    result.maxKineticEnergy = std::max(result.maxKineticEnergy,
+                                       kineticEnergy);
+  }
+  timer.stop();
+
+  const Eigen::Vector3d top = boxes.back()->getWorldCOM();
+  result.topDrift = (top - initialTop).norm();
+  result.timePerStep = 1e+3 * timer.getLastElapsedTime() / numSteps;
+
+  // The top box must still be on top of the stack
+  if (!(std::fabs(top[0]) < 0.5 * STACK_BOX_SIZE
+        && std::fabs(top[2]) < 0.5 * STACK_BOX_SIZE
+        && std::fabs(top[1] - initialTop[1]) < 0.5 * STACK_BOX_SIZE))
+  {
+    result.stable = false;
+  }
+
+  delete world;
+
+  return result;
+}
+
+//==============================================================================
+static void printResult(const std::string& _name, double _timeStep,
+                        const StackResult& _result)
+{
+  std::cout << "  " << std::left << std::setw(10) << _name << std::right
+            << std::setw(8) << _timeStep
+            << std::setw(8) << (_result.stable ? "yes" : "no")
+            << std::setw(14) << std::setprecision(3) << _result.maxPenetration
+            << std::setw(14) << _result.maxKineticEnergy
+            << std::setw(12) << _result.topDrift
+            << std::setw(12) << _result.timePerStep << std::endl;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  int numBoxes = (argc > 1) ? std::atoi(argv[1]) : 10;
+  double duration = (argc > 2) ? std::atof(argv[2]) : 5.0;
+
+  const double timeSteps[] = {0.001, 0.002, 0.005, 0.01, 0.02};
+  const size_t numTimeSteps = sizeof(timeSteps) / sizeof(timeSteps[0]);
+
+  std::cout << numBoxes << " boxes, " << duration << " s" << std::endl;
+  std::cout << "  mode            dt  stable  max pen. [m]  max KE [J]"
+            << "   drift [m]   step [ms]" << std::endl;
+
+  for (size_t i = 0; i < numTimeSteps; ++i)
+  {
+    StackResult baumgarte = simulateStack(numBoxes, timeSteps[i], duration,
+                                          false);
+    printResult("Baumgarte", timeSteps[i], baumgarte);
+
+    StackResult split = simulateStack(numBoxes, timeSteps[i], duration, true);
+    printResult("split", timeSteps[i], split);
+  }
+
+  constraint::ContactConstraint::setSplitImpulseEnabled(false);
+
+  return 0;
+}
@@ -142,8 +142,7 @@ FCLMeshCollisionNode::FCLMeshCollisionNode(dynamics::BodyNode* _bodyNode)
       case dynamics::Shape::SOFT_MESH:
       {
         SoftMeshShape* softMeshShape = static_cast<SoftMeshShape*>(shape);
-        mMeshes.push_back(createSoftMesh<fcl::OBBRSS>(
-                            softMeshShape->getAssimpMesh(), shapeT));
+        mMeshes.push_back(createSoftMesh<fcl::OBBRSS>(softMeshShape, shapeT));
         break;
       }
     }
@@ -322,24 +321,16 @@ void FCLMeshCollisionNode::updateShape()
       case dynamics::Shape::SOFT_MESH:
       {
         SoftMeshShape* softMeshShape = static_cast<SoftMeshShape*>(shape);
-        const aiMesh* mesh = softMeshShape->getAssimpMesh();
-        softMeshShape->update();
+        const Eigen::Matrix<double, Eigen::Dynamic, 3>& vertices
+            = softMeshShape->getVertices();
 
+        // Refit the shared vertices in place; the triangles are unchanged.
         mMeshes[i]->beginUpdateModel();
-
-        for (unsigned int j = 0; j < mesh->mNumFaces; j++)
+        for (int j = 0; j < vertices.rows(); j++)
         {
-          fcl::Vec3f vertices[3];
-          for (unsigned int k = 0; k < 3; k++)
-          {
-            const aiVector3D& vertex
-                = mesh->mVertices[mesh->mFaces[j].mIndices[k]];
-            vertices[k] = fcl::Vec3f(vertex.x, vertex.y, vertex.z);
-            vertices[k] = shapeT.transform(vertices[k]);
-          }
-          mMeshes[i]->updateTriangle(vertices[0], vertices[1], vertices[2]);
+          mMeshes[i]->updateVertex(shapeT.transform(
+              fcl::Vec3f(vertices(j, 0), vertices(j, 1), vertices(j, 2))));
         }
-
         mMeshes[i]->endUpdateModel();
         break;
       }
@@ -460,26 +451,36 @@ void FCLMeshCollisionNode::drawCollisionSkeletonNode(bool _bTrans)
 
 //==============================================================================
 template<class BV>
-fcl::BVHModel<BV>* createSoftMesh(const aiMesh* _mesh,
-                                  const fcl::Transform3f& _transform)
+fcl::BVHModel<BV>* createSoftMesh(
+    const dynamics::SoftMeshShape* _softMeshShape,
+    const fcl::Transform3f& _transform)
 {
-  assert(_mesh);
-  fcl::BVHModel<BV>* model = new fcl::BVHModel<BV>;
-  model->beginModel();
+  assert(_softMeshShape);
+  const aiMesh* mesh = _softMeshShape->getAssimpMesh();
+  const Eigen::Matrix<double, Eigen::Dynamic, 3>& vertices
+      = _softMeshShape->getVertices();
+
+  // One vertex per point mass, in the order of the point masses
+  std::vector<fcl::Vec3f> points(vertices.rows());
+  for (int i = 0; i < vertices.rows(); i++)
+  {
+    points[i] = _transform.transform(
+                  fcl::Vec3f(vertices(i, 0), vertices(i, 1), vertices(i, 2)));
+  }
 
-  for (unsigned int i = 0; i < _mesh->mNumFaces; i++)
+  // Triangles in the order of the faces, which soft contacts rely on to find
+  // the colliding point masses
+  std::vector<fcl::Triangle> triangles(mesh->mNumFaces);
+  for (unsigned int i = 0; i < mesh->mNumFaces; i++)
   {
-    fcl::Vec3f vertices[3];
-    for (unsigned int j = 0; j < 3; j++)
-    {
-      const aiVector3D& vertex
-          = _mesh->mVertices[_mesh->mFaces[i].mIndices[j]];
-      vertices[j] = fcl::Vec3f(vertex.x, vertex.y, vertex.z);
-      vertices[j] = _transform.transform(vertices[j]);
-    }
-    model->addTriangle(vertices[0], vertices[1], vertices[2]);
+    triangles[i].set(mesh->mFaces[i].mIndices[0],
+                     mesh->mFaces[i].mIndices[1],
+                     mesh->mFaces[i].mIndices[2]);
   }
 
+  fcl::BVHModel<BV>* model = new fcl::BVHModel<BV>;
+  model->beginModel();
+  model->addSubModel(points, triangles);
   model->endModel();
   return model;
 }
@@ -52,6 +52,7 @@
 namespace dart {
 namespace dynamics {
 class BodyNode;
+class SoftMeshShape;
 }  // namespace dynamics
 }  // namespace dart
 
@@ -121,10 +122,12 @@ private:
   static double triArea(fcl::Vec3f p1, fcl::Vec3f p2, fcl::Vec3f p3);
 };
 
-///
+/// Create a BVH model that shares one vertex per point mass among the
+/// triangles of _softMeshShape so that it can be refit vertex by vertex.
 template<class BV>
-fcl::BVHModel<BV>* createSoftMesh(const aiMesh* _mesh,
-                                  const fcl::Transform3f& _transform);
+fcl::BVHModel<BV>* createSoftMesh(
+    const dynamics::SoftMeshShape* _softMeshShape,
+    const fcl::Transform3f& _transform);
 
 //==============================================================================
 inline bool FCLMeshCollisionNode::EFtest(const fcl::Vec3f& p0,
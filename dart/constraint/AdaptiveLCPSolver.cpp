@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/AdaptiveLCPSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "dart/common/Console.h"
+#include "dart/common/Timer.h"
+#include "dart/constraint/Constraint.h"
+#include "dart/constraint/ConstrainedGroup.h"
+#include "dart/constraint/LCPProblemFile.h"
+#include "dart/constraint/PGSLCPSolver.h"
+#include "dart/lcpsolver/lcp.h"
+
+#define DART_ADAPTIVE_LCP_DEFAULT_MAX_DIRECT_DIM      60
+#define DART_ADAPTIVE_LCP_DEFAULT_MAX_ITERATIVE_COND  1e+4
+#define DART_ADAPTIVE_LCP_DEFAULT_RESIDUAL_TOL        1e-3
+#define DART_ADAPTIVE_LCP_DEFAULT_MAX_ITER            30
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+LCPSolverStatistics::LCPSolverStatistics()
+  : numDirect(0),
+    numIterative(0),
+    numFallbacks(0),
+    numFailures(0),
+    directTime(0.0),
+    iterativeTime(0.0)
+{
+}
+
+//==============================================================================
+AdaptiveLCPSolver::AdaptiveLCPSolver(double _timestep)
+  : LCPSolver(_timestep),
+    mMaxDirectDimension(DART_ADAPTIVE_LCP_DEFAULT_MAX_DIRECT_DIM),
+    mMaxIterativeConditionEstimate(DART_ADAPTIVE_LCP_DEFAULT_MAX_ITERATIVE_COND),
+    mResidualTolerance(DART_ADAPTIVE_LCP_DEFAULT_RESIDUAL_TOL),
+    mMaxIterations(DART_ADAPTIVE_LCP_DEFAULT_MAX_ITER)
+{
+}
+
+//==============================================================================
+AdaptiveLCPSolver::~AdaptiveLCPSolver()
+{
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::beginStep()
+{
+  mGroupReports.clear();
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::solve(ConstrainedGroup* _group)
+{
+  // If there is no constraint, then just return true.
+  size_t numConstraints = _group->getNumConstraints();
+  if (numConstraints == 0)
+    return;
+
+  // Build LCP terms by aggregating them from constraints
+  size_t n = _group->getTotalDimension();
+  int nSkip = dPAD(n);
+  mA.resize(n * nSkip);
+  mX0.resize(n);
+  mB.resize(n);
+  mW.resize(n);
+  mLo.resize(n);
+  mHi.resize(n);
+  mFIndex.resize(n);
+
+  double* A = &mA[0];
+  double* x = &mX0[0];
+  double* b = &mB[0];
+  double* lo = &mLo[0];
+  double* hi = &mHi[0];
+  int* findex = &mFIndex[0];
+
+  // Set A and w to 0 and findex to -1
+  std::fill(mA.begin(), mA.end(), 0.0);
+  std::fill(mW.begin(), mW.end(), 0.0);
+  std::fill(mFIndex.begin(), mFIndex.end(), -1);
+
+  // Compute offset indices
+  mOffset.resize(numConstraints);
+  mOffset[0] = 0;
+  for (size_t i = 1; i < numConstraints; ++i)
+  {
+    Constraint* constraint = _group->getConstraint(i - 1);
+    assert(constraint->getDimension() > 0);
+    mOffset[i] = mOffset[i - 1] + constraint->getDimension();
+  }
+
+  // For each constraint
+  ConstraintInfo constInfo;
+  constInfo.invTimeStep = 1.0 / mTimeStep;
+  Constraint* constraint;
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    constraint = _group->getConstraint(i);
+
+    constInfo.x      = x         + mOffset[i];
+    constInfo.lo     = lo        + mOffset[i];
+    constInfo.hi     = hi        + mOffset[i];
+    constInfo.b      = b         + mOffset[i];
+    constInfo.findex = findex    + mOffset[i];
+    constInfo.w      = &mW[0]    + mOffset[i];
+
+    // Fill vectors: lo, hi, b, w
+    constraint->getInformation(&constInfo);
+
+    // Fill a matrix by impulse tests: A
+    constraint->excite();
+    for (size_t j = 0; j < constraint->getDimension(); ++j)
+    {
+      // Adjust findex for global index
+      if (findex[mOffset[i] + j] >= 0)
+        findex[mOffset[i] + j] += mOffset[i];
+
+      // Apply impulse for mipulse test
+      constraint->applyUnitImpulse(j);
+
+      // Fill upper triangle blocks of A matrix
+      int index = nSkip * (mOffset[i] + j) + mOffset[i];
+      constraint->getVelocityChange(A + index, true);
+      for (size_t k = i + 1; k < numConstraints; ++k)
+      {
+        index = nSkip * (mOffset[i] + j) + mOffset[k];
+        _group->getConstraint(k)->getVelocityChange(A + index, false);
+      }
+
+      // Filling symmetric part of A matrix
+      for (size_t k = 0; k < i; ++k)
+      {
+        for (size_t l = 0; l < _group->getConstraint(k)->getDimension(); ++l)
+        {
+          int index1 = nSkip * (mOffset[i] + j) + mOffset[k] + l;
+          int index2 = nSkip * (mOffset[k] + l) + mOffset[i] + j;
+
+          A[index1] = A[index2];
+        }
+      }
+    }
+
+    constraint->unexcite();
+  }
+
+  // Select, solve and verify
+  LCPGroupReport report;
+  report.dimension = n;
+  report.conditionEstimate = estimateCondition(n, nSkip, A);
+  report.firstPath = selectPath(n, report.conditionEstimate);
+  report.finalPath = report.firstPath;
+  report.fellBack = false;
+
+  report.solveTime = solveWith(report.firstPath, n, nSkip);
+  report.residual = computeResidual(n, nSkip, A, &mX[0], b, lo, hi, findex);
+
+  if (!(report.residual <= mResidualTolerance))
+  {
+    const LCPSolverPath otherPath = report.firstPath == LCP_PATH_DIRECT
+                                    ? LCP_PATH_ITERATIVE : LCP_PATH_DIRECT;
+
+    mFirstX = mX;
+    report.solveTime += solveWith(otherPath, n, nSkip);
+    const double residual
+        = computeResidual(n, nSkip, A, &mX[0], b, lo, hi, findex);
+
+    report.fellBack = true;
+    mStatistics.numFallbacks++;
+
+    if (residual < report.residual || report.residual != report.residual)
+    {
+      report.finalPath = otherPath;
+      report.residual = residual;
+    }
+    else
+    {
+      mX.swap(mFirstX);
+    }
+
+    if (!(report.residual <= mResidualTolerance))
+    {
+      mStatistics.numFailures++;
+      dtwarn << "AdaptiveLCPSolver: LCP of dimension " << n
+             << " is not solved within the tolerance (residual: "
+             << report.residual << ")." << std::endl;
+    }
+  }
+
+  if (report.firstPath == LCP_PATH_DIRECT)
+    mStatistics.numDirect++;
+  else
+    mStatistics.numIterative++;
+
+  mGroupReports.push_back(report);
+
+  if (mProblemWriter)
+  {
+    mProblemWriter->beginProblem(n, nSkip, A, b, lo, hi, findex);
+    mProblemWriter->endProblem(&mX[0]);
+  }
+
+  // Apply constraint impulses
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    constraint = _group->getConstraint(i);
+    constraint->applyImpulse(&mX[0] + mOffset[i]);
+    constraint->excite();
+  }
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::setMaxDirectDimension(size_t _dim)
+{
+  mMaxDirectDimension = _dim;
+}
+
+//==============================================================================
+size_t AdaptiveLCPSolver::getMaxDirectDimension() const
+{
+  return mMaxDirectDimension;
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::setMaxIterativeConditionEstimate(double _cond)
+{
+  assert(_cond >= 1.0);
+  mMaxIterativeConditionEstimate = _cond;
+}
+
+//==============================================================================
+double AdaptiveLCPSolver::getMaxIterativeConditionEstimate() const
+{
+  return mMaxIterativeConditionEstimate;
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::setResidualTolerance(double _tol)
+{
+  assert(_tol > 0.0);
+  mResidualTolerance = _tol;
+}
+
+//==============================================================================
+double AdaptiveLCPSolver::getResidualTolerance() const
+{
+  return mResidualTolerance;
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::setMaxIterations(int _maxIter)
+{
+  assert(_maxIter > 0);
+  mMaxIterations = _maxIter;
+}
+
+//==============================================================================
+int AdaptiveLCPSolver::getMaxIterations() const
+{
+  return mMaxIterations;
+}
+
+//==============================================================================
+const std::vector<LCPGroupReport>& AdaptiveLCPSolver::getGroupReports() const
+{
+  return mGroupReports;
+}
+
+//==============================================================================
+const LCPSolverStatistics& AdaptiveLCPSolver::getStatistics() const
+{
+  return mStatistics;
+}
+
+//==============================================================================
+void AdaptiveLCPSolver::resetStatistics()
+{
+  mStatistics = LCPSolverStatistics();
+}
+
+//==============================================================================
+double AdaptiveLCPSolver::computeResidual(size_t _n, size_t _nSkip,
+                                          const double* _A, const double* _x,
+                                          const double* _b, const double* _lo,
+                                          const double* _hi,
+                                          const int* _findex)
+{
+  // Tolerance used to decide whether x is on a bound
+  const double boundTol = 1e-9;
+
+  double maxError = 0.0;
+  double scale = 1.0;
+
+  for (size_t i = 0; i < _n; ++i)
+  {
+    // Slack: w = A * x - b
+    const double* Ai = _A + _nSkip * i;
+    double w = -_b[i];
+    for (size_t j = 0; j < _n; ++j)
+      w += Ai[j] * _x[j];
+
+    double lo = _lo[i];
+    double hi = _hi[i];
+    if (_findex[i] >= 0)
+    {
+      hi = std::fabs(_hi[i] * _x[_findex[i]]);
+      lo = -hi;
+    }
+
+    // Bound violation
+    double error = std::max(0.0, std::max(lo - _x[i], _x[i] - hi));
+
+    // Complementarity: w >= 0 at the lower bound, w <= 0 at the upper bound
+    // and w = 0 in between. A collapsed box (e.g., friction of a separating
+    // contact) admits any w.
+    if (hi - lo <= boundTol)
+      ;
+    else if (_x[i] <= lo + boundTol)
+      error = std::max(error, -w);
+    else if (_x[i] >= hi - boundTol)
+      error = std::max(error, w);
+    else
+      error = std::max(error, std::fabs(w));
+
+    // NaN propagates as an infinite error
+    if (error != error)
+      return std::numeric_limits<double>::infinity();
+
+    maxError = std::max(maxError, error);
+    scale = std::max(scale, std::fabs(_b[i]));
+  }
+
+  return maxError / scale;
+}
+
+//==============================================================================
+double AdaptiveLCPSolver::estimateCondition(size_t _n, size_t _nSkip,
+                                            const double* _A) const
+{
+  double minDiag = std::numeric_limits<double>::infinity();
+  double maxDiag = 0.0;
+
+  for (size_t i = 0; i < _n; ++i)
+  {
+    const double d = std::fabs(_A[_nSkip * i + i]);
+    minDiag = std::min(minDiag, d);
+    maxDiag = std::max(maxDiag, d);
+  }
+
+  if (minDiag <= 0.0)
+    return std::numeric_limits<double>::infinity();
+
+  return maxDiag / minDiag;
+}
+
+//==============================================================================
+LCPSolverPath AdaptiveLCPSolver::selectPath(size_t _n,
+                                            double _conditionEstimate) const
+{
+  if (_n <= mMaxDirectDimension)
+    return LCP_PATH_DIRECT;
+
+  // PGS converges poorly on badly conditioned problems (e.g., large mass
+  // ratios), so those stay on the direct path regardless of their size.
+  if (_conditionEstimate > mMaxIterativeConditionEstimate)
+    return LCP_PATH_DIRECT;
+
+  return LCP_PATH_ITERATIVE;
+}
+
+//==============================================================================
+double AdaptiveLCPSolver::solveWith(LCPSolverPath _path, size_t _n, int _nSkip)
+{
+  // Both solvers modify their inputs, so work on copies of the assembled LCP
+  mWorkA      = mA;
+  mWorkB      = mB;
+  mWorkLo     = mLo;
+  mWorkHi     = mHi;
+  mWorkFIndex = mFIndex;
+  mX          = mX0;
+  std::fill(mW.begin(), mW.end(), 0.0);
+
+  const double startTime = common::Timer::getWallTime();
+
+  if (_path == LCP_PATH_DIRECT)
+  {
+    dSolveLCP(_n, &mWorkA[0], &mX[0], &mWorkB[0], &mW[0], 0,
+              &mWorkLo[0], &mWorkHi[0], &mWorkFIndex[0]);
+  }
+  else
+  {
+    PGSOption option;
+    option.setDefault();
+    option.itermax = mMaxIterations;
+    solvePGS(_n, _nSkip, 0, &mWorkA[0], &mX[0], &mWorkB[0],
+             &mWorkLo[0], &mWorkHi[0], &mWorkFIndex[0], &option);
+  }
+
+  const double elapsedTime = common::Timer::getWallTime() - startTime;
+
+  if (_path == LCP_PATH_DIRECT)
+    mStatistics.directTime += elapsedTime;
+  else
+    mStatistics.iterativeTime += elapsedTime;
+
+  return elapsedTime;
+}
+
+}  // namespace constraint
+}  // namespace dart
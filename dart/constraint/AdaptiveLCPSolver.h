@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_CONSTRAINT_ADAPTIVELCPSOLVER_H_
+#define DART_CONSTRAINT_ADAPTIVELCPSOLVER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "dart/config.h"
+#include "dart/constraint/LCPSolver.h"
+
+namespace dart {
+namespace constraint {
+
+/// Algorithm used to solve the LCP of a constrained group
+enum LCPSolverPath
+{
+  LCP_PATH_DIRECT,    ///< Dantzig pivoting (ODE's dSolveLCP)
+  LCP_PATH_ITERATIVE  ///< Projected Gauss-Seidel (solvePGS)
+};
+
+/// Report on how a single constrained group was solved
+struct LCPGroupReport
+{
+  /// Dimension of the LCP
+  size_t dimension;
+
+  /// Ratio of the largest to the smallest diagonal element of A
+  double conditionEstimate;
+
+  /// Algorithm chosen by the selection policy
+  LCPSolverPath firstPath;
+
+  /// Algorithm whose solution was applied to the group
+  LCPSolverPath finalPath;
+
+  /// True if the first algorithm failed the residual check
+  bool fellBack;
+
+  /// Relative complementarity residual of the applied solution
+  double residual;
+
+  /// Wall time spent on the LCP solve(s) in seconds, excluding assembly
+  double solveTime;
+};
+
+/// Cumulative counters of AdaptiveLCPSolver
+struct LCPSolverStatistics
+{
+  /// Default constructor
+  LCPSolverStatistics();
+
+  /// Number of groups handed to the direct solver first
+  size_t numDirect;
+
+  /// Number of groups handed to the iterative solver first
+  size_t numIterative;
+
+  /// Number of groups that failed the residual check and were re-solved
+  size_t numFallbacks;
+
+  /// Number of groups whose applied solution still failed the residual check
+  size_t numFailures;
+
+  /// Total time spent in the direct solver in seconds
+  double directTime;
+
+  /// Total time spent in the iterative solver in seconds
+  double iterativeTime;
+};
+
+/// AdaptiveLCPSolver picks an LCP algorithm for each constrained group.
+///
+/// Small or badly conditioned groups are solved with Dantzig's direct method,
+/// large well-conditioned groups with projected Gauss-Seidel. The solution is
+/// checked against the complementarity conditions, and if the residual
+/// exceeds the tolerance the group is re-solved with the other algorithm and
+/// the better of the two solutions is applied.
+class AdaptiveLCPSolver : public LCPSolver
+{
+public:
+  /// Constructor
+  explicit AdaptiveLCPSolver(double _timestep);
+
+  /// Destructor
+  virtual ~AdaptiveLCPSolver();
+
+  // Documentation inherited
+  virtual void beginStep();
+
+  // Documentation inherited
+  virtual void solve(ConstrainedGroup* _group);
+
+  //----------------------------------------------------------------------------
+  // Policy
+  //----------------------------------------------------------------------------
+
+  /// Set the largest group dimension that is solved by the direct solver
+  void setMaxDirectDimension(size_t _dim);
+
+  /// Return the largest group dimension that is solved by the direct solver
+  size_t getMaxDirectDimension() const;
+
+  /// Set the condition estimate above which large groups are still solved by
+  /// the direct solver
+  void setMaxIterativeConditionEstimate(double _cond);
+
+  /// Return the condition estimate above which large groups are still solved
+  /// by the direct solver
+  double getMaxIterativeConditionEstimate() const;
+
+  /// Set the relative residual that triggers the fallback solver
+  void setResidualTolerance(double _tol);
+
+  /// Return the relative residual that triggers the fallback solver
+  double getResidualTolerance() const;
+
+  /// Set the maximum number of projected Gauss-Seidel iterations
+  void setMaxIterations(int _maxIter);
+
+  /// Return the maximum number of projected Gauss-Seidel iterations
+  int getMaxIterations() const;
+
+  //----------------------------------------------------------------------------
+  // Statistics
+  //----------------------------------------------------------------------------
+
+  /// Return the reports of the groups solved in the current step
+  const std::vector<LCPGroupReport>& getGroupReports() const;
+
+  /// Return the counters accumulated since the last resetStatistics()
+  const LCPSolverStatistics& getStatistics() const;
+
+  /// Reset the accumulated counters
+  void resetStatistics();
+
+  /// Return the relative complementarity residual of x for the boxed LCP
+  /// (A, b, lo, hi, findex). A is stored row-major with row stride _nSkip.
+  static double computeResidual(size_t _n, size_t _nSkip, const double* _A,
+                                const double* _x, const double* _b,
+                                const double* _lo, const double* _hi,
+                                const int* _findex);
+
+protected:
+  /// Return the ratio of the largest to the smallest diagonal element of A
+  double estimateCondition(size_t _n, size_t _nSkip, const double* _A) const;
+
+  /// Select the first algorithm for a group
+  LCPSolverPath selectPath(size_t _n, double _conditionEstimate) const;
+
+  /// Solve the LCP stored in the work buffers with the given algorithm. The
+  /// solution is written to mX and the elapsed time is returned.
+  double solveWith(LCPSolverPath _path, size_t _n, int _nSkip);
+
+  /// Largest dimension solved by the direct solver
+  size_t mMaxDirectDimension;
+
+  /// Condition estimate above which the direct solver is always used
+  double mMaxIterativeConditionEstimate;
+
+  /// Relative residual that triggers the fallback
+  double mResidualTolerance;
+
+  /// Maximum number of PGS iterations
+  int mMaxIterations;
+
+  /// Reports of the groups solved in the current step
+  std::vector<LCPGroupReport> mGroupReports;
+
+  /// Accumulated counters
+  LCPSolverStatistics mStatistics;
+
+  /// Assembled LCP. The solvers modify their inputs in place, so these are
+  /// kept pristine and copied into the work buffers below before each solve.
+  std::vector<double> mA;
+  std::vector<double> mB;
+  std::vector<double> mLo;
+  std::vector<double> mHi;
+  std::vector<double> mX0;
+  std::vector<int> mFIndex;
+
+  /// Work buffers handed to the solvers
+  std::vector<double> mWorkA;
+  std::vector<double> mWorkB;
+  std::vector<double> mWorkLo;
+  std::vector<double> mWorkHi;
+  std::vector<double> mW;
+  std::vector<int> mWorkFIndex;
+
+  /// Solution of the last solve
+  std::vector<double> mX;
+
+  /// Solution of the first solve, kept while the fallback runs
+  std::vector<double> mFirstX;
+
+  /// Offsets of each constraint in the LCP
+  std::vector<size_t> mOffset;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif  // DART_CONSTRAINT_ADAPTIVELCPSOLVER_H_
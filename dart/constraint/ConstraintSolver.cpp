@@ -36,8 +36,12 @@
 
 #include "dart/constraint/ConstraintSolver.h"
 
+#include <algorithm>
+#include <map>
+
 #include "dart/common/Console.h"
 #include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/GenCoord.h"
 #include "dart/dynamics/SoftBodyNode.h"
 #include "dart/dynamics/Joint.h"
 #include "dart/dynamics/Skeleton.h"
@@ -51,18 +55,37 @@
 #include "dart/constraint/SoftContactConstraint.h"
 #include "dart/constraint/JointLimitConstraint.h"
 #include "dart/constraint/DantzigLCPSolver.h"
+#include "dart/constraint/LCPProblemFile.h"
 #include "dart/constraint/PGSLCPSolver.h"
+#include "dart/lcpsolver/lcp.h"
 
 namespace dart {
 namespace constraint {
 
 using namespace dynamics;
 
+//==============================================================================
+// Copy the generalized velocities (or velocity changes) of _skeleton into
+// _vels, which keeps its storage when its size does not change
+static void copyGenVels(const Skeleton* _skeleton, Eigen::VectorXd* _vels,
+                        bool _isVelChange = false)
+{
+  const int dof = _skeleton->getNumGenCoords();
+  _vels->resize(dof);
+  for (int i = 0; i < dof; ++i)
+  {
+    const GenCoord* genCoord = _skeleton->getGenCoord(i);
+    (*_vels)[i] = _isVelChange ? genCoord->getVelChange() : genCoord->getVel();
+  }
+}
+
 //==============================================================================
 ConstraintSolver::ConstraintSolver(double _timeStep)
   : mTimeStep(_timeStep),
     mCollisionDetector(new collision::FCLMeshCollisionDetector()),
-    mLCPSolver(new DantzigLCPSolver(mTimeStep))
+    mLCPSolver(new DantzigLCPSolver(mTimeStep)),
+    mLCPProblemWriter(NULL),
+    mIsSoftContactSplitImpulseWarned(false)
 {
   assert(_timeStep > 0.0);
 }
@@ -71,6 +94,8 @@ ConstraintSolver::ConstraintSolver(double _timeStep)
 ConstraintSolver::~ConstraintSolver()
 {
   delete mCollisionDetector;
+  delete mLCPSolver;
+  delete mLCPProblemWriter;
 }
 
 //==============================================================================
@@ -245,12 +270,66 @@ collision::CollisionDetector* ConstraintSolver::getCollisionDetector() const
   return mCollisionDetector;
 }
 
+//==============================================================================
+void ConstraintSolver::setLCPSolver(LCPSolver* _lcpSolver)
+{
+  assert(_lcpSolver && "Invalid LCP solver.");
+
+  if (_lcpSolver == mLCPSolver)
+    return;
+
+  delete mLCPSolver;
+  mLCPSolver = _lcpSolver;
+  mLCPSolver->setTimeStep(mTimeStep);
+  mLCPSolver->setProblemWriter(mLCPProblemWriter);
+}
+
+//==============================================================================
+LCPSolver* ConstraintSolver::getLCPSolver() const
+{
+  return mLCPSolver;
+}
+
+//==============================================================================
+bool ConstraintSolver::startLCPCapture(const std::string& _fileName)
+{
+  stopLCPCapture();
+
+  LCPProblemWriter* writer = new LCPProblemWriter();
+  if (!writer->open(_fileName))
+  {
+    delete writer;
+    return false;
+  }
+
+  mLCPProblemWriter = writer;
+  mLCPSolver->setProblemWriter(mLCPProblemWriter);
+
+  return true;
+}
+
+//==============================================================================
+void ConstraintSolver::stopLCPCapture()
+{
+  mLCPSolver->setProblemWriter(NULL);
+  delete mLCPProblemWriter;
+  mLCPProblemWriter = NULL;
+}
+
+//==============================================================================
+bool ConstraintSolver::isCapturingLCP() const
+{
+  return mLCPProblemWriter != NULL;
+}
+
 //==============================================================================
 void ConstraintSolver::solve()
 {
   for (size_t i = 0; i < mSkeletons.size(); ++i)
     mSkeletons[i]->clearConstraintImpulses();
 
+  mPositionCorrectionSkeletons.clear();
+
   // Update constraints and collect active constraints
   updateConstraints();
 
@@ -362,17 +441,41 @@ void ConstraintSolver::updateConstraints()
   }
   mSoftContactConstraints.clear();
 
-  // Create new contact constraints
+  // Create new contact constraints. Rigid contacts are gathered per body node
+  // pair into a contact manifold, which ContactConstraint reduces to at most
+  // DART_MAX_NUMBER_OF_CONTACTS points.
+  std::vector<std::vector<collision::Contact> > manifolds;
+  std::map<std::pair<dynamics::BodyNode*, dynamics::BodyNode*>, size_t>
+      manifoldIndices;
   for (size_t i = 0; i < mCollisionDetector->getNumContacts(); ++i)
   {
     const collision::Contact& ct = mCollisionDetector->getContact(i);
 
     if (isSoftContact(ct))
+    {
       mSoftContactConstraints.push_back(new SoftContactConstraint(ct));
+      continue;
+    }
+
+    std::pair<dynamics::BodyNode*, dynamics::BodyNode*> key
+        = std::make_pair(std::min(ct.bodyNode1, ct.bodyNode2),
+                         std::max(ct.bodyNode1, ct.bodyNode2));
+    std::map<std::pair<dynamics::BodyNode*, dynamics::BodyNode*>,
+             size_t>::const_iterator it = manifoldIndices.find(key);
+    if (it == manifoldIndices.end())
+    {
+      manifoldIndices[key] = manifolds.size();
+      manifolds.push_back(std::vector<collision::Contact>(1, ct));
+    }
     else
-      mContactConstraints.push_back(new ContactConstraint(ct));
+    {
+      manifolds[it->second].push_back(ct);
+    }
   }
 
+  for (size_t i = 0; i < manifolds.size(); ++i)
+    mContactConstraints.push_back(new ContactConstraint(manifolds[i]));
+
   // Add the new contact constraints to dynamic constraint list
   for (std::vector<ContactConstraint*>::const_iterator it
        = mContactConstraints.begin();
@@ -500,11 +603,224 @@ void ConstraintSolver::buildConstrainedGroups()
 //==============================================================================
 void ConstraintSolver::solveConstrainedGroups()
 {
+  mLCPSolver->beginStep();
+
+  const bool splitImpulse = ContactConstraint::isSplitImpulseEnabled();
+
   for (std::vector<ConstrainedGroup>::iterator it = mConstrainedGroups.begin();
        it != mConstrainedGroups.end(); ++it)
   {
+    // The position pass leaves no impulses behind, so it can run before the
+    // velocity pass without affecting it
+    if (splitImpulse)
+      solvePositionCorrection(&(*it));
+
     mLCPSolver->solve(&(*it));
   }
+
+  if (mLCPProblemWriter)
+    mLCPProblemWriter->nextFrame();
+}
+
+//==============================================================================
+void ConstraintSolver::solvePositionCorrection(ConstrainedGroup* _group)
+{
+  // Collect the contact constraints of this group. Soft contacts keep the
+  // Baumgarte stabilization of SoftContactConstraint in the velocity LCP.
+  mPositionContacts.clear();
+  mPositionOffsets.clear();
+  size_t totalDim = 0;
+  size_t maxDim = 0;
+  for (size_t i = 0; i < _group->getNumConstraints(); ++i)
+  {
+    Constraint* constraint = _group->getConstraint(i);
+    ContactConstraint* contact = dynamic_cast<ContactConstraint*>(constraint);
+    if (contact == NULL)
+    {
+      if (!mIsSoftContactSplitImpulseWarned
+          && dynamic_cast<SoftContactConstraint*>(constraint) != NULL)
+      {
+        dtwarn << "Split impulse does not support soft contacts. They are "
+               << "stabilized in the velocity LCP instead.\n";
+        mIsSoftContactSplitImpulseWarned = true;
+      }
+      continue;
+    }
+
+    mPositionContacts.push_back(contact);
+    mPositionOffsets.push_back(totalDim);
+    totalDim += contact->getDimension();
+    maxDim = std::max(maxDim, contact->getDimension());
+  }
+
+  if (mPositionContacts.empty())
+    return;
+
+  // Fill the position-level terms
+  mPositionX.assign(totalDim, 0.0);
+  mPositionB.assign(totalDim, 0.0);
+  mPositionW.assign(totalDim, 0.0);
+  mPositionLo.assign(totalDim, 0.0);
+  mPositionHi.assign(totalDim, 0.0);
+  mPositionFIndex.assign(totalDim, -1);
+
+  ConstraintInfo info;
+  info.invTimeStep = 1.0 / mTimeStep;
+  for (size_t i = 0; i < mPositionContacts.size(); ++i)
+  {
+    info.x      = &mPositionX[mPositionOffsets[i]];
+    info.lo     = &mPositionLo[mPositionOffsets[i]];
+    info.hi     = &mPositionHi[mPositionOffsets[i]];
+    info.b      = &mPositionB[mPositionOffsets[i]];
+    info.w      = &mPositionW[mPositionOffsets[i]];
+    info.findex = &mPositionFIndex[mPositionOffsets[i]];
+    mPositionContacts[i]->getPositionInformation(&info);
+  }
+
+  // Only the rows with a non-collapsed box take part in the position pass
+  mPositionRows.clear();
+  mPositionRowContacts.clear();
+  bool hasError = false;
+  for (size_t i = 0; i < mPositionContacts.size(); ++i)
+  {
+    for (size_t j = 0; j < mPositionContacts[i]->getDimension(); ++j)
+    {
+      const size_t index = mPositionOffsets[i] + j;
+      if (mPositionHi[index] > mPositionLo[index])
+      {
+        mPositionRows.push_back(index);
+        mPositionRowContacts.push_back(i);
+        if (mPositionB[index] > 0.0)
+          hasError = true;
+      }
+    }
+  }
+
+  if (!hasError)
+    return;
+
+  // Build the Delassus matrix of the active rows by impulse tests
+  const int n = mPositionRows.size();
+  const int nSkip = dPAD(n);
+  mPositionA.assign(n * nSkip, 0.0);
+  mPositionVelocityChange.resize(maxDim);
+  for (int r = 0; r < n; ++r)
+  {
+    ContactConstraint* contact = mPositionContacts[mPositionRowContacts[r]];
+
+    contact->excite();
+    contact->applyUnitImpulse(mPositionRows[r]
+                              - mPositionOffsets[mPositionRowContacts[r]]);
+
+    for (int c = 0; c < n; ++c)
+    {
+      const size_t contactIndex = mPositionRowContacts[c];
+
+      // Rows of the same contact constraint are contiguous
+      if (c == 0 || contactIndex != mPositionRowContacts[c - 1])
+      {
+        mPositionContacts[contactIndex]->getVelocityChange(
+              &mPositionVelocityChange[0],
+              contactIndex == mPositionRowContacts[r]);
+      }
+      mPositionA[nSkip * r + c]
+          = mPositionVelocityChange[mPositionRows[c]
+                                    - mPositionOffsets[contactIndex]];
+    }
+
+    contact->unexcite();
+  }
+
+  // Solve for the pseudo-impulses
+  mPositionReducedX.assign(n, 0.0);
+  mPositionReducedB.resize(n);
+  mPositionReducedW.assign(n, 0.0);
+  mPositionReducedLo.resize(n);
+  mPositionReducedHi.resize(n);
+  mPositionReducedFIndex.assign(n, -1);
+  for (int r = 0; r < n; ++r)
+  {
+    mPositionReducedB[r]  = mPositionB[mPositionRows[r]];
+    mPositionReducedLo[r] = mPositionLo[mPositionRows[r]];
+    mPositionReducedHi[r] = mPositionHi[mPositionRows[r]];
+  }
+
+  dSolveLCP(n, &mPositionA[0], &mPositionReducedX[0], &mPositionReducedB[0],
+            &mPositionReducedW[0], 0, &mPositionReducedLo[0],
+            &mPositionReducedHi[0], &mPositionReducedFIndex[0]);
+
+  for (int r = 0; r < n; ++r)
+    mPositionX[mPositionRows[r]] = mPositionReducedX[r];
+
+  // Collect the skeletons that respond to the pseudo-impulses
+  mPositionSkeletons.clear();
+  for (size_t i = 0; i < mPositionContacts.size(); ++i)
+  {
+    BodyNode* bodyNodes[2] = {mPositionContacts[i]->mBodyNode1,
+                              mPositionContacts[i]->mBodyNode2};
+    for (size_t j = 0; j < 2; ++j)
+    {
+      if (!bodyNodes[j]->isImpulseReponsible())
+        continue;
+
+      Skeleton* skeleton = bodyNodes[j]->getSkeleton();
+      if (std::find(mPositionSkeletons.begin(), mPositionSkeletons.end(),
+                    skeleton) == mPositionSkeletons.end())
+      {
+        mPositionSkeletons.push_back(skeleton);
+        skeleton->clearConstraintImpulses();
+      }
+    }
+  }
+
+  // Convert the pseudo-impulses to pseudo-velocities. The impulse forward
+  // dynamics updates the velocities, so they are restored afterwards.
+  for (size_t i = 0; i < mPositionContacts.size(); ++i)
+    mPositionContacts[i]->applyImpulse(&mPositionX[mPositionOffsets[i]]);
+
+  for (size_t i = 0; i < mPositionSkeletons.size(); ++i)
+  {
+    Skeleton* skeleton = mPositionSkeletons[i];
+
+    if (skeleton->isMobile() && skeleton->getNumGenCoords() > 0)
+    {
+      // The buffers of each slot only grow with the number of slots
+      const size_t index = mPositionCorrectionSkeletons.size();
+      mPositionCorrectionSkeletons.push_back(skeleton);
+      if (mPositionCorrectionVels.size() <= index)
+      {
+        mPositionCorrectionVels.resize(index + 1);
+        mPositionCorrectionGenVels.resize(index + 1);
+      }
+
+      Eigen::VectorXd& vels = mPositionCorrectionGenVels[index];
+      copyGenVels(skeleton, &vels);
+      skeleton->computeImpulseForwardDynamics();
+      copyGenVels(skeleton, &mPositionCorrectionVels[index], true);
+      skeleton->setGenVels(vels);
+    }
+
+    // Leave nothing of this pass to the velocity pass and World::step()
+    skeleton->clearConstraintImpulses();
+    skeleton->setImpulseApplied(false);
+  }
+}
+
+//==============================================================================
+void ConstraintSolver::integratePositionCorrections(double _timeStep)
+{
+  for (size_t i = 0; i < mPositionCorrectionSkeletons.size(); ++i)
+  {
+    Skeleton* skeleton = mPositionCorrectionSkeletons[i];
+
+    Eigen::VectorXd& vels = mPositionCorrectionGenVels[i];
+    copyGenVels(skeleton, &vels);
+    skeleton->setGenVels(mPositionCorrectionVels[i]);
+    skeleton->integrateConfigs(_timeStep);
+    skeleton->setGenVels(vels);
+  }
+
+  mPositionCorrectionSkeletons.clear();
 }
 
 //==============================================================================
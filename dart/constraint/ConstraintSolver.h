@@ -37,6 +37,7 @@
 #ifndef DART_CONSTRAINT_CONSTRAINTSOVER_H_
 #define DART_CONSTRAINT_CONSTRAINTSOVER_H_
 
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -60,6 +61,7 @@ class SoftContactConstraint;
 class JointLimitConstraint;
 class JointConstraint;
 class LCPSolver;
+class LCPProblemWriter;
 
 // TODO:
 //   - RootSkeleton concept
@@ -113,9 +115,34 @@ public:
   /// Get collision detector
   collision::CollisionDetector* getCollisionDetector() const;
 
+  /// Set LCP solver. The previous LCP solver is deleted and this constraint
+  /// solver takes the ownership of _lcpSolver.
+  void setLCPSolver(LCPSolver* _lcpSolver);
+
+  /// Get LCP solver
+  LCPSolver* getLCPSolver() const;
+
+  /// Start writing the LCP of every constrained group solved in the
+  /// following steps to _fileName. Return false if the file cannot be opened.
+  /// \sa LCPProblemWriter
+  bool startLCPCapture(const std::string& _fileName);
+
+  /// Stop writing the LCPs and close the capture file
+  void stopLCPCapture();
+
+  /// Return true if the LCPs are being captured
+  bool isCapturingLCP() const;
+
   /// Solve constraint impulses and apply them to the skeletons
   void solve();
 
+  /// Integrate the configurations of the skeletons with the split impulse
+  /// pseudo-velocities computed by the last solve(). The velocities of the
+  /// skeletons are left untouched. World::step() calls this after the
+  /// regular position integration.
+  /// \sa ContactConstraint::setSplitImpulseEnabled()
+  void integratePositionCorrections(double _timeStep);
+
 private:
   /// Check if the skeleton is contained in this solver
   bool containSkeleton(const dynamics::Skeleton* _skeleton) const;
@@ -138,6 +165,10 @@ private:
   /// Solve constrained groups
   void solveConstrainedGroups();
 
+  /// Solve the split impulse position pass of the contacts in _group and
+  /// store the resulting pseudo-velocities
+  void solvePositionCorrection(ConstrainedGroup* _group);
+
   /// Return true if at least one of colliding body is soft body
   bool isSoftContact(const collision::Contact& _contact) const;
 
@@ -150,6 +181,9 @@ private:
   /// LCP solver
   LCPSolver* mLCPSolver;
 
+  /// Writer of captured LCPs. NULL when not capturing.
+  LCPProblemWriter* mLCPProblemWriter;
+
   /// Skeleton list
   std::vector<dynamics::Skeleton*> mSkeletons;
 
@@ -170,6 +204,54 @@ private:
 
   /// Constraint group list
   std::vector<ConstrainedGroup> mConstrainedGroups;
+
+  /// Skeletons that have split impulse pseudo-velocities to integrate
+  std::vector<dynamics::Skeleton*> mPositionCorrectionSkeletons;
+
+  /// Split impulse pseudo-velocities of mPositionCorrectionSkeletons. Only the
+  /// first mPositionCorrectionSkeletons.size() entries are valid, and the
+  /// entries are kept between steps so that their storage is reused.
+  std::vector<Eigen::VectorXd> mPositionCorrectionVels;
+
+  /// Buffers for the velocities of mPositionCorrectionSkeletons while the
+  /// pseudo-velocities are computed or integrated
+  std::vector<Eigen::VectorXd> mPositionCorrectionGenVels;
+
+  /// Contact constraints of the group in the split impulse position pass and
+  /// their offsets in the LCP. These and the buffers below are kept between
+  /// steps so that the position pass does not allocate.
+  std::vector<ContactConstraint*> mPositionContacts;
+  std::vector<size_t> mPositionOffsets;
+
+  /// Position-level LCP of all the rows of mPositionContacts
+  std::vector<double> mPositionX;
+  std::vector<double> mPositionB;
+  std::vector<double> mPositionW;
+  std::vector<double> mPositionLo;
+  std::vector<double> mPositionHi;
+  std::vector<int> mPositionFIndex;
+
+  /// Rows with a non-collapsed box and the contact each belongs to
+  std::vector<size_t> mPositionRows;
+  std::vector<size_t> mPositionRowContacts;
+
+  /// LCP reduced to mPositionRows
+  std::vector<double> mPositionA;
+  std::vector<double> mPositionReducedX;
+  std::vector<double> mPositionReducedB;
+  std::vector<double> mPositionReducedW;
+  std::vector<double> mPositionReducedLo;
+  std::vector<double> mPositionReducedHi;
+  std::vector<int> mPositionReducedFIndex;
+
+  /// Relative velocity change of a contact in the impulse tests
+  std::vector<double> mPositionVelocityChange;
+
+  /// Skeletons that respond to the pseudo-impulses
+  std::vector<dynamics::Skeleton*> mPositionSkeletons;
+
+  /// Whether the user was warned that soft contacts are not split
+  bool mIsSoftContactSplitImpulseWarned;
 };
 
 }  // namespace constraint
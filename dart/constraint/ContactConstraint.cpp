@@ -36,6 +36,7 @@
 
 #include "dart/constraint/ContactConstraint.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/common/Console.h"
@@ -48,7 +49,7 @@
 #define DART_ERP     0.01
 #define DART_MAX_ERV 1e+1
 #define DART_CFM     1e-5
-// #define DART_MAX_NUMBER_OF_CONTACTS 32
+#define DART_SPLIT_IMPULSE_ERP 0.2
 
 #define DART_RESTITUTION_COEFF_THRESHOLD 1e-3
 #define DART_FRICTION_COEFF_THRESHOLD    1e-3
@@ -63,22 +64,75 @@ double ContactConstraint::mErrorAllowance            = DART_ERROR_ALLOWANCE;
 double ContactConstraint::mErrorReductionParameter   = DART_ERP;
 double ContactConstraint::mMaxErrorReductionVelocity = DART_MAX_ERV;
 double ContactConstraint::mConstraintForceMixing     = DART_CFM;
+bool   ContactConstraint::mSplitImpulseEnabled       = false;
+double ContactConstraint::mSplitImpulseErrorReductionParameter
+    = DART_SPLIT_IMPULSE_ERP;
 
 //==============================================================================
 ContactConstraint::ContactConstraint(const collision::Contact& _contact)
   : Constraint(),
+    mNumContacts(0),
     mFirstFrictionalDirection(Eigen::Vector3d::UnitZ()),
     mIsFrictionOn(true),
     mAppliedImpulseIndex(-1),
     mIsBounceOn(false),
     mActive(false)
 {
-  // TODO(JS): Assumed single contact
-  mContacts.push_back(_contact);
+  initialize(&_contact, 1);
+}
+
+//==============================================================================
+ContactConstraint::ContactConstraint(
+    const std::vector<collision::Contact>& _contacts)
+  : Constraint(),
+    mNumContacts(0),
+    mFirstFrictionalDirection(Eigen::Vector3d::UnitZ()),
+    mIsFrictionOn(true),
+    mAppliedImpulseIndex(-1),
+    mIsBounceOn(false),
+    mActive(false)
+{
+  assert(!_contacts.empty());
+
+  if (_contacts.size() <= DART_MAX_NUMBER_OF_CONTACTS)
+  {
+    initialize(&_contacts[0], _contacts.size());
+  }
+  else
+  {
+    std::vector<collision::Contact> reduced(_contacts);
+    reduceContacts(&reduced);
+    initialize(&reduced[0], reduced.size());
+  }
+}
 
-  // TODO(JS):
-  mBodyNode1 = _contact.bodyNode1;
-  mBodyNode2 = _contact.bodyNode2;
+//==============================================================================
+void ContactConstraint::initialize(const collision::Contact* _contacts,
+                                   size_t _numContacts)
+{
+  assert(0 < _numContacts && _numContacts <= DART_MAX_NUMBER_OF_CONTACTS);
+
+  mBodyNode1 = _contacts[0].bodyNode1;
+  mBodyNode2 = _contacts[0].bodyNode2;
+
+  // Store the contacts so that every contact has the body node order of the
+  // first one
+  mNumContacts = _numContacts;
+  for (size_t i = 0; i < mNumContacts; ++i)
+  {
+    collision::Contact& ct = mContacts[i];
+    ct = _contacts[i];
+
+    if (ct.bodyNode1 != mBodyNode1)
+    {
+      assert(ct.bodyNode1 == mBodyNode2 && ct.bodyNode2 == mBodyNode1);
+      std::swap(ct.bodyNode1, ct.bodyNode2);
+      std::swap(ct.shape1, ct.shape2);
+      std::swap(ct.triID1, ct.triID2);
+      ct.normal = -ct.normal;
+      ct.force  = -ct.force;
+    }
+  }
 
   //----------------------------------------------
   // Bounce
@@ -114,14 +168,10 @@ ContactConstraint::ContactConstraint(const collision::Contact& _contact)
   if (mIsFrictionOn)
   {
     // Set the dimension of this constraint. 1 is for Normal direction constraint.
-    // TODO(JS): Assumed that the number of contact is not static.
     // TODO(JS): Adjust following code once use of mNumFrictionConeBases is
     //           implemented.
-    //  mDim = mContacts.size() * (1 + mNumFrictionConeBases);
-    mDim = mContacts.size() * 3;
-
-    mJacobians1.resize(mDim);
-    mJacobians2.resize(mDim);
+    //  mDim = mNumContacts * (1 + mNumFrictionConeBases);
+    mDim = mNumContacts * 3;
 
     // Intermediate variables
     size_t idx = 0;
@@ -132,7 +182,7 @@ ContactConstraint::ContactConstraint(const collision::Contact& _contact)
     Eigen::Vector3d bodyPoint1;
     Eigen::Vector3d bodyPoint2;
 
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
       const collision::Contact& ct = mContacts[i];
 
@@ -212,10 +262,7 @@ ContactConstraint::ContactConstraint(const collision::Contact& _contact)
   else
   {
     // Set the dimension of this constraint.
-    mDim = mContacts.size();
-
-    mJacobians1.resize(mDim);
-    mJacobians2.resize(mDim);
+    mDim = mNumContacts;
 
     Eigen::Vector3d bodyDirection1;
     Eigen::Vector3d bodyDirection2;
@@ -223,7 +270,7 @@ ContactConstraint::ContactConstraint(const collision::Contact& _contact)
     Eigen::Vector3d bodyPoint1;
     Eigen::Vector3d bodyPoint2;
 
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
       const collision::Contact& ct = mContacts[i];
 
@@ -324,6 +371,46 @@ double ContactConstraint::getMaxErrorReductionVelocity()
   return mMaxErrorReductionVelocity;
 }
 
+//==============================================================================
+void ContactConstraint::setSplitImpulseEnabled(bool _enabled)
+{
+  mSplitImpulseEnabled = _enabled;
+}
+
+//==============================================================================
+bool ContactConstraint::isSplitImpulseEnabled()
+{
+  return mSplitImpulseEnabled;
+}
+
+//==============================================================================
+void ContactConstraint::setSplitImpulseErrorReductionParameter(double _erp)
+{
+  // Clamp error reduction parameter if it is out of the range [0, 1]
+  if (_erp < 0.0)
+  {
+    dtwarn << "Split impulse error reduction parameter[" << _erp
+           << "] is lower than 0.0. " << "It is set to 0.0." << std::endl;
+    mSplitImpulseErrorReductionParameter = 0.0;
+    return;
+  }
+  if (_erp > 1.0)
+  {
+    dtwarn << "Split impulse error reduction parameter[" << _erp
+           << "] is greater than 1.0. " << "It is set to 1.0." << std::endl;
+    mSplitImpulseErrorReductionParameter = 1.0;
+    return;
+  }
+
+  mSplitImpulseErrorReductionParameter = _erp;
+}
+
+//==============================================================================
+double ContactConstraint::getSplitImpulseErrorReductionParameter()
+{
+  return mSplitImpulseErrorReductionParameter;
+}
+
 //==============================================================================
 void ContactConstraint::setConstraintForceMixing(double _cfm)
 {
@@ -363,6 +450,187 @@ const Eigen::Vector3d& ContactConstraint::getFrictionDirection1() const
   return mFirstFrictionalDirection;
 }
 
+//==============================================================================
+size_t ContactConstraint::getNumContacts() const
+{
+  return mNumContacts;
+}
+
+//==============================================================================
+const collision::Contact& ContactConstraint::getContact(size_t _index) const
+{
+  assert(_index < mNumContacts);
+  return mContacts[_index];
+}
+
+//==============================================================================
+/// Twice the area of triangle (_a, _b, _c) projected onto the plane of _n. It
+/// is positive when the triangle winds counterclockwise about _n.
+static double computeSignedArea2(const Eigen::Vector3d& _a,
+                                 const Eigen::Vector3d& _b,
+                                 const Eigen::Vector3d& _c,
+                                 const Eigen::Vector3d& _n)
+{
+  return (_b - _a).cross(_c - _a).dot(_n);
+}
+
+//==============================================================================
+void ContactConstraint::reduceContacts(
+    std::vector<collision::Contact>* _contacts, size_t _maxNumContacts)
+{
+  assert(_contacts != NULL && "Null pointer is not allowed.");
+
+  std::vector<collision::Contact>& contacts = *_contacts;
+  const size_t numContacts = contacts.size();
+
+  if (numContacts <= _maxNumContacts)
+    return;
+
+  if (_maxNumContacts == 0)
+  {
+    contacts.clear();
+    return;
+  }
+
+  // Contact plane normal. The normals are summed in the body node order of the
+  // first contact.
+  Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+  for (size_t i = 0; i < numContacts; ++i)
+  {
+    if (contacts[i].bodyNode1 == contacts[0].bodyNode1)
+      normal += contacts[i].normal;
+    else
+      normal -= contacts[i].normal;
+  }
+  if (normal.norm() < DART_CONTACT_CONSTRAINT_EPSILON)
+    normal = contacts[0].normal;
+  normal.normalize();
+
+  // Selected contacts in the winding order of the polygon they span
+  std::vector<size_t> polygon;
+  polygon.reserve(_maxNumContacts);
+  std::vector<bool> selected(numContacts, false);
+
+  // 1. The deepest contact
+  size_t deepest = 0;
+  for (size_t i = 1; i < numContacts; ++i)
+  {
+    if (contacts[i].penetrationDepth > contacts[deepest].penetrationDepth)
+      deepest = i;
+  }
+  polygon.push_back(deepest);
+  selected[deepest] = true;
+
+  // 2. The contact farthest from the deepest one in the contact plane
+  if (_maxNumContacts > 1)
+  {
+    const Eigen::Vector3d& p0 = contacts[deepest].point;
+    size_t farthest = deepest;
+    double maxDist = 0.0;
+    for (size_t i = 0; i < numContacts; ++i)
+    {
+      if (selected[i])
+        continue;
+
+      Eigen::Vector3d d = contacts[i].point - p0;
+      d -= d.dot(normal) * normal;
+      if (d.squaredNorm() > maxDist)
+      {
+        maxDist = d.squaredNorm();
+        farthest = i;
+      }
+    }
+
+    if (farthest != deepest)
+    {
+      polygon.push_back(farthest);
+      selected[farthest] = true;
+    }
+  }
+
+  // 3. Contacts that add the most area to the polygon
+  while (polygon.size() >= 2 && polygon.size() < _maxNumContacts)
+  {
+    const size_t numVertices = polygon.size();
+
+    // Winding of the current polygon. A segment has none, so either side
+    // counts.
+    double winding = 0.0;
+    if (numVertices > 2)
+    {
+      const Eigen::Vector3d& p0 = contacts[polygon[0]].point;
+      for (size_t k = 1; k + 1 < numVertices; ++k)
+      {
+        winding += computeSignedArea2(p0, contacts[polygon[k]].point,
+                                      contacts[polygon[k + 1]].point, normal);
+      }
+      winding = winding < 0.0 ? -1.0 : 1.0;
+    }
+
+    size_t best = numContacts;
+    size_t bestEdge = 0;
+    double bestGain = DART_CONTACT_CONSTRAINT_EPSILON
+                      * DART_CONTACT_CONSTRAINT_EPSILON;
+    for (size_t i = 0; i < numContacts; ++i)
+    {
+      if (selected[i])
+        continue;
+
+      const Eigen::Vector3d& q = contacts[i].point;
+
+      // Added area is the sum of the triangles between q and the edges that
+      // q can see
+      double gain = 0.0;
+      double maxEdgeGain = 0.0;
+      size_t edge = 0;
+      const size_t numEdges = numVertices > 2 ? numVertices : 1;
+      for (size_t k = 0; k < numEdges; ++k)
+      {
+        const Eigen::Vector3d& a = contacts[polygon[k]].point;
+        const Eigen::Vector3d& b
+            = contacts[polygon[(k + 1) % numVertices]].point;
+
+        double area = computeSignedArea2(a, b, q, normal);
+        if (numVertices > 2)
+          area = -winding * area;
+        else
+          area = std::fabs(area);
+
+        if (area > 0.0)
+        {
+          gain += area;
+          if (area > maxEdgeGain)
+          {
+            maxEdgeGain = area;
+            edge = k;
+          }
+        }
+      }
+
+      if (gain > bestGain)
+      {
+        bestGain = gain;
+        best = i;
+        bestEdge = edge;
+      }
+    }
+
+    // Remaining contacts are inside the polygon
+    if (best == numContacts)
+      break;
+
+    polygon.insert(polygon.begin() + bestEdge + 1, best);
+    selected[best] = true;
+  }
+
+  std::vector<collision::Contact> reduced;
+  reduced.reserve(polygon.size());
+  for (size_t i = 0; i < polygon.size(); ++i)
+    reduced.push_back(contacts[polygon[i]]);
+
+  contacts.swap(reduced);
+}
+
 //==============================================================================
 void ContactConstraint::update()
 {
@@ -384,7 +652,7 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
   if (mIsFrictionOn)
   {
     size_t index = 0;
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
       // Bias term, w, should be zero
       assert(_info->w[index] == 0.0);
@@ -414,9 +682,10 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
       //------------------------------------------------------------------------
       // Bouncing
       //------------------------------------------------------------------------
-      // A. Penetration correction
+      // A. Penetration correction, unless the split impulse position pass
+      //    takes care of it
       double bouncingVelocity = mContacts[i].penetrationDepth - mErrorAllowance;
-      if (bouncingVelocity < 0.0)
+      if (bouncingVelocity < 0.0 || mSplitImpulseEnabled)
       {
         bouncingVelocity = 0.0;
       }
@@ -468,7 +737,7 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
   //----------------------------------------------------------------------------
   else
   {
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
       // Bias term, w, should be zero
       _info->w[i] = 0.0;
@@ -481,10 +750,11 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
       //------------------------------------------------------------------------
       // Bouncing
       //------------------------------------------------------------------------
-      // A. Penetration correction
+      // A. Penetration correction, unless the split impulse position pass
+      //    takes care of it
       double bouncingVelocity = mContacts[i].penetrationDepth
                                 - DART_ERROR_ALLOWANCE;
-      if (bouncingVelocity < 0.0)
+      if (bouncingVelocity < 0.0 || mSplitImpulseEnabled)
       {
         bouncingVelocity = 0.0;
       }
@@ -530,6 +800,49 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
   }
 }
 
+//==============================================================================
+void ContactConstraint::getPositionInformation(ConstraintInfo* _info)
+{
+  size_t index = 0;
+  for (size_t i = 0; i < mNumContacts; ++i)
+  {
+    // Separating pseudo-velocity that removes the penetration error
+    double errorVelocity = mContacts[i].penetrationDepth - mErrorAllowance;
+    if (errorVelocity < 0.0)
+    {
+      errorVelocity = 0.0;
+    }
+    else
+    {
+      errorVelocity *= mSplitImpulseErrorReductionParameter
+                       * _info->invTimeStep;
+      if (errorVelocity > mMaxErrorReductionVelocity)
+        errorVelocity = mMaxErrorReductionVelocity;
+    }
+
+    _info->b[index]      = errorVelocity;
+    _info->lo[index]     = 0.0;
+    _info->hi[index]     = dInfinity;
+    _info->findex[index] = -1;
+    _info->x[index]      = 0.0;
+    ++index;
+
+    // No friction in the position pass
+    if (mIsFrictionOn)
+    {
+      for (size_t j = 0; j < 2; ++j)
+      {
+        _info->b[index]      = 0.0;
+        _info->lo[index]     = 0.0;
+        _info->hi[index]     = 0.0;
+        _info->findex[index] = -1;
+        _info->x[index]      = 0.0;
+        ++index;
+      }
+    }
+  }
+}
+
 //==============================================================================
 void ContactConstraint::applyUnitImpulse(size_t _idx)
 {
@@ -641,7 +954,7 @@ void ContactConstraint::applyImpulse(double* _lambda)
   {
     size_t index = 0;
 
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
 //      std::cout << "_lambda1: " << _lambda[_idx] << std::endl;
 //      std::cout << "_lambda2: " << _lambda[_idx + 1] << std::endl;
@@ -690,7 +1003,7 @@ void ContactConstraint::applyImpulse(double* _lambda)
   //----------------------------------------------------------------------------
   else
   {
-    for (size_t i = 0; i < mContacts.size(); ++i)
+    for (size_t i = 0; i < mNumContacts; ++i)
     {
       // Normal impulsive force
 //			pContactPts[i]->lambda[0] = _lambda[i];
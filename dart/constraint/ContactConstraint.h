@@ -37,11 +37,18 @@
 #ifndef DART_CONSTRAINT_CONTACTCONSTRAINT_H_
 #define DART_CONSTRAINT_CONTACTCONSTRAINT_H_
 
+#include <vector>
+
 #include "dart/constraint/Constraint.h"
 
 #include "dart/math/MathTypes.h"
 #include "dart/collision/CollisionDetector.h"
 
+/// Maximum number of contact points kept per body pair. Contacts in excess of
+/// this are reduced to a representative manifold before the constraint is
+/// built.
+#define DART_MAX_NUMBER_OF_CONTACTS 4
+
 namespace dart {
 
 namespace dynamics {
@@ -55,9 +62,17 @@ namespace constraint {
 class ContactConstraint : public Constraint
 {
 public:
+  // To get byte-aligned Eigen vectors
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   /// Constructor
   explicit ContactConstraint(const collision::Contact& _contact);
 
+  /// Constructor for a contact manifold. All the contacts should be between
+  /// the same pair of body nodes, and they are reduced by reduceContacts() if
+  /// there are more than DART_MAX_NUMBER_OF_CONTACTS.
+  explicit ContactConstraint(const std::vector<collision::Contact>& _contacts);
+
   /// Destructor
   virtual ~ContactConstraint();
 
@@ -83,6 +98,23 @@ public:
   /// Get global error reduction parameter
   static double getMaxErrorReductionVelocity();
 
+  /// Enable or disable split impulse. When enabled, the penetration error is
+  /// not folded into the velocity LCP. ConstraintSolver removes it in a
+  /// separate position-level pass whose pseudo-velocities only move the
+  /// configurations and are discarded afterwards, so the correction does not
+  /// add kinetic energy. SoftContactConstraint is not split and keeps its
+  /// own error reduction in the velocity LCP.
+  static void setSplitImpulseEnabled(bool _enabled);
+
+  /// Return true if split impulse is enabled
+  static bool isSplitImpulseEnabled();
+
+  /// Set global error reduction parameter of the split impulse position pass
+  static void setSplitImpulseErrorReductionParameter(double _erp);
+
+  /// Get global error reduction parameter of the split impulse position pass
+  static double getSplitImpulseErrorReductionParameter();
+
   /// Set global constraint force mixing parameter
   static void setConstraintForceMixing(double _cfm);
 
@@ -95,6 +127,24 @@ public:
   /// Get first frictional direction
   const Eigen::Vector3d& getFrictionDirection1() const;
 
+  /// Return the number of contact points of this constraint
+  size_t getNumContacts() const;
+
+  /// Return a contact point of this constraint
+  const collision::Contact& getContact(size_t _index) const;
+
+  //----------------------------------------------------------------------------
+  // Contact manifold
+  //----------------------------------------------------------------------------
+
+  /// Reduce _contacts between a single pair of body nodes to at most
+  /// _maxNumContacts points. The deepest contact is always kept. The rest are
+  /// picked to span the largest area in the contact plane so that the reduced
+  /// manifold supports the same rotations as the original one.
+  static void reduceContacts(std::vector<collision::Contact>* _contacts,
+                             size_t _maxNumContacts
+                               = DART_MAX_NUMBER_OF_CONTACTS);
+
   //----------------------------------------------------------------------------
   // Friendship
   //----------------------------------------------------------------------------
@@ -138,6 +188,14 @@ protected:
   virtual bool isActive() const;
 
 private:
+  /// Build the constraint from _numContacts contacts in _contacts
+  void initialize(const collision::Contact* _contacts, size_t _numContacts);
+
+  /// Fill the LCP of the split impulse position pass. Normal rows ask for the
+  /// separating pseudo-velocity that removes the penetration error, and
+  /// frictional rows are clamped to zero.
+  void getPositionInformation(ConstraintInfo* _info);
+
   /// Get change in relative velocity at contact point due to external impulse
   /// \param[out] _relVel Change in relative velocity at contact point of the
   ///                     two colliding bodies
@@ -157,7 +215,10 @@ private:
   dynamics::BodyNode* mBodyNode2;
 
   /// Contacts between mBodyNode1 and mBodyNode2
-  std::vector<collision::Contact> mContacts;
+  collision::Contact mContacts[DART_MAX_NUMBER_OF_CONTACTS];
+
+  /// Number of contacts in mContacts
+  size_t mNumContacts;
 
   /// First frictional direction
   Eigen::Vector3d mFirstFrictionalDirection;
@@ -168,11 +229,13 @@ private:
   /// Coefficient of restitution
   double mRestitutionCoeff;
 
-  /// Local body jacobians for mBodyNode1
-  std::vector<Eigen::Vector6d> mJacobians1;
+  /// Local body jacobians for mBodyNode1. Only the first mDim entries are
+  /// used.
+  Eigen::Vector6d mJacobians1[3 * DART_MAX_NUMBER_OF_CONTACTS];
 
-  /// Local body jacobians for mBodyNode2
-  std::vector<Eigen::Vector6d> mJacobians2;
+  /// Local body jacobians for mBodyNode2. Only the first mDim entries are
+  /// used.
+  Eigen::Vector6d mJacobians2[3 * DART_MAX_NUMBER_OF_CONTACTS];
 
   ///
   bool mIsFrictionOn;
@@ -196,6 +259,13 @@ private:
   /// Maximum error reduction velocity
   static double mMaxErrorReductionVelocity;
 
+  /// Whether split impulse is used instead of Baumgarte stabilization
+  static bool mSplitImpulseEnabled;
+
+  /// Global error reduction parameter of the split impulse position pass in
+  /// the range of [0, 1]. The default is 0.2.
+  static double mSplitImpulseErrorReductionParameter;
+
   /// Global constraint force mixing parameter in the range of [1e-9, 1]. The
   /// default is 1e-5
   /// \sa http://www.ode.org/ode-latest-userguide.html#sec_3_8_0
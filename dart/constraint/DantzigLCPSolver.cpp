@@ -44,6 +44,7 @@
 #include "dart/common/Console.h"
 #include "dart/constraint/Constraint.h"
 #include "dart/constraint/ConstrainedGroup.h"
+#include "dart/constraint/LCPProblemFile.h"
 #include "dart/lcpsolver/LCPSolver.h"
 #include "dart/lcpsolver/Lemke.h"
 #include "dart/lcpsolver/lcp.h"
@@ -164,8 +165,15 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
 //  std::cout << std::endl;
 
   // Solve LCP using ODE's Dantzig algorithm
+  // Capture the LCP before the solver modifies it
+  if (mProblemWriter)
+    mProblemWriter->beginProblem(n, nSkip, A, b, lo, hi, findex);
+
   dSolveLCP(n, A, x, b, w, 0, lo, hi, findex);
 
+  if (mProblemWriter)
+    mProblemWriter->endProblem(x);
+
   // Print LCP formulation
 //  dtdbg << "After solve:" << std::endl;
 //  print(n, A, x, lo, hi, b, w, findex);
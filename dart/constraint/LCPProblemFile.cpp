@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/LCPProblemFile.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "dart/common/Console.h"
+
+#define DART_LCP_FILE_MAGIC "DLCP"
+#define DART_LCP_FILE_VERSION 1
+#define DART_LCP_FILE_MAX_DIMENSION (1 << 16)
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+template <typename T>
+static void writeRaw(std::ofstream& _file, const T* _data, size_t _size)
+{
+  _file.write(reinterpret_cast<const char*>(_data), sizeof(T) * _size);
+}
+
+//==============================================================================
+template <typename T>
+static bool readRaw(std::ifstream& _file, T* _data, size_t _size)
+{
+  _file.read(reinterpret_cast<char*>(_data), sizeof(T) * _size);
+  return static_cast<size_t>(_file.gcount()) == sizeof(T) * _size;
+}
+
+//==============================================================================
+LCPProblemWriter::LCPProblemWriter()
+  : mFrame(0),
+    mGroup(0),
+    mNumProblems(0),
+    mN(0)
+{
+}
+
+//==============================================================================
+LCPProblemWriter::~LCPProblemWriter()
+{
+  close();
+}
+
+//==============================================================================
+bool LCPProblemWriter::open(const std::string& _fileName)
+{
+  close();
+
+  mFile.open(_fileName.c_str(), std::ios::out | std::ios::binary);
+  if (mFile.fail())
+  {
+    dterr << "Failed to open LCP problem file [" << _fileName
+          << "] for writing." << std::endl;
+    return false;
+  }
+
+  const unsigned int version = DART_LCP_FILE_VERSION;
+  mFile.write(DART_LCP_FILE_MAGIC, 4);
+  writeRaw(mFile, &version, 1);
+
+  mFrame = 0;
+  mGroup = 0;
+  mNumProblems = 0;
+
+  return true;
+}
+
+//==============================================================================
+void LCPProblemWriter::close()
+{
+  if (mFile.is_open())
+    mFile.close();
+}
+
+//==============================================================================
+bool LCPProblemWriter::isOpen() const
+{
+  return mFile.is_open();
+}
+
+//==============================================================================
+void LCPProblemWriter::nextFrame()
+{
+  mFrame++;
+  mGroup = 0;
+}
+
+//==============================================================================
+void LCPProblemWriter::beginProblem(size_t _n, size_t _nSkip,
+                                    const double* _A, const double* _b,
+                                    const double* _lo, const double* _hi,
+                                    const int* _findex)
+{
+  mN = _n;
+  mData.resize(_n * (_n + 1) / 2 + 3 * _n);
+  mFIndex.assign(_findex, _findex + _n);
+
+  double* data = &mData[0];
+  for (size_t i = 0; i < _n; ++i)
+  {
+    std::memcpy(data, _A + _nSkip * i + i, sizeof(double) * (_n - i));
+    data += _n - i;
+  }
+  std::memcpy(data, _b, sizeof(double) * _n);
+  data += _n;
+  std::memcpy(data, _lo, sizeof(double) * _n);
+  data += _n;
+  std::memcpy(data, _hi, sizeof(double) * _n);
+}
+
+//==============================================================================
+void LCPProblemWriter::endProblem(const double* _x)
+{
+  if (!mFile.is_open() || mN == 0)
+    return;
+
+  const unsigned int header[3] = {static_cast<unsigned int>(mFrame),
+                                  static_cast<unsigned int>(mGroup),
+                                  static_cast<unsigned int>(mN)};
+
+  writeRaw(mFile, header, 3);
+  writeRaw(mFile, &mData[0], mData.size());
+  writeRaw(mFile, &mFIndex[0], mN);
+  writeRaw(mFile, _x, mN);
+
+  mGroup++;
+  mNumProblems++;
+  mN = 0;
+}
+
+//==============================================================================
+size_t LCPProblemWriter::getNumProblems() const
+{
+  return mNumProblems;
+}
+
+//==============================================================================
+LCPProblemReader::LCPProblemReader()
+  : mFileSize(0)
+{
+}
+
+//==============================================================================
+LCPProblemReader::~LCPProblemReader()
+{
+  close();
+}
+
+//==============================================================================
+bool LCPProblemReader::open(const std::string& _fileName)
+{
+  close();
+
+  mFile.open(_fileName.c_str(), std::ios::in | std::ios::binary);
+  if (mFile.fail())
+  {
+    dterr << "Failed to open LCP problem file [" << _fileName << "]."
+          << std::endl;
+    return false;
+  }
+
+  char magic[4];
+  unsigned int version = 0;
+  if (!readRaw(mFile, magic, 4) || std::strncmp(magic, DART_LCP_FILE_MAGIC, 4)
+      || !readRaw(mFile, &version, 1))
+  {
+    dterr << "[" << _fileName << "] is not an LCP problem file." << std::endl;
+    close();
+    return false;
+  }
+
+  if (version != DART_LCP_FILE_VERSION)
+  {
+    dterr << "Unsupported LCP problem file version [" << version << "]."
+          << std::endl;
+    close();
+    return false;
+  }
+
+  const std::streamoff offset = mFile.tellg();
+  mFile.seekg(0, std::ios::end);
+  mFileSize = mFile.tellg();
+  mFile.seekg(offset);
+
+  return true;
+}
+
+//==============================================================================
+void LCPProblemReader::close()
+{
+  if (mFile.is_open())
+    mFile.close();
+}
+
+//==============================================================================
+bool LCPProblemReader::read(LCPProblem* _problem)
+{
+  assert(_problem != NULL);
+
+  if (!mFile.is_open())
+    return false;
+
+  unsigned int header[3];
+  if (!readRaw(mFile, header, 3))
+    return false;
+
+  // Check the dimension against the rest of the file before allocating
+  const size_t n = header[2];
+  const std::streamoff size
+      = sizeof(double) * (n * (n + 1) / 2 + 4 * n) + sizeof(int) * n;
+  if (n == 0 || n > DART_LCP_FILE_MAX_DIMENSION
+      || size > mFileSize - static_cast<std::streamoff>(mFile.tellg()))
+  {
+    dterr << "Corrupt LCP problem record of dimension [" << n << "]."
+          << std::endl;
+    return false;
+  }
+
+  _problem->frame = header[0];
+  _problem->group = header[1];
+  _problem->A.resize(n, n);
+  _problem->b.resize(n);
+  _problem->lo.resize(n);
+  _problem->hi.resize(n);
+  _problem->findex.resize(n);
+  _problem->x.resize(n);
+
+  std::vector<double> upper(n * (n + 1) / 2);
+  readRaw(mFile, &upper[0], upper.size());
+
+  size_t index = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = i; j < n; ++j)
+    {
+      _problem->A(i, j) = upper[index];
+      _problem->A(j, i) = upper[index];
+      index++;
+    }
+  }
+
+  readRaw(mFile, _problem->b.data(), n);
+  readRaw(mFile, _problem->lo.data(), n);
+  readRaw(mFile, _problem->hi.data(), n);
+  readRaw(mFile, _problem->findex.data(), n);
+  readRaw(mFile, _problem->x.data(), n);
+
+  return true;
+}
+
+//==============================================================================
+std::vector<LCPProblem> LCPProblemReader::readAll()
+{
+  std::vector<LCPProblem> problems;
+  LCPProblem problem;
+
+  while (read(&problem))
+    problems.push_back(problem);
+
+  return problems;
+}
+
+}  // namespace constraint
+}  // namespace dart
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Geoorgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_CONSTRAINT_LCPPROBLEMFILE_H_
+#define DART_CONSTRAINT_LCPPROBLEMFILE_H_
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace constraint {
+
+/// Boxed LCP of a single constrained group:
+///   w = A * x - b, lo <= x <= hi, complementarity between w and x
+/// Rows with findex[i] >= 0 are friction rows whose bounds are
+/// -hi[i] * |x[findex[i]]| and hi[i] * |x[findex[i]]|.
+struct LCPProblem
+{
+  /// Frame in which the problem was captured
+  size_t frame;
+
+  /// Index of the constrained group within the frame
+  size_t group;
+
+  /// LCP matrix (symmetric)
+  Eigen::MatrixXd A;
+
+  /// Bias
+  Eigen::VectorXd b;
+
+  /// Lower bound
+  Eigen::VectorXd lo;
+
+  /// Upper bound
+  Eigen::VectorXd hi;
+
+  /// Friction index
+  Eigen::VectorXi findex;
+
+  /// Solution computed by the capturing solver
+  Eigen::VectorXd x;
+};
+
+/// LCPProblemWriter writes constrained group LCPs to a compact binary file.
+///
+/// File layout (native byte order):
+///   header : char[4] "DLCP", uint32 version
+///   record : uint32 frame, uint32 group, uint32 n,
+///            double A[n * (n + 1) / 2] (upper triangle, row-major),
+///            double b[n], double lo[n], double hi[n], int32 findex[n],
+///            double x[n]
+class LCPProblemWriter
+{
+public:
+  /// Constructor
+  LCPProblemWriter();
+
+  /// Destructor
+  virtual ~LCPProblemWriter();
+
+  /// Open a file for writing. Return false if the file cannot be opened.
+  bool open(const std::string& _fileName);
+
+  /// Close the file
+  void close();
+
+  /// Return true if the file is open
+  bool isOpen() const;
+
+  /// Advance the frame counter. Called once per ConstraintSolver::solve().
+  void nextFrame();
+
+  /// Keep a copy of the LCP before the solver modifies it. A is row-major
+  /// with row stride _nSkip.
+  void beginProblem(size_t _n, size_t _nSkip, const double* _A,
+                    const double* _b, const double* _lo, const double* _hi,
+                    const int* _findex);
+
+  /// Write the problem passed to beginProblem() together with its solution
+  void endProblem(const double* _x);
+
+  /// Return the number of written problems
+  size_t getNumProblems() const;
+
+protected:
+  /// Output stream
+  std::ofstream mFile;
+
+  /// Current frame
+  size_t mFrame;
+
+  /// Index of the next group in the current frame
+  size_t mGroup;
+
+  /// Number of written problems
+  size_t mNumProblems;
+
+  /// Dimension of the pending problem
+  size_t mN;
+
+  /// Pending problem (upper triangle of A followed by b, lo and hi)
+  std::vector<double> mData;
+
+  /// Pending friction indices
+  std::vector<int> mFIndex;
+};
+
+/// LCPProblemReader reads files written by LCPProblemWriter
+class LCPProblemReader
+{
+public:
+  /// Constructor
+  LCPProblemReader();
+
+  /// Destructor
+  virtual ~LCPProblemReader();
+
+  /// Open a file and check its header. Return false on failure.
+  bool open(const std::string& _fileName);
+
+  /// Close the file
+  void close();
+
+  /// Read the next problem. Return false at the end of the file or on a
+  /// record whose dimension does not fit the rest of the file.
+  bool read(LCPProblem* _problem);
+
+  /// Read all the remaining problems of the file
+  std::vector<LCPProblem> readAll();
+
+protected:
+  /// Input stream
+  std::ifstream mFile;
+
+  /// Size of the open file in bytes
+  std::streamoff mFileSize;
+};
+
+}  // namespace constraint
+}  // namespace dart
+
+#endif  // DART_CONSTRAINT_LCPPROBLEMFILE_H_
@@ -37,6 +37,7 @@
 #include "dart/constraint/LCPSolver.h"
 
 #include <cassert>
+#include <cstddef>
 
 namespace dart {
 namespace constraint {
@@ -55,7 +56,21 @@ double LCPSolver::getTimeStep() const
 }
 
 //==============================================================================
-LCPSolver::LCPSolver(double _timeStep) : mTimeStep(_timeStep)
+void LCPSolver::setProblemWriter(LCPProblemWriter* _writer)
+{
+  mProblemWriter = _writer;
+}
+
+//==============================================================================
+LCPProblemWriter* LCPSolver::getProblemWriter() const
+{
+  return mProblemWriter;
+}
+
+//==============================================================================
+LCPSolver::LCPSolver(double _timeStep)
+  : mTimeStep(_timeStep),
+    mProblemWriter(NULL)
 {
 }
 
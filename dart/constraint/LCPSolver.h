@@ -41,11 +41,19 @@ namespace dart {
 namespace constraint {
 
 class ConstrainedGroup;
+class LCPProblemWriter;
 
 /// LCPSolver
 class LCPSolver
 {
 public:
+  /// Destructor
+  virtual ~LCPSolver();
+
+  /// Called by ConstraintSolver once per step before the constrained groups
+  /// are solved
+  virtual void beginStep() {}
+
   /// Solve constriant impulses for a constrained group
   virtual void solve(ConstrainedGroup* _group) = 0;
 
@@ -55,16 +63,23 @@ public:
   /// Return time step
   double getTimeStep() const;
 
+  /// Set the writer that captures every solved LCP. Pass NULL to stop
+  /// capturing. The writer is not owned by this solver.
+  void setProblemWriter(LCPProblemWriter* _writer);
+
+  /// Return the problem writer
+  LCPProblemWriter* getProblemWriter() const;
+
 protected:
   /// Constructor
   LCPSolver(double _timeStep);
 
-  /// Destructor
-  virtual ~LCPSolver();
-
 protected:
   /// Simulation time step
   double mTimeStep;
+
+  /// Problem writer
+  LCPProblemWriter* mProblemWriter;
 };
 
 } // namespace constraint
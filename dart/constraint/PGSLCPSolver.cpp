@@ -36,6 +36,8 @@
 
 #include "dart/constraint/PGSLCPSolver.h"
 
+#include <algorithm>
+
 #ifdef BUILD_TYPE_DEBUG
 #include <iomanip>
 #include <iostream>
@@ -44,6 +46,7 @@
 #include "dart/common/Console.h"
 #include "dart/constraint/Constraint.h"
 #include "dart/constraint/ConstrainedGroup.h"
+#include "dart/constraint/LCPProblemFile.h"
 #include "dart/lcpsolver/LCPSolver.h"
 #include "dart/lcpsolver/Lemke.h"
 #include "dart/lcpsolver/lcp.h"
@@ -167,8 +170,15 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
 //  dSolveLCP(n, A, x, b, w, 0, lo, hi, findex);
   PGSOption option;
   option.setDefault();
+  // Capture the LCP before the solver modifies it
+  if (mProblemWriter)
+    mProblemWriter->beginProblem(n, nSkip, A, b, lo, hi, findex);
+
   solvePGS(n, nSkip, 0, A, x, b, lo, hi, findex, &option);
 
+  if (mProblemWriter)
+    mProblemWriter->endProblem(x);
+
   // Print LCP formulation
   //  dtdbg << "After solve:" << std::endl;
   //  print(n, A, x, lo, hi, b, w, findex);
@@ -347,7 +357,8 @@ void PGSLCPSolver::print(size_t _n, double* _A, double* _x,
 #endif
 
 bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
-              double * lo, double * hi, int * findex, PGSOption * option)
+              double * lo, double * hi, int * findex, PGSOption * option,
+              int* numIterations)
 {
   // LDLT solver will work !!!
   //if (nub == n)
@@ -420,6 +431,8 @@ bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
   }
   if (sentinel)
   {
+    if (numIterations)
+      *numIterations = 1;
     delete[] order;
     return true;
   }
@@ -504,6 +517,8 @@ bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
     if (sentinel)
       break;
   }
+  if (numIterations)
+    *numIterations = std::min(iter + 1, option->itermax);
   delete[] order;
   return sentinel;
 }
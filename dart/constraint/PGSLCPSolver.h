@@ -83,10 +83,12 @@ struct PGSOption
   void setDefault();
 };
 
+/// Solve the boxed LCP with projected Gauss-Seidel. Return true if converged.
+/// If numIterations is not NULL, the number of sweeps is written to it.
 bool solvePGS(int n, int nskip, int /*nub*/, double* A,
                             double* x, double * b,
                             double * lo, double * hi, int * findex,
-                            PGSOption * option);
+                            PGSOption * option, int* numIterations = NULL);
 
 
 } // namespace constraint
@@ -92,25 +92,16 @@ SoftContactConstraint::SoftContactConstraint(const collision::Contact& _contact)
   mSoftBodyNode1 = dynamic_cast<dynamics::SoftBodyNode*>(mBodyNode1);
   mSoftBodyNode2 = dynamic_cast<dynamics::SoftBodyNode*>(mBodyNode2);
 
-  // Set the colliding state of body nodes and point masses to false
-  if (mSoftBodyNode1)
-  {
-    for (int i = 0; i < mSoftBodyNode1->getNumPointMasses(); ++i)
-      mSoftBodyNode1->getPointMass(i)->setColliding(false);
-  }
-  if (mSoftBodyNode2)
-  {
-    for (int i = 0; i < mSoftBodyNode2->getNumPointMasses(); ++i)
-      mSoftBodyNode2->getPointMass(i)->setColliding(false);
-  }
-
-  // Select colling point mass based on trimesh ID
+  // Select colling point mass based on trimesh ID. The colliding state is
+  // set here and reset when this constraint is destroyed, so only the point
+  // masses in contact are visited.
   if (mSoftBodyNode1)
   {
     if (_contact.shape1->getShapeType() == dynamics::Shape::SOFT_MESH)
     {
       mPointMass1 = selectCollidingPointMass(mSoftBodyNode1, _contact.point,
                                              _contact.triID1);
+      mPointMass1->setColliding(true);
     }
   }
   if (mSoftBodyNode2)
@@ -119,6 +110,7 @@ SoftContactConstraint::SoftContactConstraint(const collision::Contact& _contact)
     {
       mPointMass2 = selectCollidingPointMass(mSoftBodyNode2, _contact.point,
                                              _contact.triID2);
+      mPointMass2->setColliding(true);
     }
   }
 
@@ -296,6 +288,10 @@ SoftContactConstraint::SoftContactConstraint(const collision::Contact& _contact)
 //==============================================================================
 SoftContactConstraint::~SoftContactConstraint()
 {
+  if (mPointMass1)
+    mPointMass1->setColliding(false);
+  if (mPointMass2)
+    mPointMass2->setColliding(false);
 }
 
 //==============================================================================
@@ -996,38 +992,7 @@ dynamics::PointMass* SoftContactConstraint::selectCollidingPointMass(
     const Eigen::Vector3d& _point,
     int _faceId)
 {
-  dynamics::PointMass* pointMass = NULL;
-
-  const Eigen::Vector3i& face = _softBodyNode->getFace(_faceId);
-
-  dynamics::PointMass* pm0 = _softBodyNode->getPointMass(face[0]);
-  dynamics::PointMass* pm1 = _softBodyNode->getPointMass(face[1]);
-  dynamics::PointMass* pm2 = _softBodyNode->getPointMass(face[2]);
-
-  const Eigen::Vector3d& pos1 = pm0->getWorldPosition();
-  const Eigen::Vector3d& pos2 = pm1->getWorldPosition();
-  const Eigen::Vector3d& pos3 = pm2->getWorldPosition();
-
-  double dist0 = (pos1 - _point).dot(pos1 - _point);
-  double dist1 = (pos2 - _point).dot(pos2 - _point);
-  double dist2 = (pos3 - _point).dot(pos3 - _point);
-
-  if (dist0 > dist1)
-  {
-    if (dist1 > dist2)
-      pointMass = pm2;
-    else
-      pointMass = pm1;
-  }
-  else
-  {
-    if (dist0 > dist2)
-      pointMass = pm2;
-    else
-      pointMass = pm0;
-  }
-
-  return pointMass;
+  return _softBodyNode->getClosestPointMass(_faceId, _point);
 }
 
 }  // namespace constraint
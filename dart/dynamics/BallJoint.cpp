@@ -46,30 +46,21 @@ namespace dynamics {
 
 //==============================================================================
 BallJoint::BallJoint(const std::string& _name)
-  : Joint(_name),
+  : MultiDofJoint<3>(_name),
     mR(Eigen::Isometry3d::Identity())
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-  mGenCoords.push_back(&mCoordinate[2]);
-
-  mS = Eigen::Matrix<double, 6, 3>::Zero();
   Eigen::Vector6d J0 = Eigen::Vector6d::Zero();
   Eigen::Vector6d J1 = Eigen::Vector6d::Zero();
   Eigen::Vector6d J2 = Eigen::Vector6d::Zero();
   J0[0] = 1.0;
   J1[1] = 1.0;
   J2[2] = 1.0;
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
-  assert(!math::isNan(mS));
-
-  mdS = Eigen::Matrix<double, 6, 3>::Zero();
+  mJacobian.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
+  mJacobian.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
+  mJacobian.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
+  assert(!math::isNan(mJacobian));
 
-  mSpringStiffness.resize(3, 0.0);
-  mDampingCoefficient.resize(3, 0.0);
-  mRestPosition.resize(3, 0.0);
+  mS = mJacobian;
 }
 
 //==============================================================================
@@ -89,25 +80,72 @@ void BallJoint::setTransformFromChildBodyNode(const Eigen::Isometry3d& _T)
   J1[1] = 1.0;
   J2[2] = 1.0;
 
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
+  mJacobian.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
+  mJacobian.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
+  mJacobian.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
+
+  assert(!math::isNan(mJacobian));
+
+  mS = mJacobian;
+}
+
+//==============================================================================
+math::Jacobian BallJoint::getLocalJacobianDeriv(size_t _index) const
+{
+  assert(_index < 3);
+  return math::Jacobian::Zero(6, 3);
+}
+
+//==============================================================================
+math::Jacobian BallJoint::getLocalJacobianTimeDerivDeriv(size_t _index) const
+{
+  assert(_index < 3);
+  return math::Jacobian::Zero(6, 3);
+}
 
-  assert(!math::isNan(mS));
+//==============================================================================
+Eigen::MatrixXd BallJoint::getConfigsPerturbationDeriv() const
+{
+  // log(exp(q) * exp(eps)) = q + J_r(q)^{-1} * eps + O(eps^2), where the right
+  // Jacobian J_r(q) is the transpose of expMapJac(q)
+  return math::expMapJac(getConfigsStatic()).transpose().inverse();
 }
 
 //==============================================================================
 void BallJoint::integrateConfigs(double _dt)
 {
-  mR.linear() = mR.linear() * math::expMapRot(getGenVels() * _dt);
+  // Integrate on SO(3) from the configurations rather than from mR, which is
+  // stale when the configurations were set without updating the transforms
+  // as in the intermediate stages of RK4Integrator.
+  const Eigen::Matrix3d R = math::expMapRot(getConfigsStatic())
+                            * math::expMapRot(getGenVelsStatic() * _dt);
+
+  setConfigsStatic(math::logMap(R));
+}
 
-  GenCoordSystem::setConfigs(math::logMap(mR.linear()));
+//==============================================================================
+void BallJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                       const Eigen::VectorXd& _genVels,
+                                       Eigen::Isometry3d* _T,
+                                       math::Jacobian* _S,
+                                       math::Jacobian* _dS) const
+{
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 3 && _genVels.size() == 3);
+
+  Eigen::Isometry3d R = Eigen::Isometry3d::Identity();
+  R.linear() = math::expMapRot(_configs);
+  *_T = mT_ParentBodyToJoint * R * mT_ChildBodyToJoint.inverse();
+
+  // Jacobian is constant
+  *_S = mJacobian;
+  _dS->setZero(6, 3);
 }
 
 //==============================================================================
 void BallJoint::updateTransform()
 {
-  mR.linear() = math::expMapRot(getConfigs());
+  mR.linear() = math::expMapRot(getConfigsStatic());
 
   mT = mT_ParentBodyToJoint * mR * mT_ChildBodyToJoint.inverse();
 
@@ -115,16 +153,16 @@ void BallJoint::updateTransform()
 }
 
 //==============================================================================
-void BallJoint::updateJacobian()
+void BallJoint::updateLocalJacobian()
 {
   // Jacobian is constant
 }
 
 //==============================================================================
-void BallJoint::updateJacobianTimeDeriv()
+void BallJoint::updateLocalJacobianTimeDeriv()
 {
   // Time derivative of Jacobian is constant
-  assert(mdS == Eigen::MatrixXd::Zero(6, 3));
+  assert(mJacobianDeriv == JacobianMatrix::Zero());
 }
 
 }  // namespace dynamics
@@ -39,14 +39,13 @@
 
 #include <Eigen/Dense>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
 /// \brief class BallJoint
-class BallJoint : public Joint
+class BallJoint : public MultiDofJoint<3>
 {
 public:
   /// \brief Constructor
@@ -58,6 +57,24 @@ public:
   // Documentation inherited
   virtual void setTransformFromChildBodyNode(const Eigen::Isometry3d& _T);
 
+  /// \brief The configuration of this joint is perturbed in the child body
+  /// frame as in integrateConfigs(), so the local Jacobian is constant.
+  virtual math::Jacobian getLocalJacobianDeriv(size_t _index) const;
+
+  // Documentation inherited
+  virtual math::Jacobian getLocalJacobianTimeDerivDeriv(size_t _index) const;
+
+  /// \brief Get the inverse of the right Jacobian of the exponential map of
+  /// SO(3) at the configurations
+  virtual Eigen::MatrixXd getConfigsPerturbationDeriv() const;
+
+  // Documentation inherited
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
 protected:
   // Documentation inherited
   virtual void integrateConfigs(double _dt);
@@ -66,15 +83,12 @@ protected:
   virtual void updateTransform();
 
   // Documentation inherited
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobianTimeDeriv();
 
 protected:
-  /// \brief Generalized coordinates
-  GenCoord mCoordinate[3];
-
   /// \brief Rotation matrix
   Eigen::Isometry3d mR;
 
@@ -38,6 +38,7 @@
 #include "dart/dynamics/BodyNode.h"
 
 #include <algorithm>
+#include <new>
 #include <vector>
 #include <string>
 
@@ -62,42 +63,63 @@ int BodyNode::msBodyNodeCount = 0;
 
 //==============================================================================
 BodyNode::BodyNode(const std::string& _name)
-  : mSkelIndex(-1),
+  : mID(BodyNode::msBodyNodeCount++),
     mName(_name),
-    mIsCollidable(true),
-    mIsColliding(false),
-    mSkeleton(NULL),
-    mParentJoint(NULL),
-    mParentBodyNode(NULL),
-    mChildBodyNodes(std::vector<BodyNode*>(0)),
+    mSkelIndex(-1),
     mGravityMode(true),
+    mI(Eigen::Matrix6d::Identity()),
     mCenterOfMass(Eigen::Vector3d::Zero()),
-    mMass(1.0),
     mIxx(1.0),
     mIyy(1.0),
     mIzz(1.0),
     mIxy(0.0),
     mIxz(0.0),
     mIyz(0.0),
+    mMass(1.0),
     mFrictionCoeff(DART_DEFAULT_FRICTION_COEFF),
     mRestitutionCoeff(DART_DEFAULT_RESTITUTION_COEFF),
-    mI(Eigen::Matrix6d::Identity()),
+    mIsCollidable(true),
+    mIsColliding(false),
+    mSkeleton(NULL),
+    mParentJoint(NULL),
+    mParentBodyNode(NULL),
+    mChildBodyNodes(std::vector<BodyNode*>(0)),
     mW(Eigen::Isometry3d::Identity()),
+    mIsBodyJacobianDirty(true),
+    mIsBodyJacobianTimeDerivDirty(true),
+    mIsWorldTransformDirty(false),
+    mIsVelocityDirty(false),
+    mIsAccelerationDirty(false),
     mV(Eigen::Vector6d::Zero()),
     mEta(Eigen::Vector6d::Zero()),
     mdV(Eigen::Vector6d::Zero()),
     mF(Eigen::Vector6d::Zero()),
     mFext(Eigen::Vector6d::Zero()),
     mFgravity(Eigen::Vector6d::Zero()),
-    mAI(Eigen::Matrix6d::Identity()),
-    mB(Eigen::Vector6d::Zero()),
-    mBeta(Eigen::Vector6d::Zero()),
-    mID(BodyNode::msBodyNodeCount++),
-    mIsBodyJacobianDirty(true),
-    mIsBodyJacobianTimeDerivDirty(true),
+    mAI(NULL),
+    mImplicitAI(NULL),
+    mB(NULL),
+    mAI_S(NULL, 6, 0),
+    mImplicitAI_S(NULL, 6, 0),
+    mAI_S_Psi(NULL, 6, 0),
+    mImplicitAI_S_ImplicitPsi(NULL, 6, 0),
+    mPsi(NULL, 0, 0),
+    mImplicitPsi(NULL, 0, 0),
+    mPi(NULL),
+    mImplicitPi(NULL),
+    mAlpha(NULL, 0),
+    mBeta(NULL),
+    mDerivLocalIndex(-1),
+    mSubtreeMass(0.0),
+    mSubtreeMassCOM(Eigen::Vector3d::Zero()),
+    mSubtreeMassCOMVel(Eigen::Vector3d::Zero()),
+    mIsOpInertiaDirty(true),
+    mIsOpBiasForceDirty(true),
+    mIsOpJacobianInverseDirty(true),
     mDelV(Eigen::Vector6d::Zero()),
-    mImpB(Eigen::Vector6d::Zero()),
-    mImpBeta(Eigen::Vector6d::Zero()),
+    mImpB(NULL),
+    mImpAlpha(NULL, 0),
+    mImpBeta(NULL),
     mConstraintImpulse(Eigen::Vector6d::Zero()),
     mImpF(Eigen::Vector6d::Zero())
 {
@@ -315,51 +337,65 @@ void BodyNode::fitWorldAngularVel(const Eigen::Vector3d& _targetAngVel,
   parentJoint->setGenVels(jointDQ, true, true);
 }
 
+// The kinematic quantities below are caches of the generalized coordinates.
+// Refreshing a stale cache does not change the logical state of this body
+// node, so the const getters may update them.
 const Eigen::Isometry3d& BodyNode::getWorldTransform() const {
+  if (mIsWorldTransformDirty)
+    const_cast<BodyNode*>(this)->updateTransform();
   return mW;
 }
 
 const Eigen::Vector6d& BodyNode::getBodyVelocity() const {
+  if (mIsVelocityDirty) {
+    BodyNode* self = const_cast<BodyNode*>(this);
+    self->updateVelocity();
+    self->updateEta();
+  }
   return mV;
 }
 
 Eigen::Vector6d BodyNode::getWorldVelocity(
     const Eigen::Vector3d& _offset, bool _isLocal) const {
-  Eigen::Isometry3d T = mW;
+  Eigen::Isometry3d T = getWorldTransform();
   if (_isLocal)
     T.translation() = mW.linear() * -_offset;
   else
     T.translation() = -_offset;
-  return math::AdT(T, mV);
+  return math::AdT(T, getBodyVelocity());
 }
 
 const Eigen::Vector6d& BodyNode::getBodyAcceleration() const {
+  if (mIsAccelerationDirty)
+    const_cast<BodyNode*>(this)->updateAcceleration();
   return mdV;
 }
 
 Eigen::Vector6d BodyNode::getWorldAcceleration(
     const Eigen::Vector3d& _offset, bool _isOffsetLocal) const {
-  Eigen::Isometry3d T = mW;
+  Eigen::Isometry3d T = getWorldTransform();
   if (_isOffsetLocal)
     T.translation() = mW.linear() * -_offset;
   else
     T.translation() = -_offset;
 
-  Eigen::Vector6d dV = mdV;
+  Eigen::Vector6d dV = getBodyAcceleration();
   dV.tail<3>() += mV.head<3>().cross(mV.tail<3>());
 
   return math::AdT(T, dV);
 }
 
 const math::Jacobian& BodyNode::getBodyJacobian() {
-  if (mIsBodyJacobianDirty)
+  if (mIsBodyJacobianDirty) {
+    getWorldTransform();
     _updateBodyJacobian();
+  }
   return mBodyJacobian;
 }
 
 math::Jacobian BodyNode::getWorldJacobian(
     const Eigen::Vector3d& _offset, bool _isOffsetLocal) {
-  Eigen::Isometry3d T = mW;
+  Eigen::Isometry3d T = getWorldTransform();
   if (_isOffsetLocal)
     T.translation() = mW.linear() * -_offset;
   else
@@ -368,14 +404,16 @@ math::Jacobian BodyNode::getWorldJacobian(
 }
 
 const math::Jacobian& BodyNode::getBodyJacobianTimeDeriv() {
-  if (mIsBodyJacobianTimeDerivDirty)
+  if (mIsBodyJacobianTimeDerivDirty) {
+    getBodyVelocity();
     _updateBodyJacobianTimeDeriv();
+  }
   return mBodyJacobianTimeDeriv;
 }
 
 math::Jacobian BodyNode::getWorldJacobianTimeDeriv(
     const Eigen::Vector3d& _offset, bool _isOffsetLocal) {
-  Eigen::Isometry3d T = mW;
+  Eigen::Isometry3d T = getWorldTransform();
   if (_isOffsetLocal)
     T.translation() = mW.linear() * -_offset;
   else
@@ -391,6 +429,30 @@ math::Jacobian BodyNode::getWorldJacobianTimeDeriv(
   return math::AdTJac(T, bodyJacobianTimeDeriv);
 }
 
+//==============================================================================
+const Eigen::Matrix6d& BodyNode::getOperationalSpaceInertia()
+{
+  return mSkeleton->getOperationalSpaceInertia(this);
+}
+
+//==============================================================================
+const Eigen::Matrix6d& BodyNode::getInvOperationalSpaceInertia()
+{
+  return mSkeleton->getInvOperationalSpaceInertia(this);
+}
+
+//==============================================================================
+const Eigen::Vector6d& BodyNode::getOperationalSpaceBiasForce()
+{
+  return mSkeleton->getOperationalSpaceBiasForce(this);
+}
+
+//==============================================================================
+const Eigen::MatrixXd& BodyNode::getDynamicallyConsistentJacobianInverse()
+{
+  return mSkeleton->getDynamicallyConsistentJacobianInverse(this);
+}
+
 //==============================================================================
 const Eigen::Vector6d& BodyNode::getBodyVelocityChange() const
 {
@@ -447,17 +509,62 @@ void BodyNode::init(Skeleton* _skeleton, int _skeletonIndex)
   int numDepGenCoords = getNumDependentGenCoords();
   mBodyJacobian.setZero(6, numDepGenCoords);
   mBodyJacobianTimeDeriv.setZero(6, numDepGenCoords);
+}
 
-  //--------------------------------------------------------------------------
-  // Set dimensions of cache data for recursive algorithms
-  //--------------------------------------------------------------------------
+int BodyNode::getArticulatedBodyStateSize() const
+{
+  // mAI, mImplicitAI, mPi, mImplicitPi: 4 * 36
+  // mB, mBeta, mImpB, mImpBeta: 4 * 6
+  // mAI_S, mImplicitAI_S, mAI_S_Psi, mImplicitAI_S_ImplicitPsi: 4 * 6 * dof
+  // mPsi, mImplicitPsi: 2 * dof * dof
+  // mAlpha, mImpAlpha: 2 * dof
   int dof = mParentJoint->getNumGenCoords();
-  mAI_S.setZero(6, dof);
-  mPsi.setZero(dof, dof);
-  mImplicitPsi.setZero(dof, dof);
-  mAlpha.setZero(dof);
+  return 4 * 36 + 4 * 6 + 4 * 6 * dof + 2 * dof * dof + 2 * dof;
+}
+
+void BodyNode::mapArticulatedBodyState(double* _data)
+{
+  assert(_data != NULL);
 
-  mImpAlpha.setZero(dof);
+  int dof = mParentJoint->getNumGenCoords();
+  std::fill(_data, _data + getArticulatedBodyStateSize(), 0.0);
+
+  // Rebind the views with placement new, the only way to change the array of
+  // an Eigen::Map.
+  double* data = _data;
+  new (&mAI) Eigen::Map<math::Inertia>(data);
+  data += 36;
+  new (&mImplicitAI) Eigen::Map<math::Inertia>(data);
+  data += 36;
+  new (&mPi) Eigen::Map<math::Inertia>(data);
+  data += 36;
+  new (&mImplicitPi) Eigen::Map<math::Inertia>(data);
+  data += 36;
+  new (&mB) Eigen::Map<Eigen::Vector6d>(data);
+  data += 6;
+  new (&mBeta) Eigen::Map<Eigen::Vector6d>(data);
+  data += 6;
+  new (&mImpB) Eigen::Map<Eigen::Vector6d>(data);
+  data += 6;
+  new (&mImpBeta) Eigen::Map<Eigen::Vector6d>(data);
+  data += 6;
+  new (&mAI_S) Eigen::Map<math::Jacobian>(data, 6, dof);
+  data += 6 * dof;
+  new (&mImplicitAI_S) Eigen::Map<math::Jacobian>(data, 6, dof);
+  data += 6 * dof;
+  new (&mAI_S_Psi) Eigen::Map<math::Jacobian>(data, 6, dof);
+  data += 6 * dof;
+  new (&mImplicitAI_S_ImplicitPsi) Eigen::Map<math::Jacobian>(data, 6, dof);
+  data += 6 * dof;
+  new (&mPsi) Eigen::Map<Eigen::MatrixXd>(data, dof, dof);
+  data += dof * dof;
+  new (&mImplicitPsi) Eigen::Map<Eigen::MatrixXd>(data, dof, dof);
+  data += dof * dof;
+  new (&mAlpha) Eigen::Map<Eigen::VectorXd>(data, dof);
+  data += dof;
+  new (&mImpAlpha) Eigen::Map<Eigen::VectorXd>(data, dof);
+  data += dof;
+  assert(data - _data == getArticulatedBodyStateSize());
 }
 
 void BodyNode::aggregateGenCoords(std::vector<GenCoord*>* _genCoords) {
@@ -475,6 +582,9 @@ void BodyNode::draw(renderer::RenderInterface* _ri,
   if (_ri == NULL)
     return;
 
+  // Bring the local transformation of the parent joint up to date
+  getWorldTransform();
+
   _ri->pushMatrix();
 
   // render the self geometry
@@ -527,6 +637,8 @@ void BodyNode::updateTransform() {
   assert(math::verifyTransform(mW));
 
   mParentJoint->updateJacobian();
+
+  mIsWorldTransformDirty = false;
 }
 
 void BodyNode::updateVelocity() {
@@ -536,8 +648,11 @@ void BodyNode::updateVelocity() {
   // V(i) = Ad(T(i, i-1), V(i-1)) + S * dq
   //--------------------------------------------------------------------------
 
+  if (mIsWorldTransformDirty)
+    updateTransform();
+
   if (mParentJoint->getNumGenCoords() > 0) {
-    mV.noalias() = mParentJoint->getLocalJacobian() * mParentJoint->getGenVels();
+    mV = mParentJoint->getLocalJacobianTimesGenVels();
     if (mParentBodyNode) {
       mV += math::AdInvT(mParentJoint->getLocalTransform(),
                          mParentBodyNode->getBodyVelocity());
@@ -545,16 +660,16 @@ void BodyNode::updateVelocity() {
   }
 
   assert(!math::isNan(mV));
+
+  mIsVelocityDirty = false;
 }
 
 void BodyNode::updateEta() {
   mParentJoint->updateJacobianTimeDeriv();
 
   if (mParentJoint->getNumGenCoords() > 0) {
-    mEta = math::ad(mV, mParentJoint->getLocalJacobian() *
-                    mParentJoint->getGenVels());
-    mEta.noalias() += mParentJoint->getLocalJacobianTimeDeriv() *
-                      mParentJoint->getGenVels();
+    mEta = math::ad(mV, mParentJoint->getLocalJacobianTimesGenVels());
+    mEta += mParentJoint->getLocalJacobianTimeDerivTimesGenVels();
     assert(!math::isNan(mEta));
   }
 }
@@ -567,9 +682,14 @@ void BodyNode::updateAcceleration() {
   //         + eta
   //         + S * ddq
 
+  if (mIsVelocityDirty) {
+    updateVelocity();
+    updateEta();
+  }
+
   if (mParentJoint->getNumGenCoords() > 0) {
     mdV = mEta;
-    mdV.noalias() += mParentJoint->getLocalJacobian() * mParentJoint->getGenAccs();
+    mdV += mParentJoint->getLocalJacobianTimesGenAccs();
     if (mParentBodyNode) {
       mdV += math::AdInvT(mParentJoint->getLocalTransform(),
                           mParentBodyNode->getBodyAcceleration());
@@ -577,6 +697,8 @@ void BodyNode::updateAcceleration() {
   }
 
   assert(!math::isNan(mdV));
+
+  mIsAccelerationDirty = false;
 }
 
 void BodyNode::setInertia(double _Ixx, double _Iyy, double _Izz,
@@ -606,7 +728,7 @@ const Eigen::Vector3d& BodyNode::getLocalCOM() const {
 }
 
 Eigen::Vector3d BodyNode::getWorldCOM() const {
-  return mW * mCenterOfMass;
+  return getWorldTransform() * mCenterOfMass;
 }
 
 Eigen::Vector3d BodyNode::getWorldCOMVelocity() const {
@@ -614,7 +736,13 @@ Eigen::Vector3d BodyNode::getWorldCOMVelocity() const {
 }
 
 Eigen::Vector3d BodyNode::getWorldCOMAcceleration() const {
-  return getWorldAcceleration(mCenterOfMass, true).tail<3>();
+  // getWorldAcceleration() transports the spatial acceleration to the COM,
+  // which leaves out the centripetal term w x (w x r) of the point.
+  const Eigen::Matrix3d& R = getWorldTransform().linear();
+  Eigen::Vector3d w = R * getBodyVelocity().head<3>();
+  Eigen::Vector3d r = R * mCenterOfMass;
+  return getWorldAcceleration(mCenterOfMass, true).tail<3>()
+      + w.cross(w.cross(r));
 }
 
 Eigen::Matrix6d BodyNode::getInertia() const {
@@ -678,7 +806,7 @@ void BodyNode::addExtForce(const Eigen::Vector3d& _force,
   if (_isForceLocal)
     F.tail<3>() = _force;
   else
-    F.tail<3>() = mW.linear().transpose() * _force;
+    F.tail<3>() = getWorldTransform().linear().transpose() * _force;
 
   mFext += math::dAdInvT(T, F);
 }
@@ -699,7 +827,7 @@ void BodyNode::setExtForce(const Eigen::Vector3d& _force,
   if (_isForceLocal)
     F.tail<3>() = _force;
   else
-    F.tail<3>() = mW.linear().transpose() * _force;
+    F.tail<3>() = getWorldTransform().linear().transpose() * _force;
 
   mFext = math::dAdInvT(T, F);
 }
@@ -710,7 +838,7 @@ void BodyNode::addExtTorque(const Eigen::Vector3d& _torque, bool _isLocal)
   if (_isLocal)
     mFext.head<3>() += _torque;
   else
-    mFext.head<3>() += mW.linear().transpose() * _torque;
+    mFext.head<3>() += getWorldTransform().linear().transpose() * _torque;
 }
 
 //==============================================================================
@@ -719,7 +847,7 @@ void BodyNode::setExtTorque(const Eigen::Vector3d& _torque, bool _isLocal)
   if (_isLocal)
     mFext.head<3>() = _torque;
   else
-    mFext.head<3>() = mW.linear().transpose() * _torque;
+    mFext.head<3>() = getWorldTransform().linear().transpose() * _torque;
 }
 
 const Eigen::Vector6d& BodyNode::getExternalForceLocal() const {
@@ -727,7 +855,7 @@ const Eigen::Vector6d& BodyNode::getExternalForceLocal() const {
 }
 
 Eigen::Vector6d BodyNode::getExternalForceGlobal() const {
-  return math::dAdInvT(mW, mFext);
+  return math::dAdInvT(getWorldTransform(), mFext);
 }
 
 //==============================================================================
@@ -749,7 +877,7 @@ void BodyNode::addConstraintImpulse(const Eigen::Vector3d& _constImp,
   if (_isImpulseLocal)
     F.tail<3>() = _constImp;
   else
-    F.tail<3>() = mW.linear().transpose() * _constImp;
+    F.tail<3>() = getWorldTransform().linear().transpose() * _constImp;
 
   mConstraintImpulse += math::dAdInvT(T, F);
 }
@@ -795,22 +923,23 @@ const Eigen::Vector6d& BodyNode::getConstraintImpulse() const
 }
 
 double BodyNode::getKineticEnergy() const {
-  return 0.5 * mV.dot(mI * mV);
+  const Eigen::Vector6d& V = getBodyVelocity();
+  return 0.5 * V.dot(mI * V);
 }
 
 double BodyNode::getPotentialEnergy(
     const Eigen::Vector3d& _gravity) const {
-  return -mMass * mW.translation().dot(_gravity);
+  return -mMass * getWorldCOM().dot(_gravity);
 }
 
 Eigen::Vector3d BodyNode::getLinearMomentum() const {
-  return (mI * mV).tail<3>();
+  return (mI * getBodyVelocity()).tail<3>();
 }
 
 Eigen::Vector3d BodyNode::getAngularMomentum(const Eigen::Vector3d& _pivot) {
   Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
   T.translation() = _pivot;
-  return math::dAdT(T, mI * mV).head<3>();
+  return math::dAdT(T, mI * getBodyVelocity()).head<3>();
 }
 
 void BodyNode::updateBodyForce(const Eigen::Vector3d& _gravity,
@@ -988,7 +1117,7 @@ void BodyNode::update_ddq() {
 
   if (mParentJoint->getNumGenCoords() > 0) {
     mdV = mEta;
-    mdV.noalias() += mParentJoint->getLocalJacobian() * mParentJoint->getGenAccs();
+    mdV += mParentJoint->getLocalJacobianTimesGenAccs();
     if (mParentBodyNode) {
       mdV += math::AdInvT(mParentJoint->getLocalTransform(),
                           mParentBodyNode->getBodyAcceleration());
@@ -1070,7 +1199,7 @@ void BodyNode::updateJointVelocityChange()
     mParentJoint->setVelsChange(del_dq);
     assert(!math::isNan(del_dq));
 
-    mDelV = mParentJoint->getLocalJacobian() * mParentJoint->getVelsChange();
+    mDelV = mParentJoint->getLocalJacobianTimesVelsChange();
   }
   else
   {
@@ -1192,12 +1321,177 @@ void BodyNode::aggregateExternalForces(Eigen::VectorXd* _Fext) {
   }
 }
 
+void BodyNode::updateInvDynDeriv(int _index, bool _wrtConfigs) {
+  // Forward-mode derivative of the recursion
+  //   V(i)   = Ad(T(i, i-1)^{-1}, V(i-1)) + S * dq
+  //   eta(i) = ad(V(i), S * dq) + dS * dq
+  //   dV(i)  = Ad(T(i, i-1)^{-1}, dV(i-1)) + eta(i) + S * ddq
+  // Perturbing q(_index) changes T(i, i-1) by exp(s) with s the column of S,
+  // so the terms transformed from the parent change by -ad(s, .).
+  mDerivLocalIndex = -1;
+  int dof = mParentJoint->getNumGenCoords();
+  if (dof > 0) {
+    int iStart = mParentJoint->getGenCoord(0)->getSkeletonIndex();
+    if (iStart <= _index && _index < iStart + dof)
+      mDerivLocalIndex = _index - iStart;
+  }
+
+  if (mParentBodyNode) {
+    const Eigen::Isometry3d& T = mParentJoint->getLocalTransform();
+    mDeriv_S = math::AdInvT(T, mParentBodyNode->mDeriv_S);
+    mDeriv_V = math::AdInvT(T, mParentBodyNode->mDeriv_V);
+    mDeriv_dV = math::AdInvT(T, mParentBodyNode->mDeriv_dV);
+  } else {
+    mDeriv_S.setZero();
+    mDeriv_V.setZero();
+    mDeriv_dV.setZero();
+  }
+
+  Eigen::Vector6d Sdq = Eigen::Vector6d::Zero();
+  Eigen::Vector6d dSdq = Eigen::Vector6d::Zero();
+  Eigen::Vector6d dSddq = Eigen::Vector6d::Zero();
+  if (dof > 0)
+    Sdq = mParentJoint->getLocalJacobianTimesGenVels();
+
+  if (mDerivLocalIndex >= 0) {
+    const math::Jacobian& S = mParentJoint->getLocalJacobian();
+    const math::Jacobian dS_dq
+        = mParentJoint->getLocalJacobianDeriv(mDerivLocalIndex);
+    const Eigen::VectorXd dq = mParentJoint->getGenVels();
+
+    if (_wrtConfigs) {
+      const Eigen::Vector6d s = S.col(mDerivLocalIndex);
+      mDeriv_S += s;
+      mDeriv_V -= math::ad(s, mV - Sdq);
+      mDeriv_dV -= math::ad(
+                     s, mdV - mEta
+                        - mParentJoint->getLocalJacobianTimesGenAccs());
+
+      mDeriv_V.noalias() += dS_dq * dq;
+      dSdq.noalias() = dS_dq * dq;
+      mDeriv_eta.noalias()
+          = mParentJoint->getLocalJacobianTimeDerivDeriv(mDerivLocalIndex)
+            * dq;
+      dSddq.noalias() = dS_dq * mParentJoint->getGenAccs();
+    } else {
+      mDeriv_V += S.col(mDerivLocalIndex);
+      dSdq = S.col(mDerivLocalIndex);
+      mDeriv_eta.noalias() = dS_dq * dq;
+      mDeriv_eta += mParentJoint->getLocalJacobianTimeDeriv().col(
+                      mDerivLocalIndex);
+    }
+  } else {
+    mDeriv_eta.setZero();
+  }
+
+  // dSdq holds the derivative of S * dq
+  mDeriv_eta += math::ad(mDeriv_V, Sdq) + math::ad(mV, dSdq);
+  mDeriv_dV += mDeriv_eta + dSddq;
+  assert(!math::isNan(mDeriv_dV));
+}
+
+void BodyNode::aggregateInvDynDeriv(Eigen::MatrixXd* _dtau, int _col,
+                                    const Eigen::Vector3d& _gravity,
+                                    bool _wrtConfigs) {
+  // Derivative of
+  //   F(i) = I * dV(i) - Fext - Fgravity - dad(V(i), I * V(i))
+  //          + sum(k \in children) dAd(T(i, k)^{-1}, F(k))
+  mDeriv_F.noalias() = mI * mDeriv_dV;
+  mDeriv_F -= math::dad(mDeriv_V, mI * mV);
+  mDeriv_F -= math::dad(mV, mI * mDeriv_V);
+
+  // The gravity force I * [0; R^T * g] changes with the rotation of this body
+  // by the angular part of mDeriv_S
+  if (mGravityMode == true && _wrtConfigs) {
+    Eigen::Vector6d dg = Eigen::Vector6d::Zero();
+    dg.tail<3>() = (mW.linear().transpose() * _gravity).cross(
+                     mDeriv_S.head<3>());
+    mDeriv_F.noalias() -= mI * dg;
+  }
+
+  for (std::vector<BodyNode*>::const_iterator it = mChildBodyNodes.begin();
+       it != mChildBodyNodes.end(); ++it) {
+    const Joint* childJoint = (*it)->mParentJoint;
+    const Eigen::Isometry3d& T = childJoint->getLocalTransform();
+    mDeriv_F += math::dAdInvT(T, (*it)->mDeriv_F);
+    if (_wrtConfigs && (*it)->mDerivLocalIndex >= 0) {
+      const Eigen::Vector6d s
+          = childJoint->getLocalJacobian().col((*it)->mDerivLocalIndex);
+      mDeriv_F -= math::dAdInvT(T, math::dad(s, (*it)->mF));
+    }
+  }
+  assert(!math::isNan(mDeriv_F));
+
+  int dof = mParentJoint->getNumGenCoords();
+  if (dof > 0) {
+    int iStart = mParentJoint->getGenCoord(0)->getSkeletonIndex();
+    _dtau->block(iStart, _col, dof, 1).noalias()
+        = mParentJoint->getLocalJacobian().transpose() * mDeriv_F;
+    if (_wrtConfigs && mDerivLocalIndex >= 0) {
+      _dtau->block(iStart, _col, dof, 1).noalias()
+          += mParentJoint->getLocalJacobianDeriv(mDerivLocalIndex).transpose()
+             * mF;
+    }
+  }
+}
+
+void BodyNode::updateSubtreeCOM(bool _withTimeDeriv) {
+  const Eigen::Isometry3d& W = getWorldTransform();
+
+  mSubtreeMass = mMass;
+  mSubtreeMassCOM = mMass * (W * mCenterOfMass);
+  if (_withTimeDeriv) {
+    const Eigen::Vector6d& V = getBodyVelocity();
+    mSubtreeMassCOMVel
+        = mMass * (W.linear()
+                   * (V.tail<3>() + V.head<3>().cross(mCenterOfMass)));
+  }
+
+  for (std::vector<BodyNode*>::const_iterator it = mChildBodyNodes.begin();
+       it != mChildBodyNodes.end(); ++it) {
+    mSubtreeMass += (*it)->mSubtreeMass;
+    mSubtreeMassCOM += (*it)->mSubtreeMassCOM;
+    if (_withTimeDeriv)
+      mSubtreeMassCOMVel += (*it)->mSubtreeMassCOMVel;
+  }
+}
+
+void BodyNode::aggregateWorldCOMJacobian(Eigen::MatrixXd* _J) {
+  // Every body node of the subtree moves with the world twist [w; v] of each
+  // column of the local Jacobian, so the mass-weighted COM velocity of the
+  // subtree is w x (sum m c) + (sum m) v.
+  const Eigen::Isometry3d& W = getWorldTransform();
+  const math::Jacobian& S = mParentJoint->getLocalJacobian();
+  for (int i = 0; i < S.cols(); ++i) {
+    const Eigen::Vector6d twist = math::AdT(W, S.col(i));
+    const int index = mParentJoint->getGenCoord(i)->getSkeletonIndex();
+    _J->col(index) = twist.head<3>().cross(mSubtreeMassCOM)
+                     + mSubtreeMass * twist.tail<3>();
+  }
+}
+
+void BodyNode::aggregateWorldCOMJacobianTimeDeriv(Eigen::MatrixXd* _dJ) {
+  // d/dt AdT(W, s) = AdT(W, ad(V, s) + ds)
+  const Eigen::Isometry3d& W = getWorldTransform();
+  const Eigen::Vector6d& V = getBodyVelocity();
+  const math::Jacobian& S = mParentJoint->getLocalJacobian();
+  const math::Jacobian& dS = mParentJoint->getLocalJacobianTimeDeriv();
+  for (int i = 0; i < S.cols(); ++i) {
+    const Eigen::Vector6d twist = math::AdT(W, S.col(i));
+    const Eigen::Vector6d dtwist
+        = math::AdT(W, math::ad(V, S.col(i)) + dS.col(i));
+    const int index = mParentJoint->getGenCoord(i)->getSkeletonIndex();
+    _dJ->col(index) = dtwist.head<3>().cross(mSubtreeMassCOM)
+                      + twist.head<3>().cross(mSubtreeMassCOMVel)
+                      + mSubtreeMass * dtwist.tail<3>();
+  }
+}
+
 void BodyNode::updateMassMatrix() {
   mM_dV.setZero();
   int dof = mParentJoint->getNumGenCoords();
   if (dof > 0) {
-    mM_dV.noalias() += mParentJoint->getLocalJacobian() *
-                       mParentJoint->getGenAccs();
+    mM_dV += mParentJoint->getLocalJacobianTimesGenAccs();
     assert(!math::isNan(mM_dV));
   }
   if (mParentBodyNode)
@@ -1429,7 +1723,7 @@ void BodyNode::_updateBodyJacobianTimeDeriv()
     assert(mParentJoint);
     mBodyJacobianTimeDeriv.leftCols(numParentDOFs)
         = math::AdInvTJac(mParentJoint->getLocalTransform(),
-                          mParentBodyNode->mBodyJacobianTimeDeriv);
+                          mParentBodyNode->getBodyJacobianTimeDeriv());
     for (int i = 0; i < numParentDOFs; ++i)
       mBodyJacobianTimeDeriv.col(i) -= math::ad(mV, J.col(i));
   }
@@ -1569,8 +1863,8 @@ BodyNode::VelocityObjFunc::VelocityObjFunc(BodyNode* _body,
                                            Skeleton* _skeleton)
   : Function(),
     mBodyNode(_body),
-    mVelocityType(_velType),
-    mSkeleton(_skeleton)
+    mSkeleton(_skeleton),
+    mVelocityType(_velType)
 {
   if (mVelocityType == VT_LINEAR)
   {
@@ -179,6 +179,10 @@ public:
   Eigen::Vector3d getWorldCOMVelocity() const;
 
   /// \brief Get body's COM acceleration w.r.t. world frame.
+  ///
+  /// This is the second time derivative of getWorldCOM(). Unlike the linear
+  /// part of getWorldAcceleration() at the COM, it includes the centripetal
+  /// term w x (w x r) of the COM.
   Eigen::Vector3d getWorldCOMAcceleration() const;
 
   /// \brief
@@ -295,7 +299,8 @@ public:
   // Properties updated by dynamics (kinematics)
   //--------------------------------------------------------------------------
   /// \brief Get the transformation from the world frame to this body node
-  ///        frame.
+  ///        frame. If the transformation is stale, it is recomputed together
+  ///        with the stale transformations of the ancestors.
   const Eigen::Isometry3d& getWorldTransform() const;
 
   /// \brief Get the generalized velocity at the origin of this body node
@@ -317,6 +322,13 @@ public:
 
   /// \brief Get generalized acceleration at a point on this body node where
   ///        the acceleration is expressed in the world frame.
+  ///
+  /// The acceleration of the origin of this body node is transported to the
+  /// point as a rigid spatial vector, so the linear part is a + dw x r without
+  /// the centripetal term w x (w x r) of the point. This matches
+  /// getWorldJacobianTimeDeriv() with the same offset. For a nonzero offset,
+  /// it is therefore not the second time derivative of the point; see
+  /// getWorldCOMAcceleration() for the COM.
   /// \param[in] _offset Position vector relative to the origin the body frame.
   /// \param[in] _isLocal True if _offset is expressed in the body frame.
   ///                     False if _offset is expressed in the world frame.
@@ -352,6 +364,22 @@ public:
       const Eigen::Vector3d& _offset = Eigen::Vector3d::Zero(),
       bool _isOffsetLocal            = false);
 
+  /// \brief Get operational space inertia of this body node expressed in
+  ///        this body node frame. See Skeleton::getOperationalSpaceInertia().
+  const Eigen::Matrix6d& getOperationalSpaceInertia();
+
+  /// \brief Get inverse of operational space inertia of this body node
+  ///        expressed in this body node frame.
+  const Eigen::Matrix6d& getInvOperationalSpaceInertia();
+
+  /// \brief Get operational space bias force of this body node expressed in
+  ///        this body node frame.
+  const Eigen::Vector6d& getOperationalSpaceBiasForce();
+
+  /// \brief Get dynamically consistent inverse of the body Jacobian of this
+  ///        body node.
+  const Eigen::MatrixXd& getDynamicallyConsistentJacobianInverse();
+
   /// \brief
   const Eigen::Vector6d& getBodyVelocityChange() const;
 
@@ -473,6 +501,15 @@ public:
   ///        generalized of the system.
   virtual void aggregateGenCoords(std::vector<GenCoord*>* _genCoords);
 
+  /// \brief Get the number of doubles of the articulated-body cache data of
+  ///        this body node in the compiled skeleton.
+  int getArticulatedBodyStateSize() const;
+
+  /// \brief Map the articulated-body cache data of this body node onto
+  ///        _data, which holds getArticulatedBodyStateSize() doubles owned by
+  ///        the skeleton. The cache data is zeroed.
+  void mapArticulatedBodyState(double* _data);
+
   //--------------------------------------------------------------------------
   // Sub-functions for Recursive Kinematics Algorithms
   //--------------------------------------------------------------------------
@@ -563,6 +600,34 @@ public:
   ///        coordinates recursively.
   virtual void aggregateExternalForces(Eigen::VectorXd* _Fext);
 
+  /// \brief Update the derivatives of the body velocity and acceleration
+  ///        with respect to the _index-th configuration of the skeleton if
+  ///        _wrtConfigs is true, or to the _index-th generalized velocity
+  ///        otherwise.
+  virtual void updateInvDynDeriv(int _index, bool _wrtConfigs);
+
+  /// \brief Aggregate the derivative of the generalized forces computed by
+  ///        inverse dynamics into the _col-th column of _dtau. The body forces
+  ///        computed by Skeleton::computeInverseDynamics() are used as the
+  ///        nominal body forces.
+  virtual void aggregateInvDynDeriv(Eigen::MatrixXd* _dtau, int _col,
+                                    const Eigen::Vector3d& _gravity,
+                                    bool _wrtConfigs);
+
+  /// \brief Update the mass, the mass-weighted world COM and, if
+  ///        _withTimeDeriv is true, its time derivative of the subtree rooted
+  ///        at this body node. The child body nodes must be updated first.
+  void updateSubtreeCOM(bool _withTimeDeriv);
+
+  /// \brief Assign the mass-weighted columns of the world COM Jacobian for
+  ///        the generalized coordinates of the parent joint to _J.
+  void aggregateWorldCOMJacobian(Eigen::MatrixXd* _J);
+
+  /// \brief Assign the mass-weighted columns of the time derivative of the
+  ///        world COM Jacobian for the generalized coordinates of the parent
+  ///        joint to _dJ.
+  void aggregateWorldCOMJacobianTimeDeriv(Eigen::MatrixXd* _dJ);
+
   /// \brief class TransformObjFunc
   class TransformObjFunc : public optimizer::Function
   {
@@ -725,6 +790,18 @@ public:
   /// \brief Dirty flag for time derivative of body Jacobian.
   bool mIsBodyJacobianTimeDerivDirty;
 
+  /// \brief Dirty flag for world transformation. Skeleton sets this flag for
+  /// the subtree of a joint whose configuration changed, and
+  /// getWorldTransform() recomputes the transformation of this body node and
+  /// its stale ancestors.
+  bool mIsWorldTransformDirty;
+
+  /// \brief Dirty flag for body velocity and eta.
+  bool mIsVelocityDirty;
+
+  /// \brief Dirty flag for body acceleration.
+  bool mIsAccelerationDirty;
+
   /// \brief Generalized body velocity w.r.t. body frame.
   Eigen::Vector6d mV;
 
@@ -743,47 +820,52 @@ public:
   /// \brief
   Eigen::Vector6d mFgravity;
 
+  //--------------------------------------------------------------------------
+  // Articulated-body cache data. These are views of this body node's block of
+  // the contiguous state of the compiled skeleton, which are bound by
+  // mapArticulatedBodyState().
+  //--------------------------------------------------------------------------
   /// \brief Articulated inertia
-  math::Inertia mAI;
+  Eigen::Map<math::Inertia> mAI;
 
   /// \brief Articulated inertia
-  math::Inertia mImplicitAI;
+  Eigen::Map<math::Inertia> mImplicitAI;
 
   /// \brief Bias force
-  Eigen::Vector6d mB;
+  Eigen::Map<Eigen::Vector6d> mB;
 
   /// \brief
-  math::Jacobian mAI_S;
+  Eigen::Map<math::Jacobian> mAI_S;
 
   /// \brief
-  math::Jacobian mImplicitAI_S;
+  Eigen::Map<math::Jacobian> mImplicitAI_S;
 
   /// \brief
-  math::Jacobian mAI_S_Psi;
+  Eigen::Map<math::Jacobian> mAI_S_Psi;
 
   /// \brief
-  math::Jacobian mImplicitAI_S_ImplicitPsi;
+  Eigen::Map<math::Jacobian> mImplicitAI_S_ImplicitPsi;
 
   /// \brief
-  Eigen::MatrixXd mPsi;
+  Eigen::Map<Eigen::MatrixXd> mPsi;
 
   /// \brief
-  Eigen::MatrixXd mImplicitPsi;
+  Eigen::Map<Eigen::MatrixXd> mImplicitPsi;
 
 public:  // TODO(JS): This will be removed once Node class is implemented.
   /// \brief
-  math::Inertia mPi;
+  Eigen::Map<math::Inertia> mPi;
 
   /// \brief
-  math::Inertia mImplicitPi;
+  Eigen::Map<math::Inertia> mImplicitPi;
 
 protected:  // TODO(JS):
   /// \brief
-  Eigen::VectorXd mAlpha;
+  Eigen::Map<Eigen::VectorXd> mAlpha;
 
 public:  // TODO(JS): This will be removed once Node class is implemented.
   /// \brief
-  Eigen::Vector6d mBeta;
+  Eigen::Map<Eigen::Vector6d> mBeta;
 
 // TODO(JS): Temporary code for soft body dynamics
 // protected:
@@ -809,6 +891,33 @@ public:
   Eigen::VectorXd mInvM_MInvVec;
   Eigen::Vector6d mInvM_U;
 
+  /// \brief Cache data for derivatives of inverse dynamics. mDeriv_S is the
+  ///        body twist of the perturbation and mDerivLocalIndex is the index
+  ///        of the differentiated coordinate in the parent joint, or -1.
+  int mDerivLocalIndex;
+  Eigen::Vector6d mDeriv_S;
+  Eigen::Vector6d mDeriv_V;
+  Eigen::Vector6d mDeriv_eta;
+  Eigen::Vector6d mDeriv_dV;
+  Eigen::Vector6d mDeriv_F;
+
+  /// \brief Cache data for COM Jacobian of the system. The mass, mass-weighted
+  ///        world COM and its time derivative of the subtree rooted at this
+  ///        body node.
+  double mSubtreeMass;
+  Eigen::Vector3d mSubtreeMassCOM;
+  Eigen::Vector3d mSubtreeMassCOMVel;
+
+  /// \brief Cache data for operational space quantities. The dirty flags are
+  ///        reset by the skeleton whenever its dynamics quantities are stale.
+  Eigen::Matrix6d mOpInvInertia;
+  Eigen::Matrix6d mOpInertia;
+  Eigen::Vector6d mOpBiasForce;
+  Eigen::MatrixXd mOpJacobianInverse;
+  bool mIsOpInertiaDirty;
+  bool mIsOpBiasForceDirty;
+  bool mIsOpJacobianInverseDirty;
+
   //------------------------- Impulse-based Dyanmics ---------------------------
   /// \brief Velocity change due to to external impulsive force exerted on
   ///        bodies of the parent skeleton.
@@ -816,13 +925,13 @@ public:
 
   /// \brief Impulsive bias force due to external impulsive force exerted on
   ///        bodies of the parent skeleton.
-  Eigen::Vector6d mImpB;
+  Eigen::Map<Eigen::Vector6d> mImpB;
 
   /// \brief Cache data for mImpB
-  Eigen::VectorXd mImpAlpha;
+  Eigen::Map<Eigen::VectorXd> mImpAlpha;
 
   /// \brief Cache data for mImpB
-  Eigen::Vector6d mImpBeta;
+  Eigen::Map<Eigen::Vector6d> mImpBeta;
 
   /// \brief Constraint impulse: contact impulse, dynamic joint impulse
   Eigen::Vector6d mConstraintImpulse;
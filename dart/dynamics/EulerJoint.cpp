@@ -46,19 +46,9 @@ namespace dart {
 namespace dynamics {
 
 EulerJoint::EulerJoint(const std::string& _name)
-  : Joint(_name),
+  : MultiDofJoint<3>(_name),
     mAxisOrder(AO_XYZ)
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-  mGenCoords.push_back(&mCoordinate[2]);
-
-  mS = Eigen::Matrix<double, 6, 3>::Zero();
-  mdS = Eigen::Matrix<double, 6, 3>::Zero();
-
-  mSpringStiffness.resize(3, 0.0);
-  mDampingCoefficient.resize(3, 0.0);
-  mRestPosition.resize(3, 0.0);
 }
 
 EulerJoint::~EulerJoint() {
@@ -72,44 +62,93 @@ EulerJoint::AxisOrder EulerJoint::getAxisOrder() const {
   return mAxisOrder;
 }
 
+void EulerJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                        const Eigen::VectorXd& _genVels,
+                                        Eigen::Isometry3d* _T,
+                                        math::Jacobian* _S,
+                                        math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 3 && _genVels.size() == 3);
+
+  *_T = mT_ParentBodyToJoint
+        * Eigen::Isometry3d(computeRotation(_configs))
+        * mT_ChildBodyToJoint.inverse();
+  *_S = computeLocalJacobian(_configs);
+  *_dS = computeLocalJacobianTimeDeriv(_configs, _genVels);
+}
+
 void EulerJoint::updateTransform() {
+  mT = mT_ParentBodyToJoint
+       * Eigen::Isometry3d(computeRotation(getConfigsStatic()))
+       * mT_ChildBodyToJoint.inverse();
+
+  assert(math::verifyTransform(mT));
+}
+
+void EulerJoint::updateLocalJacobian() {
+  mJacobian = computeLocalJacobian(getConfigsStatic());
+
+#ifndef NDEBUG
+  if ((mAxisOrder == AO_XYZ || mAxisOrder == AO_ZYX)
+      && fabs(mCoordinate[1].getPos()) == DART_PI * 0.5)
+    std::cout << "Singular configuration in ZYX-euler joint ["
+              << mName << "]. ("
+              << mCoordinate[0].getPos() << ", "
+              << mCoordinate[1].getPos() << ", "
+              << mCoordinate[2].getPos() << ")"
+              << std::endl;
+#endif
+
+  assert(!math::isNan(mJacobian));
+
+#ifndef NDEBUG
+  Eigen::MatrixXd JTJ = mJacobian.transpose() * mJacobian;
+  Eigen::FullPivLU<Eigen::MatrixXd> luJTJ(JTJ);
+  //    Eigen::FullPivLU<Eigen::MatrixXd> luS(mJacobian);
+  double det = luJTJ.determinant();
+  if (det < 1e-5) {
+    std::cout << "ill-conditioned Jacobian in joint [" << mName << "]."
+              << " The determinant of the Jacobian is (" << det << ")."
+              << std::endl;
+    std::cout << "rank is (" << luJTJ.rank() << ")." << std::endl;
+    std::cout << "det is (" << luJTJ.determinant() << ")." << std::endl;
+    //        std::cout << "mJacobian: \n" << mJacobian << std::endl;
+  }
+#endif
+}
+
+void EulerJoint::updateLocalJacobianTimeDeriv() {
+  mJacobianDeriv = computeLocalJacobianTimeDeriv(getConfigsStatic(),
+                                                 getGenVelsStatic());
+
+  assert(!math::isNan(mJacobianDeriv));
+}
+
+Eigen::Matrix3d EulerJoint::computeRotation(
+    const Eigen::Vector3d& _configs) const {
   switch (mAxisOrder) {
     case AO_XYZ:
     {
-      mT = mT_ParentBodyToJoint *
-           Eigen::Isometry3d(math::eulerXYZToMatrix(getConfigs())) *
-           mT_ChildBodyToJoint.inverse();
-      break;
+      return math::eulerXYZToMatrix(_configs);
     }
     case AO_ZYX:
     {
-      mT = mT_ParentBodyToJoint *
-           Eigen::Isometry3d(math::eulerZYXToMatrix(getConfigs())) *
-           mT_ChildBodyToJoint.inverse();
-      break;
+      return math::eulerZYXToMatrix(_configs);
     }
     default:
     {
       dterr << "Undefined Euler axis order\n";
-      break;
+      return Eigen::Matrix3d::Identity();
     }
   }
-
-  assert(math::verifyTransform(mT));
 }
 
-void EulerJoint::updateJacobian() {
-  double q0 = mCoordinate[0].getPos();
-  double q1 = mCoordinate[1].getPos();
-  double q2 = mCoordinate[2].getPos();
-
-  // double c0 = cos(q0);
-  double c1 = cos(q1);
-  double c2 = cos(q2);
-
-  // double s0 = sin(q0);
-  double s1 = sin(q1);
-  double s2 = sin(q2);
+EulerJoint::JacobianMatrix EulerJoint::computeLocalJacobian(
+    const Eigen::Vector3d& _configs) const {
+  double s1, c1;
+  double s2, c2;
+  math::sincos(_configs[1], &s1, &c1);
+  math::sincos(_configs[2], &s2, &c2);
 
   Eigen::Vector6d J0 = Eigen::Vector6d::Zero();
   Eigen::Vector6d J1 = Eigen::Vector6d::Zero();
@@ -129,17 +168,6 @@ void EulerJoint::updateJacobian() {
       J0 << c1*c2, -(c1*s2),  s1, 0.0, 0.0, 0.0;
       J1 <<    s2,       c2, 0.0, 0.0, 0.0, 0.0;
       J2 <<   0.0,      0.0, 1.0, 0.0, 0.0, 0.0;
-
-#ifndef NDEBUG
-      if (fabs(mCoordinate[1].getPos()) == DART_PI * 0.5)
-        std::cout << "Singular configuration in ZYX-euler joint ["
-                  << mName << "]. ("
-                  << mCoordinate[0].getPos() << ", "
-                  << mCoordinate[1].getPos() << ", "
-                  << mCoordinate[2].getPos() << ")"
-                  << std::endl;
-#endif
-
       break;
     }
     case AO_ZYX:
@@ -155,17 +183,6 @@ void EulerJoint::updateJacobian() {
       J0 << -s1, s2*c1, c1*c2, 0.0, 0.0, 0.0;
       J1 << 0.0,    c2,   -s2, 0.0, 0.0, 0.0;
       J2 << 1.0,   0.0,   0.0, 0.0, 0.0, 0.0;
-
-#ifndef NDEBUG
-      if (fabs(mCoordinate[1].getPos()) == DART_PI * 0.5)
-        std::cout << "Singular configuration in ZYX-euler joint ["
-                  << mName << "]. ("
-                  << mCoordinate[0].getPos() << ", "
-                  << mCoordinate[1].getPos() << ", "
-                  << mCoordinate[2].getPos() << ")"
-                  << std::endl;
-#endif
-
       break;
     }
     default:
@@ -175,44 +192,24 @@ void EulerJoint::updateJacobian() {
     }
   }
 
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
+  JacobianMatrix J;
+  J.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
+  J.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
+  J.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
 
-  assert(!math::isNan(mS));
-
-#ifndef NDEBUG
-  Eigen::MatrixXd JTJ = mS.transpose() * mS;
-  Eigen::FullPivLU<Eigen::MatrixXd> luJTJ(JTJ);
-  //    Eigen::FullPivLU<Eigen::MatrixXd> luS(mS);
-  double det = luJTJ.determinant();
-  if (det < 1e-5) {
-    std::cout << "ill-conditioned Jacobian in joint [" << mName << "]."
-              << " The determinant of the Jacobian is (" << det << ")."
-              << std::endl;
-    std::cout << "rank is (" << luJTJ.rank() << ")." << std::endl;
-    std::cout << "det is (" << luJTJ.determinant() << ")." << std::endl;
-    //        std::cout << "mS: \n" << mS << std::endl;
-  }
-#endif
+  return J;
 }
 
-void EulerJoint::updateJacobianTimeDeriv() {
-  double q0 = mCoordinate[0].getPos();
-  double q1 = mCoordinate[1].getPos();
-  double q2 = mCoordinate[2].getPos();
-
-  // double dq0 = mCoordinate[0].get_dq();
-  double dq1 = mCoordinate[1].getVel();
-  double dq2 = mCoordinate[2].getVel();
-
-  // double c0 = cos(q0);
-  double c1 = cos(q1);
-  double c2 = cos(q2);
+EulerJoint::JacobianMatrix EulerJoint::computeLocalJacobianTimeDeriv(
+    const Eigen::Vector3d& _configs, const Eigen::Vector3d& _genVels) const {
+  // double dq0 = _genVels[0];
+  double dq1 = _genVels[1];
+  double dq2 = _genVels[2];
 
-  // double s0 = sin(q0);
-  double s1 = sin(q1);
-  double s2 = sin(q2);
+  double s1, c1;
+  double s2, c2;
+  math::sincos(_configs[1], &s1, &c1);
+  math::sincos(_configs[2], &s2, &c2);
 
   Eigen::Vector6d dJ0 = Eigen::Vector6d::Zero();
   Eigen::Vector6d dJ1 = Eigen::Vector6d::Zero();
@@ -260,11 +257,12 @@ void EulerJoint::updateJacobianTimeDeriv() {
     }
   }
 
-  mdS.col(0) = math::AdT(mT_ChildBodyToJoint, dJ0);
-  mdS.col(1) = math::AdT(mT_ChildBodyToJoint, dJ1);
-  mdS.col(2) = math::AdT(mT_ChildBodyToJoint, dJ2);
+  JacobianMatrix dJ;
+  dJ.col(0) = math::AdT(mT_ChildBodyToJoint, dJ0);
+  dJ.col(1) = math::AdT(mT_ChildBodyToJoint, dJ1);
+  dJ.col(2) = math::AdT(mT_ChildBodyToJoint, dJ2);
 
-  assert(!math::isNan(mdS));
+  return dJ;
 }
 
 }  // namespace dynamics
@@ -39,13 +39,12 @@
 
 #include <string>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
-class EulerJoint : public Joint {
+class EulerJoint : public MultiDofJoint<3> {
 public:
   enum AxisOrder {
     AO_ZYX = 0,
@@ -66,18 +65,33 @@ public:
   /// \brief
   AxisOrder getAxisOrder() const;
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
   // Documentation inherited.
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited.
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobianTimeDeriv();
 
 protected:
-  /// \brief Euler angles X, Y, Z
-  GenCoord mCoordinate[3];
+  /// \brief Compute the rotation of this joint for the given configurations
+  Eigen::Matrix3d computeRotation(const Eigen::Vector3d& _configs) const;
+
+  /// \brief Compute the local Jacobian for the given configurations
+  JacobianMatrix computeLocalJacobian(const Eigen::Vector3d& _configs) const;
+
+  /// \brief Compute the time derivative of the local Jacobian for the given
+  /// configurations and generalized velocities
+  JacobianMatrix computeLocalJacobianTimeDeriv(
+      const Eigen::Vector3d& _configs, const Eigen::Vector3d& _genVels) const;
 
   /// \brief
   AxisOrder mAxisOrder;
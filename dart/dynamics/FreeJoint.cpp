@@ -46,30 +46,18 @@ namespace dynamics {
 
 //==============================================================================
 FreeJoint::FreeJoint(const std::string& _name)
-  : Joint(_name)
+  : MultiDofJoint<6>(_name)
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-  mGenCoords.push_back(&mCoordinate[2]);
-  mGenCoords.push_back(&mCoordinate[3]);
-  mGenCoords.push_back(&mCoordinate[4]);
-  mGenCoords.push_back(&mCoordinate[5]);
-
-  mS = Eigen::Matrix<double, 6, 6>::Zero();
   Eigen::Matrix6d J = Eigen::Matrix6d::Identity();
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J.col(0));
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J.col(1));
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J.col(2));
-  mS.col(3) = math::AdT(mT_ChildBodyToJoint, J.col(3));
-  mS.col(4) = math::AdT(mT_ChildBodyToJoint, J.col(4));
-  mS.col(5) = math::AdT(mT_ChildBodyToJoint, J.col(5));
-  assert(!math::isNan(mS));
-
-  mdS = Eigen::Matrix<double, 6, 6>::Zero();
-
-  mSpringStiffness.resize(6, 0.0);
-  mDampingCoefficient.resize(6, 0.0);
-  mRestPosition.resize(6, 0.0);
+  mJacobian.col(0) = math::AdT(mT_ChildBodyToJoint, J.col(0));
+  mJacobian.col(1) = math::AdT(mT_ChildBodyToJoint, J.col(1));
+  mJacobian.col(2) = math::AdT(mT_ChildBodyToJoint, J.col(2));
+  mJacobian.col(3) = math::AdT(mT_ChildBodyToJoint, J.col(3));
+  mJacobian.col(4) = math::AdT(mT_ChildBodyToJoint, J.col(4));
+  mJacobian.col(5) = math::AdT(mT_ChildBodyToJoint, J.col(5));
+  assert(!math::isNan(mJacobian));
+
+  mS = mJacobian;
 }
 
 //==============================================================================
@@ -84,28 +72,86 @@ void FreeJoint::setTransformFromChildBodyNode(const Eigen::Isometry3d& _T)
 
   Eigen::Matrix6d J = Eigen::Matrix6d::Identity();
 
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J.col(0));
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J.col(1));
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J.col(2));
-  mS.col(3) = math::AdT(mT_ChildBodyToJoint, J.col(3));
-  mS.col(4) = math::AdT(mT_ChildBodyToJoint, J.col(4));
-  mS.col(5) = math::AdT(mT_ChildBodyToJoint, J.col(5));
+  mJacobian.col(0) = math::AdT(mT_ChildBodyToJoint, J.col(0));
+  mJacobian.col(1) = math::AdT(mT_ChildBodyToJoint, J.col(1));
+  mJacobian.col(2) = math::AdT(mT_ChildBodyToJoint, J.col(2));
+  mJacobian.col(3) = math::AdT(mT_ChildBodyToJoint, J.col(3));
+  mJacobian.col(4) = math::AdT(mT_ChildBodyToJoint, J.col(4));
+  mJacobian.col(5) = math::AdT(mT_ChildBodyToJoint, J.col(5));
 
-  assert(!math::isNan(mS));
+  assert(!math::isNan(mJacobian));
+
+  mS = mJacobian;
+}
+
+//==============================================================================
+math::Jacobian FreeJoint::getLocalJacobianDeriv(size_t _index) const
+{
+  assert(_index < 6);
+  return math::Jacobian::Zero(6, 6);
+}
+
+//==============================================================================
+math::Jacobian FreeJoint::getLocalJacobianTimeDerivDeriv(size_t _index) const
+{
+  assert(_index < 6);
+  return math::Jacobian::Zero(6, 6);
+}
+
+//==============================================================================
+Eigen::MatrixXd FreeJoint::getConfigsPerturbationDeriv() const
+{
+  // The right Jacobian of SE(3) at q = [w, v] is [A, 0; B, A], where
+  // A = J_r(w) of SO(3) and B is the derivative of A along v
+  const Eigen::Vector6d& q = getConfigsStatic();
+  const Eigen::Matrix3d invA
+      = math::expMapJac(q.head<3>()).transpose().inverse();
+  const Eigen::Matrix3d B
+      = math::expMapJacDot(q.head<3>(), q.tail<3>()).transpose();
+
+  Eigen::MatrixXd invJ = Eigen::MatrixXd::Zero(6, 6);
+  invJ.topLeftCorner<3, 3>() = invA;
+  invJ.bottomRightCorner<3, 3>() = invA;
+  invJ.bottomLeftCorner<3, 3>() = -invA * B * invA;
+
+  return invJ;
 }
 
 //==============================================================================
 void FreeJoint::integrateConfigs(double _dt)
 {
-  mQ = mQ * math::expMap(getGenVels() * _dt);
+  // Integrate on SE(3) from the configurations rather than from mQ, which is
+  // stale when the configurations were set without updating the transforms
+  // as in the intermediate stages of RK4Integrator.
+  const Eigen::Isometry3d T = math::expMap(getConfigsStatic())
+                              * math::expMap(getGenVelsStatic() * _dt);
+
+  setConfigsStatic(math::logMap(T));
+}
+
+//==============================================================================
+void FreeJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                       const Eigen::VectorXd& _genVels,
+                                       Eigen::Isometry3d* _T,
+                                       math::Jacobian* _S,
+                                       math::Jacobian* _dS) const
+{
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 6 && _genVels.size() == 6);
 
-  GenCoordSystem::setConfigs(math::logMap(mQ));
+  *_T = mT_ParentBodyToJoint
+        * math::expMap(Eigen::Vector6d(_configs))
+        * mT_ChildBodyToJoint.inverse();
+
+  // Jacobian is constant
+  *_S = mJacobian;
+  _dS->setZero(6, 6);
 }
 
 //==============================================================================
 void FreeJoint::updateTransform()
 {
-  mQ = math::expMap(getConfigs());
+  mQ = math::expMap(getConfigsStatic());
 
   mT = mT_ParentBodyToJoint * mQ * mT_ChildBodyToJoint.inverse();
 
@@ -113,16 +159,16 @@ void FreeJoint::updateTransform()
 }
 
 //==============================================================================
-void FreeJoint::updateJacobian()
+void FreeJoint::updateLocalJacobian()
 {
   // Jacobian is constant
 }
 
 //==============================================================================
-void FreeJoint::updateJacobianTimeDeriv()
+void FreeJoint::updateLocalJacobianTimeDeriv()
 {
   // Time derivative of Jacobian is constant
-  assert(mdS == Eigen::Matrix6d::Zero());
+  assert(mJacobianDeriv == Eigen::Matrix6d::Zero());
 }
 
 }  // namespace dynamics
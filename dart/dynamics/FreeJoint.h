@@ -41,14 +41,13 @@
 
 #include <Eigen/Dense>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
 /// \brief class FreeJoint
-class FreeJoint : public Joint
+class FreeJoint : public MultiDofJoint<6>
 {
 public:
   /// \brief Constructor
@@ -60,6 +59,24 @@ public:
   // Documentation inherited
   virtual void setTransformFromChildBodyNode(const Eigen::Isometry3d& _T);
 
+  /// \brief The configuration of this joint is perturbed in the child body
+  /// frame as in integrateConfigs(), so the local Jacobian is constant.
+  virtual math::Jacobian getLocalJacobianDeriv(size_t _index) const;
+
+  // Documentation inherited
+  virtual math::Jacobian getLocalJacobianTimeDerivDeriv(size_t _index) const;
+
+  /// \brief Get the inverse of the right Jacobian of the exponential map of
+  /// SE(3) at the configurations
+  virtual Eigen::MatrixXd getConfigsPerturbationDeriv() const;
+
+  // Documentation inherited
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
 protected:
   // Documentation inherited
   virtual void integrateConfigs(double _dt);
@@ -68,15 +85,12 @@ protected:
   virtual void updateTransform();
 
   // Documentation inherited
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobianTimeDeriv();
 
 protected:
-  /// \brief Generalized coordinates
-  GenCoord mCoordinate[6];
-
   /// \brief Transformation matrix dependant on generalized coordinates
   Eigen::Isometry3d mQ;
 
@@ -157,7 +157,9 @@ public:
   Eigen::VectorXd getConstraintImpulses() const;
 
   //----------------------------- Integration ----------------------------------
-  /// \brief Integrate configurations with timestep _dt
+  /// \brief Integrate configurations with timestep _dt. Joints whose
+  /// configurations are exponential coordinates, such as BallJoint and
+  /// FreeJoint, override this to integrate on SO(3) or SE(3).
   virtual void integrateConfigs(double _dt);
 
   /// \brief Integrate generalized velocities with timespte _dt
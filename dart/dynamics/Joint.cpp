@@ -88,6 +88,112 @@ const math::Jacobian& Joint::getLocalJacobianTimeDeriv() const {
   return mdS;
 }
 
+//==============================================================================
+Eigen::Vector6d Joint::getLocalJacobianTimesGenVels() const
+{
+  return mS * getGenVels();
+}
+
+//==============================================================================
+Eigen::Vector6d Joint::getLocalJacobianTimesGenAccs() const
+{
+  return mS * getGenAccs();
+}
+
+//==============================================================================
+Eigen::Vector6d Joint::getLocalJacobianTimesVelsChange() const
+{
+  return mS * getVelsChange();
+}
+
+//==============================================================================
+Eigen::Vector6d Joint::getLocalJacobianTimeDerivTimesGenVels() const
+{
+  return mdS * getGenVels();
+}
+
+//==============================================================================
+math::Jacobian Joint::getLocalJacobianDeriv(size_t _index) const
+{
+  assert(_index < getNumGenCoords());
+
+  // For T = T0 * exp(S0 * q0) * ... * exp(Sn * qn) * T1, the k-th column of
+  // the body Jacobian only depends on the coordinates after k:
+  //   dS(k) / dq(l) = -ad(S(l), S(k))  if l > k
+  //                 = 0                 otherwise
+  math::Jacobian dS = math::Jacobian::Zero(6, getNumGenCoords());
+
+  for (size_t k = 0; k < _index; ++k)
+    dS.col(k) = -math::ad(mS.col(_index), mS.col(k));
+
+  return dS;
+}
+
+//==============================================================================
+math::Jacobian Joint::getLocalJacobianTimeDerivDeriv(size_t _index) const
+{
+  assert(_index < getNumGenCoords());
+
+  // The time derivative of the k-th column is dS(k) = -ad(u(k), S(k)) where
+  // u(k) = sum(m > k) S(m) * dq(m). Both u(k) and S(k) depend on q(_index).
+  const int dof = getNumGenCoords();
+  const math::Jacobian dS = getLocalJacobianDeriv(_index);
+  math::Jacobian ddS = math::Jacobian::Zero(6, dof);
+
+  for (int k = 0; k < dof; ++k)
+  {
+    Eigen::Vector6d u = Eigen::Vector6d::Zero();
+    Eigen::Vector6d du = Eigen::Vector6d::Zero();
+    for (int m = k + 1; m < dof; ++m)
+    {
+      const double dq = mGenCoords[m]->getVel();
+      u += mS.col(m) * dq;
+      du += dS.col(m) * dq;
+    }
+
+    ddS.col(k) = -math::ad(du, mS.col(k)) - math::ad(u, dS.col(k));
+  }
+
+  return ddS;
+}
+
+//==============================================================================
+Eigen::MatrixXd Joint::getConfigsPerturbationDeriv() const
+{
+  return Eigen::MatrixXd::Identity(getNumGenCoords(), getNumGenCoords());
+}
+
+//==============================================================================
+void Joint::computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                   Eigen::MatrixXd* _transforms) const
+{
+  assert(_transforms != NULL);
+
+  const int numSamples = _configs.rows();
+  const size_t dof = getNumGenCoords();
+
+  _transforms->resize(numSamples, 12);
+
+  // Generic fallback: evaluate the const computeLocalKinematics() per sample,
+  // so the state of this joint is neither read nor changed. Joints with a
+  // cheap closed form override this.
+  Eigen::VectorXd q(dof);
+  const Eigen::VectorXd genVels = Eigen::VectorXd::Zero(dof);
+  Eigen::Isometry3d T;
+  math::Jacobian S(6, dof);
+  math::Jacobian dS(6, dof);
+
+  for (int k = 0; k < numSamples; ++k)
+  {
+    for (size_t i = 0; i < dof; ++i)
+      q[i] = _configs(k, mGenCoords[i]->getSkeletonIndex());
+    computeLocalKinematics(q, genVels, &T, &S, &dS);
+    const Eigen::Matrix<double, 3, 4> M = T.matrix().topRows<3>();
+    _transforms->row(k) = Eigen::Map<const Eigen::Matrix<double, 1, 12> >(
+                            M.data());
+  }
+}
+
 bool Joint::contains(const GenCoord* _genCoord) const {
   return find(mGenCoords.begin(), mGenCoords.end(), _genCoord) !=
       mGenCoords.end() ? true : false;
@@ -169,11 +275,7 @@ void Joint::setConfig(size_t _idx,
   mGenCoords[_idx]->setPos(_config);
 
   if (mSkeleton)
-  {
-    // TODO(JS): It would be good if we know whether the skeleton is initialzed.
-    mSkeleton->computeForwardKinematics(_updateTransforms, _updateVels,
-                                        _updateAccs);
-  }
+    setKinematicsDirty(_updateTransforms, _updateVels, _updateAccs);
 }
 
 //==============================================================================
@@ -185,11 +287,32 @@ void Joint::setConfigs(const Eigen::VectorXd& _configs,
   GenCoordSystem::setConfigs(_configs);
 
   if (mSkeleton)
+    setKinematicsDirty(_updateTransforms, _updateVels, _updateAccs);
+}
+
+//==============================================================================
+void Joint::setKinematicsDirty(bool _updateTransforms,
+                               bool _updateVels,
+                               bool _updateAccs)
+{
+  assert(mSkeleton != NULL);
+
+  // The local quantities of this joint are updated right away, and only the
+  // child subtree is marked for the world transformations.
+  if (_updateTransforms)
   {
-    if (_updateTransforms || _updateVels || _updateAccs)
-    // TODO(JS): It would be good if we know whether the skeleton is initialzed.
-    mSkeleton->computeForwardKinematics(_updateTransforms, _updateVels,
-                                        _updateAccs);
+    updateTransform();
+    updateJacobian();
+  }
+
+  // TODO(JS): It would be good if we know whether the skeleton is initialzed.
+  mSkeleton->setKinematicsDirty(mSkeleton->getBodyNode(mSkelIndex),
+                                _updateTransforms, false, false);
+
+  if (_updateVels || _updateAccs)
+  {
+    mSkeleton->setKinematicsDirty(mSkeleton->getRootBodyNode(), false,
+                                  _updateVels, _updateAccs);
   }
 }
 
@@ -194,6 +194,61 @@ public:
   /// to child body node w.r.t. local generalized coordinate
   const math::Jacobian& getLocalJacobianTimeDeriv() const;
 
+  /// \brief Get relative spatial velocity of the child body node w.r.t. the
+  /// parent body node, S * dq, expressed in the child body node frame
+  virtual Eigen::Vector6d getLocalJacobianTimesGenVels() const;
+
+  /// \brief Get S * ddq, expressed in the child body node frame
+  virtual Eigen::Vector6d getLocalJacobianTimesGenAccs() const;
+
+  /// \brief Get S * (velocity change), expressed in the child body node frame
+  virtual Eigen::Vector6d getLocalJacobianTimesVelsChange() const;
+
+  /// \brief Get dS * dq, expressed in the child body node frame
+  virtual Eigen::Vector6d getLocalJacobianTimeDerivTimesGenVels() const;
+
+  /// \brief Get the derivative of the local Jacobian with respect to the
+  /// _index-th generalized coordinate of this joint.
+  ///
+  /// The default implementation assumes that the local transformation is a
+  /// product of exponentials of the columns of the local Jacobian in order,
+  /// which holds for every joint whose generalized velocities are the time
+  /// derivatives of its configurations.
+  virtual math::Jacobian getLocalJacobianDeriv(size_t _index) const;
+
+  /// \brief Get the derivative of the time derivative of the local Jacobian
+  /// with respect to the _index-th generalized coordinate of this joint while
+  /// the generalized velocities are held fixed.
+  /// \sa getLocalJacobianDeriv()
+  virtual math::Jacobian getLocalJacobianTimeDerivDeriv(size_t _index) const;
+
+  /// \brief Get the derivative of the configurations of this joint with
+  /// respect to the perturbation of the generalized coordinates used by
+  /// getLocalJacobianDeriv(). The default implementation returns the identity
+  /// for joints whose configurations are perturbed additively.
+  virtual Eigen::MatrixXd getConfigsPerturbationDeriv() const;
+
+  /// \brief Compute transformations from parent body node to child body node
+  /// for a batch of configurations. The state of this joint is neither read
+  /// nor changed, so this function can be called concurrently.
+  /// \param[in] _configs Configurations of the skeleton with one row per
+  /// sample and one column per generalized coordinate of the skeleton.
+  /// \param[out] _transforms One row per sample. Columns 0-8 hold the rotation
+  /// in column-major order and columns 9-11 hold the translation.
+  virtual void computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                      Eigen::MatrixXd* _transforms) const;
+
+  /// \brief Compute the transformation from parent body node to child body
+  /// node, the local Jacobian and its time derivative for the given
+  /// configurations and generalized velocities of this joint. Unlike
+  /// updateTransform() and updateJacobian(), the state of this joint is
+  /// neither read nor changed, so this function can be called concurrently.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const = 0;
+
   /// \brief Get whether this joint contains _genCoord.
   /// \param[in] Generalized coordinate to see.
   /// \return True if this joint contains _genCoord.
@@ -241,6 +296,14 @@ protected:
   /// \brief Initialize this joint. This function is called by BodyNode::init()
   virtual void init(Skeleton* _skel, int _skelIdx);
 
+  /// \brief Mark the kinematic quantities of the skeleton as stale after the
+  /// configurations of this joint changed. The local transformation and
+  /// Jacobian of this joint are updated immediately when _updateTransforms is
+  /// true, while the body nodes of the child subtree are updated on demand.
+  void setKinematicsDirty(bool _updateTransforms,
+                          bool _updateVels,
+                          bool _updateAccs);
+
   /// \brief Update transformation from parent body node to child body node
   virtual void updateTransform() = 0;
 
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2013-2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_DYNAMICS_MULTIDOFJOINT_H_
+#define DART_DYNAMICS_MULTIDOFJOINT_H_
+
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "dart/math/Helpers.h"
+#include "dart/dynamics/GenCoord.h"
+#include "dart/dynamics/Joint.h"
+
+namespace dart {
+namespace dynamics {
+
+/// \brief Base class of joints with a number of generalized coordinates known
+/// at compile time.
+///
+/// The local Jacobian and its time derivative are stored as fixed-size 6 x DOF
+/// matrices. The velocity-level products that BodyNode evaluates for every
+/// body in the recursive algorithms are computed with these fixed-size types,
+/// so they need neither heap allocations nor dynamic-size Eigen kernels.
+/// Joint::mS and Joint::mdS mirror the fixed-size matrices for the generic
+/// Joint interface.
+template<size_t DOF>
+class MultiDofJoint : public Joint
+{
+public:
+  /// \brief Fixed-size vector of generalized coordinates of this joint
+  typedef Eigen::Matrix<double, DOF, 1> Vector;
+
+  /// \brief Fixed-size local Jacobian of this joint
+  typedef Eigen::Matrix<double, 6, DOF> JacobianMatrix;
+
+  /// \brief Constructor
+  explicit MultiDofJoint(const std::string& _name);
+
+  /// \brief Destructor
+  virtual ~MultiDofJoint();
+
+  /// \brief Set configurations from a fixed-size vector
+  void setConfigsStatic(const Vector& _configs);
+
+  /// \brief Get configurations as a fixed-size vector
+  Vector getConfigsStatic() const;
+
+  /// \brief Get generalized velocities as a fixed-size vector
+  Vector getGenVelsStatic() const;
+
+  /// \brief Get generalized accelerations as a fixed-size vector
+  Vector getGenAccsStatic() const;
+
+  /// \brief Get velocity changes as a fixed-size vector
+  Vector getVelsChangeStatic() const;
+
+  /// \brief Get fixed-size local Jacobian
+  const JacobianMatrix& getLocalJacobianStatic() const;
+
+  /// \brief Get fixed-size time derivative of local Jacobian
+  const JacobianMatrix& getLocalJacobianTimeDerivStatic() const;
+
+  // Documentation inherited
+  virtual Eigen::Vector6d getLocalJacobianTimesGenVels() const;
+
+  // Documentation inherited
+  virtual Eigen::Vector6d getLocalJacobianTimesGenAccs() const;
+
+  // Documentation inherited
+  virtual Eigen::Vector6d getLocalJacobianTimesVelsChange() const;
+
+  // Documentation inherited
+  virtual Eigen::Vector6d getLocalJacobianTimeDerivTimesGenVels() const;
+
+protected:
+  // Documentation inherited
+  virtual void updateJacobian();
+
+  // Documentation inherited
+  virtual void updateJacobianTimeDeriv();
+
+  /// \brief Update mJacobian
+  virtual void updateLocalJacobian() = 0;
+
+  /// \brief Update mJacobianDeriv
+  virtual void updateLocalJacobianTimeDeriv() = 0;
+
+protected:
+  /// \brief Generalized coordinates
+  GenCoord mCoordinate[DOF];
+
+  /// \brief Fixed-size local Jacobian
+  JacobianMatrix mJacobian;
+
+  /// \brief Fixed-size time derivative of local Jacobian
+  JacobianMatrix mJacobianDeriv;
+
+public:
+  // To get byte-aligned Eigen vectors
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//==============================================================================
+template<size_t DOF>
+MultiDofJoint<DOF>::MultiDofJoint(const std::string& _name)
+  : Joint(_name),
+    mJacobian(JacobianMatrix::Zero()),
+    mJacobianDeriv(JacobianMatrix::Zero())
+{
+  for (size_t i = 0; i < DOF; ++i)
+    mGenCoords.push_back(&mCoordinate[i]);
+
+  mS = mJacobian;
+  mdS = mJacobianDeriv;
+
+  mSpringStiffness.resize(DOF, 0.0);
+  mDampingCoefficient.resize(DOF, 0.0);
+  mRestPosition.resize(DOF, 0.0);
+}
+
+//==============================================================================
+template<size_t DOF>
+MultiDofJoint<DOF>::~MultiDofJoint()
+{
+}
+
+//==============================================================================
+template<size_t DOF>
+void MultiDofJoint<DOF>::setConfigsStatic(const Vector& _configs)
+{
+  for (size_t i = 0; i < DOF; ++i)
+    mCoordinate[i].setPos(_configs[i]);
+}
+
+//==============================================================================
+template<size_t DOF>
+typename MultiDofJoint<DOF>::Vector MultiDofJoint<DOF>::getConfigsStatic() const
+{
+  Vector q;
+  for (size_t i = 0; i < DOF; ++i)
+    q[i] = mCoordinate[i].getPos();
+  return q;
+}
+
+//==============================================================================
+template<size_t DOF>
+typename MultiDofJoint<DOF>::Vector MultiDofJoint<DOF>::getGenVelsStatic() const
+{
+  Vector dq;
+  for (size_t i = 0; i < DOF; ++i)
+    dq[i] = mCoordinate[i].getVel();
+  return dq;
+}
+
+//==============================================================================
+template<size_t DOF>
+typename MultiDofJoint<DOF>::Vector MultiDofJoint<DOF>::getGenAccsStatic() const
+{
+  Vector ddq;
+  for (size_t i = 0; i < DOF; ++i)
+    ddq[i] = mCoordinate[i].getAcc();
+  return ddq;
+}
+
+//==============================================================================
+template<size_t DOF>
+typename MultiDofJoint<DOF>::Vector
+MultiDofJoint<DOF>::getVelsChangeStatic() const
+{
+  Vector delDq;
+  for (size_t i = 0; i < DOF; ++i)
+    delDq[i] = mCoordinate[i].getVelChange();
+  return delDq;
+}
+
+//==============================================================================
+template<size_t DOF>
+const typename MultiDofJoint<DOF>::JacobianMatrix&
+MultiDofJoint<DOF>::getLocalJacobianStatic() const
+{
+  return mJacobian;
+}
+
+//==============================================================================
+template<size_t DOF>
+const typename MultiDofJoint<DOF>::JacobianMatrix&
+MultiDofJoint<DOF>::getLocalJacobianTimeDerivStatic() const
+{
+  return mJacobianDeriv;
+}
+
+//==============================================================================
+template<size_t DOF>
+Eigen::Vector6d MultiDofJoint<DOF>::getLocalJacobianTimesGenVels() const
+{
+  return mJacobian * getGenVelsStatic();
+}
+
+//==============================================================================
+template<size_t DOF>
+Eigen::Vector6d MultiDofJoint<DOF>::getLocalJacobianTimesGenAccs() const
+{
+  return mJacobian * getGenAccsStatic();
+}
+
+//==============================================================================
+template<size_t DOF>
+Eigen::Vector6d MultiDofJoint<DOF>::getLocalJacobianTimesVelsChange() const
+{
+  return mJacobian * getVelsChangeStatic();
+}
+
+//==============================================================================
+template<size_t DOF>
+Eigen::Vector6d MultiDofJoint<DOF>::getLocalJacobianTimeDerivTimesGenVels() const
+{
+  return mJacobianDeriv * getGenVelsStatic();
+}
+
+//==============================================================================
+template<size_t DOF>
+void MultiDofJoint<DOF>::updateJacobian()
+{
+  updateLocalJacobian();
+  assert(!math::isNan(mJacobian));
+
+  mS = mJacobian;
+}
+
+//==============================================================================
+template<size_t DOF>
+void MultiDofJoint<DOF>::updateJacobianTimeDeriv()
+{
+  updateLocalJacobianTimeDeriv();
+  assert(!math::isNan(mJacobianDeriv));
+
+  mdS = mJacobianDeriv;
+}
+
+}  // namespace dynamics
+}  // namespace dart
+
+#endif  // DART_DYNAMICS_MULTIDOFJOINT_H_
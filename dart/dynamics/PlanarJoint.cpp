@@ -47,19 +47,8 @@ namespace dynamics {
 
 //==============================================================================
 PlanarJoint::PlanarJoint(const std::string& _name)
-  : Joint(_name)
+  : MultiDofJoint<3>(_name)
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-  mGenCoords.push_back(&mCoordinate[2]);
-
-  mS = Eigen::Matrix<double, 6, 3>::Zero();
-  mdS = Eigen::Matrix<double, 6, 3>::Zero();
-
-  mSpringStiffness.resize(3, 0.0);
-  mDampingCoefficient.resize(3, 0.0);
-  mRestPosition.resize(3, 0.0);
-
   setXYPlane();
 }
 
@@ -118,6 +107,40 @@ void PlanarJoint::setArbitraryPlane(const Eigen::Vector3d& _transAxis1,
   mRotAxis = (mTransAxis1.cross(mTransAxis2)).normalized();
 }
 
+//==============================================================================
+void PlanarJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                         const Eigen::VectorXd& _genVels,
+                                         Eigen::Isometry3d* _T,
+                                         math::Jacobian* _S,
+                                         math::Jacobian* _dS) const
+{
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 3 && _genVels.size() == 3);
+
+  *_T = mT_ParentBodyToJoint
+        * Eigen::Translation3d(mTransAxis1 * _configs[0])
+        * Eigen::Translation3d(mTransAxis2 * _configs[1])
+        * math::expAngular    (mRotAxis    * _configs[2])
+        * mT_ChildBodyToJoint.inverse();
+
+  Eigen::Matrix<double, 6, 3> J = Eigen::Matrix<double, 6, 3>::Zero();
+  J.block<3, 1>(3, 0) = mTransAxis1;
+  J.block<3, 1>(3, 1) = mTransAxis2;
+  J.block<3, 1>(0, 2) = mRotAxis;
+
+  _S->resize(6, 3);
+  _S->leftCols<2>()
+      = math::AdTJac(mT_ChildBodyToJoint
+                     * math::expAngular(mRotAxis * -_configs[2]),
+                     J.leftCols<2>());
+  _S->col(2) = math::AdTJac(mT_ChildBodyToJoint, J.col(2));
+
+  _dS->resize(6, 3);
+  _dS->col(0) = -math::ad(_S->col(2) * _genVels[2], _S->col(0));
+  _dS->col(1) = -math::ad(_S->col(2) * _genVels[2], _S->col(1));
+  _dS->col(2).setZero();
+}
+
 //==============================================================================
 void PlanarJoint::updateTransform()
 {
@@ -131,47 +154,47 @@ void PlanarJoint::updateTransform()
 }
 
 //==============================================================================
-void PlanarJoint::updateJacobian()
+void PlanarJoint::updateLocalJacobian()
 {
   Eigen::MatrixXd J = Eigen::MatrixXd::Zero(6, 3);
   J.block<3, 1>(3, 0) = mTransAxis1;
   J.block<3, 1>(3, 1) = mTransAxis2;
   J.block<3, 1>(0, 2) = mRotAxis;
 
-  mS.leftCols<2>()
+  mJacobian.leftCols<2>()
       = math::AdTJac(mT_ChildBodyToJoint
                      * math::expAngular(mRotAxis * -mCoordinate[2].getPos()),
                      J.leftCols<2>());
-  mS.col(2)     = math::AdTJac(mT_ChildBodyToJoint, J.col(2));
+  mJacobian.col(2) = math::AdTJac(mT_ChildBodyToJoint, J.col(2));
 
-  assert(!math::isNan(mS));
+  assert(!math::isNan(mJacobian));
 }
 
 //==============================================================================
-void PlanarJoint::updateJacobianTimeDeriv()
+void PlanarJoint::updateLocalJacobianTimeDeriv()
 {
   Eigen::MatrixXd J = Eigen::MatrixXd::Zero(6, 3);
   J.block<3, 1>(3, 0) = mTransAxis1;
   J.block<3, 1>(3, 1) = mTransAxis2;
   J.block<3, 1>(0, 2) = mRotAxis;
 
-  mdS.col(0)
-      = -math::ad(mS.col(2)*mCoordinate[2].getVel(),
+  mJacobianDeriv.col(0)
+      = -math::ad(mJacobian.col(2)*mCoordinate[2].getVel(),
                   math::AdT(mT_ChildBodyToJoint
                             * math::expAngular(mRotAxis
                                                * -mCoordinate[2].getPos()),
                             J.col(0)));
 
-  mdS.col(1)
-      = -math::ad(mS.col(2)*mCoordinate[2].getVel(),
+  mJacobianDeriv.col(1)
+      = -math::ad(mJacobian.col(2)*mCoordinate[2].getVel(),
                   math::AdT(mT_ChildBodyToJoint
                             * math::expAngular(mRotAxis
                                                * -mCoordinate[2].getPos()),
                             J.col(1)));
 
-  assert(mdS.col(2) == Eigen::Vector6d::Zero());
-  assert(!math::isNan(mdS.col(0)));
-  assert(!math::isNan(mdS.col(1)));
+  assert(mJacobianDeriv.col(2) == Eigen::Vector6d::Zero());
+  assert(!math::isNan(mJacobianDeriv.col(0)));
+  assert(!math::isNan(mJacobianDeriv.col(1)));
 }
 
 //==============================================================================
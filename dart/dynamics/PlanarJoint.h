@@ -39,8 +39,7 @@
 
 #include <string>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
@@ -60,7 +59,7 @@ enum PlaneType
 /// First and second coordiantes represent translation along first and second
 /// translational axese, respectively. Third coordinate represents rotation
 /// along rotational axis.
-class PlanarJoint : public Joint
+class PlanarJoint : public MultiDofJoint<3>
 {
 public:
   /// Constructor
@@ -94,20 +93,22 @@ public:
   /// Return second translational axis
   const Eigen::Vector3d& getTranslationalAxis2() const;
 
+  // Documentation inherited
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
 protected:
   // Documentation inherited
   virtual void updateTransform();
 
   // Documentation inherited
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited
-  virtual void updateJacobianTimeDeriv();
-
-  /// Generalized coordinates. First and second coordiantes represent
-  /// translation along first and second translational axes, respectively. Third
-  /// coordinate represents rotation along rotational axis.
-  GenCoord mCoordinate[3];
+  virtual void updateLocalJacobianTimeDeriv();
 
   /// Plane type
   PlaneType mPlaneType;
@@ -52,18 +52,20 @@ namespace dynamics {
 PointMass::PointMass(SoftBodyNode* _softBodyNode)
   : GenCoordSystem(),
     mMass(0.0005),
-    mW(Eigen::Vector3d::Zero()),
-    mX(Eigen::Vector3d::Zero()),
-    mX0(Eigen::Vector3d::Zero()),
-    mV(Eigen::Vector3d::Zero()),
-    mEta(Eigen::Vector3d::Zero()),
-    mAlpha(Eigen::Vector3d::Zero()),
-    mBeta(Eigen::Vector3d::Zero()),
-    mdV(Eigen::Vector3d::Zero()),
-    mF(Eigen::Vector3d::Zero()),
-    mB(Eigen::Vector3d::Zero()),
+    mIndex(-1),
+    mDetachedState(Eigen::Matrix<double, 3, 11>::Zero()),
+    mW(mDetachedState.col(0).data(), Eigen::InnerStride<>(1)),
+    mX(mDetachedState.col(1).data(), Eigen::InnerStride<>(1)),
+    mX0(mDetachedState.col(2).data(), Eigen::InnerStride<>(1)),
+    mV(mDetachedState.col(3).data(), Eigen::InnerStride<>(1)),
+    mEta(mDetachedState.col(4).data(), Eigen::InnerStride<>(1)),
+    mAlpha(mDetachedState.col(5).data(), Eigen::InnerStride<>(1)),
+    mBeta(mDetachedState.col(6).data(), Eigen::InnerStride<>(1)),
+    mdV(mDetachedState.col(7).data(), Eigen::InnerStride<>(1)),
+    mF(mDetachedState.col(8).data(), Eigen::InnerStride<>(1)),
+    mB(mDetachedState.col(9).data(), Eigen::InnerStride<>(1)),
+    mFext(mDetachedState.col(10).data(), Eigen::InnerStride<>(1)),
     mParentSoftBodyNode(_softBodyNode),
-    mFext(Eigen::Vector3d::Zero()),
     mShape(new EllipsoidShape(Eigen::Vector3d(0.01, 0.01, 0.01))),
     mIsColliding(false),
     mDelV(Eigen::Vector3d::Zero()),
@@ -88,6 +90,9 @@ void PointMass::setMass(double _mass)
 {
   assert(0.0 < _mass);
   mMass = _mass;
+
+  if (mIndex >= 0)
+    mParentSoftBodyNode->mPointMassMasses[mIndex] = _mass;
 }
 
 double PointMass::getMass() const
@@ -201,18 +206,21 @@ void PointMass::setRestingPosition(const Eigen::Vector3d& _p)
   mX0 = _p;
 }
 
-const Eigen::Vector3d& PointMass::getRestingPosition() const
+Eigen::Vector3d PointMass::getRestingPosition() const
 {
   return mX0;
 }
 
-const Eigen::Vector3d& PointMass::getLocalPosition() const
+Eigen::Vector3d PointMass::getLocalPosition() const
 {
+  // Point masses are updated together with their parent soft body node
+  mParentSoftBodyNode->getWorldTransform();
   return mX;
 }
 
-const Eigen::Vector3d& PointMass::getWorldPosition() const
+Eigen::Vector3d PointMass::getWorldPosition() const
 {
+  mParentSoftBodyNode->getWorldTransform();
   return mW;
 }
 
@@ -265,24 +273,27 @@ int PointMass::getDependentGenCoord(int _arrayIndex) const
   return mDependentGenCoordIndices[_arrayIndex];
 }
 
-const Eigen::Vector3d&PointMass::getBodyVelocity() const
+Eigen::Vector3d PointMass::getBodyVelocity() const
 {
+  mParentSoftBodyNode->getBodyVelocity();
   return mV;
 }
 
 Eigen::Vector3d PointMass::getWorldVelocity() const
 {
-  return mParentSoftBodyNode->getWorldTransform().linear() * mV;
+  return mParentSoftBodyNode->getWorldTransform().linear() * getBodyVelocity();
 }
 
-const Eigen::Vector3d& PointMass::getBodyAcceleration() const
+Eigen::Vector3d PointMass::getBodyAcceleration() const
 {
+  mParentSoftBodyNode->getBodyAcceleration();
   return mdV;
 }
 
 Eigen::Vector3d PointMass::getWorldAcceleration() const
 {
-  return mParentSoftBodyNode->getWorldTransform().linear() * mdV;
+  return mParentSoftBodyNode->getWorldTransform().linear()
+      * getBodyAcceleration();
 }
 
 void PointMass::init()
@@ -302,151 +313,12 @@ void PointMass::init()
   mDependentGenCoordIndices[parentDof + 2] = mCoordinate[2].getSkeletonIndex();
 }
 
-void PointMass::updateTransform()
-{
-  // Local transpose
-  mX = getConfigs() + mX0;
-  assert(!math::isNan(mX));
-
-  // World transpose
-  mW = mParentSoftBodyNode->getWorldTransform().translation()
-       + mParentSoftBodyNode->getWorldTransform().linear() * mX;
-  assert(!math::isNan(mW));
-}
-
-void PointMass::updateVelocity()
-{
-  // v = w(parent) x mX + v(parent) + dq
-  mV = mParentSoftBodyNode->getBodyVelocity().head<3>().cross(mX)
-       + mParentSoftBodyNode->getBodyVelocity().tail<3>()
-       + getGenVels();
-  assert(!math::isNan(mV));
-}
-
-void PointMass::updateEta()
-{
-  // eta = w(parent) x dq
-  Eigen::Vector3d dq = getGenVels();
-  mEta = mParentSoftBodyNode->getBodyVelocity().head<3>().cross(dq);
-  assert(!math::isNan(mEta));
-}
-
-void PointMass::updateAcceleration()
-{
-  // dv = dw(parent) x mX + dv(parent) + eata + ddq
-  mdV = mParentSoftBodyNode->getBodyAcceleration().head<3>().cross(mX) +
-        mParentSoftBodyNode->getBodyAcceleration().tail<3>() +
-        mEta + getGenAccs();
-  assert(!math::isNan(mdV));
-}
-
-void PointMass::updateBodyForce(const Eigen::Vector3d& _gravity,
-                                bool _withExternalForces)
-{
-  // f = m*dv + w(parent) x m*v - fext
-  mF.noalias() = mMass * mdV;
-  mF += mParentSoftBodyNode->getBodyVelocity().head<3>().cross(mMass * mV)
-        - mFext;
-  if (mParentSoftBodyNode->getGravityMode() == true)
-  {
-    mF -= mMass * (mParentSoftBodyNode->getWorldTransform().linear().transpose()
-                   * _gravity);
-  }
-  assert(!math::isNan(mF));
-}
-
-void PointMass::updateArticulatedInertia(double _dt)
-{
-  // Articulated inertia
-  // - Do nothing
-
-  // Cache data: PsiK and Psi
-  mPsi = 1.0 / mMass;
-  mImplicitPsi
-      = 1.0 / (mMass
-               + _dt * mParentSoftBodyNode->getDampingCoefficient()
-               + _dt * _dt * mParentSoftBodyNode->getVertexSpringStiffness());
-  assert(!math::isNan(mImplicitPsi));
-
-  // Cache data: AI_S_Psi
-  // - Do nothing
-
-  // Cache data: Pi
-  mPi         = mMass - mMass * mMass * mPsi;
-  mImplicitPi = mMass - mMass * mMass * mImplicitPsi;
-  assert(!math::isNan(mPi));
-  assert(!math::isNan(mImplicitPi));
-}
-
 void PointMass::updateGeneralizedForce(bool _withDampingForces)
 {
   // tau = f
   setGenForces(mF);
 }
 
-void PointMass::updateBiasForce(double _dt, const Eigen::Vector3d& _gravity)
-{
-  // B = w(parent) x m*v - fext - fgravity
-  // - w(parent) x m*v - fext
-  mB = mParentSoftBodyNode->getBodyVelocity().head<3>().cross(mMass*mV) - mFext;
-  // - fgravity
-  if (mParentSoftBodyNode->getGravityMode() == true)
-  {
-    mB -= mMass
-          * (mParentSoftBodyNode->getWorldTransform().linear().transpose()
-             * _gravity);
-  }
-  assert(!math::isNan(mB));
-
-  // Cache data: alpha
-  double kv = mParentSoftBodyNode->getVertexSpringStiffness();
-  double ke = mParentSoftBodyNode->getEdgeSpringStiffness();
-  double kd = mParentSoftBodyNode->getDampingCoefficient();
-  int nN = mConnectedPointMasses.size();
-  mAlpha = getGenForces()
-           - (kv + nN * ke) * getConfigs()
-           - (_dt * (kv + nN * ke) + kd) * getGenVels()
-           - mMass * mEta
-           - mB;
-  for (int i = 0; i < mConnectedPointMasses.size(); ++i)
-  {
-    mAlpha += ke * (mConnectedPointMasses[i]->getConfigs()
-                    + _dt * mConnectedPointMasses[i]->getGenVels());
-  }
-  assert(!math::isNan(mAlpha));
-
-  // Cache data: beta
-  mBeta = mB;
-  mBeta.noalias() += mMass * (mEta + mImplicitPsi * mAlpha);
-  assert(!math::isNan(mBeta));
-}
-
-void PointMass::update_ddq()
-{
-  // ddq = imp_psi*(alpha - m*(dw(parent) x mX + dv(parent))
-  Eigen::Vector3d ddq =
-      mImplicitPsi
-      * (mAlpha - mMass
-         * (mParentSoftBodyNode->getBodyAcceleration().head<3>().cross(mX)
-            + mParentSoftBodyNode->getBodyAcceleration().tail<3>()));
-  setGenAccs(ddq);
-  assert(!math::isNan(ddq));
-
-  // dv = dw(parent) x mX + dv(parent) + eata + ddq
-  mdV = mParentSoftBodyNode->getBodyAcceleration().head<3>().cross(mX) +
-        mParentSoftBodyNode->getBodyAcceleration().tail<3>() +
-        mEta + getGenAccs();
-  assert(!math::isNan(mdV));
-}
-
-void PointMass::update_F_fs()
-{
-  // f = m*dv + B
-  mF = mB;
-  mF.noalias() += mMass * mdV;
-  assert(!math::isNan(mF));
-}
-
 void PointMass::updateMassMatrix()
 {
   mM_dV = getGenAccs()
@@ -480,7 +352,7 @@ void PointMass::updateJointVelocityChange()
 //              + mParentSoftBodyNode->getBodyVelocityChange().tail<3>()));
 
   Eigen::Vector3d del_dq
-      = mPsi * mImpAlpha
+      = mParentSoftBodyNode->mPointMassPsi[mIndex] * mImpAlpha
         - mParentSoftBodyNode->getBodyVelocityChange().head<3>().cross(mX)
         - mParentSoftBodyNode->getBodyVelocityChange().tail<3>();
 
@@ -542,7 +414,8 @@ void PointMass::updateInvMassMatrix()
 
 void PointMass::updateInvAugMassMatrix()
 {
-  mInvM_beta = mMass * mImplicitPsi * getGenForces();
+  mInvM_beta = mMass * mParentSoftBodyNode->mPointMassImplicitPsi[mIndex]
+               * getGenForces();
 }
 
 void PointMass::aggregateInvMassMatrix(Eigen::MatrixXd* _MInvCol, int _col)
@@ -551,7 +424,7 @@ void PointMass::aggregateInvMassMatrix(Eigen::MatrixXd* _MInvCol, int _col)
   // We assume that the three generalized coordinates are in a row.
   int iStart = getGenCoord(0)->getSkeletonIndex();
   _MInvCol->block<3, 1>(iStart, _col)
-      = mPsi * getGenForces()
+      = mParentSoftBodyNode->mPointMassPsi[mIndex] * getGenForces()
         - mParentSoftBodyNode->mInvM_U.head<3>().cross(mX)
         - mParentSoftBodyNode->mInvM_U.tail<3>();
 }
@@ -563,7 +436,7 @@ void PointMass::aggregateInvAugMassMatrix(Eigen::MatrixXd* _MInvCol, int _col,
   // We assume that the three generalized coordinates are in a row.
   int iStart = getGenCoord(0)->getSkeletonIndex();
   _MInvCol->block<3, 1>(iStart, _col)
-      = mImplicitPsi
+      = mParentSoftBodyNode->mPointMassImplicitPsi[mIndex]
         * (getGenForces()
            - mMass * (mParentSoftBodyNode->mInvM_U.head<3>().cross(mX)
                       + mParentSoftBodyNode->mInvM_U.tail<3>()));
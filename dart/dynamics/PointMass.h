@@ -59,6 +59,11 @@ class PointMass : public GenCoordSystem
 public:
   friend class SoftBodyNode;
 
+  /// \brief View of one point mass in the contiguous x/y/z arrays owned by
+  ///        the parent soft body node.
+  typedef Eigen::Map<Eigen::Vector3d, 0, Eigen::InnerStride<> >
+      StridedVector3d;
+
   //--------------------------------------------------------------------------
   // Constructor and Desctructor
   //--------------------------------------------------------------------------
@@ -124,13 +129,13 @@ public:
   void setRestingPosition(const Eigen::Vector3d& _p);
 
   /// \brief
-  const Eigen::Vector3d& getRestingPosition() const;
+  Eigen::Vector3d getRestingPosition() const;
 
   /// \brief
-  const Eigen::Vector3d& getLocalPosition() const;
+  Eigen::Vector3d getLocalPosition() const;
 
   /// \brief
-  const Eigen::Vector3d& getWorldPosition() const;
+  Eigen::Vector3d getWorldPosition() const;
 
   /// \todo Temporary function.
   Eigen::Matrix<double, 3, Eigen::Dynamic> getBodyJacobian();
@@ -152,7 +157,7 @@ public:
 
   /// \brief Get the generalized velocity at the position of this point mass
   ///        where the velocity is expressed in the parent soft body node frame.
-  const Eigen::Vector3d& getBodyVelocity() const;
+  Eigen::Vector3d getBodyVelocity() const;
 
   /// \brief Get the generalized velocity at the position of this point mass
   ///        where the velocity is expressed in the world frame.
@@ -161,7 +166,7 @@ public:
   /// \brief Get the generalized acceleration at the position of this point mass
   ///        where the acceleration is expressed in the parent soft body node
   ///        frame.
-  const Eigen::Vector3d& getBodyAcceleration() const;
+  Eigen::Vector3d getBodyAcceleration() const;
 
   /// \brief Get the generalized acceleration at the position of this point mass
   ///        where the acceleration is expressed in the world frame.
@@ -171,37 +176,9 @@ protected:
   /// \brief
   void init();
 
-  /// \brief
-  void updateTransform();
-
-  /// \brief
-  void updateVelocity();
-
-  /// \brief
-  void updateEta();
-
-  /// \brief
-  void updateAcceleration();
-
-  /// \brief
-  void updateBodyForce(const Eigen::Vector3d& _gravity,
-                       bool _withExternalForces = false);
-
-  /// \brief
-  void updateArticulatedInertia(double _dt);
-
   /// \brief
   void updateGeneralizedForce(bool _withDampingForces = false);
 
-  /// \brief
-  void updateBiasForce(double _dt, const Eigen::Vector3d& _gravity);
-
-  /// \brief
-  void update_ddq();
-
-  /// \brief
-  void update_F_fs();
-
   /// \brief
   void updateMassMatrix();
 
@@ -294,47 +271,46 @@ protected:
   /// \brief Mass.
   double mMass;
 
+  /// \brief Index of this point mass in the contiguous state of the parent
+  ///        soft body node, or -1 until the parent is initialized.
+  int mIndex;
+
+  /// \brief Storage of the vectors below until the parent soft body node is
+  ///        initialized and maps them into its contiguous state.
+  Eigen::Matrix<double, 3, 11> mDetachedState;
+
   /// \brief Current position viewed in world frame.
-  Eigen::Vector3d mW;
+  StridedVector3d mW;
 
   /// \brief Current position viewed in parent soft body node frame.
-  Eigen::Vector3d mX;
+  StridedVector3d mX;
 
   /// \brief Resting postion viewed in parent soft body node frame.
-  Eigen::Vector3d mX0;
+  StridedVector3d mX0;
 
   /// \brief Current velocity viewed in parent soft body node frame.
-  Eigen::Vector3d mV;
+  StridedVector3d mV;
 
   /// \brief
-  Eigen::Vector3d mEta;
+  StridedVector3d mEta;
 
   /// \brief
-  Eigen::Vector3d mAlpha;
+  StridedVector3d mAlpha;
 
   /// \brief
-  Eigen::Vector3d mBeta;
+  StridedVector3d mBeta;
 
   /// \brief Current acceleration viewed in parent body node frame.
-  Eigen::Vector3d mdV;
-
-  /// \brief
-  Eigen::Vector3d mF;
-
-  /// \brief
-  double mPsi;
+  StridedVector3d mdV;
 
   /// \brief
-  double mImplicitPsi;
-
-  /// \brief
-  double mPi;
-
-  /// \brief
-  double mImplicitPi;
+  StridedVector3d mF;
 
   /// \brief Bias force
-  Eigen::Vector3d mB;
+  StridedVector3d mB;
+
+  /// \brief External force.
+  StridedVector3d mFext;
 
   /// \brief
   SoftBodyNode* mParentSoftBodyNode;
@@ -342,9 +318,6 @@ protected:
   /// \brief
   std::vector<PointMass*> mConnectedPointMasses;
 
-  /// \brief External force.
-  Eigen::Vector3d mFext;
-
   /// \brief A increasingly sorted list of dependent dof indices.
   std::vector<int> mDependentGenCoordIndices;
 
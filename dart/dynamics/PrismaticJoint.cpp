@@ -47,17 +47,9 @@ namespace dynamics {
 
 PrismaticJoint::PrismaticJoint(const Eigen::Vector3d& axis,
                                const std::string& _name)
-  : Joint(_name),
+  : MultiDofJoint<1>(_name),
     mAxis(axis.normalized())
 {
-  mGenCoords.push_back(&mCoordinate);
-
-  mS = Eigen::Matrix<double, 6, 1>::Zero();
-  mdS = Eigen::Matrix<double, 6, 1>::Zero();
-
-  mSpringStiffness.resize(1, 0.0);
-  mDampingCoefficient.resize(1, 0.0);
-  mRestPosition.resize(1, 0.0);
 }
 
 PrismaticJoint::~PrismaticJoint() {
@@ -71,21 +63,56 @@ const Eigen::Vector3d&PrismaticJoint::getAxis() const {
   return mAxis;
 }
 
+void PrismaticJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                            const Eigen::VectorXd& _genVels,
+                                            Eigen::Isometry3d* _T,
+                                            math::Jacobian* _S,
+                                            math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 1 && _genVels.size() == 1);
+
+  *_T = mT_ParentBodyToJoint
+        * Eigen::Translation3d(mAxis * _configs[0])
+        * mT_ChildBodyToJoint.inverse();
+  *_S = math::AdTLinear(mT_ChildBodyToJoint, mAxis);
+  _dS->setZero(6, 1);
+}
+
 void PrismaticJoint::updateTransform() {
   mT = mT_ParentBodyToJoint
-       * Eigen::Translation3d(mAxis * mCoordinate.getPos())
+       * Eigen::Translation3d(mAxis * mCoordinate[0].getPos())
        * mT_ChildBodyToJoint.inverse();
   assert(math::verifyTransform(mT));
 }
 
-void PrismaticJoint::updateJacobian() {
-  mS = math::AdTLinear(mT_ChildBodyToJoint, mAxis);
-  assert(!math::isNan(mS));
+void PrismaticJoint::computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                            Eigen::MatrixXd* _transforms) const {
+  assert(_transforms != NULL);
+
+  // Only the translation depends on q: M0 + q * M1
+  const Eigen::Matrix<double, 3, 4> M0
+      = (mT_ParentBodyToJoint * mT_ChildBodyToJoint.inverse())
+        .matrix().topRows<3>();
+  const Eigen::Vector3d M1 = mT_ParentBodyToJoint.linear() * mAxis;
+
+  const int numSamples = _configs.rows();
+  const size_t qIndex = mCoordinate[0].getSkeletonIndex();
+
+  _transforms->resize(numSamples, 12);
+  for (int i = 0; i < 9; ++i)
+    _transforms->col(i).setConstant(M0(i));
+  for (int i = 0; i < 3; ++i)
+    _transforms->col(9 + i).array()
+        = M0(9 + i) + M1[i] * _configs.col(qIndex).array();
+}
+
+void PrismaticJoint::updateLocalJacobian() {
+  mJacobian = math::AdTLinear(mT_ChildBodyToJoint, mAxis);
 }
 
-void PrismaticJoint::updateJacobianTimeDeriv() {
-  // mdS.setZero();
-  assert(mdS == math::Jacobian::Zero(6, 1));
+void PrismaticJoint::updateLocalJacobianTimeDeriv() {
+  // mJacobianDeriv.setZero();
+  assert(mJacobianDeriv == Eigen::Vector6d::Zero());
 }
 
 }  // namespace dynamics
@@ -48,17 +48,9 @@ namespace dynamics {
 
 RevoluteJoint::RevoluteJoint(const Eigen::Vector3d& axis,
                              const std::string& _name)
-  : Joint(_name),
+  : MultiDofJoint<1>(_name),
     mAxis(axis.normalized())
 {
-  mGenCoords.push_back(&mCoordinate);
-
-  mS = Eigen::Matrix<double, 6, 1>::Zero();
-  mdS = Eigen::Matrix<double, 6, 1>::Zero();
-
-  mSpringStiffness.resize(1, 0.0);
-  mDampingCoefficient.resize(1, 0.0);
-  mRestPosition.resize(1, 0.0);
 }
 
 RevoluteJoint::~RevoluteJoint() {
@@ -72,22 +64,64 @@ const Eigen::Vector3d&RevoluteJoint::getAxis() const {
   return mAxis;
 }
 
+void RevoluteJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                           const Eigen::VectorXd& _genVels,
+                                           Eigen::Isometry3d* _T,
+                                           math::Jacobian* _S,
+                                           math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 1 && _genVels.size() == 1);
+
+  *_T = mT_ParentBodyToJoint
+        * math::expAngular(mAxis * _configs[0])
+        * mT_ChildBodyToJoint.inverse();
+  *_S = math::AdTAngular(mT_ChildBodyToJoint, mAxis);
+  _dS->setZero(6, 1);
+}
+
 void RevoluteJoint::updateTransform() {
   mT = mT_ParentBodyToJoint
-       * math::expAngular(mAxis * mCoordinate.getPos())
+       * math::expAngular(mAxis * mCoordinate[0].getPos())
        * mT_ChildBodyToJoint.inverse();
 
   assert(math::verifyTransform(mT));
 }
 
-void RevoluteJoint::updateJacobian() {
-  mS = math::AdTAngular(mT_ChildBodyToJoint, mAxis);
-  assert(!math::isNan(mS));
+void RevoluteJoint::computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                           Eigen::MatrixXd* _transforms) const {
+  assert(_transforms != NULL);
+
+  // With K = [axis], exp(K q) = (I + K^2) + sin(q) K - cos(q) K^2, so every
+  // entry of the local transformation is M0 + sin(q) * M1 + cos(q) * M2.
+  const Eigen::Isometry3d childToJointInv = mT_ChildBodyToJoint.inverse();
+  const Eigen::Matrix3d R = mT_ParentBodyToJoint.linear();
+  const Eigen::Matrix3d K = math::makeSkewSymmetric(mAxis);
+  const Eigen::Matrix3d RK = R * K;
+  const Eigen::Matrix3d RKK = RK * K;
+
+  Eigen::Matrix<double, 3, 4> M0;
+  Eigen::Matrix<double, 3, 4> M1;
+  Eigen::Matrix<double, 3, 4> M2;
+  M1 << RK * childToJointInv.linear(), RK * childToJointInv.translation();
+  M2 << -RKK * childToJointInv.linear(), -RKK * childToJointInv.translation();
+  M0 = (mT_ParentBodyToJoint * childToJointInv).matrix().topRows<3>() - M2;
+
+  const Eigen::ArrayXd q = _configs.col(mCoordinate[0].getSkeletonIndex());
+  const Eigen::ArrayXd s = q.sin();
+  const Eigen::ArrayXd c = q.cos();
+
+  _transforms->resize(_configs.rows(), 12);
+  for (int i = 0; i < 12; ++i)
+    _transforms->col(i).array() = M0(i) + M1(i) * s + M2(i) * c;
+}
+
+void RevoluteJoint::updateLocalJacobian() {
+  mJacobian = math::AdTAngular(mT_ChildBodyToJoint, mAxis);
 }
 
-void RevoluteJoint::updateJacobianTimeDeriv() {
-  // mdS.setZero();
-  assert(mdS == math::Jacobian::Zero(6, 1));
+void RevoluteJoint::updateLocalJacobianTimeDeriv() {
+  // mJacobianDeriv.setZero();
+  assert(mJacobianDeriv == Eigen::Vector6d::Zero());
 }
 
 }  // namespace dynamics
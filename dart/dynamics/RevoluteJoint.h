@@ -41,13 +41,12 @@
 
 #include <Eigen/Dense>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
-class RevoluteJoint : public Joint {
+class RevoluteJoint : public MultiDofJoint<1> {
 public:
   /// \brief Constructor.
   RevoluteJoint(const Eigen::Vector3d& axis = Eigen::Vector3d(1.0, 0.0, 0.0),
@@ -62,19 +61,27 @@ public:
   /// \brief
   const Eigen::Vector3d& getAxis() const;
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
   // Documentation inherited.
-  virtual void updateJacobian();
+  virtual void computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                      Eigen::MatrixXd* _transforms) const;
 
   // Documentation inherited.
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobian();
 
-protected:
-  /// \brief
-  GenCoord mCoordinate;
+  // Documentation inherited.
+  virtual void updateLocalJacobianTimeDeriv();
 
+protected:
   /// \brief Rotational axis.
   Eigen::Vector3d mAxis;
 
@@ -48,18 +48,10 @@ namespace dynamics {
 ScrewJoint::ScrewJoint(const Eigen::Vector3d& axis,
                        double _pitch,
                        const std::string& _name)
-  : Joint(_name),
+  : MultiDofJoint<1>(_name),
     mAxis(axis.normalized()),
     mPitch(_pitch)
 {
-  mGenCoords.push_back(&mCoordinate);
-
-  mS = Eigen::Matrix<double, 6, 1>::Zero();
-  mdS = Eigen::Matrix<double, 6, 1>::Zero();
-
-  mSpringStiffness.resize(1, 0.0);
-  mDampingCoefficient.resize(1, 0.0);
-  mRestPosition.resize(1, 0.0);
 }
 
 ScrewJoint::~ScrewJoint() {
@@ -81,27 +73,44 @@ double ScrewJoint::getPitch() const {
   return mPitch;
 }
 
+void ScrewJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                        const Eigen::VectorXd& _genVels,
+                                        Eigen::Isometry3d* _T,
+                                        math::Jacobian* _S,
+                                        math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 1 && _genVels.size() == 1);
+
+  Eigen::Vector6d S = Eigen::Vector6d::Zero();
+  S.head<3>() = mAxis;
+  S.tail<3>() = mAxis*mPitch/DART_2PI;
+  *_T = mT_ParentBodyToJoint
+        * math::expMap(S * _configs[0])
+        * mT_ChildBodyToJoint.inverse();
+  *_S = math::AdT(mT_ChildBodyToJoint, S);
+  _dS->setZero(6, 1);
+}
+
 void ScrewJoint::updateTransform() {
   Eigen::Vector6d S = Eigen::Vector6d::Zero();
   S.head<3>() = mAxis;
   S.tail<3>() = mAxis*mPitch/DART_2PI;
   mT = mT_ParentBodyToJoint
-       * math::expMap(S*mCoordinate.getPos())
+       * math::expMap(S*mCoordinate[0].getPos())
        * mT_ChildBodyToJoint.inverse();
   assert(math::verifyTransform(mT));
 }
 
-void ScrewJoint::updateJacobian() {
+void ScrewJoint::updateLocalJacobian() {
   Eigen::Vector6d S = Eigen::Vector6d::Zero();
   S.head<3>() = mAxis;
   S.tail<3>() = mAxis*mPitch/DART_2PI;
-  mS = math::AdT(mT_ChildBodyToJoint, S);
-  assert(!math::isNan(mS));
+  mJacobian = math::AdT(mT_ChildBodyToJoint, S);
 }
 
-void ScrewJoint::updateJacobianTimeDeriv() {
-  // mdS.setZero();
-  assert(mdS == math::Jacobian::Zero(6, 1));
+void ScrewJoint::updateLocalJacobianTimeDeriv() {
+  // mJacobianDeriv.setZero();
+  assert(mJacobianDeriv == Eigen::Vector6d::Zero());
 }
 
 }  // namespace dynamics
@@ -41,13 +41,12 @@
 
 #include <Eigen/Dense>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
-class ScrewJoint : public Joint {
+class ScrewJoint : public MultiDofJoint<1> {
 public:
   /// \brief Constructor.
   ScrewJoint(const Eigen::Vector3d& axis = Eigen::Vector3d(1.0, 0.0, 0.0),
@@ -69,19 +68,23 @@ public:
   /// \brief
   double getPitch() const;
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
   // Documentation inherited.
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited.
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobianTimeDeriv();
 
 protected:
-  /// \brief
-  GenCoord mCoordinate;
-
   /// \brief Rotational axis.
   Eigen::Vector3d mAxis;
 
@@ -55,13 +55,28 @@
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+/// \brief Matrices and vectors of a joint, which has at most 6 generalized
+/// coordinates. They are stored on the stack.
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6>
+    JointMatrix;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 6, 1> JointVector;
+
+}  // namespace
+
 //==============================================================================
 Skeleton::Skeleton(const std::string& _name)
   : GenCoordSystem(),
     mName(_name),
     mEnabledSelfCollisionCheck(false),
     mEnabledAdjacentBodyCheck(false),
+    mIsKinematicsDirty(false),
     mTimeStep(0.001),
+    mIsVariationalIntegration(false),
+    mVariationalSolverTolerance(1e-10),
+    mVariationalSolverMaxIterations(20),
+    mVariationalSolverIterations(0),
     mGravity(Eigen::Vector3d(0.0, 0.0, -9.81)),
     mTotalMass(0.0),
     mIsMobile(true),
@@ -75,6 +90,7 @@ Skeleton::Skeleton(const std::string& _name)
     mIsCombinedVectorDirty(true),
     mIsExternalForceVectorDirty(true),
     mIsDampingForceVectorDirty(true),
+    mIsOperationalSpaceDirty(true),
     mIsImpulseApplied(false),
     mUnionRootSkeleton(this),
     mUnionSize(1)
@@ -165,14 +181,18 @@ void Skeleton::init(double _timeStep, const Eigen::Vector3d& _gravity) {
 
   // Initialize body nodes and generalized coordinates
   mGenCoords.clear();
+  mGenCoordBodyNodes.clear();
   for (int i = 0; i < getNumBodyNodes(); ++i) {
     mBodyNodes[i]->aggregateGenCoords(&mGenCoords);
+    mGenCoordBodyNodes.resize(mGenCoords.size(), mBodyNodes[i]);
     mBodyNodes[i]->init(this, i);
     mBodyNodes[i]->updateTransform();
     mBodyNodes[i]->updateVelocity();
     mBodyNodes[i]->updateEta();
   }
 
+  compile();
+
   for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
        it != mBodyNodes.rend(); ++it) {
     (*it)->updateArticulatedInertia(mTimeStep);
@@ -309,10 +329,9 @@ void Skeleton::setConfigSegs(const std::vector<int>& _id,
                              bool _updateVels,
                              bool _updateAccs)
 {
-  for ( unsigned int i = 0; i < _id.size(); i++ )
-    mGenCoords[_id[i]]->setPos(_configs(i));
+  assert(_id.size() == static_cast<size_t>(_configs.size()));
 
-  computeForwardKinematics(_updateTransforms, _updateVels, _updateAccs);
+  setConfigsLazily(&_id, _configs, _updateTransforms, _updateVels, _updateAccs);
 }
 
 //==============================================================================
@@ -321,9 +340,10 @@ void Skeleton::setConfigs(const Eigen::VectorXd& _configs,
                           bool _updateVels,
                           bool _updateAccs)
 {
-  GenCoordSystem::setConfigs(_configs);
+  assert(_configs.size() == getNumGenCoords());
 
-  computeForwardKinematics(_updateTransforms, _updateVels, _updateAccs);
+  setConfigsLazily(NULL, _configs, _updateTransforms, _updateVels,
+                   _updateAccs);
 }
 
 //==============================================================================
@@ -395,6 +415,148 @@ void Skeleton::integrateGenVels(double _dt)
   computeForwardKinematics(false, true, false);
 }
 
+//==============================================================================
+void Skeleton::setVariationalIntegration(bool _isVariational)
+{
+  if (_isVariational && !mSoftBodyNodes.empty())
+  {
+    dtwarn << "Variational integration of Skeleton [" << mName
+           << "] with soft body nodes is not supported.\n";
+    return;
+  }
+
+  mIsVariationalIntegration = _isVariational;
+}
+
+//==============================================================================
+bool Skeleton::isVariationalIntegration() const
+{
+  return mIsVariationalIntegration;
+}
+
+//==============================================================================
+void Skeleton::setVariationalSolverTolerance(double _tolerance)
+{
+  assert(_tolerance > 0.0);
+  mVariationalSolverTolerance = _tolerance;
+}
+
+//==============================================================================
+double Skeleton::getVariationalSolverTolerance() const
+{
+  return mVariationalSolverTolerance;
+}
+
+//==============================================================================
+void Skeleton::setVariationalSolverMaxIterations(int _maxIterations)
+{
+  assert(_maxIterations > 0);
+  mVariationalSolverMaxIterations = _maxIterations;
+}
+
+//==============================================================================
+int Skeleton::getVariationalSolverMaxIterations() const
+{
+  return mVariationalSolverMaxIterations;
+}
+
+//==============================================================================
+int Skeleton::getVariationalSolverIterations() const
+{
+  return mVariationalSolverIterations;
+}
+
+//==============================================================================
+void Skeleton::computeVariationalStep(double _timeStep)
+{
+  assert(_timeStep > 0.0);
+  assert(mSoftBodyNodes.empty());
+
+  const int dof = getNumGenCoords();
+  if (dof == 0)
+    return;
+
+  const Eigen::VectorXd configs = getConfigs();
+  const Eigen::VectorXd genVels = getGenVels();
+  const Eigen::VectorXd genForces = getGenForces();
+
+  // Discrete momentum at the beginning of the step
+  const Eigen::VectorXd momentum = getMassMatrix() * genVels;
+  const double tolerance
+      = mVariationalSolverTolerance
+        * (1.0 + momentum.lpNorm<Eigen::Infinity>());
+
+  // Newton iterations on the average velocity of the step starting from the
+  // current velocities
+  mVariationalGenVels = genVels;
+  Eigen::VectorXd residual(dof);
+  bool converged = false;
+  for (mVariationalSolverIterations = 0; ; ++mVariationalSolverIterations)
+  {
+    evalVariationalMidpoint(configs, mVariationalGenVels, genForces,
+                            _timeStep);
+
+    residual = mVariationalMassMatrix * mVariationalGenVels
+               - (0.5 * _timeStep) * mVariationalForces - momentum;
+    if (residual.lpNorm<Eigen::Infinity>() <= tolerance)
+    {
+      converged = true;
+      break;
+    }
+
+    if (mVariationalSolverIterations == mVariationalSolverMaxIterations)
+      break;
+
+    mVariationalGenVels -= mVariationalMassMatrix.ldlt().solve(residual);
+  }
+
+  if (!converged)
+  {
+    dtwarn << "Variational step of Skeleton [" << mName
+           << "] did not converge in " << mVariationalSolverIterations
+           << " iterations.\n";
+  }
+
+  // Map the discrete momentum at the end of the step to the generalized
+  // velocities at the end configurations
+  const Eigen::VectorXd nextMomentum
+      = mVariationalMassMatrix * mVariationalGenVels
+        + (0.5 * _timeStep) * mVariationalForces;
+
+  GenCoordSystem::setConfigs(configs);
+  GenCoordSystem::setGenVels(mVariationalGenVels);
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+    mBodyNodes[i]->getParentJoint()->integrateConfigs(_timeStep);
+  computeForwardKinematics(true, false, false);
+  mVariationalNextGenVels = getMassMatrix().ldlt().solve(nextMomentum);
+
+  // Restore the configurations and the internal forces
+  GenCoordSystem::setConfigs(configs);
+  GenCoordSystem::setGenVels(mVariationalNextGenVels);
+  GenCoordSystem::setGenAccs((mVariationalNextGenVels - genVels) / _timeStep);
+  setGenForces(genForces);
+  computeForwardKinematics(true, true, true);
+}
+
+//==============================================================================
+void Skeleton::integrateVariationalConfigs(double _timeStep)
+{
+  assert(mVariationalGenVels.size() == getNumGenCoords());
+
+  if (getNumGenCoords() == 0)
+    return;
+
+  const Eigen::VectorXd genVels = getGenVels();
+
+  GenCoordSystem::setGenVels(mVariationalGenVels + genVels
+                             - mVariationalNextGenVels);
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+    mBodyNodes[i]->getParentJoint()->integrateConfigs(_timeStep);
+
+  GenCoordSystem::setGenVels(genVels);
+  computeForwardKinematics(true, true, false);
+}
+
 //==============================================================================
 void Skeleton::computeForwardKinematics(bool _updateTransforms,
                                         bool _updateVels,
@@ -428,6 +590,137 @@ void Skeleton::computeForwardKinematics(bool _updateTransforms,
     }
   }
 
+  if (_updateTransforms && _updateVels && _updateAccs)
+    mIsKinematicsDirty = false;
+
+  setDynamicsDirty();
+
+  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+       it != mBodyNodes.end(); ++it)
+  {
+    (*it)->mIsBodyJacobianDirty = true;
+    (*it)->mIsBodyJacobianTimeDerivDirty = true;
+  }
+}
+
+//==============================================================================
+void Skeleton::setKinematicsDirty(BodyNode* _bodyNode,
+                                  bool _updateTransforms,
+                                  bool _updateVels,
+                                  bool _updateAccs)
+{
+  assert(_bodyNode != NULL);
+  assert(_bodyNode->getSkeleton() == this);
+
+  setDynamicsDirty();
+
+  // A dirty body node always has dirty descendants, so the subtree of a body
+  // node that already has the requested flags can be skipped.
+  if ((!_updateTransforms || _bodyNode->mIsWorldTransformDirty)
+      && (!_updateVels || _bodyNode->mIsVelocityDirty)
+      && (!_updateAccs || _bodyNode->mIsAccelerationDirty))
+  {
+    return;
+  }
+
+  if (_updateTransforms)
+  {
+    _bodyNode->mIsWorldTransformDirty = true;
+    _bodyNode->mIsBodyJacobianDirty = true;
+  }
+
+  if (_updateVels)
+    _bodyNode->mIsVelocityDirty = true;
+
+  if (_updateTransforms || _updateVels)
+    _bodyNode->mIsBodyJacobianTimeDerivDirty = true;
+
+  if (_updateAccs)
+    _bodyNode->mIsAccelerationDirty = true;
+
+  mIsKinematicsDirty = true;
+
+  for (int i = 0; i < _bodyNode->getNumChildBodyNodes(); ++i)
+  {
+    setKinematicsDirty(_bodyNode->getChildBodyNode(i), _updateTransforms,
+                       _updateVels, _updateAccs);
+  }
+}
+
+//==============================================================================
+void Skeleton::setConfigsLazily(const std::vector<int>* _id,
+                                const Eigen::VectorXd& _configs,
+                                bool _updateTransforms,
+                                bool _updateVels,
+                                bool _updateAccs)
+{
+  // The generalized coordinates of a joint are contiguous, so a body node is
+  // marked once for a run of coordinates belonging to it.
+  BodyNode* lastBodyNode = NULL;
+
+  for (int i = 0; i < _configs.size(); ++i)
+  {
+    int index = _id ? (*_id)[i] : i;
+    GenCoord* genCoord = mGenCoords[index];
+
+    if (genCoord->getPos() == _configs[i])
+      continue;
+
+    genCoord->setPos(_configs[i]);
+
+    BodyNode* bodyNode = mGenCoordBodyNodes[index];
+    if (bodyNode != lastBodyNode)
+    {
+      if (lastBodyNode != NULL)
+      {
+        lastBodyNode->getParentJoint()->setKinematicsDirty(_updateTransforms,
+                                                           false, false);
+      }
+      lastBodyNode = bodyNode;
+    }
+  }
+
+  if (lastBodyNode != NULL)
+  {
+    lastBodyNode->getParentJoint()->setKinematicsDirty(_updateTransforms,
+                                                       false, false);
+  }
+
+  // Velocities and accelerations also depend on the generalized velocities
+  // and accelerations, so they are refreshed for the whole skeleton as
+  // computeForwardKinematics() does.
+  if (_updateVels || _updateAccs)
+    setKinematicsDirty(mBodyNodes[0], false, _updateVels, _updateAccs);
+}
+
+//==============================================================================
+void Skeleton::updateDirtyKinematics()
+{
+  if (!mIsKinematicsDirty)
+    return;
+
+  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+       it != mBodyNodes.end(); ++it)
+  {
+    if ((*it)->mIsWorldTransformDirty)
+      (*it)->updateTransform();
+
+    if ((*it)->mIsVelocityDirty)
+    {
+      (*it)->updateVelocity();
+      (*it)->updateEta();
+    }
+
+    if ((*it)->mIsAccelerationDirty)
+      (*it)->updateAcceleration();
+  }
+
+  mIsKinematicsDirty = false;
+}
+
+//==============================================================================
+void Skeleton::setDynamicsDirty()
+{
   mIsArticulatedInertiaDirty = true;
   mIsMassMatrixDirty = true;
   mIsAugMassMatrixDirty = true;
@@ -438,13 +731,461 @@ void Skeleton::computeForwardKinematics(bool _updateTransforms,
   mIsCombinedVectorDirty = true;
   mIsExternalForceVectorDirty = true;
 //  mIsDampingForceVectorDirty = true;
+  mIsOperationalSpaceDirty = true;
+}
 
-  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
-       it != mBodyNodes.end(); ++it)
+//==============================================================================
+void Skeleton::multiplyInvAugMassMatrix(Eigen::MatrixXd* _X)
+{
+  assert(_X != NULL && _X->rows() == getNumGenCoords());
+
+  // Backup the origianl internal force
+  Eigen::VectorXd originalInternalForce = getGenForces();
+
+  Eigen::MatrixXd X = *_X;
+  for (int j = 0; j < X.cols(); ++j)
   {
-    (*it)->mIsBodyJacobianDirty = true;
-    (*it)->mIsBodyJacobianTimeDerivDirty = true;
+    setGenForces(X.col(j));
+
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->updateInvAugMassMatrix();
+    }
+
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->aggregateInvAugMassMatrix(_X, j, mTimeStep);
+    }
+  }
+
+  // Restore the origianl internal force
+  setGenForces(originalInternalForce);
+}
+
+//==============================================================================
+void Skeleton::multiplyInvMassMatrix(Eigen::MatrixXd* _X)
+{
+  assert(_X != NULL && _X->rows() == getNumGenCoords());
+  assert(!mIsArticulatedInertiaDirty);
+
+  // Backup the origianl internal force
+  Eigen::VectorXd originalInternalForce = getGenForces();
+
+  Eigen::MatrixXd X = *_X;
+  for (int j = 0; j < X.cols(); ++j)
+  {
+    setGenForces(X.col(j));
+
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->updateInvMassMatrix();
+    }
+
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->aggregateInvMassMatrix(_X, j);
+    }
   }
+
+  // Restore the origianl internal force
+  setGenForces(originalInternalForce);
+}
+
+//==============================================================================
+void Skeleton::updateArticulatedInertia()
+{
+  updateDirtyKinematics();
+
+  if (!mIsArticulatedInertiaDirty)
+    return;
+
+  if (mSoftBodyNodes.empty())
+  {
+    for (int i = getNumBodyNodes() - 1; i >= 0; --i)
+      updateCompiledArticulatedInertia(i);
+  }
+  else
+  {
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->updateArticulatedInertia(mTimeStep);
+    }
+  }
+
+  mIsArticulatedInertiaDirty = false;
+}
+
+//==============================================================================
+void Skeleton::compile()
+{
+  const int nNodes = getNumBodyNodes();
+
+  mParentIndices.resize(nNodes);
+  mChildOffsets.resize(nNodes + 1);
+  mGenCoordOffsets.resize(nNodes);
+
+  int stateSize = 0;
+  int childOffset = 1;
+  for (int i = 0; i < nNodes; ++i)
+  {
+    BodyNode* bodyNode = mBodyNodes[i];
+    Joint* joint = bodyNode->getParentJoint();
+    BodyNode* parent = bodyNode->getParentBodyNode();
+
+    mParentIndices[i] = parent ? parent->getSkeletonIndex() : -1;
+    mChildOffsets[i] = childOffset;
+    childOffset += bodyNode->getNumChildBodyNodes();
+    mGenCoordOffsets[i] = joint->getNumGenCoords() > 0
+                          ? joint->getGenCoord(0)->getSkeletonIndex() : 0;
+
+    // The compiled kernels keep the joint quantities in stack matrices of at
+    // most 6 x 6
+    assert(joint->getNumGenCoords() <= 6);
+
+    stateSize += bodyNode->getArticulatedBodyStateSize();
+  }
+  mChildOffsets[nNodes] = childOffset;
+  assert(nNodes == 0 || childOffset == nNodes);
+
+#ifndef NDEBUG
+  for (int i = 0; i < nNodes; ++i)
+  {
+    for (int j = mChildOffsets[i]; j < mChildOffsets[i + 1]; ++j)
+      assert(mParentIndices[j] == i);
+  }
+#endif
+
+  mArticulatedBodyState.assign(stateSize, 0.0);
+  double* data = mArticulatedBodyState.data();
+  for (int i = 0; i < nNodes; ++i)
+  {
+    mBodyNodes[i]->mapArticulatedBodyState(data);
+    data += mBodyNodes[i]->getArticulatedBodyStateSize();
+  }
+}
+
+//==============================================================================
+void Skeleton::updateCompiledArticulatedInertia(int _index)
+{
+  BodyNode* bodyNode = mBodyNodes[_index];
+  const Joint* joint = bodyNode->mParentJoint;
+
+  // Articulated inertia
+  bodyNode->mAI = bodyNode->mI;
+  bodyNode->mImplicitAI = bodyNode->mI;
+  math::Inertia childAI;
+  for (int i = mChildOffsets[_index]; i < mChildOffsets[_index + 1]; ++i)
+  {
+    const BodyNode* child = mBodyNodes[i];
+    const Eigen::Isometry3d T
+        = child->mParentJoint->getLocalTransform().inverse();
+    math::transformInertia(T, child->mPi, &childAI);
+    bodyNode->mAI += childAI;
+    math::transformInertia(T, child->mImplicitPi, &childAI);
+    bodyNode->mImplicitAI += childAI;
+  }
+  assert(!math::isNan(bodyNode->mAI));
+  assert(!math::isNan(bodyNode->mImplicitAI));
+
+  bodyNode->mPi = bodyNode->mAI;
+  bodyNode->mImplicitPi = bodyNode->mImplicitAI;
+
+  const int dof = joint->getNumGenCoords();
+  if (dof == 0)
+    return;
+
+  // Cache data: AI_S, Psi and AI_S_Psi
+  const math::Jacobian& S = joint->getLocalJacobian();
+  bodyNode->mAI_S.noalias() = bodyNode->mAI * S;
+  bodyNode->mImplicitAI_S.noalias() = bodyNode->mImplicitAI * S;
+
+  JointMatrix omega(dof, dof);
+  JointMatrix implicitOmega(dof, dof);
+  omega.noalias() = S.transpose() * bodyNode->mAI_S;
+  implicitOmega.noalias() = S.transpose() * bodyNode->mImplicitAI_S;
+  for (int i = 0; i < dof; ++i)
+  {
+    implicitOmega(i, i)
+        += mTimeStep * joint->getDampingCoefficient(i)
+           + mTimeStep * mTimeStep * joint->getSpringStiffness(i);
+  }
+  bodyNode->mPsi = omega.ldlt().solve(JointMatrix::Identity(dof, dof));
+  bodyNode->mImplicitPsi
+      = implicitOmega.ldlt().solve(JointMatrix::Identity(dof, dof));
+  assert(!math::isNan(bodyNode->mPsi));
+  assert(!math::isNan(bodyNode->mImplicitPsi));
+
+  bodyNode->mAI_S_Psi.noalias() = bodyNode->mAI_S * bodyNode->mPsi;
+  bodyNode->mImplicitAI_S_ImplicitPsi.noalias()
+      = bodyNode->mImplicitAI_S * bodyNode->mImplicitPsi;
+
+  // Cache data: Pi
+  bodyNode->mPi.noalias()
+      -= bodyNode->mAI_S_Psi * bodyNode->mAI_S.transpose();
+  bodyNode->mImplicitPi.noalias()
+      -= bodyNode->mImplicitAI_S_ImplicitPsi
+         * bodyNode->mImplicitAI_S.transpose();
+  assert(!math::isNan(bodyNode->mPi));
+  assert(!math::isNan(bodyNode->mImplicitPi));
+}
+
+//==============================================================================
+void Skeleton::updateCompiledBiasForce(int _index)
+{
+  BodyNode* bodyNode = mBodyNodes[_index];
+  const Joint* joint = bodyNode->mParentJoint;
+
+  // Bias force
+  if (bodyNode->mGravityMode)
+  {
+    bodyNode->mFgravity.noalias()
+        = bodyNode->mI * math::AdInvRLinear(bodyNode->mW, mGravity);
+  }
+  else
+  {
+    bodyNode->mFgravity.setZero();
+  }
+  bodyNode->mB = -math::dad(bodyNode->mV, bodyNode->mI * bodyNode->mV)
+                 - bodyNode->mFext - bodyNode->mFgravity;
+  for (int i = mChildOffsets[_index]; i < mChildOffsets[_index + 1]; ++i)
+  {
+    const BodyNode* child = mBodyNodes[i];
+    bodyNode->mB += math::dAdInvT(child->mParentJoint->getLocalTransform(),
+                                  child->mBeta);
+  }
+  assert(!math::isNan(bodyNode->mB));
+
+  bodyNode->mBeta = bodyNode->mB;
+  bodyNode->mBeta.noalias() += bodyNode->mImplicitAI * bodyNode->mEta;
+
+  const int dof = joint->getNumGenCoords();
+  if (dof == 0)
+    return;
+
+  // Cache data: alpha
+  const int offset = mGenCoordOffsets[_index];
+  for (int i = 0; i < dof; ++i)
+  {
+    const GenCoord* genCoord = joint->getGenCoord(i);
+    bodyNode->mAlpha[i]
+        = genCoord->getForce()
+          - joint->getSpringStiffness(i)
+            * (genCoord->getPos() + genCoord->getVel() * mTimeStep
+               - joint->getRestPosition(i))
+          - joint->getDampingCoefficient(i) * genCoord->getVel()
+          + mFc[offset + i];
+  }
+  bodyNode->mAlpha.noalias()
+      -= bodyNode->mImplicitAI_S.transpose() * bodyNode->mEta;
+  bodyNode->mAlpha.noalias()
+      -= joint->getLocalJacobian().transpose() * bodyNode->mB;
+  assert(!math::isNan(bodyNode->mAlpha));
+
+  // Cache data: beta
+  bodyNode->mBeta.noalias()
+      += bodyNode->mImplicitAI_S_ImplicitPsi * bodyNode->mAlpha;
+  assert(!math::isNan(bodyNode->mBeta));
+}
+
+//==============================================================================
+void Skeleton::updateCompiledAcceleration(int _index)
+{
+  BodyNode* bodyNode = mBodyNodes[_index];
+  Joint* joint = bodyNode->mParentJoint;
+  const int parentIndex = mParentIndices[_index];
+
+  // Acceleration of the parent body node expressed in this body node
+  Eigen::Vector6d parentAcc = Eigen::Vector6d::Zero();
+  if (parentIndex >= 0)
+  {
+    parentAcc = math::AdInvT(joint->getLocalTransform(),
+                             mBodyNodes[parentIndex]->mdV);
+  }
+
+  bodyNode->mdV = bodyNode->mEta + parentAcc;
+
+  const int dof = joint->getNumGenCoords();
+  if (dof > 0)
+  {
+    JointVector ddq(dof);
+    ddq.noalias() = bodyNode->mAlpha;
+    ddq.noalias() -= bodyNode->mImplicitAI_S.transpose() * parentAcc;
+    ddq = bodyNode->mImplicitPsi * ddq;
+    assert(!math::isNan(ddq));
+
+    for (int i = 0; i < dof; ++i)
+      joint->getGenCoord(i)->setAcc(ddq[i]);
+
+    bodyNode->mdV.noalias() += joint->getLocalJacobian() * ddq;
+  }
+  assert(!math::isNan(bodyNode->mdV));
+
+  // Body force
+  bodyNode->mF = bodyNode->mB;
+  bodyNode->mF.noalias() += bodyNode->mAI * bodyNode->mdV;
+  joint->mWrench = bodyNode->mF;
+  assert(!math::isNan(bodyNode->mF));
+}
+
+//==============================================================================
+void Skeleton::updateCompiledImpBiasForce(int _index)
+{
+  BodyNode* bodyNode = mBodyNodes[_index];
+  const Joint* joint = bodyNode->mParentJoint;
+
+  bodyNode->mImpB = -bodyNode->mConstraintImpulse;
+  for (int i = mChildOffsets[_index]; i < mChildOffsets[_index + 1]; ++i)
+  {
+    const BodyNode* child = mBodyNodes[i];
+    bodyNode->mImpB += math::dAdInvT(child->mParentJoint->getLocalTransform(),
+                                     child->mImpBeta);
+  }
+  assert(!math::isNan(bodyNode->mImpB));
+
+  // Cache data: mImpAlpha
+  const int dof = joint->getNumGenCoords();
+  if (dof > 0)
+  {
+    for (int i = 0; i < dof; ++i)
+      bodyNode->mImpAlpha[i] = joint->getGenCoord(i)->getConstraintImpulse();
+    bodyNode->mImpAlpha.noalias()
+        -= joint->getLocalJacobian().transpose() * bodyNode->mImpB;
+    assert(!math::isNan(bodyNode->mImpAlpha));
+  }
+
+  // Cache data: mImpBeta
+  if (mParentIndices[_index] >= 0)
+  {
+    bodyNode->mImpBeta = bodyNode->mImpB;
+    if (dof > 0)
+      bodyNode->mImpBeta.noalias() += bodyNode->mAI_S_Psi * bodyNode->mImpAlpha;
+    assert(!math::isNan(bodyNode->mImpBeta));
+  }
+}
+
+//==============================================================================
+void Skeleton::updateCompiledVelocityChange(int _index)
+{
+  BodyNode* bodyNode = mBodyNodes[_index];
+  Joint* joint = bodyNode->mParentJoint;
+  const int parentIndex = mParentIndices[_index];
+
+  // Velocity change of the parent body node expressed in this body node
+  Eigen::Vector6d parentDelV = Eigen::Vector6d::Zero();
+  if (parentIndex >= 0)
+  {
+    parentDelV = math::AdInvT(joint->getLocalTransform(),
+                              mBodyNodes[parentIndex]->mDelV);
+  }
+
+  bodyNode->mDelV = parentDelV;
+
+  const int dof = joint->getNumGenCoords();
+  if (dof > 0)
+  {
+    JointVector delDq(dof);
+    delDq.noalias() = bodyNode->mPsi * bodyNode->mImpAlpha;
+    delDq.noalias() -= bodyNode->mAI_S_Psi.transpose() * parentDelV;
+    assert(!math::isNan(delDq));
+
+    for (int i = 0; i < dof; ++i)
+      joint->getGenCoord(i)->setVelChange(delDq[i]);
+
+    bodyNode->mDelV.noalias() += joint->getLocalJacobian() * delDq;
+  }
+  assert(!math::isNan(bodyNode->mDelV));
+}
+
+//==============================================================================
+void Skeleton::computeForwardKinematicsBatch(
+    const Eigen::MatrixXd& _configs,
+    const std::vector<BodyNode*>& _bodyNodes,
+    std::vector<Eigen::MatrixXd>* _transforms)
+{
+  assert(_transforms != NULL);
+  assert(_configs.rows() == static_cast<int>(getNumGenCoords()));
+
+  // One row per sample so that each coordinate is contiguous over the samples
+  const Eigen::MatrixXd configs = _configs.transpose();
+  const int numSamples = configs.rows();
+  const size_t numBodyNodes = mBodyNodes.size();
+
+  // Mark the requested body nodes and their ancestors
+  std::vector<bool> isNeeded(numBodyNodes, false);
+  for (size_t i = 0; i < _bodyNodes.size(); ++i)
+  {
+    assert(_bodyNodes[i]->getSkeleton() == this);
+    BodyNode* bodyNode = _bodyNodes[i];
+    while (bodyNode != NULL && !isNeeded[bodyNode->getSkeletonIndex()])
+    {
+      isNeeded[bodyNode->getSkeletonIndex()] = true;
+      bodyNode = bodyNode->getParentBodyNode();
+    }
+  }
+
+  // mBodyNodes is ordered parents first (see init())
+  std::vector<Eigen::MatrixXd> worldTransforms(numBodyNodes);
+  Eigen::MatrixXd localTransforms;
+  for (size_t i = 0; i < numBodyNodes; ++i)
+  {
+    if (!isNeeded[i])
+      continue;
+
+    BodyNode* bodyNode = mBodyNodes[i];
+    Eigen::MatrixXd& W = worldTransforms[i];
+    BodyNode* parentBodyNode = bodyNode->getParentBodyNode();
+
+    if (parentBodyNode == NULL)
+    {
+      bodyNode->getParentJoint()->computeLocalTransforms(configs, &W);
+      continue;
+    }
+
+    bodyNode->getParentJoint()->computeLocalTransforms(configs,
+                                                       &localTransforms);
+    const Eigen::MatrixXd& P
+        = worldTransforms[parentBodyNode->getSkeletonIndex()];
+
+    // W = P * L, where column j of a 3x4 [R p] block is stored in columns
+    // 3j..3j+2
+    W.resize(numSamples, 12);
+    for (int j = 0; j < 4; ++j)
+    {
+      for (int r = 0; r < 3; ++r)
+      {
+        W.col(3 * j + r) = P.col(r).cwiseProduct(localTransforms.col(3 * j))
+            + P.col(3 + r).cwiseProduct(localTransforms.col(3 * j + 1))
+            + P.col(6 + r).cwiseProduct(localTransforms.col(3 * j + 2));
+      }
+    }
+    W.rightCols<3>() += P.rightCols<3>();
+  }
+
+  _transforms->resize(_bodyNodes.size());
+  for (size_t i = 0; i < _bodyNodes.size(); ++i)
+    (*_transforms)[i] = worldTransforms[_bodyNodes[i]->getSkeletonIndex()];
+}
+
+//==============================================================================
+Eigen::Isometry3d Skeleton::getBatchTransform(
+    const Eigen::MatrixXd& _transforms, int _sample)
+{
+  assert(_transforms.cols() == 12);
+  assert(0 <= _sample && _sample < _transforms.rows());
+
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  for (int j = 0; j < 3; ++j)
+  {
+    for (int r = 0; r < 3; ++r)
+      T.linear()(r, j) = _transforms(_sample, 3 * j + r);
+    T.translation()[j] = _transforms(_sample, 9 + j);
+  }
+  return T;
 }
 
 const Eigen::MatrixXd& Skeleton::getMassMatrix() {
@@ -465,48 +1206,240 @@ const Eigen::MatrixXd& Skeleton::getInvMassMatrix() {
   return mInvM;
 }
 
-const Eigen::MatrixXd& Skeleton::getInvAugMassMatrix() {
-  if (mIsInvAugMassMatrixDirty)
-    updateInvAugMassMatrix();
-  return mInvAugM;
-}
+const Eigen::MatrixXd& Skeleton::getInvAugMassMatrix() {
+  if (mIsInvAugMassMatrixDirty)
+    updateInvAugMassMatrix();
+  return mInvAugM;
+}
+
+const Eigen::VectorXd& Skeleton::getCoriolisForceVector() {
+  if (mIsCoriolisVectorDirty)
+    updateCoriolisForceVector();
+  return mCvec;
+}
+
+const Eigen::VectorXd& Skeleton::getGravityForceVector() {
+  if (mIsGravityForceVectorDirty)
+    updateGravityForceVector();
+  return mG;
+}
+
+const Eigen::VectorXd& Skeleton::getCombinedVector() {
+  if (mIsCombinedVectorDirty)
+    updateCombinedVector();
+  return mCg;
+}
+
+const Eigen::VectorXd& Skeleton::getExternalForceVector() {
+  if (mIsExternalForceVectorDirty)
+    updateExternalForceVector();
+  return mFext;
+}
+
+Eigen::VectorXd Skeleton::getInternalForceVector() const {
+  return getGenForces();
+}
+
+const Eigen::VectorXd& Skeleton::getDampingForceVector() {
+  if (mIsDampingForceVectorDirty)
+    updateDampingForceVector();
+  return mFd;
+}
+
+const Eigen::VectorXd& Skeleton::getConstraintForceVector() {
+  return mFc;
+}
+
+//==============================================================================
+const Eigen::Matrix6d& Skeleton::getInvOperationalSpaceInertia(
+    BodyNode* _bodyNode)
+{
+  assert(_bodyNode != NULL && _bodyNode->getSkeleton() == this);
+
+  updateDirtyOperationalSpace();
+  if (_bodyNode->mIsOpInertiaDirty)
+    updateOperationalSpaceInertia(_bodyNode);
+
+  return _bodyNode->mOpInvInertia;
+}
+
+//==============================================================================
+const Eigen::Matrix6d& Skeleton::getOperationalSpaceInertia(
+    BodyNode* _bodyNode)
+{
+  assert(_bodyNode != NULL && _bodyNode->getSkeleton() == this);
+
+  updateDirtyOperationalSpace();
+  if (_bodyNode->mIsOpInertiaDirty)
+    updateOperationalSpaceInertia(_bodyNode);
+
+  return _bodyNode->mOpInertia;
+}
+
+//==============================================================================
+const Eigen::Vector6d& Skeleton::getOperationalSpaceBiasForce(
+    BodyNode* _bodyNode)
+{
+  assert(_bodyNode != NULL && _bodyNode->getSkeleton() == this);
+
+  updateDirtyOperationalSpace();
+  if (_bodyNode->mIsOpBiasForceDirty)
+    updateOperationalSpaceBiasForce(_bodyNode);
+
+  return _bodyNode->mOpBiasForce;
+}
+
+//==============================================================================
+const Eigen::MatrixXd& Skeleton::getDynamicallyConsistentJacobianInverse(
+    BodyNode* _bodyNode)
+{
+  assert(_bodyNode != NULL && _bodyNode->getSkeleton() == this);
+
+  updateDirtyOperationalSpace();
+  if (_bodyNode->mIsOpJacobianInverseDirty)
+    updateDynamicallyConsistentJacobianInverse(_bodyNode);
+
+  return _bodyNode->mOpJacobianInverse;
+}
+
+//==============================================================================
+void Skeleton::updateDirtyOperationalSpace()
+{
+  if (!mIsOperationalSpaceDirty)
+    return;
+
+  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+       it != mBodyNodes.end(); ++it)
+  {
+    (*it)->mIsOpInertiaDirty = true;
+    (*it)->mIsOpBiasForceDirty = true;
+    (*it)->mIsOpJacobianInverseDirty = true;
+  }
+
+  mIsOperationalSpaceDirty = false;
+}
+
+//==============================================================================
+void Skeleton::updateOperationalSpaceInertia(BodyNode* _bodyNode)
+{
+  updateArticulatedInertia();
+
+  // Path from the root body node to _bodyNode
+  std::vector<BodyNode*> path;
+  for (BodyNode* bodyNode = _bodyNode; bodyNode != NULL;
+       bodyNode = bodyNode->getParentBodyNode())
+  {
+    path.push_back(bodyNode);
+  }
+  std::reverse(path.begin(), path.end());
+  const int depth = path.size();
+
+  // X maps a body velocity of the parent body node to the body frame, and
+  // P = I - AI * S * Psi * S^T projects out the part of an articulated body
+  // force that is taken by the parent joint.
+  std::vector<Eigen::Matrix6d, Eigen::aligned_allocator<Eigen::Matrix6d> >
+      X(depth);
+  std::vector<Eigen::Matrix6d, Eigen::aligned_allocator<Eigen::Matrix6d> >
+      P(depth);
+  for (int i = 0; i < depth; ++i)
+  {
+    Joint* joint = path[i]->getParentJoint();
+    X[i] = math::AdInvTJac(joint->getLocalTransform(),
+                           Eigen::Matrix6d::Identity());
+    P[i].setIdentity();
+    if (joint->getNumGenCoords() > 0)
+    {
+      P[i].noalias()
+          -= path[i]->mAI_S_Psi * joint->getLocalJacobian().transpose();
+    }
+  }
+
+  // Backward recursion: Phi[i] maps a unit body force on _bodyNode to the
+  // articulated body force it induces on path[i]
+  std::vector<Eigen::Matrix6d, Eigen::aligned_allocator<Eigen::Matrix6d> >
+      Phi(depth);
+  Phi[depth - 1].setIdentity();
+  for (int i = depth - 1; i > 0; --i)
+    Phi[i - 1].noalias() = X[i].transpose() * (P[i] * Phi[i]);
+
+  // Forward recursion: Omega maps a unit body force on _bodyNode to the body
+  // acceleration of path[i]
+  Eigen::Matrix6d Omega = Eigen::Matrix6d::Zero();
+  for (int i = 0; i < depth; ++i)
+  {
+    if (i > 0)
+      Omega = P[i].transpose() * (X[i] * Omega);
+
+    Joint* joint = path[i]->getParentJoint();
+    if (joint->getNumGenCoords() > 0)
+    {
+      const math::Jacobian& S = joint->getLocalJacobian();
+      Omega.noalias() += S * (path[i]->mPsi * (S.transpose() * Phi[i]));
+    }
+  }
+
+  _bodyNode->mOpInvInertia = 0.5 * (Omega + Omega.transpose());
+
+  // Pseudo-inverse that is well defined for body nodes with less than six
+  // degrees of freedom
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix6d> eig(_bodyNode->mOpInvInertia);
+  const Eigen::Vector6d& eigenvalues = eig.eigenvalues();
+  const double tol = 1e-12 * std::max(eigenvalues.cwiseAbs().maxCoeff(), 1.0);
+  Eigen::Vector6d invEigenvalues = Eigen::Vector6d::Zero();
+  for (int i = 0; i < 6; ++i)
+  {
+    if (eigenvalues[i] > tol)
+      invEigenvalues[i] = 1.0 / eigenvalues[i];
+  }
+  _bodyNode->mOpInertia.noalias() = eig.eigenvectors()
+                                    * invEigenvalues.asDiagonal()
+                                    * eig.eigenvectors().transpose();
 
-const Eigen::VectorXd& Skeleton::getCoriolisForceVector() {
-  if (mIsCoriolisVectorDirty)
-    updateCoriolisForceVector();
-  return mCvec;
+  _bodyNode->mIsOpInertiaDirty = false;
 }
 
-const Eigen::VectorXd& Skeleton::getGravityForceVector() {
-  if (mIsGravityForceVectorDirty)
-    updateGravityForceVector();
-  return mG;
-}
+//==============================================================================
+void Skeleton::updateOperationalSpaceBiasForce(BodyNode* _bodyNode)
+{
+  const Eigen::Matrix6d& opInertia = getOperationalSpaceInertia(_bodyNode);
+  updateArticulatedInertia();
+
+  // M^-1 * Cg
+  Eigen::MatrixXd invMCg = getCombinedVector();
+  multiplyInvMassMatrix(&invMCg);
+
+  // Body acceleration of _bodyNode for zero generalized forces, negated
+  const math::Jacobian& J = _bodyNode->getBodyJacobian();
+  const math::Jacobian& dJ = _bodyNode->getBodyJacobianTimeDeriv();
+  Eigen::Vector6d bias = Eigen::Vector6d::Zero();
+  for (int i = 0; i < _bodyNode->getNumDependentGenCoords(); ++i)
+  {
+    const int index = _bodyNode->getDependentGenCoordIndex(i);
+    bias += J.col(i) * invMCg(index, 0)
+            - dJ.col(i) * getGenCoord(index)->getVel();
+  }
 
-const Eigen::VectorXd& Skeleton::getCombinedVector() {
-  if (mIsCombinedVectorDirty)
-    updateCombinedVector();
-  return mCg;
-}
+  _bodyNode->mOpBiasForce.noalias() = opInertia * bias;
 
-const Eigen::VectorXd& Skeleton::getExternalForceVector() {
-  if (mIsExternalForceVectorDirty)
-    updateExternalForceVector();
-  return mFext;
+  _bodyNode->mIsOpBiasForceDirty = false;
 }
 
-Eigen::VectorXd Skeleton::getInternalForceVector() const {
-  return getGenForces();
-}
+//==============================================================================
+void Skeleton::updateDynamicallyConsistentJacobianInverse(BodyNode* _bodyNode)
+{
+  const Eigen::Matrix6d& opInertia = getOperationalSpaceInertia(_bodyNode);
+  updateArticulatedInertia();
 
-const Eigen::VectorXd& Skeleton::getDampingForceVector() {
-  if (mIsDampingForceVectorDirty)
-    updateDampingForceVector();
-  return mFd;
-}
+  // M^-1 * J^T
+  const math::Jacobian& J = _bodyNode->getBodyJacobian();
+  Eigen::MatrixXd invMJt = Eigen::MatrixXd::Zero(getNumGenCoords(), 6);
+  for (int i = 0; i < _bodyNode->getNumDependentGenCoords(); ++i)
+    invMJt.row(_bodyNode->getDependentGenCoordIndex(i)) = J.col(i).transpose();
+  multiplyInvMassMatrix(&invMJt);
 
-const Eigen::VectorXd& Skeleton::getConstraintForceVector() {
-  return mFc;
+  _bodyNode->mOpJacobianInverse.noalias() = invMJt * opInertia;
+
+  _bodyNode->mIsOpJacobianInverseDirty = false;
 }
 
 void Skeleton::draw(renderer::RenderInterface* _ri,
@@ -522,6 +1455,8 @@ void Skeleton::drawMarkers(renderer::RenderInterface* _ri,
 }
 
 void Skeleton::updateMassMatrix() {
+  updateDirtyKinematics();
+
   assert(mM.cols() == getNumGenCoords() && mM.rows() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -567,6 +1502,8 @@ void Skeleton::updateMassMatrix() {
 }
 
 void Skeleton::updateAugMassMatrix() {
+  updateDirtyKinematics();
+
   assert(mAugM.cols() == getNumGenCoords() && mAugM.rows() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -612,6 +1549,8 @@ void Skeleton::updateAugMassMatrix() {
 }
 
 void Skeleton::updateInvMassMatrix() {
+  updateDirtyKinematics();
+
   assert(mInvM.cols() == getNumGenCoords() &&
          mInvM.rows() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
@@ -670,6 +1609,8 @@ void Skeleton::updateInvMassMatrix() {
 }
 
 void Skeleton::updateInvAugMassMatrix() {
+  updateDirtyKinematics();
+
   assert(mInvAugM.cols() == getNumGenCoords() &&
          mInvAugM.rows() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
@@ -717,6 +1658,8 @@ void Skeleton::updateInvAugMassMatrix() {
 }
 
 void Skeleton::updateCoriolisForceVector() {
+  updateDirtyKinematics();
+
   assert(mCvec.size() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -734,6 +1677,8 @@ void Skeleton::updateCoriolisForceVector() {
 }
 
 void Skeleton::updateGravityForceVector() {
+  updateDirtyKinematics();
+
   assert(mG.size() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -748,6 +1693,8 @@ void Skeleton::updateGravityForceVector() {
 }
 
 void Skeleton::updateCombinedVector() {
+  updateDirtyKinematics();
+
   assert(mCg.size() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -765,6 +1712,8 @@ void Skeleton::updateCombinedVector() {
 }
 
 void Skeleton::updateExternalForceVector() {
+  updateDirtyKinematics();
+
   assert(mFext.size() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -805,6 +1754,8 @@ void Skeleton::updateExternalForceVector() {
 }
 
 void Skeleton::updateDampingForceVector() {
+  updateDirtyKinematics();
+
   assert(mFd.size() == getNumGenCoords());
   assert(getNumGenCoords() > 0);
 
@@ -831,10 +1782,68 @@ void Skeleton::updateDampingForceVector() {
   }
 }
 
+//==============================================================================
+void Skeleton::evalVariationalMidpoint(const Eigen::VectorXd& _configs,
+                                       const Eigen::VectorXd& _genVels,
+                                       const Eigen::VectorXd& _genForces,
+                                       double _timeStep)
+{
+  const int dof = getNumGenCoords();
+
+  // Midpoint configurations with the average velocity and zero acceleration
+  GenCoordSystem::setConfigs(_configs);
+  GenCoordSystem::setGenVels(_genVels);
+  GenCoordSystem::setGenAccs(Eigen::VectorXd::Zero(dof));
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+    mBodyNodes[i]->getParentJoint()->integrateConfigs(0.5 * _timeStep);
+  computeForwardKinematics(true, true, true);
+
+  // Coriolis, gravity and external forces by inverse dynamics
+  computeInverseDynamics(true, false);
+  mVariationalForces = _genForces - getGenForces();
+
+  // Joint spring and damping forces
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+  {
+    Joint* joint = mBodyNodes[i]->getParentJoint();
+    int localDof = joint->getNumGenCoords();
+    if (localDof == 0)
+      continue;
+
+    int iStart = joint->getGenCoord(0)->getSkeletonIndex();
+    mVariationalForces.segment(iStart, localDof)
+        += joint->getSpringForces(0.0) + joint->getDampingForces();
+  }
+
+  mVariationalMassMatrix = getMassMatrix();
+
+  // Time derivative of the mass matrix along the step, M'(q_m) v, by central
+  // differences. Together with the forces above it makes the derivative of
+  // the Lagrangian with respect to the configurations.
+  const Eigen::VectorXd midConfigs = getConfigs();
+  const double eps = 1e-6 / std::max(1.0, _genVels.lpNorm<Eigen::Infinity>());
+
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+    mBodyNodes[i]->getParentJoint()->integrateConfigs(eps);
+  computeForwardKinematics(true, false, false);
+  mVariationalForces += getMassMatrix() * (_genVels / (2.0 * eps));
+
+  GenCoordSystem::setConfigs(midConfigs);
+  for (size_t i = 0; i < mBodyNodes.size(); ++i)
+    mBodyNodes[i]->getParentJoint()->integrateConfigs(-eps);
+  computeForwardKinematics(true, false, false);
+  mVariationalForces -= getMassMatrix() * (_genVels / (2.0 * eps));
+
+  GenCoordSystem::setConfigs(midConfigs);
+  computeForwardKinematics(true, false, false);
+}
+
 //==============================================================================
 void Skeleton::computeInverseDynamics(bool _withExternalForces,
                                       bool _withDampingForces)
 {
+  updateDirtyKinematics();
+
   // Skip immobile or 0-dof skeleton
   if (getNumGenCoords() == 0)
     return;
@@ -848,12 +1857,250 @@ void Skeleton::computeInverseDynamics(bool _withExternalForces,
   }
 }
 
+//==============================================================================
+void Skeleton::computeInverseDynamicsBatch(const Eigen::MatrixXd& _configs,
+                                           const Eigen::MatrixXd& _genVels,
+                                           const Eigen::MatrixXd& _genAccs,
+                                           Eigen::MatrixXd* _genForces)
+{
+  assert(_genForces != NULL);
+  assert(_configs.rows() == static_cast<int>(getNumGenCoords()));
+  assert(_genVels.rows() == _configs.rows()
+         && _genVels.cols() == _configs.cols());
+  assert(_genAccs.rows() == _configs.rows()
+         && _genAccs.cols() == _configs.cols());
+
+  const int dof = getNumGenCoords();
+  const int numFrames = _configs.cols();
+  _genForces->setZero(dof, numFrames);
+
+  if (dof == 0 || numFrames == 0)
+    return;
+
+  if (!mSoftBodyNodes.empty())
+  {
+    dterr << "Batched inverse dynamics of soft body nodes is not supported.\n";
+    return;
+  }
+
+  // mBodyNodes is ordered parents first (see init())
+  const int numBodyNodes = mBodyNodes.size();
+  std::vector<int> parentIndices(numBodyNodes, -1);
+  std::vector<int> startIndices(numBodyNodes, 0);
+  for (int i = 0; i < numBodyNodes; ++i)
+  {
+    BodyNode* parentBodyNode = mBodyNodes[i]->getParentBodyNode();
+    if (parentBodyNode != NULL)
+      parentIndices[i] = parentBodyNode->getSkeletonIndex();
+
+    Joint* joint = mBodyNodes[i]->getParentJoint();
+    if (joint->getNumGenCoords() > 0)
+      startIndices[i] = joint->getGenCoord(0)->getSkeletonIndex();
+  }
+
+  // Each chunk of frames reuses one workspace, which is small enough to stay
+  // in cache, and the chunks are independent of each other.
+  const int chunkSize = 64;
+  const int numChunks = (numFrames + chunkSize - 1) / chunkSize;
+
+#pragma omp parallel for schedule(dynamic)
+  for (int c = 0; c < numChunks; ++c)
+  {
+    std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d> >
+        T(numBodyNodes);
+    std::vector<Eigen::Matrix3d> R(numBodyNodes);
+    std::vector<math::Jacobian> S(numBodyNodes);
+    std::vector<math::Jacobian> dS(numBodyNodes);
+    std::vector<Eigen::VectorXd> q(numBodyNodes);
+    std::vector<Eigen::VectorXd> dq(numBodyNodes);
+    std::vector<Eigen::Vector6d, Eigen::aligned_allocator<Eigen::Vector6d> >
+        V(numBodyNodes);
+    std::vector<Eigen::Vector6d, Eigen::aligned_allocator<Eigen::Vector6d> >
+        dV(numBodyNodes);
+    std::vector<Eigen::Vector6d, Eigen::aligned_allocator<Eigen::Vector6d> >
+        F(numBodyNodes);
+    Eigen::Vector6d Sdq;
+    Eigen::Vector6d gravity = Eigen::Vector6d::Zero();
+
+    const int lastFrame = std::min(numFrames, (c + 1) * chunkSize);
+    for (int f = c * chunkSize; f < lastFrame; ++f)
+    {
+      // Forward recursion
+      for (int i = 0; i < numBodyNodes; ++i)
+      {
+        Joint* joint = mBodyNodes[i]->getParentJoint();
+        const int localDof = joint->getNumGenCoords();
+        const int parentIndex = parentIndices[i];
+
+        q[i] = _configs.col(f).segment(startIndices[i], localDof);
+        dq[i] = _genVels.col(f).segment(startIndices[i], localDof);
+        joint->computeLocalKinematics(q[i], dq[i], &T[i], &S[i], &dS[i]);
+
+        Sdq.noalias() = S[i] * dq[i];
+        V[i] = Sdq;
+        dV[i].noalias() = S[i] * _genAccs.col(f).segment(startIndices[i],
+                                                         localDof);
+        dV[i].noalias() += dS[i] * dq[i];
+        if (parentIndex >= 0)
+        {
+          V[i] += math::AdInvT(T[i], V[parentIndex]);
+          dV[i] += math::AdInvT(T[i], dV[parentIndex]);
+          R[i].noalias() = R[parentIndex] * T[i].linear();
+        }
+        else
+        {
+          R[i] = T[i].linear();
+        }
+        dV[i] += math::ad(V[i], Sdq);
+
+        F[i].setZero();
+      }
+
+      // Backward recursion
+      for (int i = numBodyNodes - 1; i >= 0; --i)
+      {
+        BodyNode* bodyNode = mBodyNodes[i];
+        const math::Inertia& I = bodyNode->mI;
+
+        F[i].noalias() += I * dV[i];
+        if (bodyNode->mGravityMode)
+        {
+          gravity.tail<3>().noalias() = R[i].transpose() * mGravity;
+          F[i].noalias() -= I * gravity;
+        }
+        F[i] -= math::dad(V[i], I * V[i]);
+
+        if (parentIndices[i] >= 0)
+          F[parentIndices[i]] += math::dAdInvT(T[i], F[i]);
+
+        const int localDof = bodyNode->getParentJoint()->getNumGenCoords();
+        _genForces->col(f).segment(startIndices[i], localDof).noalias()
+            = S[i].transpose() * F[i];
+      }
+    }
+  }
+}
+
 //==============================================================================
 void Skeleton::computeHybridDynamics()
 {
   dterr << "Not implemented yet.\n";
 }
 
+//==============================================================================
+void Skeleton::computeInverseDynamicsDerivs(Eigen::MatrixXd* _dtau_dq,
+                                            Eigen::MatrixXd* _dtau_ddq,
+                                            bool _withExternalForces)
+{
+  assert(_dtau_dq != NULL && _dtau_ddq != NULL);
+
+  int dof = getNumGenCoords();
+  _dtau_dq->setZero(dof, dof);
+  _dtau_ddq->setZero(dof, dof);
+
+  if (dof == 0)
+    return;
+
+  if (!mSoftBodyNodes.empty())
+  {
+    dterr << "Derivatives of inverse dynamics of soft body nodes are not "
+          << "supported.\n";
+    return;
+  }
+
+  // Nominal body forces
+  Eigen::VectorXd originalGenForces = getGenForces();
+  computeInverseDynamics(_withExternalForces, false);
+
+  // One forward and one backward recursion per generalized coordinate
+  for (int j = 0; j < dof; ++j)
+  {
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->updateInvDynDeriv(j, true);
+    }
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->aggregateInvDynDeriv(_dtau_dq, j, mGravity, true);
+    }
+
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->updateInvDynDeriv(j, false);
+    }
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->aggregateInvDynDeriv(_dtau_ddq, j, mGravity, false);
+    }
+  }
+
+  setGenForces(originalGenForces);
+}
+
+//==============================================================================
+void Skeleton::computeForwardDynamicsDerivs(Eigen::MatrixXd* _dddq_dq,
+                                            Eigen::MatrixXd* _dddq_ddq,
+                                            Eigen::MatrixXd* _dddq_dtau)
+{
+  assert(_dddq_dq != NULL && _dddq_ddq != NULL && _dddq_dtau != NULL);
+
+  int dof = getNumGenCoords();
+  if (!isMobile() || dof == 0 || !mSoftBodyNodes.empty())
+  {
+    if (!mSoftBodyNodes.empty())
+    {
+      dterr << "Derivatives of forward dynamics of soft body nodes are not "
+            << "supported.\n";
+    }
+
+    _dddq_dq->setZero(dof, dof);
+    _dddq_ddq->setZero(dof, dof);
+    _dddq_dtau->setZero(dof, dof);
+    return;
+  }
+
+  computeForwardDynamics();
+
+  // Forward dynamics solves
+  //   (M + h * D + h^2 * K) * ddq + C + g - J^T * Fext
+  //     = tau - K * (q + h * dq - q0) - D * dq + Fc,
+  // so d(ddq)/dx = -(M + h * D + h^2 * K)^{-1} * d(residual)/dx.
+  computeInverseDynamicsDerivs(_dddq_dq, _dddq_ddq, true);
+
+  // The spring forces depend on the configurations, which change with the
+  // perturbation of the generalized coordinates as in
+  // Joint::getConfigsPerturbationDeriv()
+  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+       it != mBodyNodes.end(); ++it)
+  {
+    Joint* joint = (*it)->getParentJoint();
+    int numGenCoords = joint->getNumGenCoords();
+    if (numGenCoords == 0)
+      continue;
+
+    int index = joint->getGenCoord(0)->getSkeletonIndex();
+    Eigen::MatrixXd dconfigs = joint->getConfigsPerturbationDeriv();
+    for (int l = 0; l < numGenCoords; ++l)
+    {
+      double k = joint->getSpringStiffness(l);
+      double d = joint->getDampingCoefficient(l);
+      _dddq_dq->block(index + l, index, 1, numGenCoords) += k * dconfigs.row(l);
+      (*_dddq_ddq)(index + l, index + l) += mTimeStep * k + d;
+    }
+  }
+
+  multiplyInvAugMassMatrix(_dddq_dq);
+  multiplyInvAugMassMatrix(_dddq_ddq);
+  *_dddq_dq = -*_dddq_dq;
+  *_dddq_ddq = -*_dddq_ddq;
+
+  *_dddq_dtau = getInvAugMassMatrix();
+}
+
 void Skeleton::clearExternalForces() {
   for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
        it != mBodyNodes.end(); ++it) {
@@ -864,10 +2111,41 @@ void Skeleton::clearExternalForces() {
 //==============================================================================
 void Skeleton::computeForwardDynamics()
 {
+  updateDirtyKinematics();
+
   // Skip immobile or 0-dof skeleton
   if (!isMobile() || getNumGenCoords() == 0)
     return;
 
+  // Skeletons without soft body nodes run over the compiled form
+  if (mSoftBodyNodes.empty())
+  {
+    const int nNodes = getNumBodyNodes();
+
+    // Backward recursion
+    if (mIsArticulatedInertiaDirty)
+    {
+      for (int i = nNodes - 1; i >= 0; --i)
+      {
+        updateCompiledArticulatedInertia(i);
+        updateCompiledBiasForce(i);
+      }
+
+      mIsArticulatedInertiaDirty = false;
+    }
+    else
+    {
+      for (int i = nNodes - 1; i >= 0; --i)
+        updateCompiledBiasForce(i);
+    }
+
+    // Forward recursion
+    for (int i = 0; i < nNodes; ++i)
+      updateCompiledAcceleration(i);
+
+    return;
+  }
+
   // Backward recursion
   if (mIsArticulatedInertiaDirty)
   {
@@ -911,6 +2189,8 @@ void Skeleton::clearConstraintImpulses()
 //==============================================================================
 void Skeleton::updateBiasImpulse(BodyNode* _bodyNode)
 {
+  updateDirtyKinematics();
+
   // Assertions
   assert(_bodyNode != NULL);
   assert(getNumGenCoords() > 0);
@@ -926,6 +2206,13 @@ void Skeleton::updateBiasImpulse(BodyNode* _bodyNode)
 #endif
 
   // Prepare cache data
+  if (mSoftBodyNodes.empty())
+  {
+    for (int i = _bodyNode->getSkeletonIndex(); i >= 0; i = mParentIndices[i])
+      updateCompiledImpBiasForce(i);
+    return;
+  }
+
   BodyNode* it = _bodyNode;
   while (it != NULL)
   {
@@ -938,6 +2225,8 @@ void Skeleton::updateBiasImpulse(BodyNode* _bodyNode)
 void Skeleton::updateBiasImpulse(BodyNode* _bodyNode,
                                  const Eigen::Vector6d& _imp)
 {
+  updateDirtyKinematics();
+
   // Assertions
   assert(_bodyNode != NULL);
   assert(getNumGenCoords() > 0);
@@ -957,11 +2246,19 @@ void Skeleton::updateBiasImpulse(BodyNode* _bodyNode,
   _bodyNode->mConstraintImpulse = _imp;
 
   // Prepare cache data
-  BodyNode* it = _bodyNode;
-  while (it != NULL)
+  if (mSoftBodyNodes.empty())
   {
-    it->updateImpBiasForce();
-    it = it->getParentBodyNode();
+    for (int i = _bodyNode->getSkeletonIndex(); i >= 0; i = mParentIndices[i])
+      updateCompiledImpBiasForce(i);
+  }
+  else
+  {
+    BodyNode* it = _bodyNode;
+    while (it != NULL)
+    {
+      it->updateImpBiasForce();
+      it = it->getParentBodyNode();
+    }
   }
 
   // TODO(JS): Do we need to backup and restore the original value?
@@ -974,6 +2271,8 @@ void Skeleton::updateBiasImpulse(SoftBodyNode* _softBodyNode,
                                  PointMass* _pointMass,
                                  const Eigen::Vector3d& _imp)
 {
+  updateDirtyKinematics();
+
   // Assertions
   assert(_softBodyNode != NULL);
   assert(getNumGenCoords() > 0);
@@ -1007,6 +2306,15 @@ void Skeleton::updateBiasImpulse(SoftBodyNode* _softBodyNode,
 //==============================================================================
 void Skeleton::updateVelocityChange()
 {
+  updateDirtyKinematics();
+
+  if (mSoftBodyNodes.empty())
+  {
+    for (int i = 0; i < getNumBodyNodes(); ++i)
+      updateCompiledVelocityChange(i);
+    return;
+  }
+
   for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
        it != mBodyNodes.end(); ++it)
   {
@@ -1029,38 +2337,74 @@ bool Skeleton::isImpulseApplied() const
 //==============================================================================
 void Skeleton::computeImpulseForwardDynamics()
 {
+  updateDirtyKinematics();
+
   // Skip immobile or 0-dof skeleton
   if (!isMobile() || getNumGenCoords() == 0)
     return;
 
-  // Backward recursion
-  if (mIsArticulatedInertiaDirty)
+  // Skeletons without soft body nodes run over the compiled form
+  if (mSoftBodyNodes.empty())
   {
-    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
-         it != mBodyNodes.rend(); ++it)
+    const int nNodes = getNumBodyNodes();
+
+    // Backward recursion
+    if (mIsArticulatedInertiaDirty)
     {
-      (*it)->updateArticulatedInertia(mTimeStep);
-      (*it)->updateImpBiasForce();
+      for (int i = nNodes - 1; i >= 0; --i)
+      {
+        updateCompiledArticulatedInertia(i);
+        updateCompiledImpBiasForce(i);
+      }
+
+      mIsArticulatedInertiaDirty = false;
+    }
+    else
+    {
+      for (int i = nNodes - 1; i >= 0; --i)
+        updateCompiledImpBiasForce(i);
     }
 
-    mIsArticulatedInertiaDirty = false;
+    // Forward recursion
+    for (int i = 0; i < nNodes; ++i)
+    {
+      BodyNode* bodyNode = mBodyNodes[i];
+      updateCompiledVelocityChange(i);
+      bodyNode->mImpF = bodyNode->mImpB;
+      bodyNode->mImpF.noalias() += bodyNode->mAI * bodyNode->mDelV;
+    }
   }
   else
   {
-    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
-         it != mBodyNodes.rend(); ++it)
+    // Backward recursion
+    if (mIsArticulatedInertiaDirty)
     {
-      (*it)->updateImpBiasForce();
+      for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+           it != mBodyNodes.rend(); ++it)
+      {
+        (*it)->updateArticulatedInertia(mTimeStep);
+        (*it)->updateImpBiasForce();
+      }
+
+      mIsArticulatedInertiaDirty = false;
+    }
+    else
+    {
+      for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+           it != mBodyNodes.rend(); ++it)
+      {
+        (*it)->updateImpBiasForce();
+      }
     }
-  }
 
-  // Forward recursion
-  for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
-       it != mBodyNodes.end(); ++it)
-  {
-    (*it)->updateJointVelocityChange();
-//    (*it)->updateBodyVelocityChange();
-    (*it)->updateBodyImpForceFwdDyn();
+    // Forward recursion
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->updateJointVelocityChange();
+//      (*it)->updateBodyVelocityChange();
+      (*it)->updateBodyImpForceFwdDyn();
+    }
   }
 
   //DEBUG_CODE//////////////////////////////////////////////////////////////////
@@ -1203,60 +2547,52 @@ Eigen::Vector3d Skeleton::getWorldCOMAcceleration() {
 }
 
 Eigen::MatrixXd Skeleton::getWorldCOMJacobian() {
-  // Jacobian of COM
-  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(3, getNumGenCoords());
+  Eigen::MatrixXd J;
+  computeWorldCOMJacobian(&J);
+  return J;
+}
 
-  // Compute sum of each body's Jacobian of COM accelerations multiplied by
-  // body's mass
-  const int nNodes = getNumBodyNodes();
-  for (int i = 0; i < nNodes; i++) {
-    // BodyNode iterator
-    BodyNode* bodyNode = getBodyNode(i);
+Eigen::MatrixXd Skeleton::getWorldCOMJacobianTimeDeriv() {
+  Eigen::MatrixXd dJ;
+  computeWorldCOMJacobianTimeDeriv(&dJ);
+  return dJ;
+}
 
-    // Compute weighted Jacobian
-    Eigen::MatrixXd localJ
-        = bodyNode->getMass()
-          * bodyNode->getWorldJacobian(
-              bodyNode->getLocalCOM(), true).bottomRows<3>();
+//==============================================================================
+void Skeleton::computeWorldCOMJacobian(Eigen::MatrixXd* _J)
+{
+  assert(_J != NULL);
+  assert(mTotalMass != 0.0);
 
-    // Assign the weighted Jacobian to total Jacobian
-    for (int j = 0; j < bodyNode->getNumDependentGenCoords(); ++j) {
-      int idx = bodyNode->getDependentGenCoordIndex(j);
-      J.col(idx) += localJ.col(j);
-    }
+  // Coordinates of point masses do not move the COM of the body nodes
+  _J->setZero(3, getNumGenCoords());
+
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
+  {
+    (*it)->updateSubtreeCOM(false);
+    (*it)->aggregateWorldCOMJacobian(_J);
   }
 
-  // Divide the sum by the total mass
-  assert(mTotalMass != 0.0);
-  return J / mTotalMass;
+  *_J /= mTotalMass;
 }
 
-Eigen::MatrixXd Skeleton::getWorldCOMJacobianTimeDeriv() {
-  // Jacobian time derivative of COM
-  Eigen::MatrixXd dJ = Eigen::MatrixXd::Zero(3, getNumGenCoords());
-
-  // Compute sum of each body's Jacobian time derivative of COM accelerations
-  // multiplied by body's mass
-  const int nNodes = getNumBodyNodes();
-  for (int i = 0; i < nNodes; i++) {
-    // BodyNode iterator
-    BodyNode* bodyNode = getBodyNode(i);
+//==============================================================================
+void Skeleton::computeWorldCOMJacobianTimeDeriv(Eigen::MatrixXd* _dJ)
+{
+  assert(_dJ != NULL);
+  assert(mTotalMass != 0.0);
 
-    // Compute weighted Jacobian time derivative
-    Eigen::MatrixXd localJ
-        = bodyNode->getMass()
-          * bodyNode->getWorldJacobianTimeDeriv(bodyNode->getLocalCOM(), true).bottomRows<3>();
+  _dJ->setZero(3, getNumGenCoords());
 
-    // Assign the weighted Jacobian to total Jacobian time derivative
-    for (int j = 0; j < bodyNode->getNumDependentGenCoords(); ++j) {
-      int idx = bodyNode->getDependentGenCoordIndex(j);
-      dJ.col(idx) += localJ.col(j);
-    }
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
+  {
+    (*it)->updateSubtreeCOM(true);
+    (*it)->aggregateWorldCOMJacobianTimeDeriv(_dJ);
   }
 
-  // Divide the sum by the total mass
-  assert(mTotalMass != 0.0);
-  return dJ / mTotalMass;
+  *_dJ /= mTotalMass;
 }
 
 double Skeleton::getKineticEnergy() const {
@@ -231,6 +231,53 @@ public:
   // Documentation inherited
   virtual void integrateGenVels(double _dt);
 
+  /// \brief Set whether World::step() integrates this skeleton with the
+  /// discrete variational integrator of computeVariationalStep() instead of
+  /// the integrator of the world. Skeletons with soft body nodes are not
+  /// supported.
+  void setVariationalIntegration(bool _isVariational);
+
+  /// \brief
+  bool isVariationalIntegration() const;
+
+  /// \brief Set the tolerance of the Newton solve of the discrete
+  /// Euler-Lagrange equations relative to the generalized momentum.
+  void setVariationalSolverTolerance(double _tolerance);
+
+  /// \brief
+  double getVariationalSolverTolerance() const;
+
+  /// \brief Set the maximum number of Newton iterations per variational step.
+  void setVariationalSolverMaxIterations(int _maxIterations);
+
+  /// \brief
+  int getVariationalSolverMaxIterations() const;
+
+  /// \brief Get the number of Newton iterations taken by the last variational
+  /// step.
+  int getVariationalSolverIterations() const;
+
+  /// \brief Solve one step of the midpoint discrete variational integrator
+  /// from the current configurations and generalized velocities.
+  ///
+  /// The discrete Euler-Lagrange equations are solved in momentum form for
+  /// the average velocity v of the step,
+  ///   M(q_m) v - h/2 f(q_m, v) = p_k,  p_k+1 = M(q_m) v + h/2 f(q_m, v),
+  /// where q_m is the configuration half a step along v and f is the rate of
+  /// change of the generalized momentum, which is evaluated with the inverse
+  /// dynamics recursion and includes the internal, external, spring and
+  /// damping forces. Newton iterations use M(q_m) as the Jacobian.
+  ///
+  /// The configurations are left unchanged and the generalized velocities are
+  /// set to M(q_k+1)^-1 p_k+1 so that constraint impulses can be applied
+  /// before integrateVariationalConfigs() finishes the step.
+  void computeVariationalStep(double _timeStep);
+
+  /// \brief Integrate the configurations over the step solved by
+  /// computeVariationalStep() with its average velocity plus the change of the
+  /// generalized velocities since then, e.g. by constraint impulses.
+  void integrateVariationalConfigs(double _timeStep);
+
   //----------------------------------------------------------------------------
   // Kinematics algorithms
   //----------------------------------------------------------------------------
@@ -239,6 +286,39 @@ public:
                                 bool _updateVels = true,
                                 bool _updateAccs = true);
 
+  /// \brief Mark the kinematic quantities of _bodyNode and its descendants as
+  /// stale. They are recomputed when they are queried from the body nodes or
+  /// when a dynamics algorithm of this skeleton runs.
+  /// \param[in] _updateTransforms True to mark transformations of body nodes
+  /// \param[in] _updateVels True to mark spacial velocities of body nodes
+  /// \param[in] _updateAccs True to mark spacial accelerations of body nodes
+  void setKinematicsDirty(BodyNode* _bodyNode,
+                          bool _updateTransforms = true,
+                          bool _updateVels = false,
+                          bool _updateAccs = false);
+
+  /// \brief Compute world transformations of _bodyNodes for a batch of
+  /// configurations. The state of this skeleton is left unchanged.
+  ///
+  /// The transformations are stored structure-of-arrays style so that every
+  /// step of the recursion runs over all samples at once.
+  /// \param[in] _configs Configurations with one column per sample.
+  /// \param[in] _bodyNodes Body nodes of this skeleton to compute the world
+  /// transformations of. Only these body nodes and their ancestors are
+  /// visited.
+  /// \param[out] _transforms One matrix per body node in _bodyNodes with one
+  /// row per sample. Columns 0-8 hold the rotation in column-major order and
+  /// columns 9-11 hold the translation.
+  /// \sa getBatchTransform()
+  void computeForwardKinematicsBatch(const Eigen::MatrixXd& _configs,
+                                     const std::vector<BodyNode*>& _bodyNodes,
+                                     std::vector<Eigen::MatrixXd>* _transforms);
+
+  /// \brief Get the transformation of the _sample-th sample from a matrix
+  /// computed by computeForwardKinematicsBatch()
+  static Eigen::Isometry3d getBatchTransform(const Eigen::MatrixXd& _transforms,
+                                             int _sample);
+
   //----------------------------------------------------------------------------
   // Dynamics algorithms
   //----------------------------------------------------------------------------
@@ -249,9 +329,54 @@ public:
   void computeInverseDynamics(bool _withExternalForces = false,
                               bool _withDampingForces = false);
 
+  /// \brief Compute inverse dynamics for a batch of states such as the frames
+  /// of a trajectory. The state of this skeleton is left unchanged.
+  ///
+  /// The frames are processed in chunks, in parallel when OpenMP is enabled.
+  /// As in computeInverseDynamics() with the default arguments, external
+  /// forces and joint damping forces are not included.
+  /// \param[in] _configs Configurations with one column per frame.
+  /// \param[in] _genVels Generalized velocities with one column per frame.
+  /// \param[in] _genAccs Generalized accelerations with one column per frame.
+  /// \param[out] _genForces Generalized forces with one column per frame.
+  void computeInverseDynamicsBatch(const Eigen::MatrixXd& _configs,
+                                   const Eigen::MatrixXd& _genVels,
+                                   const Eigen::MatrixXd& _genAccs,
+                                   Eigen::MatrixXd* _genForces);
+
   /// \brief Compute hybrid dynamics
   void computeHybridDynamics();
 
+  /// \brief Compute the derivatives of the generalized forces given by
+  /// inverse dynamics at the current configurations, generalized velocities
+  /// and generalized accelerations. The derivative with respect to the
+  /// generalized accelerations is the mass matrix.
+  ///
+  /// The configurations of BallJoint and FreeJoint are perturbed in the child
+  /// body frame as in integrateConfigs(). The generalized forces of this
+  /// skeleton are left unchanged. Soft body nodes are not supported.
+  /// \param[out] _dtau_dq Derivative with respect to the configurations
+  /// \param[out] _dtau_ddq Derivative with respect to the generalized
+  /// velocities
+  /// \param[in] _withExternalForces True to include the external forces in the
+  /// nominal body forces
+  void computeInverseDynamicsDerivs(Eigen::MatrixXd* _dtau_dq,
+                                    Eigen::MatrixXd* _dtau_ddq,
+                                    bool _withExternalForces = false);
+
+  /// \brief Compute forward dynamics and the derivatives of the resulting
+  /// generalized accelerations. Joint springs and damping are differentiated
+  /// as the implicit forces used by computeForwardDynamics().
+  /// \param[out] _dddq_dq Derivative with respect to the configurations
+  /// \param[out] _dddq_ddq Derivative with respect to the generalized
+  /// velocities
+  /// \param[out] _dddq_dtau Derivative with respect to the generalized
+  /// forces, which is the inverse of the augmented mass matrix
+  /// \sa computeInverseDynamicsDerivs()
+  void computeForwardDynamicsDerivs(Eigen::MatrixXd* _dddq_dq,
+                                    Eigen::MatrixXd* _dddq_ddq,
+                                    Eigen::MatrixXd* _dddq_dtau);
+
   //----------------------------------------------------------------------------
   // Impulse-based dynamics
   //----------------------------------------------------------------------------
@@ -335,6 +460,29 @@ public:
   /// \brief Get constraint force vector.
   const Eigen::VectorXd& getConstraintForceVector();
 
+  /// \brief Get inverse of operational space inertia, J * M^-1 * J^T, of a
+  /// body node where J is the body Jacobian of the body node. The matrix is
+  /// computed with the articulated body inertias along the path from the root
+  /// to the body node, so the dense inverse of the mass matrix is not formed.
+  const Eigen::Matrix6d& getInvOperationalSpaceInertia(BodyNode* _bodyNode);
+
+  /// \brief Get operational space inertia, (J * M^-1 * J^T)^-1, of a body
+  /// node. The pseudo-inverse is used when the body node can not move in all
+  /// six directions.
+  const Eigen::Matrix6d& getOperationalSpaceInertia(BodyNode* _bodyNode);
+
+  /// \brief Get operational space bias force of a body node, which is
+  /// Lambda * (J * M^-1 * Cg - dJ * dq). The body acceleration of the body node
+  /// then satisfies Lambda * dV + bias = F when J^T * F is applied as the
+  /// generalized force.
+  const Eigen::Vector6d& getOperationalSpaceBiasForce(BodyNode* _bodyNode);
+
+  /// \brief Get dynamically consistent inverse of the body Jacobian of a body
+  /// node, M^-1 * J^T * Lambda. The rows are ordered by the generalized
+  /// coordinates of this skeleton.
+  const Eigen::MatrixXd& getDynamicallyConsistentJacobianInverse(
+      BodyNode* _bodyNode);
+
   /// \brief Set internal force vector.
   void setInternalForceVector(const Eigen::VectorXd& _forces);
 
@@ -373,6 +521,18 @@ public:
   /// \brief Get skeleton's COM Jacobian time derivative w.r.t. world frame.
   Eigen::MatrixXd getWorldCOMJacobianTimeDeriv();
 
+  /// \brief Compute skeleton's COM Jacobian w.r.t. world frame into _J. The
+  /// masses and COMs of the subtrees are accumulated in one pass from the
+  /// leaves, so the cost is linear in the number of generalized coordinates.
+  /// _J is not reallocated if it is already 3 x (number of generalized
+  /// coordinates).
+  void computeWorldCOMJacobian(Eigen::MatrixXd* _J);
+
+  /// \brief Compute skeleton's COM Jacobian time derivative w.r.t. world
+  /// frame into _dJ.
+  /// \sa computeWorldCOMJacobian()
+  void computeWorldCOMJacobianTimeDeriv(Eigen::MatrixXd* _dJ);
+
   /// \brief Get kinetic energy of this skeleton.
   virtual double getKineticEnergy() const;
 
@@ -408,6 +568,13 @@ protected:
   /// \brief List of Soft body node list in the skeleton
   std::vector<SoftBodyNode*> mSoftBodyNodes;
 
+  /// \brief Body node that each generalized coordinate belongs to. The
+  /// coordinates of a point mass belong to its soft body node.
+  std::vector<BodyNode*> mGenCoordBodyNodes;
+
+  /// \brief True if any body node has stale kinematic quantities
+  bool mIsKinematicsDirty;
+
   /// \brief If the skeleton is not mobile, its dynamic effect is equivalent
   /// to having infinite mass. If the configuration of an immobile skeleton are
   /// manually changed, the collision results might not be correct.
@@ -416,6 +583,31 @@ protected:
   /// \brief Time step for implicit joint damping force.
   double mTimeStep;
 
+  /// \brief Whether World::step() uses the variational integrator
+  bool mIsVariationalIntegration;
+
+  /// \brief
+  double mVariationalSolverTolerance;
+
+  /// \brief
+  int mVariationalSolverMaxIterations;
+
+  /// \brief
+  int mVariationalSolverIterations;
+
+  /// \brief Average generalized velocities of the last variational step
+  Eigen::VectorXd mVariationalGenVels;
+
+  /// \brief Generalized velocities at the end of the last variational step
+  Eigen::VectorXd mVariationalNextGenVels;
+
+  /// \brief Mass matrix at the midpoint configurations of a variational step
+  Eigen::MatrixXd mVariationalMassMatrix;
+
+  /// \brief Rate of change of the generalized momentum at the midpoint of a
+  /// variational step
+  Eigen::VectorXd mVariationalForces;
+
   /// \brief Gravity vector.
   Eigen::Vector3d mGravity;
 
@@ -483,10 +675,34 @@ protected:
   /// \brief Dirty flag for the damping force vector.
   bool mIsDampingForceVectorDirty;
 
+  /// \brief True if the operational space quantities cached in the body nodes
+  /// are stale.
+  bool mIsOperationalSpaceDirty;
+
   // TODO(JS): Better naming
   /// \brief Flag for status of impulse testing.
   bool mIsImpulseApplied;
 
+  //----------------------------------------------------------------------------
+  // Compiled skeleton
+  //----------------------------------------------------------------------------
+  /// \brief Index of the parent body node of each body node in mBodyNodes, or
+  /// -1 for the root body node.
+  std::vector<int> mParentIndices;
+
+  /// \brief The children of the i-th body node are the body nodes from
+  /// mChildOffsets[i] to mChildOffsets[i + 1] - 1, which are contiguous since
+  /// mBodyNodes is in BFS order.
+  std::vector<int> mChildOffsets;
+
+  /// \brief Index of the first generalized coordinate of the parent joint of
+  /// each body node.
+  std::vector<int> mGenCoordOffsets;
+
+  /// \brief Articulated-body cache data of all the body nodes in recursion
+  /// order. The cache members of each body node are views of its block.
+  std::vector<double> mArticulatedBodyState;
+
   //----------------------------------------------------------------------------
   // Union finding
   //----------------------------------------------------------------------------
@@ -509,6 +725,72 @@ public:
   size_t mUnionIndex;
 
 protected:
+  /// \brief Set the generalized coordinates listed in _id, or all the
+  /// generalized coordinates if _id is NULL, to _configs. Only the subtrees of
+  /// the joints whose configurations changed are marked as stale.
+  void setConfigsLazily(const std::vector<int>* _id,
+                        const Eigen::VectorXd& _configs,
+                        bool _updateTransforms,
+                        bool _updateVels,
+                        bool _updateAccs);
+
+  /// \brief Recompute the kinematic quantities of every body node with stale
+  /// data.
+  void updateDirtyKinematics();
+
+  /// \brief Mark the cached dynamics quantities of this skeleton as stale.
+  void setDynamicsDirty();
+
+  /// \brief Multiply each column of _X by the inverse of the augmented mass
+  /// matrix in place using the articulated body inertias.
+  void multiplyInvAugMassMatrix(Eigen::MatrixXd* _X);
+
+  /// \brief Multiply each column of _X by the inverse of the mass matrix in
+  /// place using the articulated body inertias.
+  void multiplyInvMassMatrix(Eigen::MatrixXd* _X);
+
+  /// \brief Update the articulated body inertias if they are stale.
+  void updateArticulatedInertia();
+
+  /// \brief Build the compiled form of the skeleton used by the recursive
+  /// dynamics algorithms and map the cache data of the body nodes onto it.
+  void compile();
+
+  /// \brief Update the articulated inertia of the _index-th body node over the
+  /// compiled skeleton. The skeleton must not have soft body nodes.
+  void updateCompiledArticulatedInertia(int _index);
+
+  /// \brief Update the bias force of the _index-th body node over the
+  /// compiled skeleton. The skeleton must not have soft body nodes.
+  void updateCompiledBiasForce(int _index);
+
+  /// \brief Update the joint and body accelerations and the body force of the
+  /// _index-th body node over the compiled skeleton. The skeleton must not
+  /// have soft body nodes.
+  void updateCompiledAcceleration(int _index);
+
+  /// \brief Update the impulsive bias force of the _index-th body node over
+  /// the compiled skeleton. The skeleton must not have soft body nodes.
+  void updateCompiledImpBiasForce(int _index);
+
+  /// \brief Update the joint and body velocity changes of the _index-th body
+  /// node over the compiled skeleton. The skeleton must not have soft body
+  /// nodes.
+  void updateCompiledVelocityChange(int _index);
+
+  /// \brief Mark the operational space quantities of every body node as stale
+  /// if the skeleton has changed since they were computed.
+  void updateDirtyOperationalSpace();
+
+  /// \brief Update operational space inertia of a body node and its inverse.
+  void updateOperationalSpaceInertia(BodyNode* _bodyNode);
+
+  /// \brief Update operational space bias force of a body node.
+  void updateOperationalSpaceBiasForce(BodyNode* _bodyNode);
+
+  /// \brief Update dynamically consistent Jacobian inverse of a body node.
+  void updateDynamicallyConsistentJacobianInverse(BodyNode* _bodyNode);
+
   /// \brief Update mass matrix of the skeleton.
   virtual void updateMassMatrix();
 
@@ -536,6 +818,15 @@ protected:
   /// \brief Update damping force vector.
   virtual void updateDampingForceVector();
 
+  /// \brief Evaluate mVariationalMassMatrix and mVariationalForces at the
+  /// midpoint of the step of length _timeStep from _configs with the average
+  /// velocity _genVels. The internal forces _genForces are held constant over
+  /// the step. The skeleton is left in the midpoint configurations.
+  void evalVariationalMidpoint(const Eigen::VectorXd& _configs,
+                               const Eigen::VectorXd& _genVels,
+                               const Eigen::VectorXd& _genForces,
+                               double _timeStep);
+
 public:
   // To get byte-aligned Eigen vectors
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -36,6 +36,8 @@
 
 #include "dart/dynamics/SoftBodyNode.h"
 
+#include <algorithm>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -53,11 +55,32 @@
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+// Point masses are processed in chunks of this size. The chunks run in
+// parallel when OpenMP is enabled and the soft body node has at least
+// parallelPointMassThreshold point masses. Sums over the point masses are
+// accumulated per chunk and then added in chunk order, so the results do not
+// depend on the number of threads.
+const int pointMassChunkSize = 256;
+const int parallelPointMassThreshold = 1024;
+
+int getNumPointMassChunks(int _numPointMasses)
+{
+  return (_numPointMasses + pointMassChunkSize - 1) / pointMassChunkSize;
+}
+
+}  // namespace
+
 SoftBodyNode::SoftBodyNode(const std::string& _name)
   : BodyNode(_name),
     mKv(DART_DEFAULT_VERTEX_STIFFNESS),
     mKe(DART_DEFAULT_EDGE_STIFNESS),
     mDampCoeff(DART_DEFAULT_DAMPING_COEFF),
+    mIsImplicitIntegration(false),
+    mImplicitSolverTolerance(1e-8),
+    mImplicitSolverMaxIterations(100),
+    mImplicitSolverIterations(0),
     mSoftVisualShape(NULL),
     mSoftCollShape(NULL)
 {
@@ -80,6 +103,13 @@ PointMass* SoftBodyNode::getPointMass(int _idx) const
   return mPointMasses[_idx];
 }
 
+const SoftBodyNode::PointMassArray& SoftBodyNode::getPointMassPositions() const
+{
+  // Point masses are updated together with this soft body node
+  getWorldTransform();
+  return mPointMassX;
+}
+
 void SoftBodyNode::init(Skeleton* _skeleton, int _skeletonIndex)
 {
   BodyNode::init(_skeleton, _skeletonIndex);
@@ -87,6 +117,8 @@ void SoftBodyNode::init(Skeleton* _skeleton, int _skeletonIndex)
   for (int i = 0; i < mPointMasses.size(); ++i)
     mPointMasses[i]->init();
 
+  _mapPointMassState();
+
 //  //----------------------------------------------------------------------------
 //  // Visualization shape
 //  //----------------------------------------------------------------------------
@@ -166,6 +198,43 @@ double SoftBodyNode::getDampingCoefficient() const
   return mDampCoeff;
 }
 
+void SoftBodyNode::setImplicitIntegration(bool _isImplicit)
+{
+  mIsImplicitIntegration = _isImplicit;
+}
+
+bool SoftBodyNode::isImplicitIntegration() const
+{
+  return mIsImplicitIntegration;
+}
+
+void SoftBodyNode::setImplicitSolverTolerance(double _tolerance)
+{
+  assert(_tolerance > 0.0);
+  mImplicitSolverTolerance = _tolerance;
+}
+
+double SoftBodyNode::getImplicitSolverTolerance() const
+{
+  return mImplicitSolverTolerance;
+}
+
+void SoftBodyNode::setImplicitSolverMaxIterations(int _maxIterations)
+{
+  assert(_maxIterations > 0);
+  mImplicitSolverMaxIterations = _maxIterations;
+}
+
+int SoftBodyNode::getImplicitSolverMaxIterations() const
+{
+  return mImplicitSolverMaxIterations;
+}
+
+int SoftBodyNode::getImplicitSolverIterations() const
+{
+  return mImplicitSolverIterations;
+}
+
 void SoftBodyNode::removeAllPointMasses()
 {
   mPointMasses.clear();
@@ -208,6 +277,24 @@ int SoftBodyNode::getNumFaces()
   return mFaces.size();
 }
 
+PointMass* SoftBodyNode::getClosestPointMass(
+    int _faceId, const Eigen::Vector3d& _point) const
+{
+  const Eigen::Vector3i& face = getFace(_faceId);
+
+  // Compare in body frame so that the point masses need no transform
+  const Eigen::Vector3d point = getWorldTransform().inverse() * _point;
+
+  double dist0 = (mPointMassX.row(face[0]).transpose() - point).squaredNorm();
+  double dist1 = (mPointMassX.row(face[1]).transpose() - point).squaredNorm();
+  double dist2 = (mPointMassX.row(face[2]).transpose() - point).squaredNorm();
+
+  if (dist0 > dist1)
+    return mPointMasses[dist1 > dist2 ? face[2] : face[1]];
+  else
+    return mPointMasses[dist0 > dist2 ? face[2] : face[0]];
+}
+
 void SoftBodyNode::clearConstraintImpulse()
 {
   BodyNode::clearConstraintImpulse();
@@ -220,39 +307,120 @@ void SoftBodyNode::updateTransform()
 {
   BodyNode::updateTransform();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateTransform();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // X = q + X0
+    _gatherPointMassGenCoords(&GenCoord::getPos, b, n, &mPointMassQ);
+    mPointMassX.middleRows(b, n)
+        = mPointMassQ.middleRows(b, n) + mPointMassX0.middleRows(b, n);
+
+    // W = p(parent) + R(parent) * X
+    mPointMassW.middleRows(b, n).noalias()
+        = mPointMassX.middleRows(b, n) * mW.linear().transpose();
+    mPointMassW.middleRows(b, n).rowwise() += mW.translation().transpose();
+  }
+  assert(!math::isNan(mPointMassX));
+  assert(!math::isNan(mPointMassW));
 }
 
 void SoftBodyNode::updateVelocity()
 {
   BodyNode::updateVelocity();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateVelocity();
+  const Eigen::Matrix3d wT = math::makeSkewSymmetric(mV.head<3>()).transpose();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // V = w(parent) x X + v(parent) + dq
+    _gatherPointMassGenCoords(&GenCoord::getVel, b, n, &mPointMassdQ);
+    mPointMassV.middleRows(b, n).noalias() = mPointMassX.middleRows(b, n) * wT;
+    mPointMassV.middleRows(b, n).rowwise() += mV.tail<3>().transpose();
+    mPointMassV.middleRows(b, n) += mPointMassdQ.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassV));
 }
 
 void SoftBodyNode::updateEta()
 {
   BodyNode::updateEta();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateEta();
+  const Eigen::Matrix3d wT = math::makeSkewSymmetric(mV.head<3>()).transpose();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // eta = w(parent) x dq, where dq is gathered by updateVelocity()
+    mPointMassEta.middleRows(b, n).noalias()
+        = mPointMassdQ.middleRows(b, n) * wT;
+  }
+  assert(!math::isNan(mPointMassEta));
 }
 
 void SoftBodyNode::updateAcceleration()
 {
   BodyNode::updateAcceleration();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateAcceleration();
+  const Eigen::Matrix3d dwT
+      = math::makeSkewSymmetric(mdV.head<3>()).transpose();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // dV = dw(parent) x X + dv(parent) + eta + ddq
+    _gatherPointMassGenCoords(&GenCoord::getAcc, b, n, &mPointMassddQ);
+    mPointMassdV.middleRows(b, n).noalias()
+        = mPointMassX.middleRows(b, n) * dwT;
+    mPointMassdV.middleRows(b, n).rowwise() += mdV.tail<3>().transpose();
+    mPointMassdV.middleRows(b, n)
+        += mPointMassEta.middleRows(b, n) + mPointMassddQ.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassdV));
 }
 
 void SoftBodyNode::updateBodyForce(const Eigen::Vector3d& _gravity,
                                    bool _withExternalForces)
 {
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateBodyForce(_gravity, _withExternalForces);
+  const Eigen::Matrix3d wT = math::makeSkewSymmetric(mV.head<3>()).transpose();
+  Eigen::Vector3d g = Eigen::Vector3d::Zero();
+  if (mGravityMode == true)
+    g = mW.linear().transpose() * _gravity;
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // F = m * (dV + w(parent) x V - R(parent)^T * g) - Fext
+    mPointMassF.middleRows(b, n).noalias() = mPointMassV.middleRows(b, n) * wT;
+    mPointMassF.middleRows(b, n) += mPointMassdV.middleRows(b, n);
+    mPointMassF.middleRows(b, n).rowwise() -= g.transpose();
+    mPointMassF.middleRows(b, n)
+        = mPointMassMasses.segment(b, n).asDiagonal()
+          * mPointMassF.middleRows(b, n);
+    mPointMassF.middleRows(b, n) -= mPointMassFext.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassF));
 
 //  BodyNode::updateBodyForce(_gravity, _withExternalForces);
   if (mGravityMode == true)
@@ -274,11 +442,7 @@ void SoftBodyNode::updateBodyForce(const Eigen::Vector3d& _gravity,
     mF += math::dAdInvT(childJoint->getLocalTransform(),
                         (*iChildBody)->getBodyForce());
   }
-  for (int i = 0; i < mPointMasses.size(); i++)
-  {
-    mF.head<3>() += mPointMasses[i]->mX.cross(mPointMasses[i]->mF);
-    mF.tail<3>() += mPointMasses[i]->mF;
-  }
+  mF += _sumPointMassForces(mPointMassF);
 
   // TODO(JS): mWrench and mF are duplicated. Remove one of them.
   mParentJoint->mWrench = mF;
@@ -296,8 +460,39 @@ void SoftBodyNode::updateGeneralizedForce(bool _withDampingForces)
 
 void SoftBodyNode::updateArticulatedInertia(double _timeStep)
 {
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateArticulatedInertia(_timeStep);
+  // Point mass cache data: Psi, ImplicitPsi, Pi, and ImplicitPi. With the
+  // implicit integration, ImplicitPsi is the inverse of the diagonal of the
+  // implicit matrix, which approximates the point masses for the articulated
+  // inertia and preconditions the conjugate gradient solver.
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+  const double implicitKe = mIsImplicitIntegration ? mKe : 0.0;
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    mPointMassPsi.segment(b, n) = mPointMassMasses.segment(b, n).cwiseInverse();
+    mPointMassImplicitPsi.segment(b, n)
+        = (mPointMassMasses.segment(b, n).array()
+           + _timeStep * mDampCoeff
+           + _timeStep * _timeStep
+             * (mKv + implicitKe
+                      * mPointMassNumConnections.segment(b, n).array())
+           ).inverse().matrix();
+    mPointMassPi.segment(b, n)
+        = mPointMassMasses.segment(b, n)
+          - mPointMassMasses.segment(b, n).cwiseAbs2().cwiseProduct(
+              mPointMassPsi.segment(b, n));
+    mPointMassImplicitPi.segment(b, n)
+        = mPointMassMasses.segment(b, n)
+          - mPointMassMasses.segment(b, n).cwiseAbs2().cwiseProduct(
+              mPointMassImplicitPsi.segment(b, n));
+  }
+  assert(!math::isNan(mPointMassImplicitPsi));
+  assert(!math::isNan(mPointMassPi));
+  assert(!math::isNan(mPointMassImplicitPi));
 
   assert(mParentJoint != NULL);
 
@@ -314,11 +509,8 @@ void SoftBodyNode::updateArticulatedInertia(double _timeStep)
                      (*it)->getParentJoint()->getLocalTransform().inverse(),
                      (*it)->mImplicitPi);
   }
-  for (int i = 0; i < mPointMasses.size(); i++)
-  {
-    _addPiToArticulatedInertia(mPointMasses[i]->mX, mPointMasses[i]->mPi);
-    _addImplicitPiToImplicitAI(mPointMasses[i]->mX, mPointMasses[i]->mImplicitPi);
-  }
+  mAI += _getPointMassInertia(mPointMassPi);
+  mImplicitAI += _getPointMassInertia(mPointMassImplicitPi);
   assert(!math::isNan(mAI));
   assert(!math::isNan(mImplicitAI));
 
@@ -378,8 +570,76 @@ void SoftBodyNode::updateArticulatedInertia(double _timeStep)
 void SoftBodyNode::updateBiasForce(double _timeStep,
                                    const Eigen::Vector3d& _gravity)
 {
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateBiasForce(_timeStep, _gravity);
+  const Eigen::Matrix3d wT = math::makeSkewSymmetric(mV.head<3>()).transpose();
+  Eigen::Vector3d g = Eigen::Vector3d::Zero();
+  if (mGravityMode == true)
+    g = mW.linear().transpose() * _gravity;
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    _gatherPointMassGenCoords(&GenCoord::getPos, b, n, &mPointMassQ);
+    _gatherPointMassGenCoords(&GenCoord::getVel, b, n, &mPointMassdQ);
+    _gatherPointMassGenCoords(&GenCoord::getForce, b, n, &mPointMassTau);
+
+    // Point mass bias force: B = w(parent) x m*V - Fext - m*R(parent)^T*g
+    mPointMassB.middleRows(b, n).noalias() = mPointMassV.middleRows(b, n) * wT;
+    mPointMassB.middleRows(b, n).rowwise() -= g.transpose();
+    mPointMassB.middleRows(b, n)
+        = mPointMassMasses.segment(b, n).asDiagonal()
+          * mPointMassB.middleRows(b, n);
+    mPointMassB.middleRows(b, n) -= mPointMassFext.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassB));
+
+  // The edge springs read the generalized coordinates of the other chunks,
+  // so alpha and beta are computed after all of them are gathered.
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // Point mass cache data: alpha
+    const Eigen::ArrayXd stiffness
+        = mKv + mKe * mPointMassNumConnections.segment(b, n).array();
+    mPointMassAlpha.middleRows(b, n)
+        = mPointMassTau.middleRows(b, n) - mPointMassB.middleRows(b, n);
+    mPointMassAlpha.middleRows(b, n)
+        -= stiffness.matrix().asDiagonal() * mPointMassQ.middleRows(b, n);
+    mPointMassAlpha.middleRows(b, n)
+        -= (_timeStep * stiffness + mDampCoeff).matrix().asDiagonal()
+           * mPointMassdQ.middleRows(b, n);
+    mPointMassAlpha.middleRows(b, n)
+        -= mPointMassMasses.segment(b, n).asDiagonal()
+           * mPointMassEta.middleRows(b, n);
+    for (int i = b; i < b + n; ++i)
+    {
+      for (int j = mPointMassConnectionOffsets[i];
+           j < mPointMassConnectionOffsets[i + 1]; ++j)
+      {
+        int k = mPointMassConnections[j];
+        mPointMassAlpha.row(i)
+            += mKe * (mPointMassQ.row(k) + _timeStep * mPointMassdQ.row(k));
+      }
+    }
+
+    // Point mass cache data: beta
+    mPointMassBeta.middleRows(b, n)
+        = mPointMassImplicitPsi.segment(b, n).asDiagonal()
+          * mPointMassAlpha.middleRows(b, n);
+    mPointMassBeta.middleRows(b, n) += mPointMassEta.middleRows(b, n);
+    mPointMassBeta.middleRows(b, n)
+        = mPointMassMasses.segment(b, n).asDiagonal()
+          * mPointMassBeta.middleRows(b, n);
+    mPointMassBeta.middleRows(b, n) += mPointMassB.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassAlpha));
+  assert(!math::isNan(mPointMassBeta));
 
   // Bias force
   if (mGravityMode == true)
@@ -395,11 +655,7 @@ void SoftBodyNode::updateBiasForce(double _timeStep,
     mB += math::dAdInvT((*it)->getParentJoint()->getLocalTransform(),
                         (*it)->mBeta);
   }
-  for (int i = 0; i < mPointMasses.size(); i++)
-  {
-    mB.head<3>() += mPointMasses[i]->mX.cross(mPointMasses[i]->mBeta);
-    mB.tail<3>() += mPointMasses[i]->mBeta;
-  }
+  mB += _sumPointMassForces(mPointMassBeta);
   assert(!math::isNan(mB));
 
   // Cache data: alpha
@@ -433,23 +689,84 @@ void SoftBodyNode::update_ddq()
 {
   BodyNode::update_ddq();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->update_ddq();
+  const Eigen::Vector6d& dV = getBodyAcceleration();
+  const Eigen::Matrix3d dwT = math::makeSkewSymmetric(dV.head<3>()).transpose();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // ddq = imp_psi * (alpha - m * (dw(parent) x X + dv(parent))), or the
+    // solution of the implicit matrix for the same right hand side
+    mPointMassdV.middleRows(b, n).noalias()
+        = mPointMassX.middleRows(b, n) * dwT;
+    mPointMassdV.middleRows(b, n).rowwise() += dV.tail<3>().transpose();
+    mImplicitRhs.middleRows(b, n) = mPointMassAlpha.middleRows(b, n);
+    mImplicitRhs.middleRows(b, n)
+        -= mPointMassMasses.segment(b, n).asDiagonal()
+           * mPointMassdV.middleRows(b, n);
+    if (!mIsImplicitIntegration)
+    {
+      mPointMassddQ.middleRows(b, n)
+          = mPointMassImplicitPsi.segment(b, n).asDiagonal()
+            * mImplicitRhs.middleRows(b, n);
+    }
+  }
+
+  if (mIsImplicitIntegration)
+    _solveImplicitAccelerations(mSkeleton->getTimeStep());
+
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    for (int i = b; i < b + n; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+        mPointMasses[i]->mCoordinate[j].setAcc(mPointMassddQ(i, j));
+    }
+
+    // dV = dw(parent) x X + dv(parent) + eta + ddq
+    mPointMassdV.middleRows(b, n)
+        += mPointMassEta.middleRows(b, n) + mPointMassddQ.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassddQ));
+  assert(!math::isNan(mPointMassdV));
 }
 
 void SoftBodyNode::update_F_fs()
 {
   BodyNode::update_F_fs();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->update_F_fs();
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    // F = m * dV + B
+    mPointMassF.middleRows(b, n).noalias()
+        = mPointMassMasses.segment(b, n).asDiagonal()
+          * mPointMassdV.middleRows(b, n);
+    mPointMassF.middleRows(b, n) += mPointMassB.middleRows(b, n);
+  }
+  assert(!math::isNan(mPointMassF));
 }
 
 //==============================================================================
 void SoftBodyNode::updateImpBiasForce()
 {
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateImpBiasForce();
+  const int nPointMasses = mPointMasses.size();
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int i = 0; i < nPointMasses; ++i)
+    mPointMasses[i]->updateImpBiasForce();
 
   // Update impulsive bias force
   mImpB = -mConstraintImpulse;
@@ -493,8 +810,10 @@ void SoftBodyNode::updateJointVelocityChange()
 {
   BodyNode::updateJointVelocityChange();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateJointVelocityChange();
+  const int nPointMasses = mPointMasses.size();
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int i = 0; i < nPointMasses; ++i)
+    mPointMasses[i]->updateJointVelocityChange();
 }
 
 //==============================================================================
@@ -511,8 +830,10 @@ void SoftBodyNode::updateBodyImpForceFwdDyn()
 {
   BodyNode::updateBodyImpForceFwdDyn();
 
-  for (int i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateBodyImpForceFwdDyn();
+  const int nPointMasses = mPointMasses.size();
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int i = 0; i < nPointMasses; ++i)
+    mPointMasses[i]->updateBodyImpForceFwdDyn();
 }
 
 void SoftBodyNode::updateMassMatrix()
@@ -914,6 +1235,10 @@ void SoftBodyNode::draw(renderer::RenderInterface* _ri,
   if (_ri == NULL)
     return;
 
+  // Bring the local transformation of the parent joint and the point masses
+  // up to date
+  getWorldTransform();
+
   _ri->pushMatrix();
 
   // render the self geometry
@@ -952,15 +1277,15 @@ void SoftBodyNode::draw(renderer::RenderInterface* _ri,
       glEnable(GL_AUTO_NORMAL);
       glBegin(GL_TRIANGLES);
 
-      pos = mPointMasses[mFaces[i](0)]->mX;
+      pos = mPointMassX.row(mFaces[i](0));
       pos_normalized = pos.normalized();
       glNormal3f(pos_normalized(0), pos_normalized(1), pos_normalized(2));
       glVertex3f(pos(0), pos(1), pos(2));
-      pos = mPointMasses[mFaces[i](1)]->mX;
+      pos = mPointMassX.row(mFaces[i](1));
       pos_normalized = pos.normalized();
       glNormal3f(pos_normalized(0), pos_normalized(1), pos_normalized(2));
       glVertex3f(pos(0), pos(1), pos(2));
-      pos = mPointMasses[mFaces[i](2)]->mX;
+      pos = mPointMassX.row(mFaces[i](2));
       pos_normalized = pos.normalized();
       glNormal3f(pos_normalized(0), pos_normalized(1), pos_normalized(2));
       glVertex3f(pos(0), pos(1), pos(2));
@@ -979,32 +1304,243 @@ void SoftBodyNode::draw(renderer::RenderInterface* _ri,
   _ri->popMatrix();
 }
 
-void SoftBodyNode::_addPiToArticulatedInertia(const Eigen::Vector3d& _p,
-                                              double _Pi)
+void SoftBodyNode::_mapPointMassState()
 {
-  Eigen::Matrix3d tmp = math::makeSkewSymmetric(_p);
+  int nPointMasses = mPointMasses.size();
+
+  // Copy the current point mass values through the old views before the
+  // point masses are made to view the new arrays.
+  PointMassArray* arrays[11] = {&mPointMassW, &mPointMassX, &mPointMassX0,
+                                &mPointMassV, &mPointMassEta, &mPointMassAlpha,
+                                &mPointMassBeta, &mPointMassdV, &mPointMassF,
+                                &mPointMassB, &mPointMassFext};
+  std::vector<PointMassArray> values(11, PointMassArray(nPointMasses, 3));
+  for (int i = 0; i < nPointMasses; ++i)
+  {
+    PointMass* pm = mPointMasses[i];
+    PointMass::StridedVector3d* views[11] = {&pm->mW, &pm->mX, &pm->mX0,
+                                             &pm->mV, &pm->mEta, &pm->mAlpha,
+                                             &pm->mBeta, &pm->mdV, &pm->mF,
+                                             &pm->mB, &pm->mFext};
+    for (int k = 0; k < 11; ++k)
+      values[k].row(i) = views[k]->transpose();
+  }
+
+  for (int k = 0; k < 11; ++k)
+    arrays[k]->swap(values[k]);
+
+  mPointMassQ.setZero(nPointMasses, 3);
+  mPointMassdQ.setZero(nPointMasses, 3);
+  mPointMassddQ.setZero(nPointMasses, 3);
+  mPointMassTau.setZero(nPointMasses, 3);
+  mPointMassMasses.resize(nPointMasses);
+  mPointMassPsi.setZero(nPointMasses);
+  mPointMassImplicitPsi.setZero(nPointMasses);
+  mPointMassPi.setZero(nPointMasses);
+  mPointMassImplicitPi.setZero(nPointMasses);
+  mPointMassChunkInertias.resize(getNumPointMassChunks(nPointMasses));
+  mPointMassChunkForces.resize(getNumPointMassChunks(nPointMasses));
+  mImplicitRhs.setZero(nPointMasses, 3);
+  mImplicitResidual.setZero(nPointMasses, 3);
+  mImplicitPrecondResidual.setZero(nPointMasses, 3);
+  mImplicitDirection.setZero(nPointMasses, 3);
+  mImplicitMatrixDirection.setZero(nPointMasses, 3);
 
-  mAI.topLeftCorner<3, 3>()    -= _Pi * tmp * tmp;
-  mAI.topRightCorner<3, 3>()   += _Pi * tmp;
-  mAI.bottomLeftCorner<3, 3>() -= _Pi * tmp;
+  for (int i = 0; i < nPointMasses; ++i)
+  {
+    PointMass* pm = mPointMasses[i];
+    Eigen::InnerStride<> stride(nPointMasses);
+    new (&pm->mW) PointMass::StridedVector3d(&mPointMassW(i, 0), stride);
+    new (&pm->mX) PointMass::StridedVector3d(&mPointMassX(i, 0), stride);
+    new (&pm->mX0) PointMass::StridedVector3d(&mPointMassX0(i, 0), stride);
+    new (&pm->mV) PointMass::StridedVector3d(&mPointMassV(i, 0), stride);
+    new (&pm->mEta) PointMass::StridedVector3d(&mPointMassEta(i, 0), stride);
+    new (&pm->mAlpha)
+        PointMass::StridedVector3d(&mPointMassAlpha(i, 0), stride);
+    new (&pm->mBeta) PointMass::StridedVector3d(&mPointMassBeta(i, 0), stride);
+    new (&pm->mdV) PointMass::StridedVector3d(&mPointMassdV(i, 0), stride);
+    new (&pm->mF) PointMass::StridedVector3d(&mPointMassF(i, 0), stride);
+    new (&pm->mB) PointMass::StridedVector3d(&mPointMassB(i, 0), stride);
+    new (&pm->mFext) PointMass::StridedVector3d(&mPointMassFext(i, 0), stride);
+
+    pm->mIndex = i;
+    mPointMassMasses[i] = pm->mMass;
+  }
+
+  // Connectivity of the edge springs
+  mPointMassNumConnections.resize(nPointMasses);
+  mPointMassConnectionOffsets.assign(1, 0);
+  mPointMassConnections.clear();
+  for (int i = 0; i < nPointMasses; ++i)
+  {
+    PointMass* pm = mPointMasses[i];
+    int nConnections = pm->getNumConnectedPointMasses();
+    for (int j = 0; j < nConnections; ++j)
+      mPointMassConnections.push_back(pm->getConnectedPointMass(j)->mIndex);
+    mPointMassConnectionOffsets.push_back(mPointMassConnections.size());
+    mPointMassNumConnections[i] = nConnections;
+  }
+}
+
+void SoftBodyNode::_gatherPointMassGenCoords(double (GenCoord::*_get)() const,
+                                             int _begin, int _size,
+                                             PointMassArray* _values) const
+{
+  for (int i = _begin; i < _begin + _size; ++i)
+  {
+    const PointMass* pm = mPointMasses[i];
+    (*_values)(i, 0) = (pm->mCoordinate[0].*_get)();
+    (*_values)(i, 1) = (pm->mCoordinate[1].*_get)();
+    (*_values)(i, 2) = (pm->mCoordinate[2].*_get)();
+  }
+}
 
-  mAI(3, 3) += _Pi;
-  mAI(4, 4) += _Pi;
-  mAI(5, 5) += _Pi;
+Eigen::Matrix6d SoftBodyNode::_getPointMassInertia(const Eigen::VectorXd& _Pi)
+{
+  // sum_i Pi_i * [[-[x_i]^2, [x_i]], [-[x_i], 1]] where
+  // [x]^2 = x * x^T - (x^T * x) * I
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    const Eigen::Matrix3d S
+        = mPointMassX.middleRows(b, n).transpose()
+          * (_Pi.segment(b, n).asDiagonal() * mPointMassX.middleRows(b, n));
+    const Eigen::Matrix3d s = math::makeSkewSymmetric(
+                                mPointMassX.middleRows(b, n).transpose()
+                                * _Pi.segment(b, n));
+
+    Eigen::Matrix6d& AI = mPointMassChunkInertias[c];
+    AI.topLeftCorner<3, 3>()
+        = S.trace() * Eigen::Matrix3d::Identity() - S;
+    AI.topRightCorner<3, 3>()    = s;
+    AI.bottomLeftCorner<3, 3>()  = -s;
+    AI.bottomRightCorner<3, 3>()
+        = _Pi.segment(b, n).sum() * Eigen::Matrix3d::Identity();
+  }
+
+  Eigen::Matrix6d AI = Eigen::Matrix6d::Zero();
+  for (int c = 0; c < nChunks; ++c)
+    AI += mPointMassChunkInertias[c];
+
+  return AI;
+}
+
+Eigen::Vector6d SoftBodyNode::_sumPointMassForces(const PointMassArray& _f)
+{
+  // [sum_i x_i x f_i; sum_i f_i]
+  const PointMassArray& x = mPointMassX;
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    const PointMassArray::ConstRowsBlockXpr X = x.middleRows(b, n);
+    const PointMassArray::ConstRowsBlockXpr f = _f.middleRows(b, n);
+    Eigen::Vector6d& F = mPointMassChunkForces[c];
+    F[0] = X.col(1).dot(f.col(2)) - X.col(2).dot(f.col(1));
+    F[1] = X.col(2).dot(f.col(0)) - X.col(0).dot(f.col(2));
+    F[2] = X.col(0).dot(f.col(1)) - X.col(1).dot(f.col(0));
+    F.tail<3>() = f.colwise().sum().transpose();
+  }
+
+  Eigen::Vector6d F = Eigen::Vector6d::Zero();
+  for (int c = 0; c < nChunks; ++c)
+    F += mPointMassChunkForces[c];
+
+  return F;
+}
+
+void SoftBodyNode::_multiplyImplicitMatrix(const PointMassArray& _x,
+                                           double _timeStep,
+                                           PointMassArray* _result) const
+{
+  const double offDiagonal = _timeStep * _timeStep * mKe;
+  const int nPointMasses = mPointMasses.size();
+  const int nChunks = getNumPointMassChunks(nPointMasses);
+#pragma omp parallel for if (nPointMasses >= parallelPointMassThreshold)
+  for (int c = 0; c < nChunks; ++c)
+  {
+    const int b = c * pointMassChunkSize;
+    const int n = std::min(pointMassChunkSize, nPointMasses - b);
+
+    _result->middleRows(b, n)
+        = mPointMassImplicitPsi.segment(b, n).cwiseInverse().asDiagonal()
+          * _x.middleRows(b, n);
+    for (int i = b; i < b + n; ++i)
+    {
+      for (int j = mPointMassConnectionOffsets[i];
+           j < mPointMassConnectionOffsets[i + 1]; ++j)
+      {
+        _result->row(i) -= offDiagonal * _x.row(mPointMassConnections[j]);
+      }
+    }
+  }
 }
 
-void SoftBodyNode::_addImplicitPiToImplicitAI(const Eigen::Vector3d& _p,
-                                              double _ImplicitPi)
+void SoftBodyNode::_solveImplicitAccelerations(double _timeStep)
 {
-  Eigen::Matrix3d tmp = math::makeSkewSymmetric(_p);
+  // The x, y and z components share the matrix, so they are solved together
+  // as one system with three times the unknowns.
+  PointMassArray& x = mPointMassddQ;
+  PointMassArray& r = mImplicitResidual;
+  PointMassArray& z = mImplicitPrecondResidual;
+  PointMassArray& p = mImplicitDirection;
+  PointMassArray& Ap = mImplicitMatrixDirection;
+
+  mImplicitSolverIterations = 0;
+
+  const double bNorm = mImplicitRhs.norm();
+  if (bNorm == 0.0)
+  {
+    x.setZero();
+    return;
+  }
+  const double tolerance = mImplicitSolverTolerance * bNorm;
+
+  // Warm start from the accelerations of the last solve
+  _multiplyImplicitMatrix(x, _timeStep, &r);
+  r = mImplicitRhs - r;
+  if (r.norm() <= tolerance)
+    return;
+
+  z = mPointMassImplicitPsi.asDiagonal() * r;
+  p = z;
+  double rz = r.cwiseProduct(z).sum();
+
+  bool converged = false;
+  while (!converged
+         && mImplicitSolverIterations < mImplicitSolverMaxIterations)
+  {
+    ++mImplicitSolverIterations;
 
-  mImplicitAI.topLeftCorner<3, 3>()    -= _ImplicitPi * tmp * tmp;
-  mImplicitAI.topRightCorner<3, 3>()   += _ImplicitPi * tmp;
-  mImplicitAI.bottomLeftCorner<3, 3>() -= _ImplicitPi * tmp;
+    _multiplyImplicitMatrix(p, _timeStep, &Ap);
+    const double alpha = rz / p.cwiseProduct(Ap).sum();
+    x += alpha * p;
+    r -= alpha * Ap;
+    converged = r.norm() <= tolerance;
+    if (converged)
+      break;
 
-  mImplicitAI(3, 3) += _ImplicitPi;
-  mImplicitAI(4, 4) += _ImplicitPi;
-  mImplicitAI(5, 5) += _ImplicitPi;
+    z = mPointMassImplicitPsi.asDiagonal() * r;
+    const double rzNew = r.cwiseProduct(z).sum();
+    p = z + (rzNew / rz) * p;
+    rz = rzNew;
+  }
+
+  if (!converged)
+  {
+    dtwarn << "Implicit point mass solve of SoftBodyNode [" << getName()
+           << "] did not converge in " << mImplicitSolverIterations
+           << " iterations." << std::endl;
+  }
 }
 
 void SoftBodyNodeHelper::setBox(SoftBodyNode*            _softBodyNode,
@@ -62,6 +62,12 @@ class SoftBodyNode : public BodyNode
 {
 public:
   friend class Skeleton;
+  friend class PointMass;
+
+  /// \brief Per point mass x/y/z arrays with one row per point mass. Each
+  ///        column is contiguous so that the point mass kernels run over all
+  ///        the x, y and z components at once.
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 3> PointMassArray;
 
   //--------------------------------------------------------------------------
   // Constructor and Desctructor
@@ -93,6 +99,41 @@ public:
   /// \brief
   double getDampingCoefficient() const;
 
+  /// \brief Set whether the point mass accelerations are solved fully
+  ///        implicitly (backward Euler) including the coupling of the edge
+  ///        springs. When false, only the vertex springs and the damping are
+  ///        treated implicitly, which requires small time steps for stiff
+  ///        edge springs.
+  ///
+  ///        The articulated inertia and the bias force of this body node use
+  ///        only the diagonal of the implicit matrix, while the point mass
+  ///        accelerations are solved with the full coupled matrix. This is an
+  ///        approximation: the body sees each point mass as attached by its
+  ///        edge springs to fixed neighbours, which adds a rigid motion error
+  ///        that vanishes with the time step.
+  void setImplicitIntegration(bool _isImplicit);
+
+  /// \brief
+  bool isImplicitIntegration() const;
+
+  /// \brief Set the relative residual tolerance of the conjugate gradient
+  ///        solver of the implicit point mass accelerations.
+  void setImplicitSolverTolerance(double _tolerance);
+
+  /// \brief
+  double getImplicitSolverTolerance() const;
+
+  /// \brief Set the maximum number of conjugate gradient iterations of the
+  ///        implicit point mass accelerations.
+  void setImplicitSolverMaxIterations(int _maxIterations);
+
+  /// \brief
+  int getImplicitSolverMaxIterations() const;
+
+  /// \brief Get the number of conjugate gradient iterations taken by the
+  ///        last implicit point mass solve.
+  int getImplicitSolverIterations() const;
+
   /// \brief
   void removeAllPointMasses();
 
@@ -105,6 +146,12 @@ public:
   /// \brief
   PointMass* getPointMass(int _idx) const;
 
+  /// \brief Get the local positions of the point masses with one row per
+  ///        point mass. This is the vertex buffer that the soft mesh shapes
+  ///        of this soft body node share with collision and rendering. It is
+  ///        updated once per kinematics update, not copied per consumer.
+  const PointMassArray& getPointMassPositions() const;
+
   /// \brief
   void connectPointMasses(int _idx1, int _idx2);
 
@@ -117,6 +164,12 @@ public:
   /// \brief
   int getNumFaces();
 
+  /// \brief Get the point mass of the face _faceId that is closest to
+  ///        _point expressed in world frame. Only the vertices of the face are
+  ///        visited, so the cost is independent of the number of point masses.
+  PointMass* getClosestPointMass(int _faceId,
+                                 const Eigen::Vector3d& _point) const;
+
   // Documentation inherited.
   virtual void clearConstraintImpulse();
 
@@ -253,19 +306,153 @@ protected:
   /// \brief
   double mDampCoeff;
 
+  /// \brief Whether the edge springs are solved implicitly.
+  bool mIsImplicitIntegration;
+
+  /// \brief
+  double mImplicitSolverTolerance;
+
+  /// \brief
+  int mImplicitSolverMaxIterations;
+
+  /// \brief
+  int mImplicitSolverIterations;
+
   /// \brief Soft mesh shape for visualization.
   SoftMeshShape* mSoftVisualShape;
 
   /// \brief Soft mesh shape for collision.
   SoftMeshShape* mSoftCollShape;
 
-private:
+  //----------------------- Contiguous Point Mass State ------------------------
+  // The vector states of the point masses (PointMass::mX, mV, mF, ...) are
+  // views of the rows of these arrays once init() is called.
+
+  /// \brief Current positions viewed in world frame.
+  PointMassArray mPointMassW;
+
+  /// \brief Current positions viewed in this body node frame.
+  PointMassArray mPointMassX;
+
+  /// \brief Resting positions viewed in this body node frame.
+  PointMassArray mPointMassX0;
+
+  /// \brief Current velocities viewed in this body node frame.
+  PointMassArray mPointMassV;
+
   /// \brief
-  void _addPiToArticulatedInertia(const Eigen::Vector3d& _p, double _Pi);
+  PointMassArray mPointMassEta;
 
   /// \brief
-  void _addImplicitPiToImplicitAI(const Eigen::Vector3d& _p,
-                                          double _ImplicitPi);
+  PointMassArray mPointMassAlpha;
+
+  /// \brief
+  PointMassArray mPointMassBeta;
+
+  /// \brief Current accelerations viewed in this body node frame.
+  PointMassArray mPointMassdV;
+
+  /// \brief Body forces.
+  PointMassArray mPointMassF;
+
+  /// \brief Bias forces.
+  PointMassArray mPointMassB;
+
+  /// \brief External forces.
+  PointMassArray mPointMassFext;
+
+  /// \brief Generalized positions of the point masses.
+  PointMassArray mPointMassQ;
+
+  /// \brief Generalized velocities of the point masses.
+  PointMassArray mPointMassdQ;
+
+  /// \brief Generalized accelerations of the point masses.
+  PointMassArray mPointMassddQ;
+
+  /// \brief Generalized forces of the point masses.
+  PointMassArray mPointMassTau;
+
+  /// \brief Masses of the point masses.
+  Eigen::VectorXd mPointMassMasses;
+
+  /// \brief
+  Eigen::VectorXd mPointMassPsi;
+
+  /// \brief
+  Eigen::VectorXd mPointMassImplicitPsi;
+
+  /// \brief
+  Eigen::VectorXd mPointMassPi;
+
+  /// \brief
+  Eigen::VectorXd mPointMassImplicitPi;
+
+  /// \brief Number of connected point masses of each point mass.
+  Eigen::VectorXd mPointMassNumConnections;
+
+  /// \brief Offsets into mPointMassConnections for each point mass (size of
+  ///        the number of point masses + 1).
+  std::vector<int> mPointMassConnectionOffsets;
+
+  /// \brief Indices of the connected point masses.
+  std::vector<int> mPointMassConnections;
+
+  /// \brief Point mass part of the articulated inertia of each chunk of point
+  ///        masses.
+  std::vector<Eigen::Matrix6d, Eigen::aligned_allocator<Eigen::Matrix6d> >
+      mPointMassChunkInertias;
+
+  /// \brief Sum of the point mass forces of each chunk of point masses.
+  std::vector<Eigen::Vector6d, Eigen::aligned_allocator<Eigen::Vector6d> >
+      mPointMassChunkForces;
+
+  /// \brief Right hand side of the implicit point mass accelerations.
+  PointMassArray mImplicitRhs;
+
+  /// \brief Residual of the conjugate gradient solver.
+  PointMassArray mImplicitResidual;
+
+  /// \brief Preconditioned residual of the conjugate gradient solver.
+  PointMassArray mImplicitPrecondResidual;
+
+  /// \brief Search direction of the conjugate gradient solver.
+  PointMassArray mImplicitDirection;
+
+  /// \brief Implicit matrix times the search direction.
+  PointMassArray mImplicitMatrixDirection;
+
+private:
+  /// \brief Allocate the contiguous point mass state, copy the current point
+  ///        mass values into it and make the point masses view it.
+  void _mapPointMassState();
+
+  /// \brief Gather one generalized coordinate quantity of the point masses
+  ///        [_begin, _begin + _size) into the same rows of _values.
+  void _gatherPointMassGenCoords(double (GenCoord::*_get)() const,
+                                 int _begin, int _size,
+                                 PointMassArray* _values) const;
+
+  /// \brief Return the sum of the spatial inertias of the point masses
+  ///        scaled by _Pi, i.e., the point mass part of the articulated
+  ///        inertia.
+  Eigen::Matrix6d _getPointMassInertia(const Eigen::VectorXd& _Pi);
+
+  /// \brief Return the spatial force of this body node equivalent to the
+  ///        linear forces _f applied at the point masses.
+  Eigen::Vector6d _sumPointMassForces(const PointMassArray& _f);
+
+  /// \brief Multiply _x by the sparse matrix of the implicit point mass
+  ///        accelerations, (m + h*d + h^2*(kv + n*ke)) on the diagonal and
+  ///        -h^2*ke for each pair of connected point masses.
+  void _multiplyImplicitMatrix(const PointMassArray& _x, double _timeStep,
+                               PointMassArray* _result) const;
+
+  /// \brief Solve the implicit point mass accelerations for the right hand
+  ///        side in mImplicitRhs into mPointMassddQ by the Jacobi
+  ///        preconditioned conjugate gradient method, warm started from the
+  ///        current mPointMassddQ.
+  void _solveImplicitAccelerations(double _timeStep);
 };
 
 class SoftBodyNodeHelper
@@ -65,6 +65,12 @@ const aiMesh* SoftMeshShape::getAssimpMesh() const
   return mAssimpMesh;
 }
 
+const Eigen::Matrix<double, Eigen::Dynamic, 3>&
+SoftMeshShape::getVertices() const
+{
+  return mSoftBodyNode->getPointMassPositions();
+}
+
 Eigen::Matrix3d SoftMeshShape::computeInertia(double _mass) const
 {
   // TODO(JS): Not implemented.
@@ -123,15 +129,12 @@ void SoftMeshShape::_buildMesh()
 
 void SoftMeshShape::update()
 {
-  int nVertices = mSoftBodyNode->getNumPointMasses();
+  const Eigen::Matrix<double, Eigen::Dynamic, 3>& vertices = getVertices();
 
-  aiVector3D itAIVector3d;
-  for (int i = 0; i < nVertices; ++i)
+  for (int i = 0; i < vertices.rows(); ++i)
   {
-    PointMass* itPointMass        = mSoftBodyNode->getPointMass(i);
-    const Eigen::Vector3d& vertex = itPointMass->getLocalPosition();
-    itAIVector3d.Set(vertex[0], vertex[1], vertex[2]);
-    mAssimpMesh->mVertices[i] = itAIVector3d;
+    mAssimpMesh->mVertices[i].Set(vertices(i, 0), vertices(i, 1),
+                                  vertices(i, 2));
   }
 }
 
@@ -59,7 +59,15 @@ public:
   /// \brief
   const aiMesh* getAssimpMesh() const;
 
-  /// \brief Update positions of the vertices using the parent soft body node.
+  /// \brief Get the current local positions of the vertices with one row per
+  ///        vertex. The positions are those of the point masses of the parent
+  ///        soft body node, shared without copying.
+  const Eigen::Matrix<double, Eigen::Dynamic, 3>& getVertices() const;
+
+  /// \brief Copy the current positions of the vertices into the aiMesh.
+  ///
+  /// Collision and rendering read getVertices() directly, so this is only
+  /// needed by users of the vertices of getAssimpMesh().
   void update();
 
   // Documentation inherited.
@@ -45,23 +45,34 @@ namespace dart {
 namespace dynamics {
 
 TranslationalJoint::TranslationalJoint(const std::string& _name)
-  : Joint(_name)
+  : MultiDofJoint<3>(_name)
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-  mGenCoords.push_back(&mCoordinate[2]);
-
-  mS = Eigen::Matrix<double, 6, 3>::Zero();
-  mdS = Eigen::Matrix<double, 6, 3>::Zero();
-
-  mSpringStiffness.resize(3, 0.0);
-  mDampingCoefficient.resize(3, 0.0);
-  mRestPosition.resize(3, 0.0);
 }
 
 TranslationalJoint::~TranslationalJoint() {
 }
 
+void TranslationalJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                                const Eigen::VectorXd& _genVels,
+                                                Eigen::Isometry3d* _T,
+                                                math::Jacobian* _S,
+                                                math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 3 && _genVels.size() == 3);
+
+  *_T = mT_ParentBodyToJoint
+        * Eigen::Translation3d(Eigen::Vector3d(_configs))
+        * mT_ChildBodyToJoint.inverse();
+  _S->resize(6, 3);
+  for (int i = 0; i < 3; ++i)
+  {
+    Eigen::Vector6d J = Eigen::Vector6d::Zero();
+    J[3 + i] = 1.0;
+    _S->col(i) = math::AdT(mT_ChildBodyToJoint, J);
+  }
+  _dS->setZero(6, 3);
+}
+
 void TranslationalJoint::updateTransform() {
   mT = mT_ParentBodyToJoint
        * Eigen::Translation3d(getConfigs())
@@ -69,7 +80,32 @@ void TranslationalJoint::updateTransform() {
   assert(math::verifyTransform(mT));
 }
 
-void TranslationalJoint::updateJacobian() {
+void TranslationalJoint::computeLocalTransforms(
+    const Eigen::MatrixXd& _configs, Eigen::MatrixXd* _transforms) const {
+  assert(_transforms != NULL);
+
+  // Only the translation depends on q: M0 + R * q
+  const Eigen::Matrix<double, 3, 4> M0
+      = (mT_ParentBodyToJoint * mT_ChildBodyToJoint.inverse())
+        .matrix().topRows<3>();
+  const Eigen::Matrix3d R = mT_ParentBodyToJoint.linear();
+
+  const int numSamples = _configs.rows();
+
+  _transforms->resize(numSamples, 12);
+  for (int i = 0; i < 9; ++i)
+    _transforms->col(i).setConstant(M0(i));
+  for (int i = 0; i < 3; ++i) {
+    _transforms->col(9 + i).setConstant(M0(9 + i));
+    for (int j = 0; j < 3; ++j) {
+      _transforms->col(9 + i).array()
+          += R(i, j)
+             * _configs.col(mCoordinate[j].getSkeletonIndex()).array();
+    }
+  }
+}
+
+void TranslationalJoint::updateLocalJacobian() {
   Eigen::Vector6d J0;
   Eigen::Vector6d J1;
   Eigen::Vector6d J2;
@@ -78,16 +114,16 @@ void TranslationalJoint::updateJacobian() {
   J1 << 0, 0, 0, 0, 1, 0;
   J2 << 0, 0, 0, 0, 0, 1;
 
-  mS.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
-  mS.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
-  mS.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
+  mJacobian.col(0) = math::AdT(mT_ChildBodyToJoint, J0);
+  mJacobian.col(1) = math::AdT(mT_ChildBodyToJoint, J1);
+  mJacobian.col(2) = math::AdT(mT_ChildBodyToJoint, J2);
 
-  assert(!math::isNan(mS));
+  assert(!math::isNan(mJacobian));
 }
 
-void TranslationalJoint::updateJacobianTimeDeriv() {
-  // mdS.setZero();
-  assert(mdS == math::Jacobian::Zero(6, 3));
+void TranslationalJoint::updateLocalJacobianTimeDeriv() {
+  // mJacobianDeriv.setZero();
+  assert(mJacobianDeriv == JacobianMatrix::Zero());
 }
 
 }  // namespace dynamics
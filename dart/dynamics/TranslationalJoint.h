@@ -39,13 +39,12 @@
 
 #include <string>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
-class TranslationalJoint : public Joint {
+class TranslationalJoint : public MultiDofJoint<3> {
 public:
   /// \brief Constructor.
   explicit TranslationalJoint(
@@ -54,19 +53,27 @@ public:
   /// \brief Destructor.
   virtual ~TranslationalJoint();
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
   // Documentation inherited.
-  virtual void updateJacobian();
+  virtual void computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                      Eigen::MatrixXd* _transforms) const;
 
   // Documentation inherited.
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobian();
 
-protected:
-  /// \brief
-  GenCoord mCoordinate[3];
+  // Documentation inherited.
+  virtual void updateLocalJacobianTimeDeriv();
 
+protected:
 public:
   // To get byte-aligned Eigen vectors
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
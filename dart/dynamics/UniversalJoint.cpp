@@ -47,18 +47,8 @@ namespace dynamics {
 UniversalJoint::UniversalJoint(const Eigen::Vector3d& _axis0,
                                const Eigen::Vector3d& _axis1,
                                const std::string& _name)
-  : Joint(_name)
+  : MultiDofJoint<2>(_name)
 {
-  mGenCoords.push_back(&mCoordinate[0]);
-  mGenCoords.push_back(&mCoordinate[1]);
-
-  mS = Eigen::Matrix<double, 6, 2>::Zero();
-  mdS = Eigen::Matrix<double, 6, 2>::Zero();
-
-  mSpringStiffness.resize(2, 0.0);
-  mDampingCoefficient.resize(2, 0.0);
-  mRestPosition.resize(2, 0.0);
-
   mAxis[0] = _axis0.normalized();
   mAxis[1] = _axis1.normalized();
 }
@@ -82,6 +72,28 @@ const Eigen::Vector3d& UniversalJoint::getAxis2() const {
   return mAxis[1];
 }
 
+void UniversalJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                            const Eigen::VectorXd& _genVels,
+                                            Eigen::Isometry3d* _T,
+                                            math::Jacobian* _S,
+                                            math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 2 && _genVels.size() == 2);
+
+  *_T = mT_ParentBodyToJoint
+        * Eigen::AngleAxisd(_configs[0], mAxis[0])
+        * Eigen::AngleAxisd(_configs[1], mAxis[1])
+        * mT_ChildBodyToJoint.inverse();
+  _S->resize(6, 2);
+  _S->col(0) = math::AdTAngular(mT_ChildBodyToJoint
+                                * math::expAngular(-mAxis[1] * _configs[1]),
+                                mAxis[0]);
+  _S->col(1) = math::AdTAngular(mT_ChildBodyToJoint, mAxis[1]);
+  _dS->resize(6, 2);
+  _dS->col(0) = -math::ad(_S->col(1) * _genVels[1], _S->col(0));
+  _dS->col(1).setZero();
+}
+
 void UniversalJoint::updateTransform() {
   mT = mT_ParentBodyToJoint
        * Eigen::AngleAxisd(mCoordinate[0].getPos(), mAxis[0])
@@ -90,22 +102,24 @@ void UniversalJoint::updateTransform() {
   assert(math::verifyTransform(mT));
 }
 
-void UniversalJoint::updateJacobian() {
-  mS.col(0) =  math::AdTAngular(mT_ChildBodyToJoint
-                                * math::expAngular(
-                                  -mAxis[1]*mCoordinate[1].getPos()), mAxis[0]);
-  mS.col(1) = math::AdTAngular(mT_ChildBodyToJoint, mAxis[1]);
-  assert(!math::isNan(mS));
+void UniversalJoint::updateLocalJacobian() {
+  mJacobian.col(0) = math::AdTAngular(mT_ChildBodyToJoint
+                                       * math::expAngular(
+                                         -mAxis[1]*mCoordinate[1].getPos()),
+                                       mAxis[0]);
+  mJacobian.col(1) = math::AdTAngular(mT_ChildBodyToJoint, mAxis[1]);
+  assert(!math::isNan(mJacobian));
 }
 
-void UniversalJoint::updateJacobianTimeDeriv() {
-  mdS.col(0) = -math::ad(mS.col(1)*mCoordinate[1].getVel(),
-                         math::AdTAngular(mT_ChildBodyToJoint
-                         * math::expAngular(-mAxis[1]*mCoordinate[1].getPos()),
-                                            mAxis[0]));
-  // mdS.col(1) = setZero();
-  assert(!math::isNan(mdS.col(0)));
-  assert(mdS.col(1) == Eigen::Vector6d::Zero());
+void UniversalJoint::updateLocalJacobianTimeDeriv() {
+  mJacobianDeriv.col(0)
+      = -math::ad(mJacobian.col(1)*mCoordinate[1].getVel(),
+                  math::AdTAngular(mT_ChildBodyToJoint
+                  * math::expAngular(-mAxis[1]*mCoordinate[1].getPos()),
+                                   mAxis[0]));
+  // mJacobianDeriv.col(1) = setZero();
+  assert(!math::isNan(mJacobianDeriv.col(0)));
+  assert(mJacobianDeriv.col(1) == Eigen::Vector6d::Zero());
 }
 
 }  // namespace dynamics
@@ -41,13 +41,12 @@
 
 #include <Eigen/Dense>
 
-#include "dart/dynamics/GenCoord.h"
-#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/MultiDofJoint.h"
 
 namespace dart {
 namespace dynamics {
 
-class UniversalJoint : public Joint {
+class UniversalJoint : public MultiDofJoint<2> {
 public:
   /// \brief Constructor.
   UniversalJoint(const Eigen::Vector3d& _axis0 = Eigen::Vector3d(1.0, 0.0, 0.0),
@@ -69,19 +68,23 @@ public:
   /// \brief
   const Eigen::Vector3d& getAxis2() const;
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
   // Documentation inherited.
-  virtual void updateJacobian();
+  virtual void updateLocalJacobian();
 
   // Documentation inherited.
-  virtual void updateJacobianTimeDeriv();
+  virtual void updateLocalJacobianTimeDeriv();
 
 protected:
-  /// \brief Euler angles X, Y, Z
-  GenCoord mCoordinate[2];
-
   /// \brief Rotational axis.
   Eigen::Vector3d mAxis[2];
 
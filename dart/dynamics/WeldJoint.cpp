@@ -54,11 +54,37 @@ WeldJoint::WeldJoint(const std::string& _name)
 WeldJoint::~WeldJoint() {
 }
 
+void WeldJoint::computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                       const Eigen::VectorXd& _genVels,
+                                       Eigen::Isometry3d* _T,
+                                       math::Jacobian* _S,
+                                       math::Jacobian* _dS) const {
+  assert(_T != NULL && _S != NULL && _dS != NULL);
+  assert(_configs.size() == 0 && _genVels.size() == 0);
+
+  *_T = mT_ParentBodyToJoint * mT_ChildBodyToJoint.inverse();
+  _S->resize(6, 0);
+  _dS->resize(6, 0);
+}
+
 void WeldJoint::updateTransform() {
   // T
   mT = mT_ParentBodyToJoint * mT_ChildBodyToJoint.inverse();
 }
 
+void WeldJoint::computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                       Eigen::MatrixXd* _transforms) const {
+  assert(_transforms != NULL);
+
+  const Eigen::Matrix<double, 3, 4> M
+      = (mT_ParentBodyToJoint * mT_ChildBodyToJoint.inverse())
+        .matrix().topRows<3>();
+
+  _transforms->resize(_configs.rows(), 12);
+  for (int i = 0; i < 12; ++i)
+    _transforms->col(i).setConstant(M(i));
+}
+
 void WeldJoint::updateJacobian() {
   // Do nothing
 }
@@ -55,9 +55,20 @@ public:
   /// \brief Destructor.
   virtual ~WeldJoint();
 
+  // Documentation inherited.
+  virtual void computeLocalKinematics(const Eigen::VectorXd& _configs,
+                                      const Eigen::VectorXd& _genVels,
+                                      Eigen::Isometry3d* _T,
+                                      math::Jacobian* _S,
+                                      math::Jacobian* _dS) const;
+
   // Documentation inherited.
   virtual void updateTransform();
 
+  // Documentation inherited.
+  virtual void computeLocalTransforms(const Eigen::MatrixXd& _configs,
+                                      Eigen::MatrixXd* _transforms) const;
+
   // Documentation inherited.
   virtual void updateJacobian();
 
@@ -54,20 +54,22 @@ EulerIntegrator::~EulerIntegrator()
 //==============================================================================
 void EulerIntegrator::integrate(IntegrableSystem* _system, double _dt)
 {
-  _system->integrateConfigs(_system->getGenVels(), _dt);
-  _system->integrateGenVels(_system->evalGenAccs(), _dt);
+  integratePos(_system, _dt);
+  integrateVel(_system, _dt);
 }
 
 //==============================================================================
 void EulerIntegrator::integratePos(IntegrableSystem* _system, double _dt)
 {
-  _system->integrateConfigs(_system->getGenVels(), _dt);
+  _system->getGenVels(&mGenVels);
+  _system->integrateConfigs(mGenVels, _dt);
 }
 
 //==============================================================================
 void EulerIntegrator::integrateVel(IntegrableSystem* _system, double _dt)
 {
-  _system->integrateGenVels(_system->evalGenAccs(), _dt);
+  _system->evalGenAccs(&mGenAccs);
+  _system->integrateGenVels(mGenAccs, _dt);
 }
 
 }  // namespace integration
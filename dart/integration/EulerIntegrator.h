@@ -61,6 +61,13 @@ public:
 
   // Documentation inherited
   virtual void integrateVel(IntegrableSystem* _system, double _dt);
+
+private:
+  /// \brief Cache data for generalized velocities
+  Eigen::VectorXd mGenVels;
+
+  /// \brief Cache data for generalized accelerations
+  Eigen::VectorXd mGenAccs;
 };
 
 }  // namespace integration
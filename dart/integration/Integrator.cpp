@@ -50,6 +50,24 @@ IntegrableSystem::~IntegrableSystem()
 {
 }
 
+//==============================================================================
+void IntegrableSystem::getConfigs(Eigen::VectorXd* _configs) const
+{
+  *_configs = getConfigs();
+}
+
+//==============================================================================
+void IntegrableSystem::getGenVels(Eigen::VectorXd* _genVels) const
+{
+  *_genVels = getGenVels();
+}
+
+//==============================================================================
+void IntegrableSystem::evalGenAccs(Eigen::VectorXd* _genAccs)
+{
+  *_genAccs = evalGenAccs();
+}
+
 //==============================================================================
 Integrator::Integrator()
 {
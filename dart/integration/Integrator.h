@@ -78,6 +78,22 @@ public:
   /// \brief Integrate generalized velocities and store them in the system
   virtual void integrateGenVels(const Eigen::VectorXd& _genVels,
                                 double _dt) = 0;
+
+  //----------------------------------------------------------------------------
+  // In-place variants used by the integrators. They write into _configs,
+  // _genVels and _genAccs, which are resized only when the number of
+  // generalized coordinates changes, so that integration does not allocate
+  // once the buffers have the right size. The default implementations copy
+  // the results of the variants above.
+  //----------------------------------------------------------------------------
+  /// \brief Get configurations into _configs
+  virtual void getConfigs(Eigen::VectorXd* _configs) const;
+
+  /// \brief Get generalized velocities into _genVels
+  virtual void getGenVels(Eigen::VectorXd* _genVels) const;
+
+  /// \brief Evaulate generalized accelerations into _genAccs
+  virtual void evalGenAccs(Eigen::VectorXd* _genAccs);
 };
 
 // TODO(kasiu): Consider templating the class (which currently only works on
@@ -57,9 +57,9 @@ void RK4Integrator::integrate(IntegrableSystem* _system, double _dt)
 {
   //----------------------------------------------------------------------------
   // compute ddq1
-  q1   = _system->getConfigs();
-  dq1  = _system->getGenVels();
-  ddq1 = _system->evalGenAccs();
+  _system->getConfigs(&q1);
+  _system->getGenVels(&dq1);
+  _system->evalGenAccs(&ddq1);
 
   //----------------------------------------------------------------------------
   // q2 = q1 + dq1 * 0.5 * _dt
@@ -69,8 +69,8 @@ void RK4Integrator::integrate(IntegrableSystem* _system, double _dt)
   _system->integrateGenVels(ddq1, 0.5 * _dt);
 
   // compute ddq2
-  dq2  = _system->getGenVels();
-  ddq2 = _system->evalGenAccs();
+  _system->getGenVels(&dq2);
+  _system->evalGenAccs(&ddq2);
 
   //----------------------------------------------------------------------------
   // q3 = q1 + dq2 * 0.5 * _dt
@@ -82,8 +82,8 @@ void RK4Integrator::integrate(IntegrableSystem* _system, double _dt)
   _system->integrateGenVels(ddq2, 0.5 * _dt);
 
   // compute ddq3
-  dq3  = _system->getGenVels();
-  ddq3 = _system->evalGenAccs();
+  _system->getGenVels(&dq3);
+  _system->evalGenAccs(&ddq3);
 
   //----------------------------------------------------------------------------
   // q4 = q1 + dq3 * _dt
@@ -94,21 +94,21 @@ void RK4Integrator::integrate(IntegrableSystem* _system, double _dt)
   _system->integrateGenVels(ddq3, _dt);
 
   // compute ddq4
-  dq4  = _system->getGenVels();
-  ddq4 = _system->evalGenAccs();
+  _system->getGenVels(&dq4);
+  _system->evalGenAccs(&ddq4);
 
   //----------------------------------------------------------------------------
   // q = q1 + dq5 * _dt
   //   where dq5 = (1/6) * (dq1 + (2.0 * dq2) + (2.0 * dq3) + dq4)
+  dq5 = DART_1_6 * (dq1 + (2.0 * dq2) + (2.0 * dq3) + dq4);
   _system->setConfigs(q1);
-  _system->integrateConfigs(
-        DART_1_6 * (dq1 + (2.0 * dq2) + (2.0 * dq3) + dq4), _dt);
+  _system->integrateConfigs(dq5, _dt);
 
   // dq = dq1 + ddq5 * _dt
   //   where dq5 = (1/6) * (ddq1 + (2.0 * ddq2) + (2.0 * ddq3) + ddq4)
+  ddq5 = DART_1_6 * (ddq1 + (2.0 * ddq2) + (2.0 * ddq3) + ddq4);
   _system->setGenVels(dq1);
-  _system->integrateGenVels(
-        DART_1_6 * (ddq1 + (2.0 * ddq2) + (2.0 * ddq3) + ddq4), _dt);
+  _system->integrateGenVels(ddq5, _dt);
 }
 
 }  // namespace integration
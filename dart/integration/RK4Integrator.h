@@ -65,6 +65,10 @@ private:
 
   /// \brief Chache data for generalized accelerations
   Eigen::VectorXd ddq1, ddq2, ddq3, ddq4;
+
+  /// \brief Chache data for the weighted sums of the generalized velocities
+  ///        and accelerations
+  Eigen::VectorXd dq5, ddq5;
 };
 
 }  // namespace integration
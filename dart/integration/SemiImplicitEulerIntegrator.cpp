@@ -55,22 +55,24 @@ SemiImplicitEulerIntegrator::~SemiImplicitEulerIntegrator()
 void SemiImplicitEulerIntegrator::integrate(IntegrableSystem* _system,
                                             double _dt)
 {
-  _system->integrateGenVels(_system->evalGenAccs(), _dt);
-  _system->integrateConfigs(_system->getGenVels(), _dt);
+  integrateVel(_system, _dt);
+  integratePos(_system, _dt);
 }
 
 //==============================================================================
 void SemiImplicitEulerIntegrator::integratePos(IntegrableSystem* _system,
                                                double _dt)
 {
-  _system->integrateConfigs(_system->getGenVels(), _dt);
+  _system->getGenVels(&mGenVels);
+  _system->integrateConfigs(mGenVels, _dt);
 }
 
 //==============================================================================
 void SemiImplicitEulerIntegrator::integrateVel(IntegrableSystem* _system,
                                                double _dt)
 {
-  _system->integrateGenVels(_system->evalGenAccs(), _dt);
+  _system->evalGenAccs(&mGenAccs);
+  _system->integrateGenVels(mGenAccs, _dt);
 }
 
 }  // namespace integration
@@ -59,7 +59,7 @@ bool LCPSolver::Solve(const Eigen::MatrixXd& _A,
                       int _numDir,
                       bool _bUseODESolver) {
   if (!_bUseODESolver) {
-    int err = Lemke(_A, _b, _x);
+    int err = mLemkeSolver.solve(_A, _b, _x);
     return (err == 0);
   } else {
     assert(_numDir >= 4);
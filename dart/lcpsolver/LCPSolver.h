@@ -39,6 +39,8 @@
 
 #include "Eigen/Dense"
 
+#include "dart/lcpsolver/Lemke.h"
+
 namespace dart {
 namespace lcpsolver {
 
@@ -79,6 +81,9 @@ private:
   bool checkIfSolution(const Eigen::MatrixXd& _A,
                        const Eigen::VectorXd& _b,
                        const Eigen::VectorXd& _x);
+
+  /// \brief Lemke workspace reused across calls to Solve()
+  LemkeSolver mLemkeSolver;
 };
 
 }  // namespace lcpsolver
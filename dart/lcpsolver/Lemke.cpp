@@ -37,6 +37,7 @@
 
 #include "dart/lcpsolver/Lemke.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -83,207 +84,320 @@ namespace lcpsolver {
 //  return temp;
 // }
 
-int Lemke(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q,
-          Eigen::VectorXd* _z) {
-  int n = _q.size();
+//==============================================================================
+LemkeSolver::LemkeSolver()
+  : mMaxPivots(1000),
+    mRefactorInterval(100),
+    mNumPivots(0),
+    mNumRefactorizations(0),
+    mLastError(LEMKE_SUCCESS) {
+}
 
-  const double zer_tol = 1e-5;
-  const double piv_tol = 1e-8;
-  int maxiter = 1000;
-  int err = 0;
+//==============================================================================
+LemkeSolver::~LemkeSolver() {
+}
 
-  if (_q.minCoeff() > 0) {
-    // LOG(INFO) << "Trivial solution exists.";
-    *_z = Eigen::VectorXd::Zero(n);
-    return err;
+//==============================================================================
+void LemkeSolver::reserve(int _n) {
+  if (mBInv.rows() < _n) {
+    mBInv.resize(_n, _n);
+    mB.resize(_n, _n);
+    mX.resize(_n);
+    mD.resize(_n);
+    mBe.resize(_n);
+    mCover.resize(_n);
+    mPivotRow.resize(_n);
   }
+  mBasis.reserve(_n);
+  mCandidates.reserve(_n);
+}
 
-  *_z = Eigen::VectorXd::Zero(2 * n);
-  int iter = 0;
-  double theta = 0;
-  double ratio = 0;
-  int leaving  = 0;
-  Eigen::VectorXd Be = Eigen::VectorXd::Constant(n, 1);
-  Eigen::VectorXd x = _q;
-  std::vector<int> bas;
-  std::vector<int> nonbas;
+//==============================================================================
+int LemkeSolver::solve(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q,
+                       Eigen::VectorXd* _z) {
+  const int n = _q.size();
 
-  int t = 2 * n + 1;
-  int entering = t;
+  const double zer_tol = 1e-5;
+  const double piv_tol = 1e-8;
 
-  bas.clear();
-  nonbas.clear();
+  mNumPivots = 0;
+  mNumRefactorizations = 0;
+  mLastError = LEMKE_SUCCESS;
 
-  for (int i = 0; i < n; ++i) {
-    bas.push_back(i);
+  if (n == 0 || _q.minCoeff() >= 0) {
+    // Trivial solution exists.
+    _z->setZero(n);
+    return mLastError;
   }
 
-  Eigen::MatrixXd B = -Eigen::MatrixXd::Identity(n, n);
+  reserve(n);
 
-  for (int i = 0; i < bas.size(); ++i) {
-    B.col(bas[i]) = _M.col(bas[i]);
-  }
+  Eigen::Block<Eigen::MatrixXd> BInv = mBInv.topLeftCorner(n, n);
+  Eigen::VectorBlock<Eigen::VectorXd> x = mX.head(n);
+  Eigen::VectorBlock<Eigen::VectorXd> d = mD.head(n);
+  Eigen::VectorBlock<Eigen::VectorXd> Be = mBe.head(n);
+  Eigen::VectorBlock<Eigen::VectorXd> U = mCover.head(n);
 
-  x = -B.partialPivLu().solve(_q);
+  // Start from the basis of all w, B = -I, so that B * x = -q gives x = q
+  const int t = 2 * n;
+  mBasis.resize(n);
+  for (int i = 0; i < n; ++i)
+    mBasis[i] = n + i;
+  BInv = -Eigen::MatrixXd::Identity(n, n);
+  x = _q;
 
-  Eigen::VectorXd minuxX = -x;
+  // Pivot in the artificial variable covering all negative rows
   int lvindex;
-  double tval = minuxX.maxCoeff(&lvindex);
-  leaving = bas[lvindex];
-  bas[lvindex] = t;
+  double tval = (-x).maxCoeff(&lvindex);
+  int leaving = mBasis[lvindex];
+  mBasis[lvindex] = t;
 
-  Eigen::VectorXd U = Eigen::VectorXd::Zero(n);
-  for (int i = 0; i < n; ++i) {
-    if (x[i] < 0)
-      U[i] = 1;
-  }
-  Be = -(B * U);
+  for (int i = 0; i < n; ++i)
+    U[i] = (x[i] < 0) ? 1.0 : 0.0;
   x += tval * U;
   x[lvindex] = tval;
-  B.col(lvindex) = Be;
+  d.noalias() = BInv * U;
+  updateInverse(n, lvindex);
 
-  for (iter = 0; iter < maxiter; ++iter) {
-    if (leaving == t) {
+  int entering;
+  while (leaving != t) {
+    if (mNumPivots >= mMaxPivots) {
+      mLastError = LEMKE_MAX_PIVOTS;
       break;
-    } else if (leaving < n) {
+    }
+
+    if (leaving < n) {
       entering = n + leaving;
-      Be = Eigen::VectorXd::Zero(n);
-      Be[leaving] = -1;
+      d = -BInv.col(leaving);
     } else {
       entering = leaving - n;
       Be = _M.col(entering);
+      d.noalias() = BInv * Be;
     }
 
-    Eigen::VectorXd d = B.partialPivLu().solve(Be);
-
-    std::vector<int> j;
+    // Minimum ratio test over the rows with a positive pivot
+    double theta = 0.0;
+    mCandidates.clear();
     for (int i = 0; i < n; ++i) {
-      if (d[i] > piv_tol)
-        j.push_back(i);
-    }
-    if (j.empty()) {
-      // err = 2;
-      break;
-    }
-
-    int jSize = static_cast<int>(j.size());
-    Eigen::VectorXd minRatio(jSize);
-    for (int i = 0; i < jSize; ++i) {
-      minRatio[i] = (x[j[i]] + zer_tol) / d[j[i]];
-    }
-    double theta = minRatio.minCoeff();
-
-    std::vector<int> tmpJ;
-    std::vector<double> tmpMinRatio;
-    for (int i = 0; i < jSize; ++i) {
-      if (x[j[i]] / d[j[i]] <= theta) {
-        tmpJ.push_back(j[i]);
-        tmpMinRatio.push_back(minRatio[i]);
+      if (d[i] > piv_tol) {
+        double ratio = (x[i] + zer_tol) / d[i];
+        if (mCandidates.empty() || ratio < theta)
+          theta = ratio;
+        mCandidates.push_back(i);
       }
     }
-//    if (tmpJ.empty())
-//    {
-//      LOG(WARNING) << "tmpJ should never be empty!!!";
-//      LOG(WARNING) << "dumping data:";
-//      LOG(WARNING) << "theta:" << theta;
-//      for (int i = 0; i < jSize; ++i)
-//      {
-//        LOG(WARNING) << "x(" << j[i] << "): " << x[j[i]] << "d: " << d[j[i]];
-//      }
-//    }
-
-    j = tmpJ;
-    jSize = static_cast<int>(j.size());
-    if (jSize == 0) {
-      err = 4;
+    if (mCandidates.empty()) {
+      mLastError = LEMKE_UNBOUNDED_RAY;
       break;
     }
-    lvindex = -1;
 
-    for (int i = 0; i < jSize; ++i) {
-      if (bas[j[i]] == t)
+    // Among the ties, let the artificial variable leave if it can. Otherwise
+    // take the largest pivot, which also keeps the rank-1 update stable.
+    lvindex = -1;
+    double maxPivot = 0.0;
+    for (size_t k = 0; k < mCandidates.size(); ++k) {
+      const int i = mCandidates[k];
+      if (x[i] / d[i] > theta)
+        continue;
+      if (mBasis[i] == t) {
+        lvindex = i;
+        break;
+      }
+      if (d[i] > maxPivot) {
+        maxPivot = d[i];
         lvindex = i;
-    }
-    if (lvindex != -1) {
-      lvindex = j[lvindex];
-    } else {
-      theta = tmpMinRatio[0];
-      lvindex = 0;
-
-      for (int i = 0; i < jSize; ++i) {
-        if (tmpMinRatio[i]-theta > piv_tol) {
-          theta = tmpMinRatio[i];
-          lvindex = i;
-        }
       }
-      lvindex = j[lvindex];
+    }
+    if (lvindex == -1) {
+      mLastError = LEMKE_DIVERGED;
+      break;
     }
 
-    leaving = bas[lvindex];
-
-    ratio = x[lvindex] / d[lvindex];
+    leaving = mBasis[lvindex];
+    double ratio = x[lvindex] / d[lvindex];
 
-    bool bDiverged = false;
-    for (int i = 0; i < n; ++i) {
-      if (isnan(x[i]) || isinf(x[i])) {
+    bool bDiverged = isnan(ratio) || isinf(ratio);
+    for (int i = 0; i < n && !bDiverged; ++i) {
+      if (isnan(x[i]) || isinf(x[i]))
         bDiverged = true;
-        break;
-      }
     }
     if (bDiverged) {
-      err = 4;
+      mLastError = LEMKE_DIVERGED;
       break;
     }
-    x = x - ratio * d;
+
+    x -= ratio * d;
     x[lvindex] = ratio;
-    B.col(lvindex) = Be;
-    bas[lvindex] = entering;
+    mBasis[lvindex] = entering;
+    updateInverse(n, lvindex);
+    ++mNumPivots;
+
+    if (mRefactorInterval > 0 && mNumPivots % mRefactorInterval == 0
+        && leaving != t && !refactorize(_M, _q)) {
+      mLastError = LEMKE_SINGULAR_BASIS;
+      break;
+    }
   }
 
-  if (iter >= maxiter && leaving != t)
-    err = 1;
+  _z->setZero(n);
 
-  if (err == 0) {
-    for (size_t i = 0; i < bas.size(); ++i) {
-      if (bas[i] < _z->size()) {
-        (*_z)[bas[i]] = x[i];
-      }
+  if (mLastError == LEMKE_SUCCESS) {
+    for (int i = 0; i < n; ++i) {
+      if (mBasis[i] < n)
+        (*_z)[mBasis[i]] = x[i];
     }
 
-    Eigen::VectorXd realZ = _z->segment(0, n);
-    *_z = realZ;
+    if (!validate(_M, *_z, _q))
+      mLastError = LEMKE_VALIDATION_FAILED;
+  }
+
+  return mLastError;
+}
+
+//==============================================================================
+void LemkeSolver::setMaxPivots(int _maxPivots) {
+  mMaxPivots = _maxPivots;
+}
+
+//==============================================================================
+int LemkeSolver::getMaxPivots() const {
+  return mMaxPivots;
+}
+
+//==============================================================================
+void LemkeSolver::setRefactorInterval(int _interval) {
+  mRefactorInterval = _interval;
+}
+
+//==============================================================================
+int LemkeSolver::getRefactorInterval() const {
+  return mRefactorInterval;
+}
+
+//==============================================================================
+int LemkeSolver::getNumPivots() const {
+  return mNumPivots;
+}
+
+//==============================================================================
+int LemkeSolver::getNumRefactorizations() const {
+  return mNumRefactorizations;
+}
+
+//==============================================================================
+int LemkeSolver::getLastError() const {
+  return mLastError;
+}
+
+//==============================================================================
+const char* LemkeSolver::getErrorString(int _error) {
+  switch (_error) {
+    case LEMKE_SUCCESS:
+      return "success";
+    case LEMKE_MAX_PIVOTS:
+      return "pivot limit exceeded";
+    case LEMKE_UNBOUNDED_RAY:
+      return "unbounded ray";
+    case LEMKE_VALIDATION_FAILED:
+      return "converged with numerical issues, validation failed";
+    case LEMKE_DIVERGED:
+      return "iteration diverged";
+    case LEMKE_SINGULAR_BASIS:
+      return "singular basis in refactorization";
+    default:
+      return "unknown error";
+  }
+}
 
-    if (!validate(_M, *_z, _q)) {
-      // _z = VectorXd::Zero(n);
-      err = 3;
+//==============================================================================
+void LemkeSolver::updateInverse(int _n, int _row) {
+  Eigen::Block<Eigen::MatrixXd> BInv = mBInv.topLeftCorner(_n, _n);
+  Eigen::VectorBlock<Eigen::VectorXd> d = mD.head(_n);
+  Eigen::VectorBlock<Eigen::VectorXd> p = mPivotRow.head(_n);
+
+  // Product form update, BInv <- E * BInv, where E is the eta matrix that
+  // maps d to e_row
+  p = BInv.row(_row).transpose() / d[_row];
+  BInv.noalias() -= d * p.transpose();
+  BInv.row(_row) = p.transpose();
+}
+
+//==============================================================================
+bool LemkeSolver::refactorize(const Eigen::MatrixXd& _M,
+                              const Eigen::VectorXd& _q) {
+  const int n = _q.size();
+
+  Eigen::Block<Eigen::MatrixXd> B = mB.topLeftCorner(n, n);
+  Eigen::Block<Eigen::MatrixXd> BInv = mBInv.topLeftCorner(n, n);
+  Eigen::VectorBlock<Eigen::VectorXd> x = mX.head(n);
+
+  for (int i = 0; i < n; ++i) {
+    const int index = mBasis[i];
+    if (index < n) {
+      B.col(i) = _M.col(index);
+    } else if (index < 2 * n) {
+      B.col(i).setZero();
+      B(index - n, i) = -1.0;
+    } else {
+      B.col(i) = mCover.head(n);
+    }
+  }
+
+  // Gauss-Jordan elimination with partial pivoting on [B | I] in the
+  // workspace, so that no temporary decomposition is allocated. A pivot that
+  // is negligible relative to the entries of B means a singular basis.
+  const double pivotTolerance = 1e-12 * std::max(1.0, B.cwiseAbs().maxCoeff());
+  BInv.setIdentity();
+  for (int k = 0; k < n; ++k) {
+    int pivot;
+    const double maxPivot = B.col(k).tail(n - k).cwiseAbs().maxCoeff(&pivot);
+    if (!(maxPivot > pivotTolerance))
+      return false;
+    pivot += k;
+    if (pivot != k) {
+      B.row(k).swap(B.row(pivot));
+      BInv.row(k).swap(BInv.row(pivot));
+    }
+
+    const double invPivot = 1.0 / B(k, k);
+    B.row(k) *= invPivot;
+    BInv.row(k) *= invPivot;
+    for (int i = 0; i < n; ++i) {
+      if (i == k || B(i, k) == 0.0)
+        continue;
+      const double factor = B(i, k);
+      B.row(i) -= factor * B.row(k);
+      BInv.row(i) -= factor * BInv.row(k);
     }
-  } else {
-    *_z = Eigen::VectorXd::Zero(n);  // solve failed, return a 0 vector
   }
 
-//  if (err == 1)
-//    LOG(ERROR) << "LCP Solver: Iterations exceeded limit";
-//  else if (err == 2)
-//    LOG(ERROR) << "LCP Solver: Unbounded ray";
-//  else if (err == 3)
-//    LOG(ERROR) << "LCP Solver: Solver converged with numerical issues. "
-//               << "Validation failed.";
-//  else if (err == 4)
-//    LOG(ERROR) << "LCP Solver: Iteration diverged.";
-
-  return err;
+  x.noalias() = BInv * _q;
+  x = -x;
+
+  ++mNumRefactorizations;
+
+  return true;
+}
+
+//==============================================================================
+int Lemke(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q,
+          Eigen::VectorXd* _z) {
+  LemkeSolver solver;
+  return solver.solve(_M, _q, _z);
 }
 
+//==============================================================================
 bool validate(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _z,
               const Eigen::VectorXd& _q) {
   const double threshold = 1e-4;
   int n = _z.size();
 
-  Eigen::VectorXd w = _M * _z + _q;
+  // One row at a time, so that no temporary w is allocated
   for (int i = 0; i < n; ++i) {
-    if (w(i) < -threshold || _z(i) < -threshold)
+    const double w = _M.row(i).dot(_z) + _q(i);
+    if (w < -threshold || _z(i) < -threshold)
       return false;
-    if (abs(w(i) * _z(i)) > threshold)
+    if (std::abs(w * _z(i)) > threshold)
       return false;
   }
   return true;
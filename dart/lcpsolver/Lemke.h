@@ -38,16 +38,133 @@
 #ifndef DART_LCPSOLVER_LEMKE_H_
 #define DART_LCPSOLVER_LEMKE_H_
 
+#include <vector>
+
 #include "Eigen/Dense"
 
 namespace dart {
 namespace lcpsolver {
 
-/// \brief
+/// \brief Error codes returned by Lemke() and LemkeSolver::solve()
+enum LemkeError {
+  LEMKE_SUCCESS           = 0,
+  LEMKE_MAX_PIVOTS        = 1,
+  LEMKE_UNBOUNDED_RAY     = 2,
+  LEMKE_VALIDATION_FAILED = 3,
+  LEMKE_DIVERGED          = 4,
+  LEMKE_SINGULAR_BASIS    = 5
+};
+
+/// \brief Reusable workspace for Lemke's complementary pivoting algorithm
+///
+/// Solves the LCP w = M * z + q, w >= 0, z >= 0, z'w = 0. All storage is
+/// kept between calls and only grows, so repeated solves of problems up to
+/// the same size do not allocate. The basis inverse is updated in place with
+/// a rank-1 product form update at every pivot and refactorized from scratch
+/// every getRefactorInterval() pivots to bound round-off drift.
+class LemkeSolver {
+public:
+  /// \brief
+  LemkeSolver();
+
+  /// \brief
+  ~LemkeSolver();
+
+  /// \brief Preallocate storage for problems of dimension up to _n
+  void reserve(int _n);
+
+  /// \brief Solve the LCP and return one of LemkeError. On failure _z is set
+  /// to zero.
+  int solve(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q,
+            Eigen::VectorXd* _z);
+
+  /// \brief Set the maximum number of pivots before giving up with
+  /// LEMKE_MAX_PIVOTS
+  void setMaxPivots(int _maxPivots);
+
+  /// \brief
+  int getMaxPivots() const;
+
+  /// \brief Set the number of rank-1 updates between full refactorizations
+  /// of the basis inverse. Zero disables refactorization.
+  void setRefactorInterval(int _interval);
+
+  /// \brief
+  int getRefactorInterval() const;
+
+  /// \brief Number of pivots taken by the last solve
+  int getNumPivots() const;
+
+  /// \brief Number of basis refactorizations done by the last solve
+  int getNumRefactorizations() const;
+
+  /// \brief Error code of the last solve
+  int getLastError() const;
+
+  /// \brief Human readable description of a LemkeError
+  static const char* getErrorString(int _error);
+
+private:
+  /// \brief Replace basis column _row, whose direction in the current basis
+  /// is mD, and update the _n x _n basis inverse accordingly
+  void updateInverse(int _n, int _row);
+
+  /// \brief Rebuild the basis inverse and basic variables from the current
+  /// basis index set. Return false if the basis is numerically singular, in
+  /// which case the basis inverse and basic variables are invalid.
+  bool refactorize(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q);
+
+  /// \brief
+  int mMaxPivots;
+
+  /// \brief
+  int mRefactorInterval;
+
+  /// \brief
+  int mNumPivots;
+
+  /// \brief
+  int mNumRefactorizations;
+
+  /// \brief
+  int mLastError;
+
+  /// \brief Inverse of the current basis matrix
+  Eigen::MatrixXd mBInv;
+
+  /// \brief Basis matrix, only assembled and eliminated in place for
+  /// refactorization
+  Eigen::MatrixXd mB;
+
+  /// \brief Values of the basic variables
+  Eigen::VectorXd mX;
+
+  /// \brief Direction of the entering column in the current basis
+  Eigen::VectorXd mD;
+
+  /// \brief Entering column
+  Eigen::VectorXd mBe;
+
+  /// \brief Covering vector of the artificial variable
+  Eigen::VectorXd mCover;
+
+  /// \brief Scaled pivot row used by the rank-1 update
+  Eigen::VectorXd mPivotRow;
+
+  /// \brief Basic variable of each row: [0, n) are z, [n, 2n) are w and 2n
+  /// is the artificial variable
+  std::vector<int> mBasis;
+
+  /// \brief Rows passing the ratio test
+  std::vector<int> mCandidates;
+};
+
+/// \brief Solve the LCP with a temporary LemkeSolver
 int Lemke(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _q,
           Eigen::VectorXd* _z);
 
-/// \brief
+/// \brief Return true if _z solves the LCP up to a tolerance of 1e-4.
+/// Nothing is allocated.
 bool validate(const Eigen::MatrixXd& _M, const Eigen::VectorXd& _z,
               const Eigen::VectorXd& _q);
 
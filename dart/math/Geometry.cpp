@@ -435,67 +435,121 @@ Eigen::Vector3d rotatePoint(const Eigen::Quaterniond& _q,
 
 // ----------- expmap computations -------------
 
-#define EPSILON_EXPMAP_THETA 1.0e-3
-
-Eigen::Matrix3d expMapRot(const Eigen::Vector3d &_q) {
-  double theta = _q.norm();
+// Below these angles the closed-form coefficients lose precision to
+// cancellation, so their Taylor series are used instead. The series are
+// truncated after the t^4 terms, which keeps both errors below 1e-10.
+#define EPSILON_EXPMAP_THETA 3.0e-2
+#define EPSILON_EXPMAP_JACDOT_THETA 1.0e-1
+
+// exp([w]) = I + a*[w] + b*[w]^2 = cos(t)*I + a*[w] + b*w*w^T
+// dexp([w]) = I + b*[w] + c*[w]^2, where t = |w| and
+// a = sin(t)/t, b = (1 - cos(t))/t^2, c = (t - sin(t))/t^3
+static inline void expMapCoefficients(double _t2, double* _a, double* _b,
+                                      double* _c, double* _cos) {
+  if (_t2 < EPSILON_EXPMAP_THETA*EPSILON_EXPMAP_THETA) {
+    const double t4 = _t2*_t2;
+    *_a = 1.0 - _t2/6.0 + t4/120.0;
+    *_b = 0.5 - _t2/24.0 + t4/720.0;
+    *_c = 1.0/6.0 - _t2/120.0 + t4/5040.0;
+    *_cos = 1.0 - *_b*_t2;
+  } else {
+    const double t = std::sqrt(_t2);
+    double sin_t;
+    sincos(t, &sin_t, _cos);
+    *_a = sin_t/t;
+    *_b = (1.0 - *_cos)/_t2;
+    *_c = (t - sin_t)/(_t2*t);
+  }
+}
 
-  Eigen::Matrix3d R = Eigen::Matrix3d::Zero();
-  Eigen::Matrix3d qss =  math::makeSkewSymmetric(_q);
-  Eigen::Matrix3d qss2 =  qss*qss;
+// Writes _d*I + _e*[w] + _f*w*w^T to _M
+static inline void skewPolynomial(const Eigen::Vector3d& _w,
+                                  double _d, double _e, double _f,
+                                  Eigen::Matrix3d* _M) {
+  const double fxy = _f*_w[0]*_w[1];
+  const double fyz = _f*_w[1]*_w[2];
+  const double fzx = _f*_w[2]*_w[0];
+  const double ex = _e*_w[0];
+  const double ey = _e*_w[1];
+  const double ez = _e*_w[2];
+  Eigen::Matrix3d& M = *_M;
+
+  M(0, 0) = _f*_w[0]*_w[0] + _d;
+  M(1, 0) = fxy + ez;
+  M(2, 0) = fzx - ey;
+
+  M(0, 1) = fxy - ez;
+  M(1, 1) = _f*_w[1]*_w[1] + _d;
+  M(2, 1) = fyz + ex;
+
+  M(0, 2) = fzx + ey;
+  M(1, 2) = fyz - ex;
+  M(2, 2) = _f*_w[2]*_w[2] + _d;
+}
 
-  if (theta < EPSILON_EXPMAP_THETA)
-    R = Eigen::Matrix3d::Identity() + qss + 0.5*qss2;
-  else
-    R = Eigen::Matrix3d::Identity()
-        + (sin(theta)/theta)*qss
-        + ((1-cos(theta))/(theta*theta))*qss2;
+Eigen::Matrix3d expMapRot(const Eigen::Vector3d &_q) {
+  double a, b, c, cos_t;
+  expMapCoefficients(_q.squaredNorm(), &a, &b, &c, &cos_t);
 
+  Eigen::Matrix3d R;
+  skewPolynomial(_q, cos_t, a, b, &R);
   return R;
 }
 
 Eigen::Matrix3d expMapJac(const Eigen::Vector3d &_q) {
-  double theta = _q.norm();
-
-  Eigen::Matrix3d J = Eigen::Matrix3d::Zero();
-  Eigen::Matrix3d qss =  math::makeSkewSymmetric(_q);
-  Eigen::Matrix3d qss2 =  qss*qss;
-
-  if (theta < EPSILON_EXPMAP_THETA)
-    J = Eigen::Matrix3d::Identity() + 0.5*qss +  (1.0/6.0)*qss2;
-  else
-    J = Eigen::Matrix3d::Identity()
-        + ((1-cos(theta))/(theta*theta))*qss
-        + ((theta-sin(theta))/(theta*theta*theta))*qss2;
+  const double t2 = _q.squaredNorm();
+  double a, b, c, cos_t;
+  expMapCoefficients(t2, &a, &b, &c, &cos_t);
 
+  // I + c*[q]^2 = (1 - c*t^2)*I + c*q*q^T
+  Eigen::Matrix3d J;
+  skewPolynomial(_q, 1.0 - c*t2, b, c, &J);
   return J;
 }
 
 Eigen::Matrix3d expMapJacDot(const Eigen::Vector3d& _q,
                              const Eigen::Vector3d& _qdot) {
-  double theta = _q.norm();
-
-  Eigen::Matrix3d Jdot = Eigen::Matrix3d::Zero();
-  Eigen::Matrix3d qss  = math::makeSkewSymmetric(_q);
-  Eigen::Matrix3d qss2 = qss*qss;
-  Eigen::Matrix3d qdss = math::makeSkewSymmetric(_qdot);
-  double ttdot = _q.dot(_qdot);   // theta*thetaDot
-  double st = sin(theta);
-  double ct = cos(theta);
-  double t2 = theta*theta;
-  double t3 = t2*theta;
-  double t4 = t3*theta;
-  double t5 = t4*theta;
-
-  if (theta < EPSILON_EXPMAP_THETA) {
-    Jdot = 0.5*qdss + (1.0/6.0)*(qss*qdss + qdss*qss);
-    Jdot += (-1.0/12)*ttdot*qss + (-1.0/60)*ttdot*qss2;
+  //--------------------------------------------------------------------------
+  // Jdot = b*[qdot] + c*([q][qdot] + [qdot][q]) + d*s*[q] + e*s*[q]^2, where
+  // s = <q, qdot>, d = (t*sin(t) + 2*cos(t) - 2)/t^4 and
+  // e = (3*sin(t) - t*cos(t) - 2*t)/t^5. Using [x][y] = y*x^T - <x, y>*I,
+  // Jdot = b*[qdot] + c*(q*qdot^T + qdot*q^T) + d*s*[q] + e*s*q*q^T
+  //        - (2*c + e*t^2)*s*I
+  //--------------------------------------------------------------------------
+  const double t2 = _q.squaredNorm();
+  const double s = _q.dot(_qdot);
+  double a, b, c, cos_t, d, e;
+  expMapCoefficients(t2, &a, &b, &c, &cos_t);
+
+  if (t2 < EPSILON_EXPMAP_JACDOT_THETA*EPSILON_EXPMAP_JACDOT_THETA) {
+    const double t4 = t2*t2;
+    d = -1.0/12.0 + t2/180.0 - t4/6720.0;
+    e = -1.0/60.0 + t2/1260.0 - t4/60480.0;
   } else {
-    Jdot = ((1-ct)/t2)*qdss + ((theta-st)/t3)*(qss*qdss + qdss*qss);
-    Jdot += ((theta*st + 2*ct - 2)/t4)*ttdot*qss
-            + ((3*st - theta*ct - 2*theta)/t5)*ttdot*qss2;
+    const double t = std::sqrt(t2);
+    const double sin_t = a*t;
+    d = (t*sin_t + 2.0*cos_t - 2.0)/(t2*t2);
+    e = (3.0*sin_t - t*cos_t - 2.0*t)/(t2*t2*t);
   }
 
+  Eigen::Matrix3d Jdot;
+  skewPolynomial(_q, -(2.0*c + e*t2)*s, d*s, e*s, &Jdot);
+
+  const double cx = c*_q[0], cy = c*_q[1], cz = c*_q[2];
+  const double bx = b*_qdot[0], by = b*_qdot[1], bz = b*_qdot[2];
+
+  Jdot(0, 0) += 2.0*cx*_qdot[0];
+  Jdot(1, 0) += cx*_qdot[1] + cy*_qdot[0] + bz;
+  Jdot(2, 0) += cx*_qdot[2] + cz*_qdot[0] - by;
+
+  Jdot(0, 1) += cy*_qdot[0] + cx*_qdot[1] - bz;
+  Jdot(1, 1) += 2.0*cy*_qdot[1];
+  Jdot(2, 1) += cy*_qdot[2] + cz*_qdot[1] + bx;
+
+  Jdot(0, 2) += cz*_qdot[0] + cx*_qdot[2] + by;
+  Jdot(1, 2) += cz*_qdot[1] + cy*_qdot[2] - bx;
+  Jdot(2, 2) += 2.0*cz*_qdot[2];
+
   return Jdot;
 }
 
@@ -630,19 +684,103 @@ Eigen::Vector6d logMap(const Eigen::Isometry3d& _T) {
   return ret;
 }
 
+//==============================================================================
+// Spatial algebra kernels. Each kernel reads its whole input into locals before
+// writing the output, so the output may alias the input. They work on raw
+// column-major storage so that the Jacobian versions can run them over each
+// column without copying it into a temporary Vector6d.
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// w' = R*w
+// v' = p x R*w + R*v
+// operation count: multiplication = 24, addition/subtraction = 18
+static inline void adTKernel(const Eigen::Isometry3d& _T,
+                             const double* _v, double* _res) {
+  const double w0 = _v[0], w1 = _v[1], w2 = _v[2];
+  const double u0 = _v[3], u1 = _v[4], u2 = _v[5];
+
+  const double a0 = _T(0, 0) * w0 + _T(0, 1) * w1 + _T(0, 2) * w2;
+  const double a1 = _T(1, 0) * w0 + _T(1, 1) * w1 + _T(1, 2) * w2;
+  const double a2 = _T(2, 0) * w0 + _T(2, 1) * w1 + _T(2, 2) * w2;
+
+  const double b0 = _T(0, 0) * u0 + _T(0, 1) * u1 + _T(0, 2) * u2;
+  const double b1 = _T(1, 0) * u0 + _T(1, 1) * u1 + _T(1, 2) * u2;
+  const double b2 = _T(2, 0) * u0 + _T(2, 1) * u1 + _T(2, 2) * u2;
+
+  _res[0] = a0;
+  _res[1] = a1;
+  _res[2] = a2;
+  _res[3] = _T(1, 3) * a2 - _T(2, 3) * a1 + b0;
+  _res[4] = _T(2, 3) * a0 - _T(0, 3) * a2 + b1;
+  _res[5] = _T(0, 3) * a1 - _T(1, 3) * a0 + b2;
+}
+
+//------------------------------------------------------------------------------
+// w' = R^T*w
+// v' = R^T*(v + w x p)
+// operation count: multiplication = 24, addition/subtraction = 18
+static inline void adInvTKernel(const Eigen::Isometry3d& _T,
+                                const double* _v, double* _res) {
+  const double w0 = _v[0], w1 = _v[1], w2 = _v[2];
+
+  const double c0 = _v[3] + w1 * _T(2, 3) - w2 * _T(1, 3);
+  const double c1 = _v[4] + w2 * _T(0, 3) - w0 * _T(2, 3);
+  const double c2 = _v[5] + w0 * _T(1, 3) - w1 * _T(0, 3);
+
+  _res[0] = _T(0, 0) * w0 + _T(1, 0) * w1 + _T(2, 0) * w2;
+  _res[1] = _T(0, 1) * w0 + _T(1, 1) * w1 + _T(2, 1) * w2;
+  _res[2] = _T(0, 2) * w0 + _T(1, 2) * w1 + _T(2, 2) * w2;
+  _res[3] = _T(0, 0) * c0 + _T(1, 0) * c1 + _T(2, 0) * c2;
+  _res[4] = _T(0, 1) * c0 + _T(1, 1) * c1 + _T(2, 1) * c2;
+  _res[5] = _T(0, 2) * c0 + _T(1, 2) * c1 + _T(2, 2) * c2;
+}
+
+//------------------------------------------------------------------------------
+// f' = R*f
+// m' = R*m + p x R*f
+// operation count: multiplication = 24, addition/subtraction = 18
+static inline void dAdInvTKernel(const Eigen::Isometry3d& _T,
+                                 const double* _f, double* _res) {
+  const double m0 = _f[0], m1 = _f[1], m2 = _f[2];
+  const double f0 = _f[3], f1 = _f[4], f2 = _f[5];
+
+  const double a0 = _T(0, 0) * f0 + _T(0, 1) * f1 + _T(0, 2) * f2;
+  const double a1 = _T(1, 0) * f0 + _T(1, 1) * f1 + _T(1, 2) * f2;
+  const double a2 = _T(2, 0) * f0 + _T(2, 1) * f1 + _T(2, 2) * f2;
+
+  const double b0 = _T(0, 0) * m0 + _T(0, 1) * m1 + _T(0, 2) * m2;
+  const double b1 = _T(1, 0) * m0 + _T(1, 1) * m1 + _T(1, 2) * m2;
+  const double b2 = _T(2, 0) * m0 + _T(2, 1) * m1 + _T(2, 2) * m2;
+
+  _res[0] = b0 + _T(1, 3) * a2 - _T(2, 3) * a1;
+  _res[1] = b1 + _T(2, 3) * a0 - _T(0, 3) * a2;
+  _res[2] = b2 + _T(0, 3) * a1 - _T(1, 3) * a0;
+  _res[3] = a0;
+  _res[4] = a1;
+  _res[5] = a2;
+}
+
+//------------------------------------------------------------------------------
+/// Resize _res to 6 x _numCols only if needed
+static inline void resizeJacobian(Jacobian* _res, int _numCols) {
+  if (_res->cols() != _numCols || _res->rows() != 6)
+    _res->resize(6, _numCols);
+}
+
 // res = T * s * Inv(T)
 Eigen::Vector6d AdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V) {
-  //--------------------------------------------------------------------------
-  // w' = R*w
-  // v' = p x R*w + R*v
-  //--------------------------------------------------------------------------
   Eigen::Vector6d res;
-  res.head<3>().noalias() = _T.linear() * _V.head<3>();
-  res.tail<3>().noalias() = _T.linear() * _V.tail<3>() +
-                            _T.translation().cross(res.head<3>());
+  adTKernel(_T, _V.data(), res.data());
   return res;
 }
 
+void AdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V,
+         Eigen::Vector6d* _res) {
+  assert(_res != NULL);
+  adTKernel(_T, _V.data(), _res->data());
+}
+
 Eigen::Vector6d AdR(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V) {
   //--------------------------------------------------------------------------
   // w' = R*w
@@ -678,16 +816,19 @@ Eigen::Vector6d AdTLinear(const Eigen::Isometry3d& _T,
 }
 
 Jacobian AdTJac(const Eigen::Isometry3d& _T, const Jacobian& _J) {
-  Jacobian res = Jacobian::Zero(6, _J.cols());
-//  res.topRows<3>().noalias() = T.linear() * J.topRows<3>();
-//  res.bottomRows<3>().noalias()
-//      = -res.topRows<3>().colwise().cross(T.translation())
-//        + T.linear() * J.bottomRows<3>();
-  for (int i = 0; i < _J.cols(); ++i)
-    res.col(i) = AdT(_T, _J.col(i));
+  Jacobian res(6, _J.cols());
+  AdTJac(_T, _J, &res);
   return res;
 }
 
+void AdTJac(const Eigen::Isometry3d& _T, const Jacobian& _J, Jacobian* _res) {
+  assert(_res != NULL);
+  assert(_J.rows() == 6);
+  resizeJacobian(_res, _J.cols());
+  for (int i = 0; i < _J.cols(); ++i)
+    adTKernel(_T, _J.data() + 6 * i, _res->data() + 6 * i);
+}
+
 // se3 AdP(const Vec3& p, const se3& s)
 // {
 //  //--------------------------------------------------------------------------
@@ -720,24 +861,31 @@ Jacobian AdTJac(const Eigen::Isometry3d& _T, const Jacobian& _J) {
 // re = Inv(T)*s*T
 Eigen::Vector6d AdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V) {
   Eigen::Vector6d res;
-  res.head<3>().noalias() = _T.linear().transpose() * _V.head<3>();
-  res.tail<3>().noalias() =
-      _T.linear().transpose()
-      * (_V.tail<3>() + _V.head<3>().cross(_T.translation()));
+  adInvTKernel(_T, _V.data(), res.data());
   return res;
 }
 
+void AdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V,
+            Eigen::Vector6d* _res) {
+  assert(_res != NULL);
+  adInvTKernel(_T, _V.data(), _res->data());
+}
+
 Jacobian AdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J) {
-  Jacobian res = Jacobian::Zero(6, _J.cols());
-//  res.topRows<3>().noalias()    = T.linear().transpose() * J.topRows<3>();
-//  res.bottomRows<3>().noalias()
-//      = T.linear().transpose()
-//      * (J.bottomRows<3>() + J.topRows<3>().colwise().cross(T.translation()));
-  for (int i = 0; i < _J.cols(); ++i)
-    res.col(i) = AdInvT(_T, _J.col(i));
+  Jacobian res(6, _J.cols());
+  AdInvTJac(_T, _J, &res);
   return res;
 }
 
+void AdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J,
+               Jacobian* _res) {
+  assert(_res != NULL);
+  assert(_J.rows() == 6);
+  resizeJacobian(_res, _J.cols());
+  for (int i = 0; i < _J.cols(); ++i)
+    adInvTKernel(_T, _J.data() + 6 * i, _res->data() + 6 * i);
+}
+
 // se3 AdInvR(const SE3& T, const se3& s)
 // {
 //     se3 ret;
@@ -768,12 +916,29 @@ Eigen::Vector6d ad(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y) {
   //              | [v1]w2 + [w1]v2 |
   //--------------------------------------------------------------------------
   Eigen::Vector6d res;
-  res.head<3>() = _X.head<3>().cross(_Y.head<3>());
-  res.tail<3>() = _X.head<3>().cross(_Y.tail<3>()) +
-                  _X.tail<3>().cross(_Y.head<3>());
+  ad(_X, _Y, &res);
   return res;
 }
 
+void ad(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y,
+        Eigen::Vector6d* _res) {
+  assert(_res != NULL);
+
+  // operation count: multiplication = 18, addition/subtraction = 12
+  const double w0 = _X[0], w1 = _X[1], w2 = _X[2];
+  const double v0 = _X[3], v1 = _X[4], v2 = _X[5];
+  const double a0 = _Y[0], a1 = _Y[1], a2 = _Y[2];
+  const double b0 = _Y[3], b1 = _Y[4], b2 = _Y[5];
+
+  Eigen::Vector6d& res = *_res;
+  res[0] = w1 * a2 - w2 * a1;
+  res[1] = w2 * a0 - w0 * a2;
+  res[2] = w0 * a1 - w1 * a0;
+  res[3] = w1 * b2 - w2 * b1 + v1 * a2 - v2 * a1;
+  res[4] = w2 * b0 - w0 * b2 + v2 * a0 - v0 * a2;
+  res[5] = w0 * b1 - w1 * b0 + v0 * a1 - v1 * a0;
+}
+
 Eigen::Vector6d dAdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F) {
   Eigen::Vector6d res;
   res.head<3>().noalias() =
@@ -802,22 +967,29 @@ Eigen::Vector6d dAdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F) {
 Eigen::Vector6d dAdInvT(const Eigen::Isometry3d& _T,
                         const Eigen::Vector6d& _F) {
   Eigen::Vector6d res;
-  res.tail<3>().noalias() = _T.linear() * _F.tail<3>();
-  res.head<3>().noalias() = _T.linear() * _F.head<3>();
-  res.head<3>() += _T.translation().cross(res.tail<3>());
+  dAdInvTKernel(_T, _F.data(), res.data());
   return res;
 }
 
+void dAdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F,
+             Eigen::Vector6d* _res) {
+  assert(_res != NULL);
+  dAdInvTKernel(_T, _F.data(), _res->data());
+}
+
 Jacobian dAdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J) {
-  math::Jacobian res = math::Jacobian::Zero(6, _J.cols());
-//  res.bottomRows<3>().noalias() = T.linear() * J.bottomRows<3>();
-//  res.topRows<3>().noalias()    = T.linear() * J.topRows<3>();
-//  res.topRows<3>() -= res.bottomRows<3>().colwise().cross(T.translation());
+  Jacobian res(6, _J.cols());
+  dAdInvTJac(_T, _J, &res);
+  return res;
+}
 
+void dAdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J,
+                Jacobian* _res) {
+  assert(_res != NULL);
+  assert(_J.rows() == 6);
+  resizeJacobian(_res, _J.cols());
   for (int i = 0; i < _J.cols(); ++i)
-    res.col(i) = dAdInvT(_T, _J.col(i));
-
-  return res;
+    dAdInvTKernel(_T, _J.data() + 6 * i, _res->data() + 6 * i);
 }
 
 Eigen::Vector6d dAdInvR(const Eigen::Isometry3d& _T,
@@ -884,12 +1056,10 @@ Eigen::Matrix3d eulerXYZToMatrix(const Eigen::Vector3d& _angle) {
 
   Eigen::Matrix3d ret;
 
-  double cx = cos(_angle[0]);
-  double sx = sin(_angle[0]);
-  double cy = cos(_angle[1]);
-  double sy = sin(_angle[1]);
-  double cz = cos(_angle[2]);
-  double sz = sin(_angle[2]);
+  double cx, sx, cy, sy, cz, sz;
+  sincos(_angle[0], &sx, &cx);
+  sincos(_angle[1], &sy, &cy);
+  sincos(_angle[2], &sz, &cz);
 
   ret(0, 0) = cy*cz;
   ret(1, 0) = cx*sz + cz*sx*sy;
@@ -1116,12 +1286,10 @@ Eigen::Matrix3d eulerZYXToMatrix(const Eigen::Vector3d& _angle) {
 
   Eigen::Matrix3d ret;
 
-  double cz = cos(_angle[0]);
-  double sz = sin(_angle[0]);
-  double cy = cos(_angle[1]);
-  double sy = sin(_angle[1]);
-  double cx = cos(_angle[2]);
-  double sx = sin(_angle[2]);
+  double cz, sz, cy, sy, cx, sx;
+  sincos(_angle[0], &sz, &cz);
+  sincos(_angle[1], &sy, &cy);
+  sincos(_angle[2], &sx, &cx);
 
   ret(0, 0) =  cz*cy;
   ret(1, 0) =  sz*cy;
@@ -1204,72 +1372,34 @@ Eigen::Matrix3d eulerZYZToMatrix(const Eigen::Vector3d& _angle) {
 // p = sin(t) / t*v + (t - sin(t)) / t^3*<w, v>*w + (1 - cos(t)) / t^2*(w X v)
 // , when S = (w, v), t = |w|
 Eigen::Isometry3d expMap(const Eigen::Vector6d& _S) {
-  Eigen::Isometry3d ret = Eigen::Isometry3d::Identity();
-  double s2[] = { _S[0]*_S[0], _S[1]*_S[1], _S[2]*_S[2] };
-  double s3[] = { _S[0]*_S[1], _S[1]*_S[2], _S[2]*_S[0] };
-  double theta = sqrt(s2[0] + s2[1] + s2[2]);
-  double cos_t = cos(theta), alpha, beta, gamma;
-
-  if (theta > DART_EPSILON) {
-    double sin_t = sin(theta);
-    alpha = sin_t / theta;
-    beta = (1.0 - cos_t) / theta / theta;
-    gamma = (_S[0]*_S[3] + _S[1]*_S[4] + _S[2]*_S[5])
-            * (theta - sin_t) / theta / theta / theta;
-  } else {
-    alpha = 1.0 - theta*theta/6.0;
-    beta = 0.5 - theta*theta/24.0;
-    gamma = (_S[0]*_S[3] + _S[1]*_S[4] + _S[2]*_S[5])/6.0 - theta*theta/120.0;
-  }
-
-  ret(0, 0) = beta*s2[0] + cos_t;
-  ret(1, 0) = beta*s3[0] + alpha*_S[2];
-  ret(2, 0) = beta*s3[2] - alpha*_S[1];
-
-  ret(0, 1) = beta*s3[0] - alpha*_S[2];
-  ret(1, 1) = beta*s2[1] + cos_t;
-  ret(2, 1) = beta*s3[1] + alpha*_S[0];
-
-  ret(0, 2) = beta*s3[2] + alpha*_S[1];
-  ret(1, 2) = beta*s3[1] - alpha*_S[0];
-  ret(2, 2) = beta*s2[2] + cos_t;
-
-  ret(0, 3) = alpha*_S[3] + beta*(_S[1]*_S[5] - _S[2]*_S[4]) + gamma*_S[0];
-  ret(1, 3) = alpha*_S[4] + beta*(_S[2]*_S[3] - _S[0]*_S[5]) + gamma*_S[1];
-  ret(2, 3) = alpha*_S[5] + beta*(_S[0]*_S[4] - _S[1]*_S[3]) + gamma*_S[2];
+  const Eigen::Vector3d w = _S.head<3>();
+  const Eigen::Vector3d v = _S.tail<3>();
+  double alpha, beta, gamma, cos_t;
+  expMapCoefficients(w.squaredNorm(), &alpha, &beta, &gamma, &cos_t);
+
+  Eigen::Isometry3d ret;
+  Eigen::Matrix3d R;
+  skewPolynomial(w, cos_t, alpha, beta, &R);
+  ret.linear() = R;
+
+  gamma *= w.dot(v);
+  ret(0, 3) = alpha*v[0] + beta*(w[1]*v[2] - w[2]*v[1]) + gamma*w[0];
+  ret(1, 3) = alpha*v[1] + beta*(w[2]*v[0] - w[0]*v[2]) + gamma*w[1];
+  ret(2, 3) = alpha*v[2] + beta*(w[0]*v[1] - w[1]*v[0]) + gamma*w[2];
+  ret.makeAffine();
 
   return ret;
 }
 
 // I + sin(t) / t*[S] + (1 - cos(t)) / t^2*[S]^2, where t = |S|
 Eigen::Isometry3d expAngular(const Eigen::Vector3d& _s) {
-  Eigen::Isometry3d ret = Eigen::Isometry3d::Identity();
-  double s2[] = { _s[0]*_s[0], _s[1]*_s[1], _s[2]*_s[2] };
-  double s3[] = { _s[0]*_s[1], _s[1]*_s[2], _s[2]*_s[0] };
-  double theta = sqrt(s2[0] + s2[1] + s2[2]);
-  double cos_t = cos(theta);
-  double alpha = 0.0;
-  double beta = 0.0;
-
-  if (theta > DART_EPSILON) {
-    alpha = sin(theta) / theta;
-    beta = (1.0 - cos_t) / theta / theta;
-  } else {
-    alpha = 1.0 - theta*theta/6.0;
-    beta = 0.5 - theta*theta/24.0;
-  }
-
-  ret(0, 0) = beta*s2[0] + cos_t;
-  ret(1, 0) = beta*s3[0] + alpha*_s[2];
-  ret(2, 0) = beta*s3[2] - alpha*_s[1];
-
-  ret(0, 1) = beta*s3[0] - alpha*_s[2];
-  ret(1, 1) = beta*s2[1] + cos_t;
-  ret(2, 1) = beta*s3[1] + alpha*_s[0];
+  double alpha, beta, gamma, cos_t;
+  expMapCoefficients(_s.squaredNorm(), &alpha, &beta, &gamma, &cos_t);
 
-  ret(0, 2) = beta*s3[2] + alpha*_s[1];
-  ret(1, 2) = beta*s3[1] - alpha*_s[0];
-  ret(2, 2) = beta*s2[2] + cos_t;
+  Eigen::Isometry3d ret = Eigen::Isometry3d::Identity();
+  Eigen::Matrix3d R;
+  skewPolynomial(_s, cos_t, alpha, beta, &R);
+  ret.linear() = R;
 
   return ret;
 }
@@ -1332,16 +1462,39 @@ Eigen::Isometry3d expAngular(const Eigen::Vector3d& _s) {
 
 Eigen::Vector6d dad(const Eigen::Vector6d& _s, const Eigen::Vector6d& _t) {
   Eigen::Vector6d res;
-  res.head<3>() = _t.head<3>().cross(_s.head<3>())
-                  + _t.tail<3>().cross(_s.tail<3>());
-  res.tail<3>() = _t.tail<3>().cross(_s.head<3>());
+  dad(_s, _t, &res);
   return res;
 }
 
+void dad(const Eigen::Vector6d& _s, const Eigen::Vector6d& _t,
+         Eigen::Vector6d* _res) {
+  assert(_res != NULL);
+
+  // operation count: multiplication = 18, addition/subtraction = 12
+  const double w0 = _s[0], w1 = _s[1], w2 = _s[2];
+  const double v0 = _s[3], v1 = _s[4], v2 = _s[5];
+  const double m0 = _t[0], m1 = _t[1], m2 = _t[2];
+  const double f0 = _t[3], f1 = _t[4], f2 = _t[5];
+
+  Eigen::Vector6d& res = *_res;
+  res[0] = m1 * w2 - m2 * w1 + f1 * v2 - f2 * v1;
+  res[1] = m2 * w0 - m0 * w2 + f2 * v0 - f0 * v2;
+  res[2] = m0 * w1 - m1 * w0 + f0 * v1 - f1 * v0;
+  res[3] = f1 * w2 - f2 * w1;
+  res[4] = f2 * w0 - f0 * w2;
+  res[5] = f0 * w1 - f1 * w0;
+}
+
 Inertia transformInertia(const Eigen::Isometry3d& _T, const Inertia& _I) {
-  // operation count: multiplication = 186, addition = 117, subtract = 21
+  Inertia ret;
+  transformInertia(_T, _I, &ret);
+  return ret;
+}
 
-  Inertia ret = Inertia::Identity();
+void transformInertia(const Eigen::Isometry3d& _T, const Inertia& _I,
+                      Inertia* _res) {
+  // operation count: multiplication = 186, addition = 117, subtract = 21
+  assert(_res != NULL);
 
   double d0 = _I(0, 3) + _T(2, 3) * _I(3, 4) - _T(1, 3) * _I(3, 5);
   double d1 = _I(1, 3) - _T(2, 3) * _I(3, 3) + _T(0, 3) * _I(3, 5);
@@ -1385,6 +1538,16 @@ Inertia transformInertia(const Eigen::Isometry3d& _T, const Inertia& _I) {
   double h3 = _T(0, 1) * _I(3, 3) + _T(1, 1) * _I(3, 4) + _T(2, 1) * _I(3, 5);
   double h4 = _T(0, 1) * _I(3, 4) + _T(1, 1) * _I(4, 4) + _T(2, 1) * _I(4, 5);
   double h5 = _T(0, 1) * _I(3, 5) + _T(1, 1) * _I(4, 5) + _T(2, 1) * _I(5, 5);
+  double k5 =
+      (_T(0, 2) * _I(3, 3) + _T(1, 2) * _I(3, 4) + _T(2, 2) * _I(3, 5))
+      * _T(0, 2)
+      + (_T(0, 2) * _I(3, 4) + _T(1, 2) * _I(4, 4) + _T(2, 2) * _I(4, 5))
+      * _T(1, 2)
+      + (_T(0, 2) * _I(3, 5) + _T(1, 2) * _I(4, 5) + _T(2, 2) * _I(5, 5))
+      * _T(2, 2);
+
+  // All the entries of _I are read above, so _res may alias _I
+  Inertia& ret = *_res;
 
   ret(0, 0) = f0 * _T(0, 0) + f1 * _T(1, 0) + f2 * _T(2, 0);
   ret(0, 1) = f0 * _T(0, 1) + f1 * _T(1, 1) + f2 * _T(2, 1);
@@ -1408,17 +1571,9 @@ Inertia transformInertia(const Eigen::Isometry3d& _T, const Inertia& _I) {
   ret(3, 5) = h0 * _T(0, 2) + h1 * _T(1, 2) + h2 * _T(2, 2);
   ret(4, 4) = h3 * _T(0, 1) + h4 * _T(1, 1) + h5 * _T(2, 1);
   ret(4, 5) = h3 * _T(0, 2) + h4 * _T(1, 2) + h5 * _T(2, 2);
-  ret(5, 5) =
-      (_T(0, 2) * _I(3, 3) + _T(1, 2) * _I(3, 4) + _T(2, 2) * _I(3, 5))
-      * _T(0, 2)
-      + (_T(0, 2) * _I(3, 4) + _T(1, 2) * _I(4, 4) + _T(2, 2) * _I(4, 5))
-      * _T(1, 2)
-      + (_T(0, 2) * _I(3, 5) + _T(1, 2) * _I(4, 5) + _T(2, 2) * _I(5, 5))
-      * _T(2, 2);
+  ret(5, 5) = k5;
 
   ret.triangularView<Eigen::StrictlyLower>() = ret.transpose();
-
-  return ret;
 }
 
 bool verifyRotation(const Eigen::Matrix3d& _T) {
@@ -200,6 +200,14 @@ Eigen::Vector6d logMap(const Eigen::Isometry3d& _T);
 Eigen::Vector6d AdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V);
 Jacobian AdTJac(const Eigen::Isometry3d& _T, const Jacobian& _J);
 
+/// \brief In-place version of AdT. _res may be the same object as _V.
+void AdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V,
+         Eigen::Vector6d* _res);
+
+/// \brief In-place version of AdTJac. _res is resized only if its size differs
+/// from _J, and it may be the same object as _J.
+void AdTJac(const Eigen::Isometry3d& _T, const Jacobian& _J, Jacobian* _res);
+
 /// \brief Fast version of Ad([R 0; 0 1], V)
 Eigen::Vector6d AdR(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V);
 
@@ -222,6 +230,15 @@ Eigen::Vector6d AdTLinear(const Eigen::Isometry3d& _T,
 Eigen::Vector6d AdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V);
 Jacobian AdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J);
 
+/// \brief In-place version of AdInvT. _res may be the same object as _V.
+void AdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _V,
+            Eigen::Vector6d* _res);
+
+/// \brief In-place version of AdInvTJac. _res is resized only if its size
+/// differs from _J, and it may be the same object as _J.
+void AdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J,
+               Jacobian* _res);
+
 ///// \brief fast version of Ad(Inv(T), se3(Eigen_Vec3(0), v))
 // Eigen::Vector3d AdInvTLinear(const Eigen::Isometry3d& T,
 //                             const Eigen::Vector3d& v);
@@ -248,6 +265,15 @@ Eigen::Vector6d dAdT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F);
 Eigen::Vector6d dAdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F);
 Jacobian dAdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J);
 
+/// \brief In-place version of dAdInvT. _res may be the same object as _F.
+void dAdInvT(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F,
+             Eigen::Vector6d* _res);
+
+/// \brief In-place version of dAdInvTJac. _res is resized only if its size
+/// differs from _J, and it may be the same object as _J.
+void dAdInvTJac(const Eigen::Isometry3d& _T, const Jacobian& _J,
+                Jacobian* _res);
+
 /// \brief fast version of dAd(Inv([R 0; 0 1]), F)
 Eigen::Vector6d dAdInvR(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F);
 
@@ -259,6 +285,10 @@ Eigen::Vector6d dAdInvR(const Eigen::Isometry3d& _T, const Eigen::Vector6d& _F);
 /// where @f$X=(w_X,v_X)@in se(3), @quad Y=(w_Y,v_Y)@in se(3) @f$.
 Eigen::Vector6d ad(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y);
 
+/// \brief In-place version of ad. _res may be the same object as _X or _Y.
+void ad(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y,
+        Eigen::Vector6d* _res);
+
 /// \brief fast version of ad(se3(Eigen_Vec3(0), v), S)
 // Vec3 ad_Vec3_se3(const Vec3& v, const se3& S);
 
@@ -270,9 +300,18 @@ Eigen::Vector6d ad(const Eigen::Vector6d& _X, const Eigen::Vector6d& _Y);
 /// , where @f$F=(m,f)@in se^{@,*}(3), @quad V=(w,v)@in se(3) @f$.
 Eigen::Vector6d dad(const Eigen::Vector6d& _s, const Eigen::Vector6d& _t);
 
+/// \brief In-place version of dad. _res may be the same object as _s or _t.
+void dad(const Eigen::Vector6d& _s, const Eigen::Vector6d& _t,
+         Eigen::Vector6d* _res);
+
 /// \brief
 Inertia transformInertia(const Eigen::Isometry3d& _T, const Inertia& _AI);
 
+/// \brief In-place version of transformInertia. _res may be the same object
+/// as _AI.
+void transformInertia(const Eigen::Isometry3d& _T, const Inertia& _AI,
+                      Inertia* _res);
+
 /// \brief Check if determinant of _R is equat to 1 and all the elements are not
 /// NaN values.
 bool verifyRotation(const Eigen::Matrix3d& _R);
@@ -78,6 +78,16 @@ inline double sqr(double _x) {
   return _x*_x;
 }
 
+/// \brief Compute sin(_x) and cos(_x) with a single call where available
+inline void sincos(double _x, double* _sin, double* _cos) {
+#if defined(__GNUC__) && !defined(__clang__)
+  __builtin_sincos(_x, _sin, _cos);
+#else
+  *_sin = std::sin(_x);
+  *_cos = std::cos(_x);
+#endif
+}
+
 inline double Tsinc(double _theta) {
   return 0.5-sqrt(_theta)/48;
 }
@@ -42,36 +42,86 @@
 
 #include "dart/simulation/Recording.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include "dart/common/Console.h"
+#include "dart/collision/CollisionDetector.h"
+#include "dart/dynamics/GenCoord.h"
 #include "dart/dynamics/Skeleton.h"
 
+#define DART_RECORDING_FILE_MAGIC "DREC"
+#define DART_RECORDING_FILE_VERSION 1
+#define DART_RECORDING_FILE_MAX_GEN_COORDS (1 << 20)
+
 namespace dart {
 namespace simulation {
 
+//==============================================================================
+template <typename T>
+static void writeRaw(std::fstream& _file, const T* _data, size_t _size)
+{
+  _file.write(reinterpret_cast<const char*>(_data), sizeof(T) * _size);
+}
+
+//==============================================================================
+template <typename T>
+static bool readRaw(std::fstream& _file, T* _data, size_t _size)
+{
+  _file.read(reinterpret_cast<char*>(_data), sizeof(T) * _size);
+  return static_cast<size_t>(_file.gcount()) == sizeof(T) * _size;
+}
+
 //==============================================================================
 Recording::Recording(const std::vector<dynamics::Skeleton*>& _skeletons)
+  : mNumGenCoords(0),
+    mNumFrames(0),
+    mNumFramesPerChunk(0),
+    mFileEnd(0)
 {
   for (int i = 0; i < _skeletons.size(); i++)
+  {
     mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumGenCoords());
+    mNumGenCoords += _skeletons[i]->getNumGenCoords();
+  }
+
+  resetChunk(&mChunk, 0);
+  resetChunk(&mReadChunk, 0);
 }
 
 //==============================================================================
 Recording::Recording(const std::vector<int>& _skelDofs)
+  : mNumGenCoords(0),
+    mNumFrames(0),
+    mNumFramesPerChunk(0),
+    mFileEnd(0)
 {
   for (int i = 0; i < _skelDofs.size(); i++)
+  {
     mNumGenCoordsForSkeletons.push_back(_skelDofs[i]);
+    mNumGenCoords += _skelDofs[i];
+  }
+
+  resetChunk(&mChunk, 0);
+  resetChunk(&mReadChunk, 0);
 }
 
 //==============================================================================
 Recording::~Recording()
 {
+  if (isStreaming())
+  {
+    writeChunk();
+    mFile.close();
+  }
 }
 
 //==============================================================================
 int Recording::getNumFrames() const
 {
-  return mBakedStates.size();
+  return mNumFrames;
 }
 
 //==============================================================================
@@ -89,10 +139,9 @@ int Recording::getNumGenCoords(int _skelIdx) const
 //==============================================================================
 int Recording::getNumContacts(int _frameIdx) const
 {
-  int totalDofs = 0;
-  for (int i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return (mBakedStates[_frameIdx].size() - totalDofs) / 6;
+  const RecordingChunk& chunk = getChunk(_frameIdx);
+  int frame = _frameIdx - chunk.firstFrame;
+  return chunk.contactOffsets[frame + 1] - chunk.contactOffsets[frame];
 }
 
 //==============================================================================
@@ -101,7 +150,14 @@ Eigen::VectorXd Recording::getConfig(int _frameIdx, int _skelIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(index, getNumGenCoords(_skelIdx));
+
+  Eigen::VectorXd config(getNumGenCoords(_skelIdx));
+  const RecordingChunk& chunk = getChunk(_frameIdx);
+  index += (_frameIdx - chunk.firstFrame) * mNumGenCoords;
+  for (int i = 0; i < config.size(); ++i)
+    config[i] = chunk.configs[index + i];
+
+  return config;
 }
 
 //==============================================================================
@@ -110,42 +166,434 @@ double Recording::getGenCoord(int _frameIdx, int _skelIdx, int _dofIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx][index + _dofIdx];
+
+  const RecordingChunk& chunk = getChunk(_frameIdx);
+  index += (_frameIdx - chunk.firstFrame) * mNumGenCoords;
+  return chunk.configs[index + _dofIdx];
 }
 
 //==============================================================================
 Eigen::Vector3d Recording::getContactPoint(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (int i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6, 3);
+  const RecordingChunk& chunk = getChunk(_frameIdx);
+  int index = 6 * (chunk.contactOffsets[_frameIdx - chunk.firstFrame]
+                   + _contactIdx);
+  return Eigen::Vector3d(chunk.contacts[index], chunk.contacts[index + 1],
+                         chunk.contacts[index + 2]);
 }
 
 //==============================================================================
 Eigen::Vector3d Recording::getContactForce(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (int i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6 + 3, 3);
+  const RecordingChunk& chunk = getChunk(_frameIdx);
+  int index = 6 * (chunk.contactOffsets[_frameIdx - chunk.firstFrame]
+                   + _contactIdx) + 3;
+  return Eigen::Vector3d(chunk.contacts[index], chunk.contacts[index + 1],
+                         chunk.contacts[index + 2]);
 }
 
 //==============================================================================
 void Recording::addState(const Eigen::VectorXd& _state)
 {
-  mBakedStates.push_back(_state);
+  assert(_state.size() >= mNumGenCoords);
+  assert((_state.size() - mNumGenCoords) % 6 == 0);
+
+  for (int i = 0; i < mNumGenCoords; ++i)
+    mChunk.configs.push_back(_state[i]);
+
+  for (int i = mNumGenCoords; i < _state.size(); ++i)
+    mChunk.contacts.push_back(_state[i]);
+
+  finishFrame();
+}
+
+//==============================================================================
+void Recording::addFrame(const std::vector<dynamics::Skeleton*>& _skeletons,
+                         collision::CollisionDetector* _collisionDetector)
+{
+  assert(_skeletons.size() == mNumGenCoordsForSkeletons.size());
+
+  for (size_t i = 0; i < _skeletons.size(); ++i)
+  {
+    assert(_skeletons[i]->getNumGenCoords() == mNumGenCoordsForSkeletons[i]);
+    for (int j = 0; j < mNumGenCoordsForSkeletons[i]; ++j)
+      mChunk.configs.push_back(_skeletons[i]->getGenCoord(j)->getPos());
+  }
+
+  int nContacts = _collisionDetector ? _collisionDetector->getNumContacts() : 0;
+  for (int i = 0; i < nContacts; ++i)
+  {
+    const collision::Contact& contact = _collisionDetector->getContact(i);
+    for (int j = 0; j < 3; ++j)
+      mChunk.contacts.push_back(contact.point[j]);
+    for (int j = 0; j < 3; ++j)
+      mChunk.contacts.push_back(contact.force[j]);
+  }
+
+  finishFrame();
 }
 
 //==============================================================================
 void Recording::updateNumGenCoords(
     const std::vector<dynamics::Skeleton*>& _skeletons)
 {
-  mNumGenCoordsForSkeletons.clear();
+  std::vector<int> numGenCoordsForSkeletons;
+  int numGenCoords = 0;
   for (int i = 0; i < _skeletons.size(); ++i)
-    mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumGenCoords());
+  {
+    numGenCoordsForSkeletons.push_back(_skeletons[i]->getNumGenCoords());
+    numGenCoords += _skeletons[i]->getNumGenCoords();
+  }
+
+  if (numGenCoordsForSkeletons == mNumGenCoordsForSkeletons)
+    return;
+
+  // The frames have a fixed stride, so the frames recorded with the old
+  // skeletons can't be kept
+  if (isStreaming())
+  {
+    dtwarn << "Stopped streaming the recording because the skeletons "
+           << "changed.\n";
+    stopStreaming();
+  }
+  else if (mNumFrames > 0)
+  {
+    dtwarn << "Cleared " << mNumFrames << " recorded frames because the "
+           << "skeletons changed.\n";
+  }
+
+  mNumGenCoordsForSkeletons = numGenCoordsForSkeletons;
+  mNumGenCoords = numGenCoords;
+  clearFrames();
+}
+
+//==============================================================================
+bool Recording::startStreaming(const std::string& _fileName,
+                               int _numFramesPerChunk)
+{
+  assert(_numFramesPerChunk > 0);
+
+  if (isStreaming())
+  {
+    dterr << "The recording is already streamed to a file.\n";
+    return false;
+  }
+
+  mFile.open(_fileName.c_str(),
+             std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+  if (mFile.fail())
+  {
+    dterr << "Failed to open recording file [" << _fileName
+          << "] for writing." << std::endl;
+    mFile.close();
+    return false;
+  }
+
+  const unsigned int header[2]
+      = {DART_RECORDING_FILE_VERSION,
+         static_cast<unsigned int>(mNumGenCoordsForSkeletons.size())};
+  mFile.write(DART_RECORDING_FILE_MAGIC, 4);
+  writeRaw(mFile, header, 2);
+  for (size_t i = 0; i < mNumGenCoordsForSkeletons.size(); ++i)
+  {
+    const unsigned int numGenCoords = mNumGenCoordsForSkeletons[i];
+    writeRaw(mFile, &numGenCoords, 1);
+  }
+
+  mNumFramesPerChunk = _numFramesPerChunk;
+  mChunkFirstFrames.clear();
+  mChunkOffsets.clear();
+  mFileEnd = mFile.tellp();
+
+  // Write the frames recorded so far through the same path as new frames
+  RecordingChunk frames;
+  std::swap(frames, mChunk);
+  resetChunk(&mChunk, 0);
+  mNumFrames = 0;
+  for (int i = 0; i < frames.numFrames; ++i)
+  {
+    mChunk.configs.insert(mChunk.configs.end(),
+                          frames.configs.begin() + i * mNumGenCoords,
+                          frames.configs.begin() + (i + 1) * mNumGenCoords);
+    mChunk.contacts.insert(mChunk.contacts.end(),
+                           frames.contacts.begin()
+                           + 6 * frames.contactOffsets[i],
+                           frames.contacts.begin()
+                           + 6 * frames.contactOffsets[i + 1]);
+    finishFrame();
+  }
+
+  return true;
+}
+
+//==============================================================================
+bool Recording::loadStream(const std::string& _fileName,
+                           int _numFramesPerChunk)
+{
+  assert(_numFramesPerChunk > 0);
+
+  // Frames recorded in memory, e.g. by World::bake(), are replaced as well
+  stopStreaming();
+  clearFrames();
+
+  mFile.open(_fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  if (mFile.fail())
+  {
+    dterr << "Failed to open recording file [" << _fileName << "]."
+          << std::endl;
+    mFile.close();
+    return false;
+  }
+
+  char magic[4];
+  unsigned int header[2];
+  if (!readRaw(mFile, magic, 4)
+      || std::strncmp(magic, DART_RECORDING_FILE_MAGIC, 4)
+      || !readRaw(mFile, header, 2))
+  {
+    dterr << "[" << _fileName << "] is not a recording file." << std::endl;
+    mFile.close();
+    return false;
+  }
+
+  if (header[0] != DART_RECORDING_FILE_VERSION)
+  {
+    dterr << "Unsupported recording file version [" << header[0] << "]."
+          << std::endl;
+    mFile.close();
+    return false;
+  }
+
+  // Check the sizes in the header before allocating anything with them
+  std::streamoff offset = mFile.tellg();
+  mFile.seekg(0, std::ios::end);
+  const std::streamoff fileSize = mFile.tellg();
+  mFile.seekg(offset);
+
+  if (header[1] > (fileSize - offset) / sizeof(unsigned int))
+  {
+    dterr << "Truncated header of recording file [" << _fileName << "]."
+          << std::endl;
+    mFile.close();
+    return false;
+  }
+
+  std::vector<unsigned int> numGenCoordsForSkeletons(header[1]);
+  if (header[1] > 0)
+    readRaw(mFile, &numGenCoordsForSkeletons[0], header[1]);
+  offset = mFile.tellg();
+
+  unsigned int numGenCoords = 0;
+  for (size_t i = 0; i < numGenCoordsForSkeletons.size(); ++i)
+  {
+    if (numGenCoordsForSkeletons[i]
+        > DART_RECORDING_FILE_MAX_GEN_COORDS - numGenCoords)
+    {
+      dterr << "Recording file [" << _fileName << "] has more than "
+            << DART_RECORDING_FILE_MAX_GEN_COORDS << " generalized "
+            << "coordinates." << std::endl;
+      mFile.close();
+      return false;
+    }
+    numGenCoords += numGenCoordsForSkeletons[i];
+  }
+
+  mNumGenCoordsForSkeletons.assign(numGenCoordsForSkeletons.begin(),
+                                   numGenCoordsForSkeletons.end());
+  mNumGenCoords = numGenCoords;
+
+  // Index the chunks by their headers. A truncated last chunk, e.g. of a
+  // recording that was not flushed, is ignored and overwritten by new frames.
+  while (offset < fileSize)
+  {
+    unsigned int chunkHeader[2];
+    mFile.seekg(offset);
+    if (!readRaw(mFile, chunkHeader, 2))
+      break;
+
+    const std::streamoff chunkSize
+        = 2 * sizeof(unsigned int)
+          + chunkHeader[0] * (mNumGenCoords * sizeof(double)
+                              + sizeof(unsigned int))
+          + chunkHeader[1] * 6 * sizeof(double);
+    if (chunkHeader[0] == 0 || offset + chunkSize > fileSize)
+      break;
+
+    mChunkFirstFrames.push_back(mNumFrames);
+    mChunkOffsets.push_back(offset);
+    mNumFrames += chunkHeader[0];
+    offset += chunkSize;
+  }
+
+  if (offset < fileSize)
+  {
+    dtwarn << "Ignored " << fileSize - offset << " bytes of an incomplete "
+           << "chunk at the end of recording file [" << _fileName << "]."
+           << std::endl;
+  }
+
+  mFile.clear();
+  mFileEnd = offset;
+  mNumFramesPerChunk = _numFramesPerChunk;
+  resetChunk(&mChunk, mNumFrames);
+  resetChunk(&mReadChunk, 0);
+
+  return true;
+}
+
+//==============================================================================
+void Recording::flush()
+{
+  if (!isStreaming())
+    return;
+
+  writeChunk();
+  mFile.flush();
+}
+
+//==============================================================================
+void Recording::stopStreaming()
+{
+  if (!isStreaming())
+    return;
+
+  writeChunk();
+  mFile.close();
+
+  clearFrames();
+}
+
+//==============================================================================
+bool Recording::isStreaming() const
+{
+  return mFile.is_open();
+}
+
+//==============================================================================
+void Recording::resetChunk(RecordingChunk* _chunk, int _firstFrame)
+{
+  _chunk->firstFrame = _firstFrame;
+  _chunk->numFrames = 0;
+  _chunk->configs.clear();
+  _chunk->contactOffsets.assign(1, 0);
+  _chunk->contacts.clear();
+}
+
+//==============================================================================
+void Recording::clearFrames()
+{
+  mNumFrames = 0;
+  mChunkFirstFrames.clear();
+  mChunkOffsets.clear();
+  mFileEnd = 0;
+  resetChunk(&mChunk, 0);
+  resetChunk(&mReadChunk, 0);
+}
+
+//==============================================================================
+void Recording::finishFrame()
+{
+  mChunk.contactOffsets.push_back(mChunk.contacts.size() / 6);
+  mChunk.numFrames++;
+  mNumFrames++;
+
+  if (isStreaming() && mChunk.numFrames >= mNumFramesPerChunk)
+    writeChunk();
+}
+
+//==============================================================================
+void Recording::writeChunk()
+{
+  if (mChunk.numFrames == 0)
+    return;
+
+  const unsigned int header[2]
+      = {static_cast<unsigned int>(mChunk.numFrames),
+         static_cast<unsigned int>(mChunk.contactOffsets.back())};
+
+  mFile.seekp(mFileEnd);
+  writeRaw(mFile, header, 2);
+  if (!mChunk.configs.empty())
+    writeRaw(mFile, &mChunk.configs[0], mChunk.configs.size());
+  for (int i = 0; i < mChunk.numFrames; ++i)
+  {
+    const unsigned int numContacts
+        = mChunk.contactOffsets[i + 1] - mChunk.contactOffsets[i];
+    writeRaw(mFile, &numContacts, 1);
+  }
+  if (!mChunk.contacts.empty())
+    writeRaw(mFile, &mChunk.contacts[0], mChunk.contacts.size());
+
+  if (mFile.fail())
+    dterr << "Failed to write a chunk of the recording file.\n";
+
+  mChunkFirstFrames.push_back(mChunk.firstFrame);
+  mChunkOffsets.push_back(mFileEnd);
+  mFileEnd = mFile.tellp();
+
+  resetChunk(&mChunk, mNumFrames);
+}
+
+//==============================================================================
+const RecordingChunk& Recording::getChunk(int _frameIdx) const
+{
+  assert(0 <= _frameIdx && _frameIdx < mNumFrames);
+
+  if (_frameIdx >= mChunk.firstFrame)
+    return mChunk;
+
+  if (mReadChunk.firstFrame <= _frameIdx
+      && _frameIdx < mReadChunk.firstFrame + mReadChunk.numFrames)
+  {
+    return mReadChunk;
+  }
+
+  const int chunkIdx = std::upper_bound(mChunkFirstFrames.begin(),
+                                        mChunkFirstFrames.end(), _frameIdx)
+                       - mChunkFirstFrames.begin() - 1;
+  assert(0 <= chunkIdx);
+
+  unsigned int header[2] = {0, 0};
+  mFile.seekg(mChunkOffsets[chunkIdx]);
+  readRaw(mFile, header, 2);
+
+  resetChunk(&mReadChunk, mChunkFirstFrames[chunkIdx]);
+  mReadChunk.numFrames = header[0];
+  mReadChunk.configs.resize(header[0] * mNumGenCoords);
+  mReadChunk.contacts.resize(6 * header[1]);
+
+  bool succeeded = true;
+  if (!mReadChunk.configs.empty())
+  {
+    succeeded = readRaw(mFile, &mReadChunk.configs[0],
+                        mReadChunk.configs.size());
+  }
+  for (int i = 0; i < mReadChunk.numFrames; ++i)
+  {
+    unsigned int numContacts = 0;
+    succeeded = readRaw(mFile, &numContacts, 1) && succeeded;
+    mReadChunk.contactOffsets.push_back(mReadChunk.contactOffsets.back()
+                                        + numContacts);
+  }
+  if (!mReadChunk.contacts.empty())
+  {
+    succeeded = readRaw(mFile, &mReadChunk.contacts[0],
+                        mReadChunk.contacts.size()) && succeeded;
+  }
+
+  if (!succeeded
+      || static_cast<unsigned int>(mReadChunk.contactOffsets.back())
+         != header[1])
+  {
+    dterr << "Failed to read frame [" << _frameIdx << "] from the recording "
+          << "file.\n";
+    mFile.clear();
+    std::fill(mReadChunk.configs.begin(), mReadChunk.configs.end(), 0.0);
+    mReadChunk.contactOffsets.assign(mReadChunk.numFrames + 1, 0);
+  }
+
+  return mReadChunk;
 }
 
 }  // namespace simulation
 }  // namespace dart
-
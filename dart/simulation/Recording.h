@@ -43,19 +43,60 @@
 #ifndef DART_SIMULATION_RECORDING_H_
 #define DART_SIMULATION_RECORDING_H_
 
+#include <fstream>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
 
 namespace dart {
 
+namespace collision {
+class CollisionDetector;
+}  // namespace collision
+
 namespace dynamics {
 class Skeleton;
 }  // namespace dynamics
 
 namespace simulation {
 
+/// \brief Consecutive frames of a Recording. The configurations of all the
+/// frames share a fixed stride and the contacts of each frame are stored in a
+/// separate variable-length section.
+struct RecordingChunk
+{
+  /// \brief Index of the first frame of the chunk
+  int firstFrame;
+
+  /// \brief Number of frames of the chunk
+  int numFrames;
+
+  /// \brief Configurations of all the skeletons, one frame after another
+  std::vector<double> configs;
+
+  /// \brief The contacts of the i-th frame are the contacts from
+  /// contactOffsets[i] to contactOffsets[i + 1] - 1
+  std::vector<int> contactOffsets;
+
+  /// \brief Contact point and force of each contact
+  std::vector<double> contacts;
+};
+
 /// \brief class Recording
+///
+/// A recording keeps its frames in memory unless it streams them to a file
+/// with startStreaming() or plays a file back with loadStream(). A streamed
+/// recording keeps only the frames of the chunk being written in memory and
+/// reads other frames back from the file one chunk at a time.
+///
+/// File layout (native byte order):
+///   header : char[4] "DREC", uint32 version, uint32 numSkeletons,
+///            uint32 numGenCoords[numSkeletons]
+///   chunk  : uint32 numFrames, uint32 numContacts,
+///            double configs[numFrames * sum(numGenCoords)],
+///            uint32 numContactsOfFrame[numFrames],
+///            double contacts[numContacts * 6] (point and force)
 class Recording
 {
 public:
@@ -65,7 +106,8 @@ public:
   /// \brief Create Recording with a list of number of dofs
   explicit Recording(const std::vector<int>& _skelDofs);
 
-  /// \brief Destructor
+  /// \brief Destructor. The frames not yet written to the stream file are
+  /// written.
   virtual ~Recording();
 
   /// \brief Get number of frames
@@ -97,18 +139,93 @@ public:
   /// _frameIdx
   Eigen::Vector3d getContactForce(int _frameIdx, int _contactIdx) const;
 
-  /// \brief Add state
+  /// \brief Add state, which is the configurations of all the skeletons
+  /// followed by the point and the force of each contact
   void addState(const Eigen::VectorXd& _state);
 
-  /// \brief Update list for number of generalized coordinates
+  /// \brief Add a frame with the configurations of _skeletons and the
+  /// contacts of _collisionDetector without a temporary state vector
+  void addFrame(const std::vector<dynamics::Skeleton*>& _skeletons,
+                collision::CollisionDetector* _collisionDetector);
+
+  /// \brief Update list for number of generalized coordinates. The recorded
+  /// frames are cleared if the number of generalized coordinates changes.
   void updateNumGenCoords(const std::vector<dynamics::Skeleton*>& _skeletons);
 
+  //--------------------------------------------------------------------------
+  // Streaming
+  //--------------------------------------------------------------------------
+  /// \brief Stream this recording to a new file. The frames recorded so far
+  /// are written to it, and from then on at most _numFramesPerChunk frames are
+  /// kept in memory. Return false if the file cannot be opened.
+  bool startStreaming(const std::string& _fileName,
+                      int _numFramesPerChunk = 256);
+
+  /// \brief Replace this recording with the frames of a file written by
+  /// startStreaming(). The frames are read on demand, and new frames are
+  /// appended to the file. Return false if the file is not a valid recording.
+  bool loadStream(const std::string& _fileName,
+                  int _numFramesPerChunk = 256);
+
+  /// \brief Write the frames kept in memory to the stream file
+  void flush();
+
+  /// \brief Close the stream file. The frames are dropped, so this recording
+  /// is empty afterwards.
+  void stopStreaming();
+
+  /// \brief Return true if this recording is streamed to a file
+  bool isStreaming() const;
+
 private:
-  /// \brief Baked states
-  std::vector<Eigen::VectorXd> mBakedStates;
+  /// \brief Empty _chunk so that it holds frames from _firstFrame on. The
+  /// capacity of its buffers is kept.
+  static void resetChunk(RecordingChunk* _chunk, int _firstFrame);
+
+  /// \brief Drop all frames and the chunk index of the stream file
+  void clearFrames();
+
+  /// \brief Finish the frame whose configurations and contacts were appended
+  /// to mChunk
+  void finishFrame();
+
+  /// \brief Write mChunk as a chunk of the stream file and clear it
+  void writeChunk();
+
+  /// \brief Get the chunk containing frame _frameIdx, reading it from the
+  /// stream file if it is not in memory
+  const RecordingChunk& getChunk(int _frameIdx) const;
+
+  /// \brief Total number of generalized coordinates of the skeletons
+  int mNumGenCoords;
 
   /// \brief Number of generalized coordinates for skeletons
   std::vector<int> mNumGenCoordsForSkeletons;
+
+  /// \brief Number of frames
+  int mNumFrames;
+
+  /// \brief Frames kept in memory. With streaming, these are the frames not
+  /// yet written to the file.
+  RecordingChunk mChunk;
+
+  /// \brief Stream file
+  mutable std::fstream mFile;
+
+  /// \brief Maximum number of frames of a chunk of the stream file
+  int mNumFramesPerChunk;
+
+  /// \brief Index of the first frame of each chunk of the stream file
+  std::vector<int> mChunkFirstFrames;
+
+  /// \brief Position of each chunk in the stream file
+  std::vector<std::streamoff> mChunkOffsets;
+
+  /// \brief End of the last complete chunk of the stream file
+  std::streamoff mFileEnd;
+
+  /// \brief Chunk read back from the stream file most recently
+  mutable RecordingChunk mReadChunk;
 };
 
 }  // namespace simulation
@@ -42,6 +42,8 @@
 
 #include "dart/simulation/World.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -51,6 +53,7 @@
 #include "dart/dynamics/GenCoord.h"
 #include "dart/dynamics/Skeleton.h"
 #include "dart/constraint/ConstraintSolver.h"
+#include "dart/collision/CollisionDetector.h"
 
 namespace dart {
 namespace simulation {
@@ -61,6 +64,12 @@ World::World()
     mGravity(0.0, 0.0, -9.81),
     mTime(0.0),
     mTimeStep(0.001),
+    mIsAdaptiveTimeStepping(false),
+    mMinTimeStep(1e-4),
+    mMaxTimeStep(1e-2),
+    mAdaptiveTolerance(1e-6),
+    mAdaptiveTimeStep(mTimeStep),
+    mAdaptiveNumContacts(0),
     mFrame(0),
     mIntegrator(new integration::SemiImplicitEulerIntegrator()),
     mConstraintSolver(new constraint::ConstraintSolver(mTimeStep)),
@@ -117,100 +126,91 @@ void World::setGenVels(const Eigen::VectorXd& _genVels)
 //==============================================================================
 Eigen::VectorXd World::getConfigs() const
 {
-  Eigen::VectorXd config(mIndices.back());
+  Eigen::VectorXd configs;
+  getConfigs(&configs);
+  return configs;
+}
+
+//==============================================================================
+Eigen::VectorXd World::getGenVels() const
+{
+  Eigen::VectorXd genVels;
+  getGenVels(&genVels);
+  return genVels;
+}
+
+//==============================================================================
+Eigen::VectorXd World::evalGenAccs()
+{
+  Eigen::VectorXd genAccs;
+  evalGenAccs(&genAccs);
+  return genAccs;
+}
 
-  for (unsigned int i = 0; i < getNumSkeletons(); i++)
+//==============================================================================
+void World::integrateConfigs(const Eigen::VectorXd& _genVels, double _dt)
+{
+  for (int i = 0; i < getNumSkeletons(); i++)
   {
     int start = mIndices[i];
-    int size = getSkeleton(i)->getNumGenCoords();
+    int size  = getSkeleton(i)->getNumGenCoords();
 
-    if (size == 0 || !mSkeletons[i]->isMobile())
+    if (size == 0 || !mSkeletons[i]->isMobile()
+        || mSkeletons[i]->isVariationalIntegration())
       continue;
 
-    config.segment(start, size) = getSkeleton(i)->getConfigs();
+    // Same as setGenVels(_genVels.segment(start, size), true, false) without
+    // copying the segment into a temporary vector
+    for (int j = 0; j < size; ++j)
+      mSkeletons[i]->getGenCoord(j)->setVel(_genVels[start + j]);
+    mSkeletons[i]->computeForwardKinematics(false, true, false);
+    mSkeletons[i]->integrateConfigs(_dt);
   }
-
-  return config;
 }
 
 //==============================================================================
-Eigen::VectorXd World::getGenVels() const
+void World::integrateGenVels(const Eigen::VectorXd& _genAccs, double _dt)
 {
-  Eigen::VectorXd genVels(mIndices.back());
-
-  for (unsigned int i = 0; i < getNumSkeletons(); i++)
+  for (int i = 0; i < getNumSkeletons(); i++)
   {
     int start = mIndices[i];
-    int size = getSkeleton(i)->getNumGenCoords();
+    int size  = getSkeleton(i)->getNumGenCoords();
 
-    if (size == 0 || !mSkeletons[i]->isMobile())
+    if (size == 0 || !mSkeletons[i]->isMobile()
+        || mSkeletons[i]->isVariationalIntegration())
       continue;
 
-    genVels.segment(start, size) = getSkeleton(i)->getGenVels();
+    for (int j = 0; j < size; ++j)
+      mSkeletons[i]->getGenCoord(j)->setAcc(_genAccs[start + j]);
+    mSkeletons[i]->integrateGenVels(_dt);
   }
-
-  return genVels;
 }
 
 //==============================================================================
-Eigen::VectorXd World::evalGenAccs()
+void World::getConfigs(Eigen::VectorXd* _configs) const
 {
-  // Compute unconstrained acceleration.
-  for (std::vector<dynamics::Skeleton*>::iterator it = mSkeletons.begin();
-       it != mSkeletons.end(); ++it)
-  {
-    // Transmitted body force doesn't need to be computed here since it will be
-    // computed at below.
-    (*it)->computeForwardDynamics();
-
-    // TODO(JS): Just do Euler integration for test
-//    (*it)->integrateConfigs(mTimeStep);
-//    (*it)->integrateGenVels(mTimeStep);
-  }
-
-//  // compute constraint (contact/contact, joint limit) forces
-//  mConstraintHandler->computeConstraintForces();
+  // The entries of immobile skeletons are zero as in evalGenAccs()
+  _configs->setZero(mIndices.back());
 
-//  // set constraint force
-//  for (int i = 0; i < getNumSkeletons(); i++)
-//  {
-//    // skip immobile objects in forward simulation
-//    if (!mSkeletons[i]->isMobile() || mSkeletons[i]->getNumGenCoords() == 0)
-//      continue;
-
-//    mSkeletons[i]->setConstraintForceVector(
-//          mConstraintHandler->getTotalConstraintForce(i) -
-//          mConstraintHandler->getContactForce(i));
-//  }
-
-//  // compute forward dynamics
-//  for (std::vector<dynamics::Skeleton*>::iterator it = mSkeletons.begin();
-//       it != mSkeletons.end(); ++it)
-//  {
-//    (*it)->computeForwardDynamics();
-//  }
-
-  // compute derivatives for integration
-  Eigen::VectorXd genAccs = Eigen::VectorXd::Zero(mIndices.back());
-  for (unsigned int i = 0; i < getNumSkeletons(); i++)
+  for (int i = 0; i < getNumSkeletons(); i++)
   {
-    // skip immobile objects in forward simulation
-    if (!mSkeletons[i]->isMobile() || mSkeletons[i]->getNumGenCoords() == 0)
-      continue;
-
     int start = mIndices[i];
-    int size = getSkeleton(i)->getNumGenCoords();
+    int size  = getSkeleton(i)->getNumGenCoords();
 
-    // set accelerations
-    genAccs.segment(start, size) = getSkeleton(i)->getGenAccs();
-  }
+    if (size == 0 || !mSkeletons[i]->isMobile())
+      continue;
 
-  return genAccs;
+    for (int j = 0; j < size; ++j)
+      (*_configs)[start + j] = mSkeletons[i]->getGenCoord(j)->getPos();
+  }
 }
 
 //==============================================================================
-void World::integrateConfigs(const Eigen::VectorXd& _genVels, double _dt)
+void World::getGenVels(Eigen::VectorXd* _genVels) const
 {
+  // The entries of immobile skeletons are zero as in evalGenAccs()
+  _genVels->setZero(mIndices.back());
+
   for (int i = 0; i < getNumSkeletons(); i++)
   {
     int start = mIndices[i];
@@ -219,26 +219,42 @@ void World::integrateConfigs(const Eigen::VectorXd& _genVels, double _dt)
     if (size == 0 || !mSkeletons[i]->isMobile())
       continue;
 
-    // TODO(JS)
-//    getSkeleton(i)->setGenVels(_genVels.segment(start, size), false, false);
-    getSkeleton(i)->setGenVels(_genVels.segment(start, size), true, false);
-    getSkeleton(i)->integrateConfigs(_dt);
+    for (int j = 0; j < size; ++j)
+      (*_genVels)[start + j] = mSkeletons[i]->getGenCoord(j)->getVel();
   }
 }
 
 //==============================================================================
-void World::integrateGenVels(const Eigen::VectorXd& _genAccs, double _dt)
+void World::evalGenAccs(Eigen::VectorXd* _genAccs)
 {
+  // Compute unconstrained acceleration.
+  for (std::vector<dynamics::Skeleton*>::iterator it = mSkeletons.begin();
+       it != mSkeletons.end(); ++it)
+  {
+    // The generalized accelerations of variationally integrated skeletons are
+    // those of their last step
+    if ((*it)->isVariationalIntegration())
+      continue;
+
+    // Transmitted body force doesn't need to be computed here since it will be
+    // computed at below.
+    (*it)->computeForwardDynamics();
+  }
+
+  // compute derivatives for integration
+  _genAccs->setZero(mIndices.back());
   for (int i = 0; i < getNumSkeletons(); i++)
   {
+    // skip immobile objects in forward simulation
+    if (!mSkeletons[i]->isMobile() || mSkeletons[i]->getNumGenCoords() == 0)
+      continue;
+
     int start = mIndices[i];
     int size  = getSkeleton(i)->getNumGenCoords();
 
-    if (size == 0 || !mSkeletons[i]->isMobile())
-      continue;
-
-    getSkeleton(i)->setGenAccs(_genAccs.segment(start, size), false);
-    getSkeleton(i)->integrateGenVels(_dt);
+    // set accelerations
+    for (int j = 0; j < size; ++j)
+      (*_genAccs)[start + j] = mSkeletons[i]->getGenCoord(j)->getAcc();
   }
 }
 
@@ -263,12 +279,74 @@ double World::getTimeStep() const
   return mTimeStep;
 }
 
+//==============================================================================
+void World::setAdaptiveTimeStepping(bool _isAdaptive)
+{
+  mIsAdaptiveTimeStepping = _isAdaptive;
+  mAdaptiveTimeStep = std::min(std::max(mTimeStep, mMinTimeStep),
+                               mMaxTimeStep);
+  mAdaptiveNumContacts = 0;
+}
+
+//==============================================================================
+bool World::isAdaptiveTimeStepping() const
+{
+  return mIsAdaptiveTimeStepping;
+}
+
+//==============================================================================
+void World::setTimeStepLimits(double _minTimeStep, double _maxTimeStep)
+{
+  assert(0.0 < _minTimeStep && _minTimeStep <= _maxTimeStep
+         && "Invalid time step limits.");
+
+  mMinTimeStep = _minTimeStep;
+  mMaxTimeStep = _maxTimeStep;
+  mAdaptiveTimeStep = std::min(std::max(mAdaptiveTimeStep, mMinTimeStep),
+                               mMaxTimeStep);
+}
+
+//==============================================================================
+double World::getMinTimeStep() const
+{
+  return mMinTimeStep;
+}
+
+//==============================================================================
+double World::getMaxTimeStep() const
+{
+  return mMaxTimeStep;
+}
+
+//==============================================================================
+void World::setAdaptiveTolerance(double _tolerance)
+{
+  assert(_tolerance > 0.0 && "Invalid tolerance.");
+
+  mAdaptiveTolerance = _tolerance;
+}
+
+//==============================================================================
+double World::getAdaptiveTolerance() const
+{
+  return mAdaptiveTolerance;
+}
+
 //==============================================================================
 void World::step()
 {
   // Integrate velocity unconstrained skeletons
   mIntegrator->integrateVel(this, mTimeStep);
 
+  // Solve the discrete Euler-Lagrange equations of the skeletons that are
+  // integrated variationally, which are skipped by the integrator
+  for (std::vector<dynamics::Skeleton*>::iterator it = mSkeletons.begin();
+       it != mSkeletons.end(); ++it)
+  {
+    if ((*it)->isMobile() && (*it)->isVariationalIntegration())
+      (*it)->computeVariationalStep(mTimeStep);
+  }
+
   // Detect active constraints and compute constraint impulses
   mConstraintSolver->solve();
 
@@ -291,6 +369,16 @@ void World::step()
 
   mIntegrator->integratePos(this, mTimeStep);
 
+  for (std::vector<dynamics::Skeleton*>::iterator it = mSkeletons.begin();
+       it != mSkeletons.end(); ++it)
+  {
+    if ((*it)->isMobile() && (*it)->isVariationalIntegration())
+      (*it)->integrateVariationalConfigs(mTimeStep);
+  }
+
+  // Remove penetration with the split impulse pseudo-velocities, if any
+  mConstraintSolver->integratePositionCorrections(mTimeStep);
+
 //  dtdbg << "GenCoordSystem::getConfigs(): "
 //        << getConfigs().transpose() << std::endl;
 
@@ -307,6 +395,93 @@ void World::step()
   mFrame++;
 }
 
+//==============================================================================
+int World::advance(double _duration)
+{
+  assert(_duration >= 0.0 && "Invalid duration.");
+
+  mAdvanceTimeSteps.clear();
+
+  const double fixedTimeStep = mTimeStep;
+  const double endTime = mTime + _duration;
+  const double timeEpsilon = 1e-12 * std::max(1.0, std::fabs(endTime));
+
+  while (endTime - mTime > timeEpsilon)
+  {
+    double timeStep = mIsAdaptiveTimeStepping ? mAdaptiveTimeStep
+                                              : fixedTimeStep;
+    timeStep = std::min(timeStep, endTime - mTime);
+    if (timeStep != mTimeStep)
+      setTimeStep(timeStep);
+
+    if (mIsAdaptiveTimeStepping)
+    {
+      getGenVels(&mAdaptiveGenVels);
+      step();
+      _updateAdaptiveTimeStep();
+    }
+    else
+    {
+      step();
+    }
+
+    mAdvanceTimeSteps.push_back(timeStep);
+  }
+
+  // Avoid accumulating round-off of the step sizes in the time
+  if (!mAdvanceTimeSteps.empty())
+    mTime = endTime;
+
+  // The adaptive steps only apply within advance(), so step() keeps using the
+  // time step of the world
+  if (mTimeStep != fixedTimeStep)
+    setTimeStep(fixedTimeStep);
+
+  return mAdvanceTimeSteps.size();
+}
+
+//==============================================================================
+const std::vector<double>& World::getAdvanceTimeSteps() const
+{
+  return mAdvanceTimeSteps;
+}
+
+//==============================================================================
+void World::_updateAdaptiveTimeStep()
+{
+  // The step just taken moved the positions by dt * v1 (semi-implicit Euler,
+  // first order). The trapezoidal rule, dt * (v0 + v1) / 2, is second order
+  // for the same velocities, so their difference, dt / 2 * |v1 - v0|, is an
+  // embedded estimate of the local position error of the step. It includes
+  // the velocity changes of constraint impulses.
+  getGenVels(&mAdaptiveNextGenVels);
+  mAdaptiveNextGenVels -= mAdaptiveGenVels;
+  const double error
+      = 0.5 * mTimeStep * mAdaptiveNextGenVels.lpNorm<Eigen::Infinity>();
+
+  int numContacts
+      = mConstraintSolver->getCollisionDetector()->getNumContacts();
+
+  if (numContacts > mAdaptiveNumContacts)
+  {
+    // New contacts are impacts, which are resolved with the smallest steps
+    mAdaptiveTimeStep = mMinTimeStep;
+  }
+  else
+  {
+    // The error is second order in the time step. Steps are not rejected and
+    // repeated, so the estimate of this step sizes the next one, and the
+    // step shrinks by up to a factor of five at once.
+    double scale = 2.0;
+    if (error > 0.0)
+      scale = std::min(2.0, 0.9 * std::sqrt(mAdaptiveTolerance / error));
+    mAdaptiveTimeStep = std::min(std::max(std::max(0.2, scale) * mTimeStep,
+                                          mMinTimeStep), mMaxTimeStep);
+  }
+
+  mAdaptiveNumContacts = numContacts;
+}
+
 //==============================================================================
 void World::setTime(double _time)
 {
@@ -459,23 +634,8 @@ constraint::ConstraintSolver* World::getConstraintSolver() const
 //==============================================================================
 void World::bake()
 {
-  collision::CollisionDetector* cd
-      = getConstraintSolver()->getCollisionDetector();
-  int nContacts = cd->getNumContacts();
-  int nSkeletons = getNumSkeletons();
-  Eigen::VectorXd state(getIndex(nSkeletons) + 6 * nContacts);
-  for (unsigned int i = 0; i < getNumSkeletons(); i++)
-  {
-    state.segment(getIndex(i), getSkeleton(i)->getNumGenCoords())
-        = getSkeleton(i)->getConfigs();
-  }
-  for (int i = 0; i < nContacts; i++)
-  {
-    int begin = getIndex(nSkeletons) + i * 6;
-    state.segment(begin, 3)     = cd->getContact(i).point;
-    state.segment(begin + 3, 3) = cd->getContact(i).force;
-  }
-  mRecording->addState(state);
+  mRecording->addFrame(mSkeletons,
+                       getConstraintSolver()->getCollisionDetector());
 }
 
 //==============================================================================
@@ -106,6 +106,15 @@ public:
   // Documentation inherited
   virtual void integrateGenVels(const Eigen::VectorXd& _genAccs, double _dt);
 
+  // Documentation inherited
+  virtual void getConfigs(Eigen::VectorXd* _configs) const;
+
+  // Documentation inherited
+  virtual void getGenVels(Eigen::VectorXd* _genVels) const;
+
+  // Documentation inherited
+  virtual void evalGenAccs(Eigen::VectorXd* _genAccs);
+
   //--------------------------------------------------------------------------
   // Simulation
   //--------------------------------------------------------------------------
@@ -121,6 +130,19 @@ public:
   /// \brief Get the number of simulated frames
   int getSimFrames() const;
 
+  /// \brief Step the world until the current time has advanced by _duration.
+  ///
+  /// With adaptive time stepping the step sizes are chosen by error control
+  /// between the minimum and maximum time steps; otherwise the time step is
+  /// used. The last step is shortened to end exactly at the target time. The
+  /// time step of the world is restored afterwards.
+  /// \return The number of steps taken. Their sizes are available from
+  /// getAdvanceTimeSteps().
+  int advance(double _duration);
+
+  /// \brief Get the sizes of the steps taken by the last call of advance()
+  const std::vector<double>& getAdvanceTimeSteps() const;
+
   //--------------------------------------------------------------------------
   // Properties
   //--------------------------------------------------------------------------
@@ -136,6 +158,34 @@ public:
   /// \brief Get time step
   double getTimeStep() const;
 
+  /// \brief Set whether advance() adapts the time step. The step size is
+  /// controlled by an embedded estimate of the local position error of the
+  /// semi-implicit Euler step, its difference from the trapezoidal rule
+  /// 0.5 * dt * |v1 - v0|, and drops to the minimum time step when new
+  /// contacts appear. Steps are not rejected: the estimate of a step sizes the
+  /// next one.
+  void setAdaptiveTimeStepping(bool _isAdaptive);
+
+  /// \brief Get whether advance() adapts the time step
+  bool isAdaptiveTimeStepping() const;
+
+  /// \brief Set the minimum and maximum time steps of adaptive time stepping
+  void setTimeStepLimits(double _minTimeStep, double _maxTimeStep);
+
+  /// \brief Get the minimum time step of adaptive time stepping
+  double getMinTimeStep() const;
+
+  /// \brief Get the maximum time step of adaptive time stepping
+  double getMaxTimeStep() const;
+
+  /// \brief Set the tolerance of the local position error per step of
+  /// adaptive time stepping
+  void setAdaptiveTolerance(double _tolerance);
+
+  /// \brief Get the tolerance of the local position error per step of
+  /// adaptive time stepping
+  double getAdaptiveTolerance() const;
+
   //--------------------------------------------------------------------------
   // Structueral Properties
   //--------------------------------------------------------------------------
@@ -197,6 +247,33 @@ protected:
   /// \brief Simulation time step
   double mTimeStep;
 
+  /// \brief Whether advance() adapts the time step
+  bool mIsAdaptiveTimeStepping;
+
+  /// \brief Minimum time step of adaptive time stepping
+  double mMinTimeStep;
+
+  /// \brief Maximum time step of adaptive time stepping
+  double mMaxTimeStep;
+
+  /// \brief Tolerance of the local position error of adaptive time stepping
+  double mAdaptiveTolerance;
+
+  /// \brief Time step proposed for the next adaptive step
+  double mAdaptiveTimeStep;
+
+  /// \brief Generalized velocities at the beginning of an adaptive step
+  Eigen::VectorXd mAdaptiveGenVels;
+
+  /// \brief Generalized velocities at the end of an adaptive step
+  Eigen::VectorXd mAdaptiveNextGenVels;
+
+  /// \brief Number of contacts of the last adaptive step
+  int mAdaptiveNumContacts;
+
+  /// \brief Sizes of the steps taken by the last call of advance()
+  std::vector<double> mAdvanceTimeSteps;
+
   /// \brief Current simulation time
   double mTime;
 
@@ -211,6 +288,10 @@ protected:
 
   /// \brief
   Recording* mRecording;
+
+private:
+  /// \brief Choose the next adaptive time step from the step just taken
+  void _updateAdaptiveTimeStep();
 };
 
 }  // namespace simulation
@@ -35,6 +35,8 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 
 #include <Eigen/Dense>
@@ -46,8 +48,13 @@
 #include "dart/math/Geometry.h"
 #include "dart/math/Helpers.h"
 #include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/constraint/AdaptiveLCPSolver.h"
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/constraint/ContactConstraint.h"
+#include "dart/constraint/LCPProblemFile.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/Skeleton.h"
+#include "dart/lcpsolver/Lemke.h"
 #include "dart/simulation/World.h"
 #include "dart/utils/SkelParser.h"
 #include "dart/utils/Paths.h"
@@ -62,6 +69,13 @@ public:
   //
   void SingleContactTest(const std::string& _fileName);
 
+  //
+  void AdaptiveLCPSolverTest(size_t _maxDirectDimension);
+
+  //
+  void AdaptiveLCPSolverFallbackTest(size_t _maxDirectDimension,
+                                     double _residualTolerance);
+
 protected:
   // Sets up the test fixture.
   virtual void SetUp();
@@ -242,6 +256,430 @@ TEST_F(ConstraintTest, SingleContactTest)
   SingleContactTest(getList()[0]);
 }
 
+//==============================================================================
+void ConstraintTest::AdaptiveLCPSolverTest(size_t _maxDirectDimension)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  World* world = new World;
+  world->setGravity(Vector3d(0.0, -10.00, 0.0));
+  world->setTimeStep(0.001);
+
+  ConstraintSolver* cs = world->getConstraintSolver();
+  cs->setCollisionDetector(new DARTCollisionDetector());
+  AdaptiveLCPSolver* lcpSolver = new AdaptiveLCPSolver(world->getTimeStep());
+  lcpSolver->setMaxDirectDimension(_maxDirectDimension);
+  cs->setLCPSolver(lcpSolver);
+  EXPECT_EQ(cs->getLCPSolver(), lcpSolver);
+
+  // The ground box is centered at the origin, so its top face is at 0.05
+  Skeleton* sphereSkel = createSphere(0.05, Vector3d(0.0, 0.1, 0.0));
+  world->addSkeleton(sphereSkel);
+
+  Skeleton* groundSkel = createGround(Vector3d(10000.0, 0.1, 10000.0));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+
+  size_t numGroups = 0;
+  for (int i = 0; i < 200; ++i)
+  {
+    world->step();
+
+    const std::vector<LCPGroupReport>& reports = lcpSolver->getGroupReports();
+    numGroups += reports.size();
+
+    for (size_t j = 0; j < reports.size(); ++j)
+    {
+      if (reports[j].dimension <= _maxDirectDimension)
+      {
+        EXPECT_EQ(reports[j].firstPath, LCP_PATH_DIRECT);
+      }
+      EXPECT_GE(reports[j].solveTime, 0.0);
+    }
+  }
+
+  // The sphere rests on the ground, so every step after the first contact
+  // solves one group
+  EXPECT_GT(numGroups, 0u);
+
+  const LCPSolverStatistics& stats = lcpSolver->getStatistics();
+  EXPECT_EQ(stats.numDirect + stats.numIterative, numGroups);
+  EXPECT_LE(stats.numFailures, stats.numFallbacks);
+  if (_maxDirectDimension == 0)
+  {
+    EXPECT_EQ(stats.numDirect, 0u);
+  }
+
+  // The sphere should neither sink into nor bounce off the ground
+  BodyNode* sphere = sphereSkel->getBodyNode(0);
+  EXPECT_NEAR(sphere->getWorldTransform().translation()[1], 0.1, 1e-3);
+
+  lcpSolver->resetStatistics();
+  EXPECT_EQ(lcpSolver->getStatistics().numDirect, 0u);
+
+  delete world;
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, AdaptiveLCPSolver)
+{
+  // Every group is small enough for the direct solver
+  AdaptiveLCPSolverTest(60);
+
+  // Every well-conditioned group goes to the iterative solver
+  AdaptiveLCPSolverTest(0);
+}
+
+//==============================================================================
+void ConstraintTest::AdaptiveLCPSolverFallbackTest(size_t _maxDirectDimension,
+                                                   double _residualTolerance)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  World* world = new World;
+  world->setGravity(Vector3d(0.0, -10.00, 0.0));
+  world->setTimeStep(0.001);
+
+  // A single PGS sweep cannot reach the residual tolerance, so every group
+  // is solved by both paths
+  ConstraintSolver* cs = world->getConstraintSolver();
+  cs->setCollisionDetector(new DARTCollisionDetector());
+  AdaptiveLCPSolver* lcpSolver = new AdaptiveLCPSolver(world->getTimeStep());
+  lcpSolver->setMaxDirectDimension(_maxDirectDimension);
+  lcpSolver->setMaxIterations(1);
+  lcpSolver->setResidualTolerance(_residualTolerance);
+  cs->setLCPSolver(lcpSolver);
+
+  // The contacts of a box resting on the ground are coupled
+  Skeleton* boxSkel = createBox(Vector3d::Constant(0.1),
+                                Vector3d(0.0, 0.1, 0.0));
+  world->addSkeleton(boxSkel);
+
+  Skeleton* groundSkel = createGround(Vector3d(10000.0, 0.1, 10000.0));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+
+  size_t numGroups = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    world->step();
+
+    const std::vector<LCPGroupReport>& reports = lcpSolver->getGroupReports();
+    numGroups += reports.size();
+
+    for (size_t j = 0; j < reports.size(); ++j)
+    {
+      // The direct solution is kept whichever path ran first, since it is
+      // the better one
+      EXPECT_TRUE(reports[j].fellBack);
+      EXPECT_EQ(reports[j].finalPath, LCP_PATH_DIRECT);
+      EXPECT_LT(reports[j].residual, 1e-6);
+    }
+  }
+  EXPECT_GT(numGroups, 0u);
+
+  const LCPSolverStatistics& stats = lcpSolver->getStatistics();
+  EXPECT_GT(stats.numFallbacks, 0u);
+  EXPECT_EQ(stats.numFallbacks, numGroups);
+
+  // The kept direct solution rests the box on the ground
+  BodyNode* box = boxSkel->getBodyNode(0);
+  EXPECT_NEAR(box->getWorldTransform().translation()[1], 0.1, 1e-3);
+
+  delete world;
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, AdaptiveLCPSolverFallback)
+{
+  // PGS first; the direct fallback replaces its solution
+  AdaptiveLCPSolverFallbackTest(0, 1e-12);
+
+  // Direct first with a tolerance below round-off; the PGS fallback is worse,
+  // so the direct solution is swapped back
+  AdaptiveLCPSolverFallbackTest(60, 1e-300);
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, LCPCapture)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  const std::string fileName = "testConstraint_LCPCapture.lcp";
+
+  World* world = new World;
+  world->setGravity(Vector3d(0.0, -10.00, 0.0));
+  world->setTimeStep(0.001);
+
+  ConstraintSolver* cs = world->getConstraintSolver();
+  cs->setCollisionDetector(new DARTCollisionDetector());
+
+  // The ground box is centered at the origin, so its top face is at 0.05
+  world->addSkeleton(createSphere(0.05, Vector3d(0.0, 0.1, 0.0)));
+  Skeleton* groundSkel = createGround(Vector3d(10000.0, 0.1, 10000.0));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+
+  EXPECT_TRUE(cs->startLCPCapture(fileName));
+  EXPECT_TRUE(cs->isCapturingLCP());
+  for (int i = 0; i < 100; ++i)
+    world->step();
+  cs->stopLCPCapture();
+  EXPECT_FALSE(cs->isCapturingLCP());
+
+  LCPProblemReader reader;
+  ASSERT_TRUE(reader.open(fileName));
+  std::vector<LCPProblem> problems = reader.readAll();
+  EXPECT_FALSE(problems.empty());
+
+  for (size_t i = 0; i < problems.size(); ++i)
+  {
+    const LCPProblem& p = problems[i];
+    const int n = p.b.size();
+
+    EXPECT_LT(p.frame, 100u);
+    EXPECT_EQ(p.A.rows(), n);
+    EXPECT_TRUE(p.A.isApprox(p.A.transpose()));
+
+    // The captured solution is the one applied by the Dantzig solver, so it
+    // satisfies the unilateral normal constraints
+    for (int j = 0; j < n; ++j)
+    {
+      if (p.findex[j] < 0)
+      {
+        EXPECT_GE(p.x[j], p.lo[j] - 1e-9);
+      }
+    }
+  }
+  reader.close();
+
+  // A record whose dimension does not fit the rest of the file is rejected
+  // before anything is allocated
+  const unsigned int corruptRecords[2][4]
+      = {{1u, 0u, 0u, 0xFFFFFFFFu}, {1u, 0u, 0u, 2u}};
+  for (int i = 0; i < 2; ++i)
+  {
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+    file.write("DLCP", 4);
+    file.write(reinterpret_cast<const char*>(corruptRecords[i]),
+               sizeof(corruptRecords[i]));
+    file.close();
+
+    LCPProblem problem;
+    ASSERT_TRUE(reader.open(fileName));
+    EXPECT_FALSE(reader.read(&problem));
+    reader.close();
+  }
+
+  delete world;
+  std::remove(fileName.c_str());
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, SplitImpulse)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  const double boxSize = 0.1;
+  const double timeStep = 0.01;
+
+  double maxPenetration[2];
+  double kineticEnergy[2];
+
+  for (int mode = 0; mode < 2; ++mode)
+  {
+    ContactConstraint::setSplitImpulseEnabled(mode == 1);
+
+    World* world = new World;
+    world->setGravity(Vector3d(0.0, -9.81, 0.0));
+    world->setTimeStep(timeStep);
+    world->getConstraintSolver()->setCollisionDetector(
+          new DARTCollisionDetector());
+
+    Skeleton* ground = createGround(Vector3d(10.0, boxSize, 10.0));
+    ground->setMobile(false);
+    world->addSkeleton(ground);
+
+    std::vector<Skeleton*> boxes;
+    for (int i = 0; i < 3; ++i)
+    {
+      Vector3d position(0.0, (i + 1) * boxSize * 1.001, 0.0);
+      boxes.push_back(createBox(Vector3d::Constant(boxSize), position));
+      world->addSkeleton(boxes.back());
+    }
+
+    CollisionDetector* cd = world->getConstraintSolver()->getCollisionDetector();
+    maxPenetration[mode] = 0.0;
+    for (int i = 0; i < 200; ++i)
+    {
+      world->step();
+      if (world->getTime() < 1.0)
+        continue;
+
+      for (size_t j = 0; j < cd->getNumContacts(); ++j)
+      {
+        maxPenetration[mode] = std::max(maxPenetration[mode],
+                                        cd->getContact(j).penetrationDepth);
+      }
+    }
+
+    kineticEnergy[mode] = 0.0;
+    for (size_t i = 0; i < boxes.size(); ++i)
+      kineticEnergy[mode] += boxes[i]->getKineticEnergy();
+
+    // The stack is still standing
+    Vector3d top = boxes.back()->getWorldCOM();
+    EXPECT_NEAR(top[0], 0.0, 0.5 * boxSize);
+    EXPECT_NEAR(top[1], 3.0 * boxSize, 0.5 * boxSize);
+    EXPECT_NEAR(top[2], 0.0, 0.5 * boxSize);
+
+    delete world;
+  }
+
+  ContactConstraint::setSplitImpulseEnabled(false);
+
+  // Split impulse removes the penetration that Baumgarte stabilization leaves
+  // at this time step without adding energy
+  EXPECT_LT(maxPenetration[1], 1e-4);
+  EXPECT_LT(maxPenetration[1], maxPenetration[0]);
+  EXPECT_LT(kineticEnergy[1], 1e-6);
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, ContactManifold)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+
+  Skeleton* ground = createGround(Vector3d(10.0, 0.1, 10.0));
+  Skeleton* box = createBox(Vector3d::Constant(2.0), Vector3d(0.0, 1.0, 0.0));
+
+  // 5 x 5 grid of contacts over the bottom face of the box. The deepest one is
+  // at the corner (1, 1).
+  std::vector<Contact> contacts;
+  for (int i = 0; i < 5; ++i)
+  {
+    for (int j = 0; j < 5; ++j)
+    {
+      Contact ct;
+      ct.point = Vector3d(-1.0 + 0.5 * i, 0.0, -1.0 + 0.5 * j);
+      ct.normal = Vector3d::UnitY();
+      ct.force = Vector3d::Zero();
+      ct.bodyNode1 = box->getBodyNode(0);
+      ct.bodyNode2 = ground->getBodyNode(0);
+      ct.shape1 = NULL;
+      ct.shape2 = NULL;
+      ct.penetrationDepth = 0.01 + 0.001 * (i + j);
+      ct.triID1 = 0;
+      ct.triID2 = 0;
+      ct.userData = NULL;
+
+      // Some contacts are reported with the body nodes swapped
+      if ((i + j) % 3 == 1)
+      {
+        std::swap(ct.bodyNode1, ct.bodyNode2);
+        ct.normal = -ct.normal;
+      }
+
+      contacts.push_back(ct);
+    }
+  }
+
+  ContactConstraint constraint(contacts);
+  ASSERT_EQ(constraint.getNumContacts(), (size_t)DART_MAX_NUMBER_OF_CONTACTS);
+
+  // The deepest contact is kept and the contacts span the whole face
+  double maxDepth = 0.0;
+  double area = 0.0;
+  for (size_t i = 0; i < constraint.getNumContacts(); ++i)
+  {
+    const Contact& ct = constraint.getContact(i);
+    const Contact& next
+        = constraint.getContact((i + 1) % constraint.getNumContacts());
+
+    EXPECT_EQ(ct.bodyNode1, constraint.getContact(0).bodyNode1);
+    EXPECT_TRUE(ct.normal.isApprox(constraint.getContact(0).normal));
+
+    maxDepth = std::max(maxDepth, ct.penetrationDepth);
+    area += ct.point[2] * next.point[0] - ct.point[0] * next.point[2];
+  }
+  EXPECT_NEAR(maxDepth, 0.018, 1e-12);
+  EXPECT_NEAR(std::fabs(0.5 * area), 4.0, 1e-12);
+
+  // Collinear contacts reduce to the end points
+  std::vector<Contact> line(contacts.begin(), contacts.begin() + 5);
+  ContactConstraint::reduceContacts(&line);
+  EXPECT_EQ(line.size(), 2u);
+
+  delete ground;
+  delete box;
+}
+
+//==============================================================================
+TEST_F(ConstraintTest, LemkeSolver)
+{
+  using namespace Eigen;
+  using namespace dart::lcpsolver;
+
+  LemkeSolver solver;
+
+  // Symmetric positive definite problems of varying size reuse the workspace
+  for (int i = 0; i < 50; ++i)
+  {
+    const int n = 2 + (i * 7) % 40;
+    MatrixXd R = MatrixXd::Random(n, n);
+    MatrixXd M = R * R.transpose() + 0.1 * MatrixXd::Identity(n, n);
+    VectorXd q = 5.0 * VectorXd::Random(n);
+    VectorXd z;
+
+    EXPECT_EQ(solver.solve(M, q, &z), LEMKE_SUCCESS);
+    EXPECT_EQ(z.size(), n);
+    EXPECT_TRUE(validate(M, z, q));
+
+    // The free function uses a temporary workspace and agrees with it
+    VectorXd z2;
+    EXPECT_EQ(Lemke(M, q, &z2), LEMKE_SUCCESS);
+    EXPECT_TRUE(equals(z, z2, 1e-8));
+  }
+
+  // Frequent refactorization gives the same answer
+  MatrixXd R = MatrixXd::Random(30, 30);
+  MatrixXd M = R * R.transpose() + MatrixXd::Identity(30, 30);
+  VectorXd q = -VectorXd::Ones(30);
+  VectorXd z1;
+  VectorXd z2;
+  EXPECT_EQ(solver.solve(M, q, &z1), LEMKE_SUCCESS);
+  solver.setRefactorInterval(2);
+  EXPECT_EQ(solver.solve(M, q, &z2), LEMKE_SUCCESS);
+  EXPECT_GT(solver.getNumRefactorizations(), 0);
+  EXPECT_TRUE(equals(z1, z2, 1e-8));
+
+  // Pivot cap
+  solver.setMaxPivots(2);
+  EXPECT_EQ(solver.solve(M, q, &z1), LEMKE_MAX_PIVOTS);
+  EXPECT_EQ(solver.getLastError(), LEMKE_MAX_PIVOTS);
+  EXPECT_EQ(solver.getNumPivots(), 2);
+  EXPECT_TRUE(z1.isZero());
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -43,6 +43,7 @@
 #include "TestHelpers.h"
 
 #include "dart/common/Console.h"
+#include "dart/common/Timer.h"
 #include "dart/math/Geometry.h"
 #include "dart/math/Helpers.h"
 #include "dart/dynamics/BodyNode.h"
@@ -88,6 +89,23 @@ public:
   // Test impulse based dynamics
   void testImpulseBasedDynamics(const std::string& _fileName);
 
+  // Compare analytical derivatives of inverse and forward dynamics with
+  // finite differences, and compare their computation times.
+  void compareDynamicsDerivatives(const std::string& _fileName);
+
+  // Compare operational space quantities with the ones computed from the
+  // dense mass matrix, and check them against forward dynamics.
+  void compareOperationalSpaceDynamics(const std::string& _fileName);
+
+  // Compare batched inverse dynamics with the per-frame inverse dynamics, and
+  // compare their computation times.
+  void compareInverseDynamicsBatch(const std::string& _fileName);
+
+  // Compare forward and impulse-based forward dynamics over the compiled
+  // skeleton with the recursions over the body nodes, and compare their
+  // computation times.
+  void compareCompiledDynamics(const std::string& _fileName);
+
 protected:
   // Sets up the test fixture.
   virtual void SetUp();
@@ -815,6 +833,28 @@ void DynamicsTest::centerOfMass(const std::string& _fileName)
       MatrixXd comJ  = skel->getWorldCOMJacobian();
       MatrixXd comdJ = skel->getWorldCOMJacobianTimeDeriv();
 
+      // Mass-weighted sum of the Jacobians of the body nodes
+      MatrixXd sumJ  = MatrixXd::Zero(3, dof);
+      double totalMass = 0.0;
+      for (int k = 0; k < skel->getNumBodyNodes(); ++k)
+      {
+        BodyNode* body = skel->getBodyNode(k);
+        totalMass += body->getMass();
+        MatrixXd bodyJ = body->getMass()
+            * body->getWorldJacobian(body->getLocalCOM(), true).bottomRows<3>();
+        for (int l = 0; l < body->getNumDependentGenCoords(); ++l)
+          sumJ.col(body->getDependentGenCoordIndex(l)) += bodyJ.col(l);
+      }
+      sumJ /= totalMass;
+      EXPECT_TRUE(equals(comJ, sumJ, 1e-8));
+
+      // The caller buffer is reused
+      MatrixXd buffer(3, dof);
+      const double* data = buffer.data();
+      skel->computeWorldCOMJacobian(&buffer);
+      skel->computeWorldCOMJacobianTimeDeriv(&buffer);
+      EXPECT_EQ(data, buffer.data());
+
       VectorXd dcom2  = comJ * dq;
       VectorXd ddcom2 = comdJ * dq + comJ * ddq;
 
@@ -934,6 +974,305 @@ void DynamicsTest::testImpulseBasedDynamics(const std::string& _fileName)
   delete myWorld;
 }
 
+//==============================================================================
+// Perturb the configurations of _skel along the _index-th generalized
+// coordinate as the integrator does
+void perturbConfigs(dynamics::Skeleton* _skel, int _index, double _eps)
+{
+  VectorXd dq = _skel->getGenVels();
+  VectorXd e = VectorXd::Zero(dq.size());
+  e[_index] = 1.0;
+  _skel->setGenVels(e, false, false);
+  _skel->integrateConfigs(_eps);
+  _skel->setGenVels(dq, true, false);
+}
+
+//==============================================================================
+// Return the generalized forces from inverse dynamics at the current state
+// and the generalized accelerations _ddq
+VectorXd computeInverseDynamics(dynamics::Skeleton* _skel, const VectorXd& _ddq)
+{
+  _skel->setGenAccs(_ddq, true);
+  _skel->computeInverseDynamics(true, false);
+  return _skel->getGenForces();
+}
+
+//==============================================================================
+// Return the generalized accelerations from forward dynamics at the current
+// state
+VectorXd computeForwardDynamics(dynamics::Skeleton* _skel)
+{
+  _skel->computeForwardDynamics();
+  return _skel->getGenAccs();
+}
+
+//==============================================================================
+void DynamicsTest::compareDynamicsDerivatives(const std::string& _fileName)
+{
+  using namespace std;
+  using namespace dynamics;
+
+  //---------------------------- Settings --------------------------------------
+#ifndef NDEBUG  // Debug mode
+  int nRandomItr = 1;
+#else
+  int nRandomItr = 3;
+#endif
+  double eps = 1e-6;
+
+  simulation::World* myWorld = utils::SkelParser::readWorld(_fileName);
+  EXPECT_TRUE(myWorld != NULL);
+
+  for (int i = 0; i < myWorld->getNumSkeletons(); ++i)
+  {
+    Skeleton* skel = myWorld->getSkeleton(i);
+    int dof = skel->getNumGenCoords();
+    if (dof == 0 || !skel->isMobile())
+      continue;
+
+    common::Timer analyticTimer("analytic");
+    common::Timer finiteDiffTimer("finite difference");
+
+    for (int j = 0; j < nRandomItr; ++j)
+    {
+      // Random joint damping and stiffness, including the joints whose
+      // configurations are perturbed on SO(3) or SE(3)
+      for (int k = 0; k < skel->getNumBodyNodes(); ++k)
+      {
+        Joint* joint = skel->getBodyNode(k)->getParentJoint();
+        for (int l = 0; l < joint->getNumGenCoords(); ++l)
+        {
+          joint->setDampingCoefficient(l, math::random(0.0, 1.0));
+          joint->setSpringStiffness(l, math::random(0.0, 1.0));
+        }
+      }
+
+      // Random state, accelerations and forces
+      VectorXd x = VectorXd::Random(2 * dof);
+      skel->setState(x, true, true, false);
+      VectorXd ddq = VectorXd::Random(dof);
+      VectorXd tau = VectorXd::Random(dof);
+
+      //------------------------ Inverse dynamics ------------------------------
+      skel->setGenAccs(ddq, true);
+      MatrixXd dtau_dq;
+      MatrixXd dtau_ddq;
+      skel->computeInverseDynamicsDerivs(&dtau_dq, &dtau_ddq, true);
+
+      MatrixXd fd_dtau_dq(dof, dof);
+      MatrixXd fd_dtau_ddq(dof, dof);
+      for (int k = 0; k < dof; ++k)
+      {
+        perturbConfigs(skel, k, eps);
+        VectorXd tauPlus = computeInverseDynamics(skel, ddq);
+        skel->setState(x, true, true, false);
+        perturbConfigs(skel, k, -eps);
+        VectorXd tauMinus = computeInverseDynamics(skel, ddq);
+        skel->setState(x, true, true, false);
+        fd_dtau_dq.col(k) = (tauPlus - tauMinus) / (2.0 * eps);
+
+        VectorXd dq = x.tail(dof);
+        dq[k] += eps;
+        skel->setGenVels(dq, true, false);
+        tauPlus = computeInverseDynamics(skel, ddq);
+        dq[k] -= 2.0 * eps;
+        skel->setGenVels(dq, true, false);
+        tauMinus = computeInverseDynamics(skel, ddq);
+        skel->setState(x, true, true, false);
+        fd_dtau_ddq.col(k) = (tauPlus - tauMinus) / (2.0 * eps);
+      }
+
+      double tol = 1e-5 * (1.0 + fd_dtau_dq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(dtau_dq, fd_dtau_dq, tol));
+      tol = 1e-5 * (1.0 + fd_dtau_ddq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(dtau_ddq, fd_dtau_ddq, tol));
+
+      //------------------------ Forward dynamics ------------------------------
+      skel->setGenForces(tau);
+
+      analyticTimer.start();
+      MatrixXd dddq_dq;
+      MatrixXd dddq_ddq;
+      MatrixXd dddq_dtau;
+      skel->computeForwardDynamicsDerivs(&dddq_dq, &dddq_ddq, &dddq_dtau);
+      analyticTimer.stop();
+
+      finiteDiffTimer.start();
+      MatrixXd fd_dddq_dq(dof, dof);
+      MatrixXd fd_dddq_ddq(dof, dof);
+      MatrixXd fd_dddq_dtau(dof, dof);
+      for (int k = 0; k < dof; ++k)
+      {
+        perturbConfigs(skel, k, eps);
+        VectorXd ddqPlus = computeForwardDynamics(skel);
+        skel->setState(x, true, true, false);
+        perturbConfigs(skel, k, -eps);
+        VectorXd ddqMinus = computeForwardDynamics(skel);
+        skel->setState(x, true, true, false);
+        fd_dddq_dq.col(k) = (ddqPlus - ddqMinus) / (2.0 * eps);
+
+        VectorXd dq = x.tail(dof);
+        dq[k] += eps;
+        skel->setGenVels(dq, true, false);
+        ddqPlus = computeForwardDynamics(skel);
+        dq[k] -= 2.0 * eps;
+        skel->setGenVels(dq, true, false);
+        ddqMinus = computeForwardDynamics(skel);
+        skel->setState(x, true, true, false);
+        fd_dddq_ddq.col(k) = (ddqPlus - ddqMinus) / (2.0 * eps);
+
+        VectorXd tauPerturbed = tau;
+        tauPerturbed[k] += eps;
+        skel->setGenForces(tauPerturbed);
+        ddqPlus = computeForwardDynamics(skel);
+        tauPerturbed[k] -= 2.0 * eps;
+        skel->setGenForces(tauPerturbed);
+        ddqMinus = computeForwardDynamics(skel);
+        skel->setGenForces(tau);
+        fd_dddq_dtau.col(k) = (ddqPlus - ddqMinus) / (2.0 * eps);
+      }
+      finiteDiffTimer.stop();
+
+      tol = 1e-5 * (1.0 + fd_dddq_dq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(dddq_dq, fd_dddq_dq, tol));
+      tol = 1e-5 * (1.0 + fd_dddq_ddq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(dddq_ddq, fd_dddq_ddq, tol));
+      tol = 1e-5 * (1.0 + fd_dddq_dtau.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(dddq_dtau, fd_dddq_dtau, tol));
+    }
+
+    dtmsg << "Derivatives of forward dynamics of [" << skel->getName()
+          << "] (" << dof << " DOF): analytic "
+          << analyticTimer.getTotalElapsedTime() / nRandomItr
+          << " s, finite difference "
+          << finiteDiffTimer.getTotalElapsedTime() / nRandomItr << " s"
+          << endl;
+  }
+
+  delete myWorld;
+}
+
+//==============================================================================
+void DynamicsTest::compareCompiledDynamics(const std::string& _fileName)
+{
+  using namespace std;
+  using namespace dynamics;
+
+  //---------------------------- Settings --------------------------------------
+#ifndef NDEBUG  // Debug mode
+  int nRandomItr = 2;
+  int nTimingItr = 10;
+#else
+  int nRandomItr = 10;
+  int nTimingItr = 1000;
+#endif
+
+  simulation::World* myWorld = utils::SkelParser::readWorld(_fileName);
+  EXPECT_TRUE(myWorld != NULL);
+
+  for (int i = 0; i < myWorld->getNumSkeletons(); ++i)
+  {
+    Skeleton* skel = myWorld->getSkeleton(i);
+    int dof = skel->getNumGenCoords();
+    int nNodes = skel->getNumBodyNodes();
+    if (dof == 0 || !skel->isMobile())
+      continue;
+
+    const double timeStep = skel->getTimeStep();
+    const Eigen::Vector3d gravity = skel->getGravity();
+
+    for (int j = 0; j < nRandomItr; ++j)
+    {
+      VectorXd x = VectorXd::Random(2 * dof);
+      skel->setState(x, true, true, false);
+      skel->setGenForces(VectorXd::Random(dof));
+
+      // Forward dynamics over the compiled skeleton
+      skel->computeForwardDynamics();
+      VectorXd ddq = skel->getGenAccs();
+      vector<Vector6d, Eigen::aligned_allocator<Vector6d> > F(nNodes);
+      for (int k = 0; k < nNodes; ++k)
+        F[k] = skel->getBodyNode(k)->getBodyForce();
+
+      // Forward dynamics over the body nodes
+      for (int k = nNodes - 1; k >= 0; --k)
+      {
+        skel->getBodyNode(k)->updateArticulatedInertia(timeStep);
+        skel->getBodyNode(k)->updateBiasForce(timeStep, gravity);
+      }
+      for (int k = 0; k < nNodes; ++k)
+      {
+        skel->getBodyNode(k)->update_ddq();
+        skel->getBodyNode(k)->update_F_fs();
+      }
+
+      double tol = 1e-10 * (1.0 + ddq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(skel->getGenAccs(), ddq, tol));
+      for (int k = 0; k < nNodes; ++k)
+      {
+        tol = 1e-10 * (1.0 + F[k].cwiseAbs().maxCoeff());
+        EXPECT_TRUE(equals(skel->getBodyNode(k)->getBodyForce(), F[k], tol));
+      }
+
+      // Velocity change due to an impulse on the last body node
+      BodyNode* lastBodyNode = skel->getBodyNode(nNodes - 1);
+      Vector6d impulse = Vector6d::Random();
+      skel->clearConstraintImpulses();
+      skel->updateBiasImpulse(lastBodyNode, impulse);
+      skel->updateVelocityChange();
+      VectorXd delDq = skel->getVelsChange();
+
+      lastBodyNode->mConstraintImpulse = impulse;
+      for (BodyNode* it = lastBodyNode; it != NULL;
+           it = it->getParentBodyNode())
+      {
+        it->updateImpBiasForce();
+      }
+      lastBodyNode->mConstraintImpulse.setZero();
+      for (int k = 0; k < nNodes; ++k)
+        skel->getBodyNode(k)->updateJointVelocityChange();
+
+      tol = 1e-10 * (1.0 + delDq.cwiseAbs().maxCoeff());
+      EXPECT_TRUE(equals(skel->getVelsChange(), delDq, tol));
+    }
+
+    // Timings of forward dynamics
+    VectorXd dq = skel->getGenVels();
+
+    common::Timer compiledTimer("compiled");
+    compiledTimer.start();
+    for (int j = 0; j < nTimingItr; ++j)
+    {
+      skel->setGenVels(dq, true, false);
+      skel->computeForwardDynamics();
+    }
+    compiledTimer.stop();
+
+    common::Timer bodyNodeTimer("body nodes");
+    bodyNodeTimer.start();
+    for (int j = 0; j < nTimingItr; ++j)
+    {
+      skel->setGenVels(dq, true, false);
+      for (int k = nNodes - 1; k >= 0; --k)
+      {
+        skel->getBodyNode(k)->updateArticulatedInertia(timeStep);
+        skel->getBodyNode(k)->updateBiasForce(timeStep, gravity);
+      }
+      for (int k = 0; k < nNodes; ++k)
+      {
+        skel->getBodyNode(k)->update_ddq();
+        skel->getBodyNode(k)->update_F_fs();
+      }
+    }
+    bodyNodeTimer.stop();
+
+    dtmsg << "Forward dynamics of [" << skel->getName() << "] (" << dof
+          << " DOF) over " << nTimingItr << " iterations: compiled "
+          << compiledTimer.getLastElapsedTime() << " s, body nodes "
+          << bodyNodeTimer.getLastElapsedTime() << " s" << std::endl;
+  }
+}
+
 //==============================================================================
 TEST_F(DynamicsTest, compareVelocities)
 {
@@ -1009,10 +1348,224 @@ TEST_F(DynamicsTest, testImpulseBasedDynamics)
   }
 }
 
+//==============================================================================
+void DynamicsTest::compareOperationalSpaceDynamics(const std::string& _fileName)
+{
+  using namespace std;
+  using namespace dynamics;
+
+  //---------------------------- Settings --------------------------------------
+#ifndef NDEBUG  // Debug mode
+  int nRandomItr = 1;
+#else
+  int nRandomItr = 3;
+#endif
+
+  simulation::World* myWorld = utils::SkelParser::readWorld(_fileName);
+  EXPECT_TRUE(myWorld != NULL);
+
+  for (int i = 0; i < myWorld->getNumSkeletons(); ++i)
+  {
+    Skeleton* skel = myWorld->getSkeleton(i);
+    int dof = skel->getNumGenCoords();
+    if (dof == 0 || !skel->isMobile())
+      continue;
+
+    // Forward dynamics below should only see the generalized forces
+    for (int k = 0; k < skel->getNumBodyNodes(); ++k)
+    {
+      Joint* joint = skel->getBodyNode(k)->getParentJoint();
+      for (int l = 0; l < joint->getNumGenCoords(); ++l)
+      {
+        joint->setDampingCoefficient(l, 0.0);
+        joint->setSpringStiffness(l, 0.0);
+      }
+    }
+
+    for (int j = 0; j < nRandomItr; ++j)
+    {
+      VectorXd x = VectorXd::Random(2 * dof);
+      skel->setState(x, true, true, false);
+      skel->setGenForces(VectorXd::Zero(dof));
+
+      MatrixXd invM = skel->getMassMatrix().inverse();
+      VectorXd invMCg = invM * skel->getCombinedVector();
+      VectorXd dq = skel->getGenVels();
+
+      for (int k = 0; k < skel->getNumBodyNodes(); ++k)
+      {
+        BodyNode* body = skel->getBodyNode(k);
+
+        MatrixXd J = MatrixXd::Zero(6, dof);
+        MatrixXd dJ = MatrixXd::Zero(6, dof);
+        for (int l = 0; l < body->getNumDependentGenCoords(); ++l)
+        {
+          J.col(body->getDependentGenCoordIndex(l))
+              = body->getBodyJacobian().col(l);
+          dJ.col(body->getDependentGenCoordIndex(l))
+              = body->getBodyJacobianTimeDeriv().col(l);
+        }
+
+        // Inverse of operational space inertia
+        MatrixXd Omega = J * invM * J.transpose();
+        MatrixXd invLambda = body->getInvOperationalSpaceInertia();
+        double tol = 1e-8 * (1.0 + Omega.cwiseAbs().maxCoeff());
+        EXPECT_TRUE(equals(invLambda, Omega, tol));
+
+        // Operational space inertia is the pseudo-inverse of Omega
+        MatrixXd Lambda = body->getOperationalSpaceInertia();
+        EXPECT_TRUE(equals(MatrixXd(Lambda * Omega * Lambda), Lambda,
+                           1e-6 * (1.0 + Lambda.cwiseAbs().maxCoeff())));
+        EXPECT_TRUE(equals(MatrixXd(Omega * Lambda * Omega), Omega, tol));
+
+        // Bias force and dynamically consistent Jacobian inverse
+        VectorXd mu = Lambda * (J * invMCg - dJ * dq);
+        VectorXd bias = body->getOperationalSpaceBiasForce();
+        EXPECT_TRUE(equals(bias, mu, 1e-6 * (1.0 + mu.cwiseAbs().maxCoeff())));
+
+        MatrixXd Jbar = invM * J.transpose() * Lambda;
+        EXPECT_TRUE(equals(body->getDynamicallyConsistentJacobianInverse(),
+                           Jbar, 1e-6 * (1.0 + Jbar.cwiseAbs().maxCoeff())));
+        EXPECT_TRUE(equals(MatrixXd(J * Jbar * Omega), Omega, tol));
+
+        // Lambda * dV + mu = F when J^T * F is applied and the body node can
+        // move in all six directions
+        if (Eigen::FullPivLU<MatrixXd>(Omega).rank() < 6)
+          continue;
+
+        Vector6d F = Vector6d::Random();
+        skel->setGenForces(J.transpose() * F);
+        skel->computeForwardDynamics();
+        Vector6d dV = body->getBodyAcceleration();
+        skel->setGenForces(VectorXd::Zero(dof));
+        EXPECT_TRUE(equals(Vector6d(Lambda * dV + bias), F, 1e-6));
+      }
+    }
+  }
+
+  delete myWorld;
+}
+
+//==============================================================================
+void DynamicsTest::compareInverseDynamicsBatch(const std::string& _fileName)
+{
+  using namespace std;
+  using namespace dynamics;
+
+  //---------------------------- Settings --------------------------------------
+#ifndef NDEBUG  // Debug mode
+  int nFrames = 10;
+#else
+  int nFrames = 1000;
+#endif
+
+  simulation::World* myWorld = utils::SkelParser::readWorld(_fileName);
+  EXPECT_TRUE(myWorld != NULL);
+
+  for (int i = 0; i < myWorld->getNumSkeletons(); ++i)
+  {
+    Skeleton* skel = myWorld->getSkeleton(i);
+    int dof = skel->getNumGenCoords();
+    if (dof == 0 || !skel->isMobile())
+      continue;
+
+    MatrixXd q = MatrixXd::Random(dof, nFrames);
+    MatrixXd dq = MatrixXd::Random(dof, nFrames);
+    MatrixXd ddq = MatrixXd::Random(dof, nFrames);
+
+    // The batch must leave the state of the skeleton unchanged
+    VectorXd x = VectorXd::Random(2 * dof);
+    skel->setState(x, true, true, false);
+    BodyNode* lastBodyNode = skel->getBodyNode(skel->getNumBodyNodes() - 1);
+    Eigen::Isometry3d T = lastBodyNode->getWorldTransform();
+
+    common::Timer batchTimer("batch");
+    batchTimer.start();
+    MatrixXd tau;
+    skel->computeInverseDynamicsBatch(q, dq, ddq, &tau);
+    batchTimer.stop();
+
+    EXPECT_TRUE(equals(skel->getState(), x));
+    EXPECT_TRUE(equals(lastBodyNode->getWorldTransform().matrix(),
+                       T.matrix()));
+
+    common::Timer loopTimer("per-frame loop");
+    loopTimer.start();
+    MatrixXd loopTau(dof, nFrames);
+    VectorXd state(2 * dof);
+    for (int j = 0; j < nFrames; ++j)
+    {
+      state << q.col(j), dq.col(j);
+      skel->setState(state, true, true, false);
+      skel->setGenAccs(ddq.col(j), true);
+      skel->computeInverseDynamics();
+      loopTau.col(j) = skel->getGenForces();
+    }
+    loopTimer.stop();
+
+    double tol = 1e-8 * (1.0 + loopTau.cwiseAbs().maxCoeff());
+    EXPECT_TRUE(equals(tau, loopTau, tol));
+
+    dtmsg << "Inverse dynamics of [" << skel->getName() << "] (" << dof
+          << " DOF) over " << nFrames << " frames: batch "
+          << batchTimer.getTotalElapsedTime() << " s, per-frame loop "
+          << loopTimer.getTotalElapsedTime() << " s" << endl;
+  }
+
+  delete myWorld;
+}
+
+//==============================================================================
+TEST_F(DynamicsTest, compareDynamicsDerivatives)
+{
+  for (int i = 0; i < getList().size(); ++i)
+  {
+#ifndef NDEBUG
+    dtdbg << getList()[i] << std::endl;
+#endif
+    compareDynamicsDerivatives(getList()[i]);
+  }
+}
+
+//==============================================================================
+TEST_F(DynamicsTest, compareOperationalSpaceDynamics)
+{
+  for (int i = 0; i < getList().size(); ++i)
+  {
+#ifndef NDEBUG
+    dtdbg << getList()[i] << std::endl;
+#endif
+    compareOperationalSpaceDynamics(getList()[i]);
+  }
+}
+
+//==============================================================================
+TEST_F(DynamicsTest, compareInverseDynamicsBatch)
+{
+  for (int i = 0; i < getList().size(); ++i)
+  {
+#ifndef NDEBUG
+    dtdbg << getList()[i] << std::endl;
+#endif
+    compareInverseDynamicsBatch(getList()[i]);
+  }
+}
+
+//==============================================================================
+TEST_F(DynamicsTest, compareCompiledDynamics)
+{
+  for (int i = 0; i < getList().size(); ++i)
+  {
+#ifndef NDEBUG
+    dtdbg << getList()[i] << std::endl;
+#endif
+    compareCompiledDynamics(getList()[i]);
+  }
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
 }
-
@@ -34,9 +34,13 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <gtest/gtest.h>
 #include "TestHelpers.h"
+#include "dart/utils/SkelParser.h"
+#include "dart/utils/Paths.h"
 
 std::vector<int> twoLinkIndices;
 
@@ -124,6 +128,135 @@ TEST(FORWARD_KINEMATICS, TWO_ROLLS)
   }
 }
 
+//==============================================================================
+void checkForwardKinematicsBatch(Skeleton* _skel, int _numSamples)
+{
+  const int dof = _skel->getNumGenCoords();
+  const Eigen::VectorXd oldConfigs = _skel->getConfigs();
+  const Eigen::Isometry3d oldT
+      = _skel->getBodyNode(_skel->getNumBodyNodes() - 1)->getWorldTransform();
+
+  Eigen::MatrixXd configs = Eigen::MatrixXd::Random(dof, _numSamples);
+
+  std::vector<BodyNode*> bodyNodes;
+  for (int i = 0; i < _skel->getNumBodyNodes(); i += 2)
+    bodyNodes.push_back(_skel->getBodyNode(i));
+
+  std::vector<Eigen::MatrixXd> transforms;
+  _skel->computeForwardKinematicsBatch(configs, bodyNodes, &transforms);
+  ASSERT_EQ(transforms.size(), bodyNodes.size());
+
+  // The state of the skeleton must not change
+  EXPECT_TRUE(equals(_skel->getConfigs(), oldConfigs));
+  EXPECT_TRUE(equals(
+      _skel->getBodyNode(_skel->getNumBodyNodes() - 1)->getWorldTransform()
+      .matrix(), oldT.matrix()));
+
+  // Compare with the regular forward kinematics
+  for (int k = 0; k < _numSamples; ++k)
+  {
+    _skel->setConfigs(configs.col(k), true, false, false);
+    for (size_t i = 0; i < bodyNodes.size(); ++i)
+    {
+      ASSERT_EQ(transforms[i].rows(), _numSamples);
+      Eigen::Isometry3d T = Skeleton::getBatchTransform(transforms[i], k);
+      EXPECT_TRUE(equals(T.matrix(),
+                         bodyNodes[i]->getWorldTransform().matrix(), 1e-9));
+    }
+  }
+  _skel->setConfigs(oldConfigs);
+}
+
+//==============================================================================
+TEST(FORWARD_KINEMATICS, BATCH)
+{
+  Skeleton* robot = createThreeLinkRobot(Vector3d(0.3, 0.3, 1.0), DOF_X,
+                                         Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                         Vector3d(0.3, 0.3, 1.0), DOF_Z,
+                                         true);
+  checkForwardKinematicsBatch(robot, 17);
+  delete robot;
+
+  World* world = dart::utils::SkelParser::readWorld(
+                   DART_DATA_PATH"skel/fullbody1.skel");
+  ASSERT_TRUE(world != NULL);
+  for (int i = 0; i < world->getNumSkeletons(); ++i)
+    checkForwardKinematicsBatch(world->getSkeleton(i), 17);
+  delete world;
+}
+
+//==============================================================================
+void checkLazyForwardKinematics(Skeleton* _skel, int _numTests)
+{
+  const int dof = _skel->getNumGenCoords();
+  const int numBodyNodes = _skel->getNumBodyNodes();
+  if (dof == 0)
+    return;
+
+  std::vector<Eigen::Isometry3d,
+              Eigen::aligned_allocator<Eigen::Isometry3d> > T(numBodyNodes);
+  std::vector<Eigen::Vector6d,
+              Eigen::aligned_allocator<Eigen::Vector6d> > V(numBodyNodes);
+  std::vector<Jacobian> J(numBodyNodes);
+
+  for (int idxTest = 0; idxTest < _numTests; ++idxTest)
+  {
+    _skel->setState(Eigen::VectorXd::Random(2 * dof));
+
+    // Change a few generalized coordinates and query the body nodes in a
+    // random order
+    std::vector<int> ids;
+    for (int i = 0; i < 3; ++i)
+      ids.push_back(std::rand() % dof);
+    _skel->setConfigSegs(ids, Eigen::VectorXd::Random(ids.size()),
+                         true, true, false);
+
+    std::vector<int> order;
+    for (int i = 0; i < numBodyNodes; ++i)
+      order.push_back(i);
+    std::random_shuffle(order.begin(), order.end());
+
+    for (int i = 0; i < numBodyNodes; ++i)
+    {
+      BodyNode* bodyNode = _skel->getBodyNode(order[i]);
+      T[order[i]] = bodyNode->getWorldTransform();
+      V[order[i]] = bodyNode->getWorldVelocity();
+      J[order[i]] = bodyNode->getBodyJacobian();
+    }
+    Eigen::MatrixXd M = _skel->getMassMatrix();
+
+    // Compare with the eager forward kinematics
+    _skel->computeForwardKinematics(true, true, false);
+    for (int i = 0; i < numBodyNodes; ++i)
+    {
+      BodyNode* bodyNode = _skel->getBodyNode(i);
+      EXPECT_TRUE(equals(T[i].matrix(),
+                         bodyNode->getWorldTransform().matrix()));
+      EXPECT_TRUE(equals(V[i], bodyNode->getWorldVelocity()));
+      EXPECT_TRUE(equals(J[i], bodyNode->getBodyJacobian()));
+    }
+    EXPECT_TRUE(equals(M, _skel->getMassMatrix()));
+  }
+}
+
+//==============================================================================
+TEST(FORWARD_KINEMATICS, LAZY)
+{
+  Skeleton* robot = createThreeLinkRobot(Vector3d(0.3, 0.3, 1.0), DOF_X,
+                                         Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                         Vector3d(0.3, 0.3, 1.0), DOF_Z,
+                                         true);
+  checkLazyForwardKinematics(robot, 10);
+  delete robot;
+
+  World* world = dart::utils::SkelParser::readWorld(
+                   DART_DATA_PATH"skel/fullbody1.skel");
+  ASSERT_TRUE(world != NULL);
+  for (int i = 0; i < world->getNumSkeletons(); ++i)
+    checkLazyForwardKinematics(world->getSkeleton(i), 10);
+  delete world;
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -368,6 +368,53 @@ TEST(LIE_GROUP_OPERATORS, EXPONENTIAL_MAPPINGS)
     }
 }
 
+/******************************************************************************/
+TEST(LIE_GROUP_OPERATORS, EXPONENTIAL_MAPPINGS_ACROSS_ANGLES)
+{
+    // Angles around the thresholds of the Taylor series paths included
+    const double angles[] = { 0.0, 1e-9, 1e-5, 1e-3, 0.02, 0.03, 0.05, 0.1,
+                              0.5, 1.0, 3.0 };
+    const int numAngles = sizeof(angles) / sizeof(angles[0]);
+    const double h = 1e-6;
+
+    for (int i = 0; i < numAngles; ++i)
+    {
+        Eigen::Vector3d axis = Eigen::Vector3d::Random().normalized();
+        Eigen::Vector3d q = angles[i] * axis;
+        Eigen::Vector3d qdot = Eigen::Vector3d::Random();
+        Eigen::Vector3d v = Eigen::Vector3d::Random();
+
+        // Rotation
+        Eigen::Matrix3d R = math::expMapRot(q);
+        Eigen::Matrix3d R_ref
+            = Eigen::AngleAxisd(angles[i], axis).toRotationMatrix();
+        EXPECT_TRUE(equals(R, R_ref, 1e-12));
+        EXPECT_TRUE(equals(Eigen::Matrix3d(math::expAngular(q).linear()),
+                           R_ref, 1e-12));
+
+        // Jacobian: dR/dt * R^T = [J * qdot]
+        Eigen::Matrix3d dR = (math::expMapRot(q + h * qdot)
+                              - math::expMapRot(q - h * qdot)) / (2.0 * h);
+        Eigen::Matrix3d W = dR * R.transpose();
+        Eigen::Vector3d w(W(2, 1), W(0, 2), W(1, 0));
+        EXPECT_TRUE(equals(Eigen::Vector3d(math::expMapJac(q) * qdot), w,
+                           1e-8));
+
+        // Time derivative of Jacobian
+        Eigen::Matrix3d dJ = (math::expMapJac(q + h * qdot)
+                              - math::expMapJac(q - h * qdot)) / (2.0 * h);
+        EXPECT_TRUE(equals(math::expMapJacDot(q, qdot), dJ, 1e-8));
+
+        // Exp: R = exp([q]) and p = J * v
+        Eigen::Vector6d S;
+        S << q, v;
+        Eigen::Isometry3d T = math::expMap(S);
+        EXPECT_TRUE(equals(Eigen::Matrix3d(T.linear()), R_ref, 1e-12));
+        EXPECT_TRUE(equals(Eigen::Vector3d(T.translation()),
+                           Eigen::Vector3d(math::expMapJac(q) * v), 1e-12));
+    }
+}
+
 /******************************************************************************/
 TEST(LIE_GROUP_OPERATORS, ADJOINT_MAPPINGS)
 {
@@ -599,6 +646,113 @@ TEST(LIE_GROUP_OPERATORS, ADJOINT_MAPPINGS)
     }
 }
 
+/******************************************************************************/
+// Return the 6x6 matrix of Ad(T), which maps a twist in the frame of T to the
+// reference frame
+static Eigen::Matrix6d getAdTMatrix(const Eigen::Isometry3d& _T)
+{
+    Eigen::Matrix6d AdTMatrix = Eigen::Matrix6d::Zero();
+    AdTMatrix.topLeftCorner<3,3>() = _T.linear();
+    AdTMatrix.bottomRightCorner<3,3>() = _T.linear();
+    AdTMatrix.bottomLeftCorner<3,3>()
+        = math::makeSkewSymmetric(_T.translation()) * _T.linear();
+    return AdTMatrix;
+}
+
+/******************************************************************************/
+// Return the 6x6 matrix of ad(V)
+static Eigen::Matrix6d getAdMatrix(const Eigen::Vector6d& _V)
+{
+    Eigen::Matrix6d adVMatrix = Eigen::Matrix6d::Zero();
+    adVMatrix.topLeftCorner<3,3>() = math::makeSkewSymmetric(_V.head<3>());
+    adVMatrix.bottomRightCorner<3,3>() = math::makeSkewSymmetric(_V.head<3>());
+    adVMatrix.bottomLeftCorner<3,3>() = math::makeSkewSymmetric(_V.tail<3>());
+    return adVMatrix;
+}
+
+/******************************************************************************/
+TEST(LIE_GROUP_OPERATORS, IN_PLACE_ADJOINT_MAPPINGS)
+{
+    int numTest = 100;
+
+    for (int i = 0; i < numTest; ++i)
+    {
+        Eigen::Vector6d t = Eigen::Vector6d::Random();
+        Eigen::Isometry3d T = math::expMap(t);
+        Eigen::Vector6d V = Eigen::Vector6d::Random();
+        Eigen::Vector6d W = Eigen::Vector6d::Random();
+        Jacobian J = Jacobian::Random(6, 4);
+        Eigen::Vector6d res;
+
+        // The in-place versions are compared with the explicit matrix forms,
+        // also when the output is the input
+        Eigen::Matrix6d AdTMatrix = getAdTMatrix(T);
+        Eigen::Matrix6d AdInvTMatrix = getAdTMatrix(T.inverse());
+        Eigen::Matrix6d adVMatrix = getAdMatrix(V);
+
+        Eigen::Vector6d refAdTV = AdTMatrix * V;
+        AdT(T, V, &res);
+        EXPECT_TRUE(equals(res, refAdTV, LIE_GROUP_OPT_TOL));
+        res = V;
+        AdT(T, res, &res);
+        EXPECT_TRUE(equals(res, refAdTV, LIE_GROUP_OPT_TOL));
+
+        Eigen::Vector6d refAdInvTV = AdInvTMatrix * V;
+        AdInvT(T, V, &res);
+        EXPECT_TRUE(equals(res, refAdInvTV, LIE_GROUP_OPT_TOL));
+        res = V;
+        AdInvT(T, res, &res);
+        EXPECT_TRUE(equals(res, refAdInvTV, LIE_GROUP_OPT_TOL));
+
+        Eigen::Vector6d refdAdInvTV = AdInvTMatrix.transpose() * V;
+        dAdInvT(T, V, &res);
+        EXPECT_TRUE(equals(res, refdAdInvTV, LIE_GROUP_OPT_TOL));
+        res = V;
+        dAdInvT(T, res, &res);
+        EXPECT_TRUE(equals(res, refdAdInvTV, LIE_GROUP_OPT_TOL));
+
+        Eigen::Vector6d refAdVW = adVMatrix * W;
+        ad(V, W, &res);
+        EXPECT_TRUE(equals(res, refAdVW, LIE_GROUP_OPT_TOL));
+        res = W;
+        ad(V, res, &res);
+        EXPECT_TRUE(equals(res, refAdVW, LIE_GROUP_OPT_TOL));
+
+        Eigen::Vector6d refdAdVW = adVMatrix.transpose() * W;
+        dad(V, W, &res);
+        EXPECT_TRUE(equals(res, refdAdVW, LIE_GROUP_OPT_TOL));
+        res = V;
+        dad(res, W, &res);
+        EXPECT_TRUE(equals(res, refdAdVW, LIE_GROUP_OPT_TOL));
+
+        // Jacobian versions apply the matrix forms to each column
+        Jacobian refAdTJ = AdTMatrix * J;
+        Jacobian refAdInvTJ = AdInvTMatrix * J;
+        Jacobian refdAdInvTJ = AdInvTMatrix.transpose() * J;
+        Jacobian resJ;
+        AdTJac(T, J, &resJ);
+        EXPECT_TRUE(equals(resJ, refAdTJ, LIE_GROUP_OPT_TOL));
+        AdInvTJac(T, J, &resJ);
+        EXPECT_TRUE(equals(resJ, refAdInvTJ, LIE_GROUP_OPT_TOL));
+        dAdInvTJac(T, J, &resJ);
+        EXPECT_TRUE(equals(resJ, refdAdInvTJ, LIE_GROUP_OPT_TOL));
+        resJ = J;
+        AdInvTJac(T, resJ, &resJ);
+        EXPECT_TRUE(equals(resJ, refAdInvTJ, LIE_GROUP_OPT_TOL));
+
+        // transformInertia(T, I) = Ad(T)^T * I * Ad(T)
+        Eigen::Matrix6d A = Eigen::Matrix6d::Random();
+        Inertia I = A * A.transpose();
+        Inertia refI = AdTMatrix.transpose() * I * AdTMatrix;
+        Inertia resI;
+        transformInertia(T, I, &resI);
+        EXPECT_TRUE(equals(resI, refI, 1e-10));
+        resI = I;
+        transformInertia(T, resI, &resI);
+        EXPECT_TRUE(equals(resI, refI, 1e-10));
+    }
+}
+
 /******************************************************************************/
 int main(int argc, char* argv[])
 {
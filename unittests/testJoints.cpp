@@ -125,6 +125,26 @@ void JOINTS::kinematicsTest(Joint* _joint)
     //--------------------------------------------------------------------------
     EXPECT_TRUE(math::verifyTransform(T));
 
+    //--------------------------------------------------------------------------
+    // Test fixed-size products against the generic Jacobians
+    //--------------------------------------------------------------------------
+    Vector6d V = J * _joint->getGenVels();
+    Vector6d dJdq = dJ * _joint->getGenVels();
+    EXPECT_TRUE(equals(_joint->getLocalJacobianTimesGenVels(), V));
+    EXPECT_TRUE(equals(_joint->getLocalJacobianTimeDerivTimesGenVels(), dJdq));
+
+    //--------------------------------------------------------------------------
+    // Test stateless local kinematics against the ones of the joint state
+    //--------------------------------------------------------------------------
+    Eigen::Isometry3d statelessT;
+    Jacobian statelessJ;
+    Jacobian statelessdJ;
+    _joint->computeLocalKinematics(q, dq, &statelessT, &statelessJ,
+                                   &statelessdJ);
+    EXPECT_TRUE(equals(statelessT.matrix(), T.matrix()));
+    EXPECT_TRUE(equals(statelessJ, J));
+    EXPECT_TRUE(equals(statelessdJ, dJ));
+
     //--------------------------------------------------------------------------
     // Test analytic Jacobian and numerical Jacobian
     // J == numericalJ
@@ -322,6 +342,50 @@ TEST_F(JOINTS, FREE_JOINT)
   kinematicsTest(freeJoint);
 }
 
+//==============================================================================
+TEST_F(JOINTS, LIE_GROUP_INTEGRATION)
+{
+  // One large step with a constant body velocity should be the exact
+  // exponential update, also right after the configurations are set without
+  // updating the transforms as the stages of RK4Integrator do.
+  double dt = 0.5;
+
+  BallJoint* ballJoint = new BallJoint;
+  BodyNode* ballBody = new BodyNode();
+  ballBody->setParentJoint(ballJoint);
+  Skeleton ballSkel;
+  ballSkel.addBodyNode(ballBody);
+  ballSkel.init();
+
+  FreeJoint* freeJoint = new FreeJoint;
+  BodyNode* freeBody = new BodyNode();
+  freeBody->setParentJoint(freeJoint);
+  Skeleton freeSkel;
+  freeSkel.addBodyNode(freeBody);
+  freeSkel.init();
+
+  for (int i = 0; i < 2; ++i)
+  {
+    Eigen::Vector3d q3 = Eigen::Vector3d::Random() * 2.0;
+    Eigen::Vector3d dq3 = Eigen::Vector3d::Random() * 5.0;
+    ballSkel.setConfigs(q3, i == 0);
+    ballSkel.setGenVels(dq3);
+    ballSkel.integrateConfigs(dt);
+    Eigen::Matrix3d R = expMapRot(q3) * expMapRot(dq3 * dt);
+    EXPECT_TRUE(equals(expMapRot(Eigen::Vector3d(ballSkel.getConfigs())), R,
+                       1e-10));
+
+    Eigen::Vector6d q6 = Eigen::Vector6d::Random() * 2.0;
+    Eigen::Vector6d dq6 = Eigen::Vector6d::Random() * 5.0;
+    freeSkel.setConfigs(q6, i == 0);
+    freeSkel.setGenVels(dq6);
+    freeSkel.integrateConfigs(dt);
+    Eigen::Isometry3d T = expMap(q6) * expMap(dq6 * dt);
+    EXPECT_TRUE(equals(expMap(Eigen::Vector6d(freeSkel.getConfigs())).matrix(),
+                       T.matrix(), 1e-10));
+  }
+}
+
 //==============================================================================
 TEST_F(JOINTS, POSITION_LIMIT)
 {
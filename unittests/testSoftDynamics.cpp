@@ -37,12 +37,18 @@
 #include <vector>
 #include <string>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include <Eigen/Dense>
 #include <gtest/gtest.h>
 #include <boost/math/special_functions/fpclassify.hpp>
 
 #include "dart/common/Console.h"
+#include "dart/common/Timer.h"
 #include "dart/math/Helpers.h"
+#include "dart/dynamics/FreeJoint.h"
 #include "dart/dynamics/Joint.h"
 
 #include "dart/dynamics/Skeleton.h"
@@ -114,6 +120,27 @@ public:
   // force vector.
   void compareEquationsOfMotion(const std::string& _fileName);
 
+  // Compare the forward dynamics of a soft box of the given fragments with
+  // the equations of motion, and report the timing of the forward dynamics.
+  // Zero fragments give the 8 point mass box of test_drop_box.skel.
+  void compareForwardDynamics(const Eigen::Vector3i& _frags);
+
+  // Simulate the soft ellipsoid of createSoftEllipsoid() from the given
+  // initial configurations and velocities, and return the final
+  // configurations. _maxAcc is set to the largest generalized acceleration of
+  // the steps.
+  Eigen::VectorXd simulateSoftEllipsoid(const Eigen::VectorXd& _configs,
+                                        const Eigen::VectorXd& _genVels,
+                                        double _timeStep, double _duration,
+                                        bool _isImplicit, double* _maxAcc);
+
+  // Compare the implicit and the explicit point mass integrations of a soft
+  // ellipsoid with stiff edge springs at the given time step with a reference
+  // simulated explicitly at a small time step. _translationTolerance bounds
+  // the error of the rigid translation.
+  void compareImplicitIntegration(double _timeStep,
+                                  double _translationTolerance);
+
 protected:
   // Sets up the test fixture.
   virtual void SetUp();
@@ -504,6 +531,301 @@ TEST_F(SoftDynamicsTest, compareEquationsOfMotion)
   }
 }
 
+//==============================================================================
+void SoftDynamicsTest::compareForwardDynamics(const Eigen::Vector3i& _frags)
+{
+  using namespace std;
+  using namespace Eigen;
+  using namespace dart;
+  using namespace math;
+  using namespace dynamics;
+
+  //---------------------------- Settings --------------------------------------
+#ifndef NDEBUG  // Debug mode
+  int nRandomItr = 2;
+  int nTimingItr = 10;
+#else
+  int nRandomItr = 10;
+  int nTimingItr = 1000;
+#endif
+
+  // Soft box of test_drop_box.skel
+  Skeleton* skel = new Skeleton("soft box");
+  SoftBodyNode* softBodyNode = new SoftBodyNode("soft box");
+  softBodyNode->setParentJoint(new FreeJoint("free joint"));
+  softBodyNode->setMass(0.5);
+  if (_frags == Vector3i::Zero())
+  {
+    SoftBodyNodeHelper::setBox(softBodyNode, Vector3d::Constant(0.25),
+                               Isometry3d::Identity(), 0.5,
+                               100.0, 10.0, 1.0);
+  }
+  else
+  {
+    SoftBodyNodeHelper::setBox(softBodyNode, Vector3d::Constant(0.25),
+                               Isometry3d::Identity(), _frags, 0.5,
+                               100.0, 10.0, 1.0);
+  }
+  skel->addBodyNode(softBodyNode);
+  skel->init();
+
+  int dof = skel->getNumGenCoords();
+  int nPointMasses = softBodyNode->getNumPointMasses();
+  EXPECT_EQ(dof, 6 + 3 * nPointMasses);
+
+  //----------------------------- Tests ----------------------------------------
+  // Without the point mass springs and damping, forward dynamics should
+  // satisfy the equations of motion, M * ddq + Cg = tau.
+  softBodyNode->setVertexSpringStiffness(0.0);
+  softBodyNode->setEdgeSpringStiffness(0.0);
+  softBodyNode->setDampingCoefficient(0.0);
+  for (int i = 0; i < nRandomItr; ++i)
+  {
+    VectorXd x = skel->getState();
+    for (int k = 0; k < x.size(); ++k)
+      x[k] = random(-0.1, 0.1);
+    skel->setState(x, true, true, false);
+    VectorXd tau = VectorXd::Zero(dof);
+    for (int k = 0; k < dof; ++k)
+      tau[k] = random(-1.0, 1.0);
+    skel->setGenForces(tau);
+
+    skel->computeForwardDynamics();
+    VectorXd ddq = skel->getGenAccs();
+    VectorXd tau2 = skel->getMassMatrix() * ddq + skel->getCombinedVector();
+
+    EXPECT_TRUE(equals(tau, tau2, 1e-6));
+    if (!equals(tau, tau2, 1e-6))
+    {
+      cout << "tau :" << tau.transpose()  << endl;
+      cout << "tau2:" << tau2.transpose() << endl;
+    }
+
+    // The closest point mass of a face should be the nearest vertex of the
+    // face in world frame
+    for (int j = 0; j < softBodyNode->getNumFaces(); ++j)
+    {
+      const Vector3i& face = softBodyNode->getFace(j);
+      Vector3d point = Vector3d(random(-0.2, 0.2), random(-0.2, 0.2),
+                                random(-0.2, 0.2));
+      int closest = face[0];
+      for (int k = 1; k < 3; ++k)
+      {
+        if ((softBodyNode->getPointMass(face[k])->getWorldPosition()
+             - point).norm()
+            < (softBodyNode->getPointMass(closest)->getWorldPosition()
+               - point).norm())
+        {
+          closest = face[k];
+        }
+      }
+      EXPECT_EQ(softBodyNode->getClosestPointMass(j, point),
+                softBodyNode->getPointMass(closest));
+    }
+  }
+
+  // Timing of forward dynamics with the springs and damping
+  softBodyNode->setVertexSpringStiffness(100.0);
+  softBodyNode->setEdgeSpringStiffness(10.0);
+  softBodyNode->setDampingCoefficient(1.0);
+  VectorXd dq = skel->getGenVels();
+
+  common::Timer timer("forward dynamics");
+  timer.start();
+  for (int i = 0; i < nTimingItr; ++i)
+  {
+    skel->setGenVels(dq, true, false);
+    skel->computeForwardDynamics();
+  }
+  timer.stop();
+  EXPECT_FALSE(math::isNan(skel->getGenAccs()));
+
+  dtmsg << "Forward dynamics of soft box with " << nPointMasses
+        << " point masses over " << nTimingItr << " iterations: "
+        << timer.getLastElapsedTime() << " s" << std::endl;
+
+#ifdef _OPENMP
+  // Single-threaded and multi-threaded updates of the point masses should give
+  // identical dynamics
+  VectorXd x = skel->getState();
+  for (int k = 0; k < x.size(); ++k)
+    x[k] = random(-0.1, 0.1);
+  VectorXd tau = VectorXd::Zero(dof);
+  for (int k = 0; k < dof; ++k)
+    tau[k] = random(-1.0, 1.0);
+  VectorXd impulse = VectorXd::Zero(6);
+  for (int k = 0; k < 6; ++k)
+    impulse[k] = random(-1.0, 1.0);
+
+  const int maxNumThreads = omp_get_max_threads();
+  const int numThreads[] = {1, std::max(2, maxNumThreads)};
+  VectorXd ddqs[2];
+  VectorXd genForces[2];
+  VectorXd velsChanges[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    omp_set_num_threads(numThreads[i]);
+
+    skel->setState(x, true, true, false);
+    skel->setGenForces(tau);
+    skel->computeForwardDynamics();
+    ddqs[i] = skel->getGenAccs();
+
+    skel->computeInverseDynamics(false, true);
+    genForces[i] = skel->getGenForces();
+
+    skel->clearConstraintImpulses();
+    softBodyNode->addConstraintImpulse(impulse);
+    skel->computeImpulseForwardDynamics();
+    velsChanges[i] = skel->getVelsChange();
+    skel->clearConstraintImpulses();
+  }
+  omp_set_num_threads(maxNumThreads);
+
+  EXPECT_TRUE(ddqs[0] == ddqs[1]);
+  EXPECT_TRUE(genForces[0] == genForces[1]);
+  EXPECT_TRUE(velsChanges[0] == velsChanges[1]);
+#endif
+
+  delete skel;
+}
+
+//==============================================================================
+TEST_F(SoftDynamicsTest, compareForwardDynamics)
+{
+  // Point masses of the soft box of softDropBoxTest and ten times of them
+  compareForwardDynamics(Eigen::Vector3i::Zero());
+  compareForwardDynamics(Eigen::Vector3i(4, 4, 3));
+
+  // Enough point masses to be updated in parallel chunks
+  compareForwardDynamics(Eigen::Vector3i(14, 14, 14));
+}
+
+//==============================================================================
+// Create a soft ellipsoid with stiff edge springs on a free joint
+static dart::dynamics::Skeleton* createSoftEllipsoid(bool _isImplicit)
+{
+  using namespace Eigen;
+  using namespace dart::dynamics;
+
+  Skeleton* skel = new Skeleton("soft ellipsoid");
+  SoftBodyNode* softBodyNode = new SoftBodyNode("soft ellipsoid");
+  softBodyNode->setParentJoint(new FreeJoint("free joint"));
+  softBodyNode->setMass(0.5);
+  SoftBodyNodeHelper::setEllipsoid(softBodyNode, Vector3d::Constant(0.25),
+                                   20, 20, 0.5, 100.0, 1000.0, 1.0);
+  softBodyNode->setImplicitIntegration(_isImplicit);
+  skel->addBodyNode(softBodyNode);
+
+  return skel;
+}
+
+//==============================================================================
+Eigen::VectorXd SoftDynamicsTest::simulateSoftEllipsoid(
+    const Eigen::VectorXd& _configs, const Eigen::VectorXd& _genVels,
+    double _timeStep, double _duration, bool _isImplicit, double* _maxAcc)
+{
+  using namespace Eigen;
+  using namespace dart;
+  using namespace dynamics;
+
+  simulation::World* world = new simulation::World;
+  world->setGravity(Vector3d::Zero());
+  world->setTimeStep(_timeStep);
+  Skeleton* skel = createSoftEllipsoid(_isImplicit);
+  world->addSkeleton(skel);
+
+  skel->setConfigs(_configs);
+  skel->setGenVels(_genVels);
+  skel->computeForwardKinematics(true, true, false);
+
+  const int nSteps = static_cast<int>(_duration / _timeStep + 0.5);
+  *_maxAcc = 0.0;
+  for (int i = 0; i < nSteps; ++i)
+  {
+    world->step();
+    *_maxAcc = std::max(*_maxAcc, skel->getGenAccs().cwiseAbs().maxCoeff());
+  }
+
+  VectorXd configs = skel->getConfigs();
+  delete world;
+
+  return configs;
+}
+
+//==============================================================================
+void SoftDynamicsTest::compareImplicitIntegration(
+    double _timeStep, double _translationTolerance)
+{
+  using namespace std;
+  using namespace Eigen;
+  using namespace dart;
+  using namespace math;
+
+  //---------------------------- Settings --------------------------------------
+  // Long enough for the spin to settle the ellipsoid in its centrifugal
+  // deformation
+  const double duration = 0.5;
+  const double refTimeStep = 1e-4;
+
+  //----------------------------- Tests ----------------------------------------
+  // Random initial deformation of the point masses and a spin of the body
+  dynamics::Skeleton* skel = createSoftEllipsoid(true);
+  skel->init();
+  const int dof = skel->getNumGenCoords();
+  delete skel;
+
+  VectorXd q = VectorXd::Zero(dof);
+  for (int k = 6; k < dof; ++k)
+    q[k] = random(-0.01, 0.01);
+  VectorXd dq = VectorXd::Zero(dof);
+  dq << 3.0, 5.0, 1.0, 0.2, 0.0, 0.0, VectorXd::Zero(dof - 6);
+
+  // Edge springs this stiff need time steps well below 1 ms without the
+  // implicit integration
+  double refMaxAcc = 0.0;
+  double implicitMaxAcc = 0.0;
+  double explicitMaxAcc = 0.0;
+  VectorXd refQ = simulateSoftEllipsoid(q, dq, refTimeStep, duration, false,
+                                        &refMaxAcc);
+  VectorXd implicitQ = simulateSoftEllipsoid(q, dq, _timeStep, duration, true,
+                                             &implicitMaxAcc);
+  VectorXd explicitQ = simulateSoftEllipsoid(q, dq, _timeStep, duration, false,
+                                             &explicitMaxAcc);
+  ASSERT_FALSE(math::isNan(refQ));
+
+  // The explicit integration diverges at this time step
+  double explicitDeformation = explicitQ.tail(dof - 6).cwiseAbs().maxCoeff();
+  EXPECT_FALSE(explicitDeformation < 1.0);
+  EXPECT_GT(explicitMaxAcc, 100.0 * implicitMaxAcc);
+
+  // The implicit integration agrees with the reference. The deformation of the
+  // spinning ellipsoid is about 3e-5 and matches to a fraction of a percent.
+  // The drift of the rigid motion is first order in the time step, and it
+  // includes the error of the diagonal point mass approximation in the
+  // articulated inertia of the body (see setImplicitIntegration()).
+  VectorXd deformationError = (implicitQ - refQ).tail(dof - 6);
+  EXPECT_FALSE(math::isNan(implicitQ));
+  EXPECT_LT(deformationError.cwiseAbs().maxCoeff(), 1e-7);
+  EXPECT_LT((implicitQ - refQ).head<3>().cwiseAbs().maxCoeff(), 2e-4);
+  EXPECT_LT((implicitQ - refQ).segment<3>(3).cwiseAbs().maxCoeff(),
+            _translationTolerance);
+
+  dtmsg << "Soft ellipsoid at time step " << _timeStep
+        << ": max |ddq| implicit " << implicitMaxAcc << ", explicit "
+        << explicitMaxAcc << ", reference " << refMaxAcc
+        << "; deformation error of implicit integration "
+        << deformationError.cwiseAbs().maxCoeff() << std::endl;
+}
+
+//==============================================================================
+TEST_F(SoftDynamicsTest, compareImplicitIntegration)
+{
+  // Five and ten times of the default time step
+  compareImplicitIntegration(0.005, 5e-3);
+  compareImplicitIntegration(0.01, 8e-3);
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
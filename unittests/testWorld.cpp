@@ -34,11 +34,19 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 #include "TestHelpers.h"
 
 #include "dart/math/Geometry.h"
+#include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/constraint/ConstraintSolver.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/RevoluteJoint.h"
 #include "dart/dynamics/Skeleton.h"
@@ -129,6 +137,375 @@ TEST(WORLD, ADDING_AND_REMOVING_SKELETONS)
     delete world;
 }
 
+/******************************************************************************/
+TEST(WORLD, ADAPTIVE_TIME_STEPPING)
+{
+    // Reference with small fixed steps
+    World* fixedWorld = new World;
+    fixedWorld->setTimeStep(1e-5);
+    Skeleton* fixedSkel = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0),
+                                               DOF_ROLL,
+                                               Eigen::Vector3d(0.3, 0.3, 1.0),
+                                               DOF_PITCH,
+                                               Eigen::Vector3d(0.3, 0.3, 1.0),
+                                               DOF_ROLL,
+                                               false, false);
+    fixedWorld->addSkeleton(fixedSkel);
+
+    Eigen::VectorXd q = Eigen::VectorXd::Constant(3, 0.5);
+    fixedSkel->setConfigs(q);
+
+    double duration = 1.0;
+    int nFixedSteps = fixedWorld->advance(duration);
+
+    // The sum of the steps may fall short by round-off and take one more step
+    EXPECT_NEAR(nFixedSteps, 100000, 1);
+    EXPECT_EQ(fixedWorld->getTimeStep(), 1e-5);
+
+    // The global error of the first order integrator goes with the square
+    // root of the tolerance of the local error
+    const double tolerances[2] = {1e-6, 1e-8};
+    const double maxErrors[2] = {2e-3, 3e-4};
+    double errors[2];
+    for (int i = 0; i < 2; ++i)
+    {
+      World* adaptiveWorld = new World;
+      adaptiveWorld->setAdaptiveTimeStepping(true);
+      adaptiveWorld->setTimeStepLimits(1e-4, 1e-2);
+      adaptiveWorld->setAdaptiveTolerance(tolerances[i]);
+      Skeleton* adaptiveSkel
+          = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                 Eigen::Vector3d(0.3, 0.3, 1.0), DOF_PITCH,
+                                 Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                 false, false);
+      adaptiveWorld->addSkeleton(adaptiveSkel);
+      adaptiveSkel->setConfigs(q);
+
+      int nAdaptiveSteps = adaptiveWorld->advance(duration);
+      EXPECT_NEAR(adaptiveWorld->getTime(), duration, 1e-12);
+
+      // The reported steps cover the duration within the limits
+      const std::vector<double>& timeSteps
+          = adaptiveWorld->getAdvanceTimeSteps();
+      EXPECT_EQ(static_cast<int>(timeSteps.size()), nAdaptiveSteps);
+      double sum = 0.0;
+      for (size_t j = 0; j < timeSteps.size(); ++j)
+      {
+        EXPECT_LE(timeSteps[j], 1e-2 + 1e-12);
+        if (j + 1 < timeSteps.size())
+          EXPECT_GE(timeSteps[j], 1e-4 - 1e-12);
+        sum += timeSteps[j];
+      }
+      EXPECT_NEAR(sum, duration, 1e-9);
+
+      // Fewer steps than the reference with a state within the error
+      // expected for the tolerance
+      EXPECT_LT(nAdaptiveSteps, nFixedSteps / 5);
+      errors[i] = (fixedSkel->getConfigs() - adaptiveSkel->getConfigs())
+                  .lpNorm<Eigen::Infinity>();
+      EXPECT_LT(errors[i], maxErrors[i]);
+
+      delete adaptiveWorld;
+    }
+    EXPECT_LT(4.0 * errors[1], errors[0]);
+
+    delete fixedWorld;
+}
+
+/******************************************************************************/
+TEST(WORLD, ADAPTIVE_TIME_STEPPING_IMMOBILE)
+{
+    // An immobile skeleton with degrees of freedom does not change the steps
+    // of a mobile one
+    World* worlds[2];
+    Skeleton* skels[2];
+    for (int i = 0; i < 2; ++i)
+    {
+      worlds[i] = new World;
+      worlds[i]->setTimeStep(1e-3);
+      worlds[i]->setAdaptiveTimeStepping(true);
+      worlds[i]->setTimeStepLimits(1e-4, 1e-2);
+      worlds[i]->setAdaptiveTolerance(1e-6);
+      skels[i] = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                      Eigen::Vector3d(0.3, 0.3, 1.0), DOF_PITCH,
+                                      Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                      false, false);
+      worlds[i]->addSkeleton(skels[i]);
+      skels[i]->setConfigs(Eigen::VectorXd::Constant(3, 0.5));
+    }
+
+    Skeleton* immobileSkel
+        = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_PITCH,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               false, false);
+    immobileSkel->setMobile(false);
+    worlds[1]->addSkeleton(immobileSkel);
+
+    Eigen::VectorXd genVels;
+    worlds[1]->getGenVels(&genVels);
+    EXPECT_EQ(genVels.size(), 6);
+    EXPECT_TRUE(genVels.tail(3).isZero());
+
+    int nSteps[2];
+    for (int i = 0; i < 2; ++i)
+    {
+      nSteps[i] = worlds[i]->advance(1.0);
+
+      // advance() leaves the time step of step() unchanged
+      EXPECT_EQ(worlds[i]->getTimeStep(), 1e-3);
+    }
+
+    EXPECT_EQ(nSteps[0], nSteps[1]);
+    EXPECT_LT(nSteps[1], 5000);
+    EXPECT_TRUE(worlds[0]->getAdvanceTimeSteps()
+                == worlds[1]->getAdvanceTimeSteps());
+    EXPECT_TRUE(equals(skels[0]->getConfigs(), skels[1]->getConfigs(), 1e-12));
+
+    delete worlds[0];
+    delete worlds[1];
+}
+
+/******************************************************************************/
+TEST(WORLD, ADAPTIVE_TIME_STEPPING_CONTACT)
+{
+    World* world = new World;
+    world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+    world->setAdaptiveTimeStepping(true);
+    world->setTimeStepLimits(1e-4, 1e-2);
+    world->setAdaptiveTolerance(1e-6);
+    world->getConstraintSolver()->setCollisionDetector(
+          new collision::DARTCollisionDetector());
+
+    // The ground box is centered at the origin, so its top face is at 0.05,
+    // and the box hits it after falling 0.15 for about 0.175 s
+    Skeleton* box = createBox(Eigen::Vector3d(0.1, 0.1, 0.1),
+                              Eigen::Vector3d(0.0, 0.3, 0.0));
+    Skeleton* ground = createGround(Eigen::Vector3d(10.0, 0.1, 10.0));
+    ground->setMobile(false);
+    world->addSkeleton(box);
+    world->addSkeleton(ground);
+
+    world->advance(1.0);
+
+    // The free fall takes steps above the minimum, and the impact takes the
+    // minimum time step
+    const std::vector<double>& timeSteps = world->getAdvanceTimeSteps();
+    double time = 0.0;
+    double impactTime = -1.0;
+    for (size_t i = 0; i + 1 < timeSteps.size(); ++i)
+    {
+      if (timeSteps[i] <= 1e-4 + 1e-12)
+      {
+        impactTime = time;
+        break;
+      }
+      time += timeSteps[i];
+    }
+    EXPECT_GT(impactTime, 0.15);
+    EXPECT_LT(impactTime, 0.25);
+
+    // The box rests on the ground
+    EXPECT_GT(world->getConstraintSolver()->getCollisionDetector()
+              ->getNumContacts(), 0);
+    EXPECT_NEAR(box->getBodyNode(0)->getWorldTransform().translation()[1],
+                0.1, 1e-2);
+
+    delete world;
+}
+
+/******************************************************************************/
+TEST(WORLD, VARIATIONAL_INTEGRATION)
+{
+    // Reference with small steps of the default integrator
+    World* refWorld = new World;
+    refWorld->setTimeStep(1e-4);
+    Skeleton* refSkel = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0),
+                                             DOF_ROLL,
+                                             Eigen::Vector3d(0.3, 0.3, 1.0),
+                                             DOF_PITCH,
+                                             Eigen::Vector3d(0.3, 0.3, 1.0),
+                                             DOF_ROLL,
+                                             false, false);
+    refWorld->addSkeleton(refSkel);
+
+    World* eulerWorld = new World;
+    eulerWorld->setTimeStep(1e-2);
+    Skeleton* eulerSkel
+        = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_PITCH,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               false, false);
+    eulerWorld->addSkeleton(eulerSkel);
+
+    World* variationalWorld = new World;
+    variationalWorld->setTimeStep(1e-2);
+    Skeleton* variationalSkel
+        = createThreeLinkRobot(Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_PITCH,
+                               Eigen::Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                               false, false);
+    variationalSkel->setVariationalIntegration(true);
+    EXPECT_TRUE(variationalSkel->isVariationalIntegration());
+    variationalWorld->addSkeleton(variationalSkel);
+
+    // Joint limit impulses would change the energy
+    Skeleton* skels[] = {refSkel, eulerSkel, variationalSkel};
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < skels[i]->getNumBodyNodes(); ++j)
+        skels[i]->getBodyNode(j)->getParentJoint()->setPositionLimited(false);
+    }
+
+    Eigen::VectorXd q = Eigen::VectorXd::Constant(3, 0.5);
+    refSkel->setConfigs(q);
+    eulerSkel->setConfigs(q);
+    variationalSkel->setConfigs(q);
+
+    const double energy = variationalSkel->getKineticEnergy()
+                          + variationalSkel->getPotentialEnergy();
+
+    // The short-time motion agrees with the reference
+    refWorld->advance(0.5);
+    variationalWorld->advance(0.5);
+    EXPECT_TRUE(equals(refSkel->getConfigs(), variationalSkel->getConfigs(),
+                       1e-2));
+
+    // The energy error stays bounded over a long horizon while the default
+    // integrator drifts
+    eulerWorld->advance(0.5);
+    double maxEulerDrift = 0.0;
+    double maxVariationalDrift = 0.0;
+    for (int i = 0; i < 2000; ++i)
+    {
+      eulerWorld->step();
+      variationalWorld->step();
+
+      EXPECT_LE(variationalSkel->getVariationalSolverIterations(),
+                variationalSkel->getVariationalSolverMaxIterations());
+
+      maxEulerDrift = std::max(maxEulerDrift,
+                               std::abs(eulerSkel->getKineticEnergy()
+                                        + eulerSkel->getPotentialEnergy()
+                                        - energy));
+      maxVariationalDrift
+          = std::max(maxVariationalDrift,
+                     std::abs(variationalSkel->getKineticEnergy()
+                              + variationalSkel->getPotentialEnergy()
+                              - energy));
+    }
+
+    EXPECT_LT(maxVariationalDrift, 1e-2 * std::abs(energy));
+    EXPECT_LT(maxVariationalDrift, 0.1 * maxEulerDrift);
+
+    delete refWorld;
+    delete eulerWorld;
+    delete variationalWorld;
+}
+
+/******************************************************************************/
+TEST(WORLD, RECORDING_STREAM)
+{
+    const std::string fileName = "testWorld_RecordingStream.rec";
+
+    std::vector<int> skelDofs;
+    skelDofs.push_back(3);
+    skelDofs.push_back(2);
+
+    // States with a varying number of contacts
+    std::vector<Eigen::VectorXd> states;
+    for (int i = 0; i < 35; ++i)
+      states.push_back(Eigen::VectorXd::Random(5 + 6 * (i % 3)));
+
+    // Frames recorded in memory before streaming are written to the file
+    Recording* recording = new Recording(skelDofs);
+    for (int i = 0; i < 10; ++i)
+      recording->addState(states[i]);
+    ASSERT_TRUE(recording->startStreaming(fileName, 4));
+    EXPECT_TRUE(recording->isStreaming());
+    for (int i = 10; i < 35; ++i)
+      recording->addState(states[i]);
+    recording->flush();
+
+    // Random access to frames on disk and in memory
+    Recording* loaded = new Recording(std::vector<int>());
+    ASSERT_TRUE(loaded->loadStream(fileName, 4));
+    EXPECT_EQ(loaded->getNumSkeletons(), 2);
+    EXPECT_EQ(loaded->getNumGenCoords(0), 3);
+    EXPECT_EQ(loaded->getNumGenCoords(1), 2);
+
+    Recording* recordings[] = {recording, loaded};
+    for (int r = 0; r < 2; ++r)
+    {
+      EXPECT_EQ(recordings[r]->getNumFrames(), 35);
+      for (int k = 0; k < 35; ++k)
+      {
+        int i = (k * 13) % 35;
+        const Eigen::VectorXd& state = states[i];
+        EXPECT_TRUE(equals(recordings[r]->getConfig(i, 0),
+                           Eigen::VectorXd(state.head(3))));
+        EXPECT_TRUE(equals(recordings[r]->getConfig(i, 1),
+                           Eigen::VectorXd(state.segment(3, 2))));
+        EXPECT_EQ(recordings[r]->getGenCoord(i, 1, 1), state[4]);
+        ASSERT_EQ(recordings[r]->getNumContacts(i), i % 3);
+        for (int j = 0; j < i % 3; ++j)
+        {
+          EXPECT_TRUE(equals(recordings[r]->getContactPoint(i, j),
+                             Eigen::Vector3d(state.segment(5 + 6 * j, 3))));
+          EXPECT_TRUE(equals(recordings[r]->getContactForce(i, j),
+                             Eigen::Vector3d(state.segment(8 + 6 * j, 3))));
+        }
+      }
+    }
+
+    // New frames are appended to a loaded file
+    delete recording;
+    loaded->addState(states[0]);
+    loaded->stopStreaming();
+    EXPECT_FALSE(loaded->isStreaming());
+    EXPECT_EQ(loaded->getNumFrames(), 0);
+    ASSERT_TRUE(loaded->loadStream(fileName));
+    EXPECT_EQ(loaded->getNumFrames(), 36);
+    EXPECT_TRUE(equals(loaded->getConfig(35, 0),
+                       Eigen::VectorXd(states[0].head(3))));
+    delete loaded;
+
+    // Loading replaces the frames recorded in memory, e.g. by World::bake()
+    Recording* baked = new Recording(skelDofs);
+    for (int i = 0; i < 5; ++i)
+      baked->addState(states[20 + i]);
+    ASSERT_TRUE(baked->loadStream(fileName, 4));
+    EXPECT_EQ(baked->getNumFrames(), 36);
+    for (int i = 0; i < 35; ++i)
+    {
+      EXPECT_TRUE(equals(baked->getConfig(i, 0),
+                         Eigen::VectorXd(states[i].head(3))));
+      EXPECT_EQ(baked->getNumContacts(i), i % 3);
+    }
+    delete baked;
+
+    // Sizes in a corrupt header are rejected before anything is allocated
+    const unsigned int corruptHeaders[2][4]
+        = {{1u, 0xFFFFFFFFu, 0u, 0u}, {1u, 2u, 3u, 0xFFFFFFFFu}};
+    for (int i = 0; i < 2; ++i)
+    {
+      std::ofstream file(fileName.c_str(), std::ios::binary);
+      file.write("DREC", 4);
+      file.write(reinterpret_cast<const char*>(corruptHeaders[i]),
+                 sizeof(corruptHeaders[i]));
+      file.close();
+
+      Recording* corrupt = new Recording(skelDofs);
+      corrupt->addState(states[0]);
+      EXPECT_FALSE(corrupt->loadStream(fileName));
+      EXPECT_FALSE(corrupt->isStreaming());
+      EXPECT_EQ(corrupt->getNumFrames(), 0);
+      delete corrupt;
+    }
+
+    std::remove(fileName.c_str());
+}
+
 /******************************************************************************/
 int main(int argc, char* argv[])
 {